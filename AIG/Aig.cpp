@@ -0,0 +1,276 @@
+#include "Aig.h"
+
+#include <algorithm>
+
+namespace SMT
+{
+
+namespace
+{
+
+/// child marker of inputs and the constant node
+const AigLit NoChild = 0xffffffffu;
+
+inline uint64_t hashKey(AigLit a, AigLit b)
+{
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+}
+
+Aig::Statistics::Statistics()
+  : ands(0),
+    hashHits(0),
+    rewrites(0)
+{}
+
+Aig::Aig()
+{
+    Node constant = {NoChild, NoChild, 0};
+    m_nodes.push_back(constant);
+}
+
+AigLit Aig::mkInput(const std::string &name, unsigned int bit)
+{
+    uint32_t node = static_cast<uint32_t>(m_nodes.size());
+    Node input = {NoChild, NoChild, 0};
+    m_nodes.push_back(input);
+
+    std::unordered_map<std::string, unsigned int>::iterator it = m_nameIndex.find(name);
+    unsigned int nameIndex;
+    if (it == m_nameIndex.end()) {
+        nameIndex = static_cast<unsigned int>(m_names.size());
+        m_names.push_back(name);
+        m_nameIndex.insert(std::make_pair(name, nameIndex));
+    } else {
+        nameIndex = it->second;
+    }
+    Input info = {nameIndex, bit};
+    m_inputs.insert(std::make_pair(node, info));
+    return 2 * node;
+}
+
+AigLit Aig::mkAnd(AigLit a, AigLit b)
+{
+    if (a > b) {
+        std::swap(a, b);
+    }
+
+    // one-level rules, a is the smaller edge so constants end up there
+    if (a == AigFalse) {
+        return AigFalse;
+    }
+    if (a == AigTrue || a == b) {
+        return b;
+    }
+    if (a == aigNot(b)) {
+        return AigFalse;
+    }
+
+    AigLit result;
+    if (rewrite(a, b, result)) {
+        ++m_statistics.rewrites;
+        return result;
+    }
+
+    uint64_t key = hashKey(a, b);
+    std::unordered_map<uint64_t, uint32_t>::iterator it = m_hash.find(key);
+    if (it != m_hash.end()) {
+        ++m_statistics.hashHits;
+        return 2 * it->second;
+    }
+
+    uint32_t node = static_cast<uint32_t>(m_nodes.size());
+    Node gate = {a, b, 0};
+    m_nodes.push_back(gate);
+    ++m_nodes[aigNode(a)].fanout;
+    ++m_nodes[aigNode(b)].fanout;
+    m_hash.insert(std::make_pair(key, node));
+    ++m_statistics.ands;
+    return 2 * node;
+}
+
+bool Aig::rewrite(AigLit a, AigLit b, AigLit &result)
+{
+    bool aIsAnd = isAnd(aigNode(a));
+    bool bIsAnd = isAnd(aigNode(b));
+    if (aIsAnd && rewriteOneLevel(a, b, result)) {
+        return true;
+    }
+    if (bIsAnd && rewriteOneLevel(b, a, result)) {
+        return true;
+    }
+    return aIsAnd && bIsAnd && rewriteTwoLevel(a, b, result);
+}
+
+bool Aig::rewriteOneLevel(AigLit gate, AigLit other, AigLit &result)
+{
+    AigLit c0 = getChild0(aigNode(gate));
+    AigLit c1 = getChild1(aigNode(gate));
+
+    if (!aigIsNegated(gate)) {
+        // contradiction: (a /\ b) /\ -a = 0
+        if (other == aigNot(c0) || other == aigNot(c1)) {
+            result = AigFalse;
+            return true;
+        }
+        // idempotence: (a /\ b) /\ a = a /\ b
+        if (other == c0 || other == c1) {
+            result = gate;
+            return true;
+        }
+        return false;
+    }
+
+    // subsumption: -(a /\ b) /\ -a = -a
+    if (other == aigNot(c0) || other == aigNot(c1)) {
+        result = other;
+        return true;
+    }
+    // substitution: -(a /\ b) /\ a = -b /\ a
+    if (other == c0) {
+        result = mkAnd(aigNot(c1), other);
+        return true;
+    }
+    if (other == c1) {
+        result = mkAnd(aigNot(c0), other);
+        return true;
+    }
+    return false;
+}
+
+bool Aig::rewriteTwoLevel(AigLit left, AigLit right, AigLit &result)
+{
+    if (aigIsNegated(left) && !aigIsNegated(right)) {
+        std::swap(left, right);
+    }
+    AigLit l[2] = {getChild0(aigNode(left)), getChild1(aigNode(left))};
+    AigLit r[2] = {getChild0(aigNode(right)), getChild1(aigNode(right))};
+
+    if (!aigIsNegated(left) && !aigIsNegated(right)) {
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 2; ++j) {
+                // contradiction: (a /\ b) /\ (-a /\ c) = 0
+                if (l[i] == aigNot(r[j])) {
+                    result = AigFalse;
+                    return true;
+                }
+            }
+        }
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 2; ++j) {
+                // idempotence: (a /\ b) /\ (a /\ c) = (a /\ b) /\ c
+                if (l[i] == r[j]) {
+                    result = mkAnd(left, r[1 - j]);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    if (!aigIsNegated(left)) {
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 2; ++j) {
+                // subsumption: (a /\ b) /\ -(-a /\ c) = a /\ b
+                if (l[i] == aigNot(r[j])) {
+                    result = left;
+                    return true;
+                }
+            }
+        }
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 2; ++j) {
+                // substitution: (a /\ b) /\ -(a /\ c) = (a /\ b) /\ -c
+                if (l[i] == r[j]) {
+                    result = mkAnd(left, aigNot(r[1 - j]));
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // resolution: -(a /\ b) /\ -(a /\ -b) = -a
+    for (int i = 0; i < 2; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            if (l[i] == r[j] && l[1 - i] == aigNot(r[1 - j])) {
+                result = aigNot(l[i]);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+AigLit Aig::mkOr(AigLit a, AigLit b)
+{
+    return aigNot(mkAnd(aigNot(a), aigNot(b)));
+}
+
+AigLit Aig::mkXor(AigLit a, AigLit b)
+{
+    // -(a /\ b) /\ -(-a /\ -b), the shape the CNF encoder recognizes
+    return mkAnd(aigNot(mkAnd(a, b)), aigNot(mkAnd(aigNot(a), aigNot(b))));
+}
+
+AigLit Aig::mkIff(AigLit a, AigLit b)
+{
+    return aigNot(mkXor(a, b));
+}
+
+AigLit Aig::mkMux(AigLit cond, AigLit then, AigLit otherwise)
+{
+    if (then == otherwise) {
+        return then;
+    }
+    // -(-(c /\ t) /\ -(-c /\ e)), again recognized by the CNF encoder
+    return aigNot(mkAnd(aigNot(mkAnd(cond, then)), aigNot(mkAnd(aigNot(cond), otherwise))));
+}
+
+bool Aig::isInput(uint32_t node) const
+{
+    return node != 0 && m_nodes[node].child0 == NoChild;
+}
+
+bool Aig::isAnd(uint32_t node) const
+{
+    return m_nodes[node].child0 != NoChild;
+}
+
+AigLit Aig::getChild0(uint32_t node) const
+{
+    return m_nodes[node].child0;
+}
+
+AigLit Aig::getChild1(uint32_t node) const
+{
+    return m_nodes[node].child1;
+}
+
+unsigned int Aig::getFanout(uint32_t node) const
+{
+    return m_nodes[node].fanout;
+}
+
+const std::string &Aig::getInputName(uint32_t node) const
+{
+    return m_names[m_inputs.find(node)->second.name];
+}
+
+unsigned int Aig::getInputBit(uint32_t node) const
+{
+    return m_inputs.find(node)->second.bit;
+}
+
+uint32_t Aig::getNodeCount() const
+{
+    return static_cast<uint32_t>(m_nodes.size());
+}
+
+const Aig::Statistics &Aig::getStatistics() const
+{
+    return m_statistics;
+}
+
+}
@@ -0,0 +1,125 @@
+#ifndef SMT_AIG_AIG_H
+#define SMT_AIG_AIG_H
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SMT
+{
+
+/// \brief Edge of an And-Inverter Graph: 2 * node + complement bit
+///
+/// Node 0 is the constant false, so AigFalse is 0 and AigTrue is 1.
+typedef uint32_t AigLit;
+
+const AigLit AigFalse = 0;
+const AigLit AigTrue = 1;
+
+inline AigLit aigNot(AigLit lit)
+{
+    return lit ^ 1;
+}
+
+inline uint32_t aigNode(AigLit lit)
+{
+    return lit >> 1;
+}
+
+inline bool aigIsNegated(AigLit lit)
+{
+    return (lit & 1) != 0;
+}
+
+/// \brief Structurally hashed And-Inverter Graph
+///
+/// Nodes are only ever appended, so the children of a node always have
+/// smaller indices and the node array is in topological order. Every
+/// and gate goes through the local two-level rewriting of Brummayer and
+/// Biere ("Local Two-Level And-Inverter Graph Minimization without
+/// Blowup") before it is looked up in the structural hash table, so
+/// equivalent gates over the same inputs are shared and contradictions,
+/// idempotence, subsumption, substitution and resolution within two
+/// levels never create a node.
+/// \ingroup SMT
+class Aig
+{
+public:
+    struct Statistics
+    {
+        unsigned long ands;
+        unsigned long hashHits;
+        unsigned long rewrites;
+
+        Statistics();
+    };
+
+    Aig();
+
+    /// \brief New input standing for \a bit of the bitvector \a name
+    AigLit mkInput(const std::string &name, unsigned int bit);
+
+    AigLit mkAnd(AigLit a, AigLit b);
+    AigLit mkOr(AigLit a, AigLit b);
+    AigLit mkXor(AigLit a, AigLit b);
+    AigLit mkIff(AigLit a, AigLit b);
+    AigLit mkMux(AigLit cond, AigLit then, AigLit otherwise);
+
+    bool isInput(uint32_t node) const;
+    bool isAnd(uint32_t node) const;
+
+    /// \brief Children of the and gate \a node, the smaller edge first
+    AigLit getChild0(uint32_t node) const;
+    AigLit getChild1(uint32_t node) const;
+
+    /// \brief Number of and gates using \a node as a child
+    unsigned int getFanout(uint32_t node) const;
+
+    /// \brief Bitvector name and bit of the input \a node
+    const std::string &getInputName(uint32_t node) const;
+    unsigned int getInputBit(uint32_t node) const;
+
+    uint32_t getNodeCount() const;
+
+    const Statistics &getStatistics() const;
+
+private:
+    Aig(const Aig &);
+    Aig &operator=(const Aig &);
+
+    struct Node
+    {
+        AigLit child0;
+        AigLit child1;
+        unsigned int fanout;
+    };
+
+    struct Input
+    {
+        unsigned int name;
+        unsigned int bit;
+    };
+
+    /// \brief Two-level rewriting of a /\ b, false if no rule applies
+    bool rewrite(AigLit a, AigLit b, AigLit &result);
+
+    /// \brief Rules for an and gate \a gate next to an arbitrary edge \a other
+    bool rewriteOneLevel(AigLit gate, AigLit other, AigLit &result);
+
+    /// \brief Rules for two and gates
+    bool rewriteTwoLevel(AigLit left, AigLit right, AigLit &result);
+
+    std::vector<Node> m_nodes;
+    std::unordered_map<uint64_t, uint32_t> m_hash;
+
+    std::unordered_map<uint32_t, Input> m_inputs;
+    std::vector<std::string> m_names;
+    std::unordered_map<std::string, unsigned int> m_nameIndex;
+
+    Statistics m_statistics;
+};
+
+}
+
+#endif
@@ -0,0 +1,205 @@
+#include "AigCnf.h"
+
+namespace SMT
+{
+
+namespace
+{
+
+/// widest and gate built by collapsing, keeps clauses at a sane length
+const size_t MaxAndLeaves = 64;
+
+}
+
+AigCnf::Statistics::Statistics()
+  : variables(0),
+    clauses(0),
+    xors(0),
+    muxes(0),
+    ands(0)
+{}
+
+AigCnf::AigCnf(const Aig &aig, ClauseSink &sink)
+  : m_aig(aig),
+    m_sink(sink)
+{}
+
+int AigCnf::encode(AigLit lit)
+{
+    uint32_t root = aigNode(lit);
+    if (m_variables.size() < m_aig.getNodeCount()) {
+        m_variables.resize(m_aig.getNodeCount(), 0);
+    }
+    if (m_variables[root] != 0) {
+        return literal(lit);
+    }
+
+    // children first without recursion, AIGs of wide arithmetic are deep
+    m_stack.push_back(root);
+    while (!m_stack.empty()) {
+        uint32_t node = m_stack.back();
+        if (m_variables[node] != 0) {
+            m_stack.pop_back();
+            continue;
+        }
+        if (!m_aig.isAnd(node)) {
+            encodeNode(node);
+            m_stack.pop_back();
+            continue;
+        }
+
+        findCut(node, m_leaves);
+        bool ready = true;
+        for (std::vector<AigLit>::const_iterator it = m_leaves.begin(); it != m_leaves.end(); ++it) {
+            if (m_variables[aigNode(*it)] == 0) {
+                m_stack.push_back(aigNode(*it));
+                ready = false;
+            }
+        }
+        if (ready) {
+            encodeNode(node);
+            m_stack.pop_back();
+        }
+    }
+    return literal(lit);
+}
+
+int AigCnf::getVariable(uint32_t node) const
+{
+    return node < m_variables.size() ? m_variables[node] : 0;
+}
+
+const AigCnf::Statistics &AigCnf::getStatistics() const
+{
+    return m_statistics;
+}
+
+bool AigCnf::isCollapsible(AigLit lit) const
+{
+    uint32_t node = aigNode(lit);
+    return !aigIsNegated(lit) && m_aig.isAnd(node) && m_aig.getFanout(node) == 1 && m_variables[node] == 0;
+}
+
+AigCnf::CutKind AigCnf::findCut(uint32_t node, std::vector<AigLit> &leaves) const
+{
+    leaves.clear();
+    AigLit c0 = m_aig.getChild0(node);
+    AigLit c1 = m_aig.getChild1(node);
+
+    // -(x0 /\ x1) /\ -(y0 /\ y1) with both inner gates private to this node
+    if (aigIsNegated(c0) && aigIsNegated(c1) && isCollapsible(aigNot(c0)) && isCollapsible(aigNot(c1))) {
+        AigLit x[2] = {m_aig.getChild0(aigNode(c0)), m_aig.getChild1(aigNode(c0))};
+        AigLit y[2] = {m_aig.getChild0(aigNode(c1)), m_aig.getChild1(aigNode(c1))};
+
+        if ((y[0] == aigNot(x[0]) && y[1] == aigNot(x[1])) || (y[0] == aigNot(x[1]) && y[1] == aigNot(x[0]))) {
+            leaves.push_back(x[0]);
+            leaves.push_back(x[1]);
+            return CutXor;
+        }
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 2; ++j) {
+                if (x[i] == aigNot(y[j])) {
+                    leaves.push_back(x[i]);
+                    leaves.push_back(x[1 - i]);
+                    leaves.push_back(y[1 - j]);
+                    return CutMux;
+                }
+            }
+        }
+    }
+
+    std::vector<AigLit> pending;
+    pending.push_back(c1);
+    pending.push_back(c0);
+    while (!pending.empty()) {
+        AigLit lit = pending.back();
+        pending.pop_back();
+        if (isCollapsible(lit) && leaves.size() + pending.size() + 2 <= MaxAndLeaves) {
+            pending.push_back(m_aig.getChild1(aigNode(lit)));
+            pending.push_back(m_aig.getChild0(aigNode(lit)));
+        } else {
+            leaves.push_back(lit);
+        }
+    }
+    return CutAnd;
+}
+
+void AigCnf::encodeNode(uint32_t node)
+{
+    if (node == 0) {
+        int constant = m_sink.addVariable();
+        ++m_statistics.variables;
+        m_variables[0] = constant;
+        m_clause.assign(1, -constant);
+        addClause();
+        return;
+    }
+    if (m_aig.isInput(node)) {
+        m_variables[node] = m_sink.addVariable(m_aig.getInputName(node), m_aig.getInputBit(node));
+        ++m_statistics.variables;
+        return;
+    }
+
+    CutKind kind = findCut(node, m_leaves);
+    int v = m_sink.addVariable();
+    ++m_statistics.variables;
+    m_variables[node] = v;
+
+    switch (kind) {
+    case CutXor: {
+        ++m_statistics.xors;
+        int a = literal(m_leaves[0]);
+        int b = literal(m_leaves[1]);
+        int clauses[4][3] = {{-v, a, b}, {-v, -a, -b}, {v, -a, b}, {v, a, -b}};
+        for (int i = 0; i < 4; ++i) {
+            m_clause.assign(clauses[i], clauses[i] + 3);
+            addClause();
+        }
+        break;
+    }
+    case CutMux: {
+        ++m_statistics.muxes;
+        int c = literal(m_leaves[0]);
+        int t = literal(m_leaves[1]);
+        int e = literal(m_leaves[2]);
+        // the node is the negated mux
+        int o = -v;
+        int clauses[6][3] = {{-c, -t, o}, {-c, t, -o}, {c, -e, o}, {c, e, -o}, {-t, -e, o}, {t, e, -o}};
+        for (int i = 0; i < 6; ++i) {
+            m_clause.assign(clauses[i], clauses[i] + 3);
+            addClause();
+        }
+        break;
+    }
+    case CutAnd: {
+        ++m_statistics.ands;
+        std::vector<int> wide;
+        wide.push_back(v);
+        for (std::vector<AigLit>::const_iterator it = m_leaves.begin(); it != m_leaves.end(); ++it) {
+            int l = literal(*it);
+            m_clause.clear();
+            m_clause.push_back(-v);
+            m_clause.push_back(l);
+            addClause();
+            wide.push_back(-l);
+        }
+        m_clause.swap(wide);
+        addClause();
+        break;
+    }
+    }
+}
+
+int AigCnf::literal(AigLit lit) const
+{
+    int v = m_variables[aigNode(lit)];
+    return aigIsNegated(lit) ? -v : v;
+}
+
+void AigCnf::addClause()
+{
+    m_sink.addClause(m_clause);
+    ++m_statistics.clauses;
+}
+
+}
@@ -0,0 +1,93 @@
+#ifndef SMT_AIG_AIGCNF_H
+#define SMT_AIG_AIGCNF_H
+
+#include "Aig.h"
+
+#include "../ClauseSink.h"
+
+#include <vector>
+
+namespace SMT
+{
+
+/// \brief Cut-based CNF encoding of an Aig, produced on demand
+///
+/// Instead of one Tseitin variable and three clauses per and gate, every
+/// encoded node is defined over a cut of its fanin cone:
+///
+/// - xor and mux shapes (as built by Aig::mkXor and Aig::mkMux) become one
+///   variable over their two or three inputs with four or six clauses,
+/// - other gates are widened into a multi-input and over all single-fanout,
+///   non-negated and gates below them, one variable and n + 1 clauses.
+///
+/// Only cut leaves get variables, so the inner gates of wide ands, xors and
+/// muxes do not appear in the CNF at all. Nodes are encoded once; later
+/// calls reuse their variables, which makes the encoder usable for
+/// incremental solving.
+/// \ingroup SMT
+class AigCnf
+{
+public:
+    struct Statistics
+    {
+        unsigned long variables;
+        unsigned long clauses;
+        unsigned long xors;
+        unsigned long muxes;
+        unsigned long ands;
+
+        Statistics();
+    };
+
+    AigCnf(const Aig &aig, ClauseSink &sink);
+
+    /// \brief DIMACS literal equivalent to \a lit, encoding its cone first
+    int encode(AigLit lit);
+
+    /// \brief Variable of \a node, 0 if it has not been encoded
+    int getVariable(uint32_t node) const;
+
+    const Statistics &getStatistics() const;
+
+private:
+    AigCnf(const AigCnf &);
+    AigCnf &operator=(const AigCnf &);
+
+    enum CutKind
+    {
+        CutAnd,
+        CutXor,
+        CutMux
+    };
+
+    /// \brief Leaves of the cut of the and gate \a node
+    ///
+    /// For CutXor the leaves are a and b with node = a xor b, for CutMux
+    /// they are c, t and e with node = -(c ? t : e), and for CutAnd node is
+    /// the conjunction of all leaves.
+    CutKind findCut(uint32_t node, std::vector<AigLit> &leaves) const;
+
+    bool isCollapsible(AigLit lit) const;
+
+    void encodeNode(uint32_t node);
+
+    int literal(AigLit lit) const;
+
+    void addClause();
+
+    const Aig &m_aig;
+    ClauseSink &m_sink;
+
+    /// \brief CNF variable per node, 0 if not encoded yet
+    std::vector<int> m_variables;
+
+    std::vector<uint32_t> m_stack;
+    std::vector<AigLit> m_leaves;
+    std::vector<int> m_clause;
+
+    Statistics m_statistics;
+};
+
+}
+
+#endif
@@ -0,0 +1,373 @@
+#include "AigSolver.h"
+#include "Bitvectors.h"
+#include "SatCore.h"
+
+#include "../ClauseSink.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <minisat/core/Solver.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+namespace SMT
+{
+
+/// \brief Feeds the clauses of AigCnf into MiniSat, optionally copying them
+///
+/// DIMACS variable v is MiniSat variable v - 1.
+class AigSolver::MiniSatSink : public ClauseSink
+{
+public:
+    MiniSatSink(Minisat::Solver &solver)
+      : m_solver(solver),
+        m_tee(NULL),
+        m_used(false)
+    {}
+
+    using ClauseSink::addClause;
+
+    int addVariable(const std::string &name, unsigned int bit)
+    {
+        m_used = true;
+        if (m_tee != NULL) {
+            m_tee->addVariable(name, bit);
+        }
+        return m_solver.newVar() + 1;
+    }
+
+    int addVariable()
+    {
+        m_used = true;
+        if (m_tee != NULL) {
+            m_tee->addVariable();
+        }
+        return m_solver.newVar() + 1;
+    }
+
+    void addClause(const int *literals, size_t size)
+    {
+        addClause(literals, size, true);
+    }
+
+    /// \brief Clause for MiniSat only if not \a copy
+    void addClause(const int *literals, size_t size, bool copy)
+    {
+        m_clause.clear();
+        for (size_t i = 0; i < size; ++i) {
+            m_clause.push(Minisat::mkLit(std::abs(literals[i]) - 1, literals[i] < 0));
+        }
+        // false only once the clauses are unsatisfiable, solve() reports that
+        m_solver.addClause(m_clause);
+        if (copy && m_tee != NULL) {
+            m_tee->addClause(literals, size);
+        }
+    }
+
+    void setTee(ClauseSink *tee)
+    {
+        if (m_used) {
+            throw LLBMCException("The clause sink must be set before the first assertion");
+        }
+        m_tee = tee;
+    }
+
+private:
+    MiniSatSink(const MiniSatSink&);
+    MiniSatSink &operator=(const MiniSatSink&);
+
+    Minisat::Solver &m_solver;
+    ClauseSink *m_tee;
+    bool m_used;
+    Minisat::vec<Minisat::Lit> m_clause;
+};
+
+AigSolver::AigSolver()
+  : m_aig(),
+    m_minisat(new Minisat::Solver()),
+    m_sink(new MiniSatSink(*m_minisat)),
+    m_cnf(m_aig, *m_sink),
+    m_sat(new AigSatCore(m_aig)),
+    m_bvs(new AigBitvectors(m_aig)),
+    m_result(Solver::Unknown),
+    m_description("AIG with MiniSat"),
+    m_levels(),
+    m_assumptions(),
+    m_cancelled(false),
+    m_timeoutMs(0),
+    m_solving(false),
+    m_timedOut(false),
+    m_values()
+{}
+
+AigSolver::~AigSolver()
+{
+    delete m_bvs;
+    delete m_sat;
+    delete m_sink;
+    delete m_minisat;
+}
+
+bool AigSolver::hasCapability(Capability cap) const
+{
+    switch (cap) {
+    case CapSMTSolving:
+    case CapIncrementalSolving:
+    case CapAssume:
+    case CapPushPop:
+    case CapTimeout:
+    case CapTheoryOfBitvectors:
+        return true;
+    default:
+        return false;
+    }
+}
+
+SatCore *AigSolver::getSatCore()
+{
+    return m_sat;
+}
+
+TheoryOfBitvectors *AigSolver::getTheoryOfBitvectors()
+{
+    return m_bvs;
+}
+
+BitvectorTheoryOfArrays *AigSolver::getBitvectorTheoryOfArrays()
+{
+    return NULL;
+}
+
+BitvectorTheoryOfUFs *AigSolver::getBitvectorTheoryOfUFs()
+{
+    return NULL;
+}
+
+bool AigSolver::hasModel()
+{
+    return m_result == Solver::Satisfiable;
+}
+
+Model *AigSolver::getModel()
+{
+    if (m_result == Solver::Satisfiable) {
+        return this;
+    } else {
+        return NULL;
+    }
+}
+
+bool AigSolver::evaluate(AigLit lit) const
+{
+    uint32_t node = aigNode(lit);
+    // nodes are in topological order, so one pass over the new ones suffices
+    while (m_values.size() <= node) {
+        uint32_t next = static_cast<uint32_t>(m_values.size());
+        char value = 0;
+        if (m_aig.isAnd(next)) {
+            AigLit c0 = m_aig.getChild0(next);
+            AigLit c1 = m_aig.getChild1(next);
+            bool v0 = (m_values[aigNode(c0)] != 0) != aigIsNegated(c0);
+            bool v1 = (m_values[aigNode(c1)] != 0) != aigIsNegated(c1);
+            value = v0 && v1;
+        } else if (m_aig.isInput(next)) {
+            // inputs that never made it into the CNF are unconstrained, take 0
+            int variable = m_cnf.getVariable(next);
+            value = variable != 0 && variable <= m_minisat->model.size()
+                    && m_minisat->model[variable - 1] == l_True;
+        }
+        m_values.push_back(value);
+    }
+    return (m_values[node] != 0) != aigIsNegated(lit);
+}
+
+bool AigSolver::getBoolean(BoolExp *exp) const
+{
+    return evaluate(toAig(exp));
+}
+
+bool AigSolver::getBooleanMask(BoolExp *) const
+{
+    return true;
+}
+
+const Bitvector *AigSolver::getBitvector(BVExp *exp) const
+{
+    const std::vector<AigLit> &bits = toAig(exp)->bits;
+    unsigned int width = static_cast<unsigned int>(bits.size());
+    if (width <= 64) {
+        uint64_t value = 0;
+        for (unsigned int i = 0; i < width; ++i) {
+            if (evaluate(bits[i])) {
+                value |= static_cast<uint64_t>(1) << i;
+            }
+        }
+        return new Bitvector(value, width);
+    }
+
+    Bitvector *res = new Bitvector(0, width);
+    for (unsigned int i = 0; i < width; ++i) {
+        res->setBit(i, evaluate(bits[i]));
+    }
+    return res;
+}
+
+const BVArray *AigSolver::getBVArray(AExp *) const
+{
+    return NULL;
+}
+
+const BVArray *AigSolver::getBVUF(UFExp *) const
+{
+    return NULL;
+}
+
+void AigSolver::assertConstraint(BoolExp *exp)
+{
+    int lit = m_cnf.encode(toAig(exp));
+    if (m_levels.empty()) {
+        m_sink->addClause(&lit, 1, true);
+    } else {
+        int clause[2] = {-m_levels.back(), lit};
+        m_sink->addClause(clause, 2, false);
+    }
+}
+
+void AigSolver::assume(BoolExp *exp)
+{
+    m_assumptions.push_back(m_cnf.encode(toAig(exp)));
+}
+
+void AigSolver::push()
+{
+    m_levels.push_back(m_sink->addVariable());
+}
+
+void AigSolver::pop()
+{
+    if (m_levels.empty()) {
+        throw LLBMCException("pop() without push()");
+    }
+    // the level's assertions are switched off for good
+    int disable = -m_levels.back();
+    m_sink->addClause(&disable, 1, false);
+    m_levels.pop_back();
+}
+
+void AigSolver::solve()
+{
+    m_values.clear();
+
+    Minisat::vec<Minisat::Lit> assumptions;
+    // an assertion of a level also needs the activation literals below it
+    for (std::vector<int>::const_iterator it = m_levels.begin(); it != m_levels.end(); ++it) {
+        assumptions.push(Minisat::mkLit(*it - 1, false));
+    }
+    for (std::vector<int>::const_iterator it = m_assumptions.begin(); it != m_assumptions.end(); ++it) {
+        assumptions.push(Minisat::mkLit(std::abs(*it) - 1, *it < 0));
+    }
+    m_assumptions.clear();
+
+    // cancel() after this point interrupts the search
+    m_minisat->clearInterrupt();
+    if (m_cancelled) {
+        m_result = Solver::Timeout;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_solveMutex);
+        m_solving = true;
+        m_timedOut = false;
+    }
+    std::thread watchdog;
+    if (m_timeoutMs != 0) {
+        watchdog = std::thread(&AigSolver::watchTimeout, this);
+    }
+
+    Minisat::lbool res = m_minisat->solveLimited(assumptions);
+
+    {
+        std::lock_guard<std::mutex> lock(m_solveMutex);
+        m_solving = false;
+    }
+    m_solveDone.notify_all();
+    if (watchdog.joinable()) {
+        watchdog.join();
+    }
+
+    if (res == l_True) {
+        m_result = Solver::Satisfiable;
+    } else if (res == l_False) {
+        m_result = Solver::Unsatisfiable;
+    } else if (m_cancelled || m_timedOut) {
+        m_result = Solver::Timeout;
+    } else {
+        m_result = Solver::Unknown;
+    }
+}
+
+void AigSolver::watchTimeout()
+{
+    std::unique_lock<std::mutex> lock(m_solveMutex);
+    bool done = m_solveDone.wait_for(lock, std::chrono::milliseconds(m_timeoutMs), [this] { return !m_solving; });
+    if (!done) {
+        m_timedOut = true;
+        m_minisat->interrupt();
+    }
+}
+
+Solver::Result AigSolver::getResult() const
+{
+    return m_result;
+}
+
+const std::string &AigSolver::getDescription() const
+{
+    return m_description;
+}
+
+void AigSolver::enableIncrementalSolving()
+{
+    // always incremental
+}
+
+void AigSolver::setTimeout(int seconds)
+{
+    setTimeoutMs(seconds > 0 ? static_cast<unsigned long>(seconds) * 1000 : 0);
+}
+
+void AigSolver::setTimeoutMs(unsigned long milliseconds)
+{
+    m_timeoutMs = milliseconds;
+}
+
+void AigSolver::cancel()
+{
+    m_cancelled = true;
+    m_minisat->interrupt();
+}
+
+void AigSolver::resetCancel()
+{
+    m_cancelled = false;
+}
+
+void AigSolver::setClauseSink(ClauseSink *sink)
+{
+    m_sink->setTee(sink);
+}
+
+const Aig::Statistics &AigSolver::getAigStatistics() const
+{
+    return m_aig.getStatistics();
+}
+
+const AigCnf::Statistics &AigSolver::getCnfStatistics() const
+{
+    return m_cnf.getStatistics();
+}
+
+}
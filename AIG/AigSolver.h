@@ -0,0 +1,148 @@
+#ifndef SMT_AIG_SOLVER_H
+#define SMT_AIG_SOLVER_H
+
+#include "Aig.h"
+#include "AigCnf.h"
+
+#include <llbmc/SMT/Solver.h>
+#include <llbmc/SMT/Model.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ClauseSink;
+
+namespace Minisat
+{
+class Solver;
+}
+
+namespace SMT
+{
+
+class AigSatCore;
+class AigBitvectors;
+
+/// \brief Bit-blasting SMT::Solver on an embedded MiniSat
+///
+/// Bitvector and propositional expressions are built in a structurally
+/// hashed, locally rewritten Aig. Asserted and assumed expressions are
+/// encoded into CNF with AigCnf right away, each node only once, and the
+/// clauses go straight into MiniSat. Solving is always incremental:
+/// push() opens a level guarded by a fresh activation literal that every
+/// assertion of the level is conditioned on, pop() disables it for good.
+///
+/// Only the theory of bitvectors is supported, no arrays or UFs.
+/// \ingroup SMT
+class AigSolver
+  : public Solver,
+    public Model
+{
+public:
+    AigSolver();
+    virtual ~AigSolver();
+
+    virtual bool hasCapability(Capability) const;
+
+    virtual SatCore *getSatCore();
+    virtual TheoryOfBitvectors *getTheoryOfBitvectors();
+    virtual BitvectorTheoryOfArrays *getBitvectorTheoryOfArrays();
+    virtual BitvectorTheoryOfUFs *getBitvectorTheoryOfUFs();
+
+    virtual bool hasModel();
+    virtual Model *getModel();
+
+    virtual bool getBoolean(BoolExp*) const;
+    virtual bool getBooleanMask(BoolExp*) const;
+
+    virtual const Bitvector *getBitvector(BVExp *) const;
+
+    virtual const BVArray *getBVArray(AExp*) const;
+
+    virtual const BVArray *getBVUF(UFExp*) const;
+
+    virtual void assertConstraint(BoolExp *exp);
+
+    /// \brief Assume \a exp for the next solve() only
+    virtual void assume(BoolExp *exp);
+
+    virtual void push();
+
+    virtual void pop();
+
+    virtual void solve();
+
+    virtual Result getResult() const;
+
+    virtual const std::string &getDescription() const;
+
+    virtual void enableIncrementalSolving();
+
+    virtual void setTimeout(int seconds);
+
+    /// \brief Limit each solve() to \a milliseconds, 0 disables the limit
+    void setTimeoutMs(unsigned long milliseconds);
+
+    /// \brief Abort the running solve() with Timeout
+    ///
+    /// May be called from any thread. The request is sticky: a later
+    /// solve() returns Timeout right away until resetCancel() is called.
+    void cancel();
+
+    /// \brief Allow solving again after cancel()
+    void resetCancel();
+
+    /// \brief Also send every variable and clause to \a sink
+    ///
+    /// Must be called before the first assertion so that the variable
+    /// numbers of \a sink and MiniSat agree. Activation literals of push()
+    /// and assumptions are not part of the copied CNF.
+    void setClauseSink(ClauseSink *sink);
+
+    const Aig::Statistics &getAigStatistics() const;
+    const AigCnf::Statistics &getCnfStatistics() const;
+
+private:
+    AigSolver(const AigSolver &);
+    AigSolver &operator=(const AigSolver &);
+
+    class MiniSatSink;
+
+    /// \brief Interrupts MiniSat when the timeout of the running solve() expires
+    void watchTimeout();
+
+    /// \brief Model value of \a lit, evaluating nodes created since the last call
+    bool evaluate(AigLit lit) const;
+
+    Aig m_aig;
+    Minisat::Solver *m_minisat;
+    MiniSatSink *m_sink;
+    AigCnf m_cnf;
+
+    AigSatCore *m_sat;
+    AigBitvectors *m_bvs;
+
+    Result m_result;
+    std::string m_description;
+
+    /// activation literal per open push()
+    std::vector<int> m_levels;
+    std::vector<int> m_assumptions;
+
+    std::atomic<bool> m_cancelled;
+    unsigned long m_timeoutMs;
+    std::mutex m_solveMutex;
+    std::condition_variable m_solveDone;
+    bool m_solving;
+    bool m_timedOut;
+
+    /// model value per node, filled up lazily after a satisfiable solve()
+    mutable std::vector<char> m_values;
+};
+
+}
+
+#endif
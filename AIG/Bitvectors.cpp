@@ -0,0 +1,541 @@
+#include "Bitvectors.h"
+
+namespace SMT
+{
+
+BVExp *AigBitvectors::make(Bits &bits)
+{
+    AigWord *word = new AigWord();
+    word->refs = 1;
+    word->bits.swap(bits);
+    return toBVExp(word);
+}
+
+const AigBitvectors::Bits &AigBitvectors::bits(BVExp *exp)
+{
+    return toAig(exp)->bits;
+}
+
+BVExp *AigBitvectors::bitvector(unsigned int width, const std::string &name)
+{
+    Bits result(width);
+    for (unsigned int i = 0; i < width; ++i) {
+        result[i] = m_aig.mkInput(name, i);
+    }
+    return make(result);
+}
+
+BVExp *AigBitvectors::copy(BVExp *exp)
+{
+    ++toAig(exp)->refs;
+    return exp;
+}
+
+void AigBitvectors::release(BVExp *exp)
+{
+    AigWord *word = toAig(exp);
+    if (--word->refs == 0) {
+        delete word;
+    }
+}
+
+unsigned int AigBitvectors::width(BVExp *exp)
+{
+    return static_cast<unsigned int>(bits(exp).size());
+}
+
+BVExp *AigBitvectors::bool2bv1(BoolExp *exp)
+{
+    Bits result(1, toAig(exp));
+    return make(result);
+}
+
+BoolExp *AigBitvectors::bv12bool(BVExp *exp)
+{
+    return toBoolExp(bits(exp)[0]);
+}
+
+BoolExp *AigBitvectors::eq(BVExp *exp1, BVExp *exp2)
+{
+    return toBoolExp(equal(bits(exp1), bits(exp2)));
+}
+
+BoolExp *AigBitvectors::bvne(BVExp *exp1, BVExp *exp2)
+{
+    return toBoolExp(aigNot(equal(bits(exp1), bits(exp2))));
+}
+
+BVExp *AigBitvectors::concat(BVExp *exp1, BVExp *exp2)
+{
+    // exp1 is the high part
+    Bits result(bits(exp2));
+    result.insert(result.end(), bits(exp1).begin(), bits(exp1).end());
+    return make(result);
+}
+
+BVExp *AigBitvectors::extract(unsigned int i, unsigned int j, BVExp *exp)
+{
+    const Bits &a = bits(exp);
+    Bits result(a.begin() + j, a.begin() + i + 1);
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvnot(BVExp *exp)
+{
+    const Bits &a = bits(exp);
+    Bits result(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        result[i] = aigNot(a[i]);
+    }
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvneg(BVExp *exp)
+{
+    Bits result;
+    negate(bits(exp), result);
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvand(BVExp *exp1, BVExp *exp2)
+{
+    const Bits &a = bits(exp1);
+    const Bits &b = bits(exp2);
+    Bits result(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        result[i] = m_aig.mkAnd(a[i], b[i]);
+    }
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvor(BVExp *exp1, BVExp *exp2)
+{
+    const Bits &a = bits(exp1);
+    const Bits &b = bits(exp2);
+    Bits result(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        result[i] = m_aig.mkOr(a[i], b[i]);
+    }
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvxor(BVExp *exp1, BVExp *exp2)
+{
+    const Bits &a = bits(exp1);
+    const Bits &b = bits(exp2);
+    Bits result(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        result[i] = m_aig.mkXor(a[i], b[i]);
+    }
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvimplies(BVExp *exp1, BVExp *exp2)
+{
+    const Bits &a = bits(exp1);
+    const Bits &b = bits(exp2);
+    Bits result(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        result[i] = m_aig.mkOr(aigNot(a[i]), b[i]);
+    }
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvcond(BoolExp *cond, BVExp *exp1, BVExp *exp2)
+{
+    Bits result;
+    select(toAig(cond), bits(exp1), bits(exp2), result);
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvadd(BVExp *exp1, BVExp *exp2)
+{
+    Bits result;
+    add(bits(exp1), bits(exp2), AigFalse, result);
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvsub(BVExp *exp1, BVExp *exp2)
+{
+    const Bits &b = bits(exp2);
+    Bits inverted(b.size());
+    for (size_t i = 0; i < b.size(); ++i) {
+        inverted[i] = aigNot(b[i]);
+    }
+    Bits result;
+    add(bits(exp1), inverted, AigTrue, result);
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvmul(BVExp *exp1, BVExp *exp2)
+{
+    Bits result;
+    multiply(bits(exp1), bits(exp2), result);
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvudiv(BVExp *exp1, BVExp *exp2)
+{
+    Bits quotient;
+    Bits remainder;
+    divide(bits(exp1), bits(exp2), quotient, remainder);
+    return make(quotient);
+}
+
+BVExp *AigBitvectors::bvurem(BVExp *exp1, BVExp *exp2)
+{
+    Bits quotient;
+    Bits remainder;
+    divide(bits(exp1), bits(exp2), quotient, remainder);
+    return make(remainder);
+}
+
+BVExp *AigBitvectors::bvsdiv(BVExp *exp1, BVExp *exp2)
+{
+    Bits a;
+    Bits b;
+    AigLit signA = absolute(bits(exp1), a);
+    AigLit signB = absolute(bits(exp2), b);
+    Bits quotient;
+    Bits remainder;
+    divide(a, b, quotient, remainder);
+    Bits negated;
+    negate(quotient, negated);
+    Bits result;
+    select(m_aig.mkXor(signA, signB), negated, quotient, result);
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvsrem(BVExp *exp1, BVExp *exp2)
+{
+    // the remainder takes the sign of the dividend
+    Bits a;
+    Bits b;
+    AigLit signA = absolute(bits(exp1), a);
+    absolute(bits(exp2), b);
+    Bits quotient;
+    Bits remainder;
+    divide(a, b, quotient, remainder);
+    Bits negated;
+    negate(remainder, negated);
+    Bits result;
+    select(signA, negated, remainder, result);
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvshl(BVExp *exp1, BVExp *exp2)
+{
+    Bits result;
+    shift(bits(exp1), bits(exp2), true, AigFalse, result);
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvlshr(BVExp *exp1, BVExp *exp2)
+{
+    Bits result;
+    shift(bits(exp1), bits(exp2), false, AigFalse, result);
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvashr(BVExp *exp1, BVExp *exp2)
+{
+    const Bits &a = bits(exp1);
+    Bits result;
+    shift(a, bits(exp2), false, a.back(), result);
+    return make(result);
+}
+
+BVExp *AigBitvectors::bv2bv(const Bitvector *bv)
+{
+    unsigned int bvWidth = bv->getWidth();
+    Bits result(bvWidth);
+    for (unsigned int i = 0; i < bvWidth; ++i) {
+        result[i] = bv->getBit(i) ? AigTrue : AigFalse;
+    }
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvzeros(unsigned int width)
+{
+    Bits result(width, AigFalse);
+    return make(result);
+}
+
+BVExp *AigBitvectors::bvones(unsigned int width)
+{
+    Bits result(width, AigTrue);
+    return make(result);
+}
+
+BVExp *AigBitvectors::uext(BVExp *exp, unsigned int newWidth)
+{
+    Bits result(bits(exp));
+    result.resize(newWidth, AigFalse);
+    return make(result);
+}
+
+BVExp *AigBitvectors::sext(BVExp *exp, unsigned int newWidth)
+{
+    Bits result(bits(exp));
+    result.resize(newWidth, result.back());
+    return make(result);
+}
+
+BoolExp *AigBitvectors::bvult(BVExp *exp1, BVExp *exp2)
+{
+    return toBoolExp(lessUnsigned(bits(exp1), bits(exp2)));
+}
+
+BoolExp *AigBitvectors::bvule(BVExp *exp1, BVExp *exp2)
+{
+    return toBoolExp(aigNot(lessUnsigned(bits(exp2), bits(exp1))));
+}
+
+BoolExp *AigBitvectors::bvugt(BVExp *exp1, BVExp *exp2)
+{
+    return toBoolExp(lessUnsigned(bits(exp2), bits(exp1)));
+}
+
+BoolExp *AigBitvectors::bvuge(BVExp *exp1, BVExp *exp2)
+{
+    return toBoolExp(aigNot(lessUnsigned(bits(exp1), bits(exp2))));
+}
+
+BoolExp *AigBitvectors::bvslt(BVExp *exp1, BVExp *exp2)
+{
+    return toBoolExp(lessSigned(bits(exp1), bits(exp2)));
+}
+
+BoolExp *AigBitvectors::bvsle(BVExp *exp1, BVExp *exp2)
+{
+    return toBoolExp(aigNot(lessSigned(bits(exp2), bits(exp1))));
+}
+
+BoolExp *AigBitvectors::bvsgt(BVExp *exp1, BVExp *exp2)
+{
+    return toBoolExp(lessSigned(bits(exp2), bits(exp1)));
+}
+
+BoolExp *AigBitvectors::bvsge(BVExp *exp1, BVExp *exp2)
+{
+    return toBoolExp(aigNot(lessSigned(bits(exp1), bits(exp2))));
+}
+
+BoolExp *AigBitvectors::bvuaddo(BVExp *exp1, BVExp *exp2)
+{
+    Bits sum;
+    return toBoolExp(add(bits(exp1), bits(exp2), AigFalse, sum));
+}
+
+BoolExp *AigBitvectors::bvusubo(BVExp *exp1, BVExp *exp2)
+{
+    return toBoolExp(lessUnsigned(bits(exp1), bits(exp2)));
+}
+
+BoolExp *AigBitvectors::bvumulo(BVExp *exp1, BVExp *exp2)
+{
+    size_t w = bits(exp1).size();
+    Bits a(bits(exp1));
+    Bits b(bits(exp2));
+    a.resize(2 * w, AigFalse);
+    b.resize(2 * w, AigFalse);
+    Bits product;
+    multiply(a, b, product);
+    return toBoolExp(aigNot(allEqual(product, w, AigFalse)));
+}
+
+BoolExp *AigBitvectors::bvsaddo(BVExp *exp1, BVExp *exp2)
+{
+    const Bits &a = bits(exp1);
+    const Bits &b = bits(exp2);
+    Bits sum;
+    add(a, b, AigFalse, sum);
+    // same signs in, different sign out
+    return toBoolExp(m_aig.mkAnd(m_aig.mkIff(a.back(), b.back()), m_aig.mkXor(sum.back(), a.back())));
+}
+
+BoolExp *AigBitvectors::bvssubo(BVExp *exp1, BVExp *exp2)
+{
+    const Bits &a = bits(exp1);
+    const Bits &b = bits(exp2);
+    Bits inverted(b.size());
+    for (size_t i = 0; i < b.size(); ++i) {
+        inverted[i] = aigNot(b[i]);
+    }
+    Bits difference;
+    add(a, inverted, AigTrue, difference);
+    return toBoolExp(m_aig.mkAnd(m_aig.mkXor(a.back(), b.back()), m_aig.mkXor(difference.back(), a.back())));
+}
+
+BoolExp *AigBitvectors::bvsmulo(BVExp *exp1, BVExp *exp2)
+{
+    size_t w = bits(exp1).size();
+    Bits a(bits(exp1));
+    Bits b(bits(exp2));
+    a.resize(2 * w, a.back());
+    b.resize(2 * w, b.back());
+    Bits product;
+    multiply(a, b, product);
+    // the product fits iff the upper half repeats the sign of the lower half
+    return toBoolExp(aigNot(allEqual(product, w, product[w - 1])));
+}
+
+BoolExp *AigBitvectors::bvsdivo(BVExp *exp1, BVExp *exp2)
+{
+    // only INT_MIN / -1 overflows
+    const Bits &a = bits(exp1);
+    const Bits &b = bits(exp2);
+    Bits lowerA(a.begin(), a.end() - 1);
+    AigLit minA = m_aig.mkAnd(a.back(), allEqual(lowerA, 0, AigFalse));
+    return toBoolExp(m_aig.mkAnd(minA, allEqual(b, 0, AigTrue)));
+}
+
+AigLit AigBitvectors::add(const Bits &a, const Bits &b, AigLit carry, Bits &sum)
+{
+    sum.resize(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        AigLit half = m_aig.mkXor(a[i], b[i]);
+        sum[i] = m_aig.mkXor(half, carry);
+        carry = m_aig.mkOr(m_aig.mkAnd(a[i], b[i]), m_aig.mkAnd(half, carry));
+    }
+    return carry;
+}
+
+void AigBitvectors::negate(const Bits &a, Bits &result)
+{
+    Bits inverted(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        inverted[i] = aigNot(a[i]);
+    }
+    Bits zeros(a.size(), AigFalse);
+    add(inverted, zeros, AigTrue, result);
+}
+
+void AigBitvectors::multiply(const Bits &a, const Bits &b, Bits &product)
+{
+    size_t w = a.size();
+    product.assign(w, AigFalse);
+    Bits partial(w);
+    Bits sum;
+    for (size_t i = 0; i < w; ++i) {
+        if (b[i] == AigFalse) {
+            continue;
+        }
+        for (size_t j = 0; j < w; ++j) {
+            partial[j] = j < i ? AigFalse : m_aig.mkAnd(a[j - i], b[i]);
+        }
+        add(product, partial, AigFalse, sum);
+        product.swap(sum);
+    }
+}
+
+void AigBitvectors::divide(const Bits &a, const Bits &b, Bits &quotient, Bits &remainder)
+{
+    size_t w = a.size();
+    quotient.assign(w, AigFalse);
+
+    // one extra bit: after shifting, the partial remainder is below 2 * b
+    Bits rem(w + 1, AigFalse);
+    Bits invertedB(w + 1, AigTrue);
+    for (size_t i = 0; i < w; ++i) {
+        invertedB[i] = aigNot(b[i]);
+    }
+    Bits shifted(w + 1);
+    Bits difference;
+    for (size_t k = w; k-- > 0;) {
+        shifted[0] = a[k];
+        for (size_t i = 1; i <= w; ++i) {
+            shifted[i] = rem[i - 1];
+        }
+        // no borrow means shifted >= b
+        AigLit fits = add(shifted, invertedB, AigTrue, difference);
+        quotient[k] = fits;
+        select(fits, difference, shifted, rem);
+    }
+    remainder.assign(rem.begin(), rem.begin() + w);
+}
+
+AigLit AigBitvectors::absolute(const Bits &a, Bits &result)
+{
+    Bits negated;
+    negate(a, negated);
+    select(a.back(), negated, a, result);
+    return a.back();
+}
+
+void AigBitvectors::select(AigLit cond, const Bits &a, const Bits &b, Bits &result)
+{
+    Bits selected(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        selected[i] = m_aig.mkMux(cond, a[i], b[i]);
+    }
+    // a or b may alias result
+    result.swap(selected);
+}
+
+void AigBitvectors::shift(const Bits &a, const Bits &b, bool left, AigLit fill, Bits &result)
+{
+    size_t w = a.size();
+    result = a;
+    Bits shifted(w);
+    AigLit outOfRange = AigFalse;
+    for (size_t k = 0; k < b.size(); ++k) {
+        if (k >= 8 * sizeof(size_t) - 1 || (static_cast<size_t>(1) << k) >= w) {
+            // shifting by this bit alone moves everything out
+            outOfRange = m_aig.mkOr(outOfRange, b[k]);
+            continue;
+        }
+        size_t amount = static_cast<size_t>(1) << k;
+        for (size_t i = 0; i < w; ++i) {
+            if (left) {
+                shifted[i] = i >= amount ? result[i - amount] : fill;
+            } else {
+                shifted[i] = i + amount < w ? result[i + amount] : fill;
+            }
+        }
+        select(b[k], shifted, result, result);
+    }
+    Bits filled(w, fill);
+    select(outOfRange, filled, result, result);
+}
+
+AigLit AigBitvectors::equal(const Bits &a, const Bits &b)
+{
+    AigLit result = AigTrue;
+    for (size_t i = 0; i < a.size(); ++i) {
+        result = m_aig.mkAnd(result, m_aig.mkIff(a[i], b[i]));
+    }
+    return result;
+}
+
+AigLit AigBitvectors::lessUnsigned(const Bits &a, const Bits &b)
+{
+    // a < b iff a - b borrows, i.e. a + ~b + 1 has no carry out
+    AigLit carry = AigTrue;
+    for (size_t i = 0; i < a.size(); ++i) {
+        AigLit nb = aigNot(b[i]);
+        carry = m_aig.mkOr(m_aig.mkAnd(a[i], nb), m_aig.mkAnd(m_aig.mkXor(a[i], nb), carry));
+    }
+    return aigNot(carry);
+}
+
+AigLit AigBitvectors::lessSigned(const Bits &a, const Bits &b)
+{
+    // flipping the sign bits maps signed order onto unsigned order
+    Bits flippedA(a);
+    Bits flippedB(b);
+    flippedA.back() = aigNot(flippedA.back());
+    flippedB.back() = aigNot(flippedB.back());
+    return lessUnsigned(flippedA, flippedB);
+}
+
+AigLit AigBitvectors::allEqual(const Bits &a, size_t from, AigLit value)
+{
+    AigLit result = AigTrue;
+    for (size_t i = from; i < a.size(); ++i) {
+        result = m_aig.mkAnd(result, m_aig.mkIff(a[i], value));
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,113 @@
+#ifndef SMT_AIG_BITVECTORS_H
+#define SMT_AIG_BITVECTORS_H
+
+#include "Common.h"
+
+#include <llbmc/Util/Bitvector.h>
+
+namespace SMT
+{
+
+/// \brief Bit-blasts the theory of bitvectors into an Aig
+///
+/// Arithmetic uses ripple-carry adders, shift-and-add multipliers,
+/// restoring division and barrel shifters. Division by zero follows
+/// SMT-LIB: the quotient is all ones and the remainder the dividend.
+class AigBitvectors : public TheoryOfBitvectors
+{
+public:
+    AigBitvectors(Aig &aig)
+      : m_aig(aig)
+    {}
+
+    BVExp *bitvector(unsigned int width, const std::string &name);
+    BVExp *copy(BVExp *exp);
+    BVExp *bool2bv1(BoolExp *exp);
+    BoolExp *bv12bool(BVExp *exp);
+    BoolExp *eq(BVExp *exp1, BVExp *exp2);
+    BVExp *concat(BVExp *exp1, BVExp *exp2);
+    BVExp *extract(unsigned int i, unsigned int j, BVExp *exp);
+    BVExp *bvnot(BVExp *exp);
+    BVExp *bvneg(BVExp *exp);
+    BVExp *bvand(BVExp *exp1, BVExp *exp2);
+    BVExp *bvor(BVExp *exp1, BVExp *exp2);
+    BVExp *bvadd(BVExp *exp1, BVExp *exp2);
+    BVExp *bvmul(BVExp *exp1, BVExp *exp2);
+    BVExp *bvudiv(BVExp *exp1, BVExp *exp2);
+    BVExp *bvurem(BVExp *exp1, BVExp *exp2);
+    BVExp *bvshl(BVExp *exp1, BVExp *exp2);
+    BVExp *bvlshr(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvult(BVExp *exp1, BVExp *exp2);
+    BVExp *bv2bv(const Bitvector *bv);
+    BVExp *bvzeros(unsigned int width);
+    BVExp *bvones(unsigned int width);
+    BVExp *uext(BVExp *exp, unsigned int newWidth);
+    BVExp *sext(BVExp *exp, unsigned int newWidth);
+    BoolExp *bvne(BVExp *exp1, BVExp *exp2);
+    BVExp *bvxor(BVExp *exp1, BVExp *exp2);
+    BVExp *bvimplies(BVExp *exp1, BVExp *exp2);
+    BVExp *bvcond(BoolExp *cond, BVExp *exp1, BVExp *exp2);
+    BVExp *bvsub(BVExp *exp1, BVExp *exp2);
+    BVExp *bvsdiv(BVExp *exp1, BVExp *exp2);
+    BVExp *bvsrem(BVExp *exp1, BVExp *exp2);
+    BVExp *bvashr(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvuaddo(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvusubo(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvumulo(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvsaddo(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvssubo(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvsmulo(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvsdivo(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvule(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvugt(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvuge(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvslt(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvsle(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvsgt(BVExp *exp1, BVExp *exp2);
+    BoolExp *bvsge(BVExp *exp1, BVExp *exp2);
+
+    void release(BVExp *exp);
+
+    unsigned int width(BVExp *exp);
+
+private:
+    AigBitvectors(const AigBitvectors&);
+    AigBitvectors &operator=(const AigBitvectors&);
+
+    typedef std::vector<AigLit> Bits;
+
+    /// \brief New word taking over \a bits
+    BVExp *make(Bits &bits);
+
+    static const Bits &bits(BVExp *exp);
+
+    /// \brief a + b + carry, returns the carry out
+    AigLit add(const Bits &a, const Bits &b, AigLit carry, Bits &sum);
+
+    void negate(const Bits &a, Bits &result);
+
+    void multiply(const Bits &a, const Bits &b, Bits &product);
+
+    void divide(const Bits &a, const Bits &b, Bits &quotient, Bits &remainder);
+
+    /// \brief |a| and the sign of a
+    AigLit absolute(const Bits &a, Bits &result);
+
+    void select(AigLit cond, const Bits &a, const Bits &b, Bits &result);
+
+    /// \brief Shift by b, left or right, filling with \a fill
+    void shift(const Bits &a, const Bits &b, bool left, AigLit fill, Bits &result);
+
+    AigLit equal(const Bits &a, const Bits &b);
+    AigLit lessUnsigned(const Bits &a, const Bits &b);
+    AigLit lessSigned(const Bits &a, const Bits &b);
+
+    /// \brief True iff bits [from, end) of a are all equal to \a value
+    AigLit allEqual(const Bits &a, size_t from, AigLit value);
+
+    Aig &m_aig;
+};
+
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef SMT_AIG_COMMON_H
+#define SMT_AIG_COMMON_H
+
+#include "Aig.h"
+
+#include <llbmc/SMT/SatCore.h>
+#include <llbmc/SMT/TheoryOfBitvectors.h>
+
+#include <stdint.h>
+#include <vector>
+
+namespace SMT
+{
+
+/// \brief Bit-blasted bitvector, least significant bit first
+///
+/// BVExps handed out by the AIG solver point to reference counted words,
+/// BoolExps are the AIG edges themselves (offset by one so that the
+/// constant false is not a null pointer).
+struct AigWord
+{
+    unsigned int refs;
+    std::vector<AigLit> bits;
+};
+
+static inline AigLit toAig(BoolExp *exp)
+{
+    return static_cast<AigLit>(reinterpret_cast<uintptr_t>(exp) - 1);
+}
+
+static inline BoolExp *toBoolExp(AigLit lit)
+{
+    return reinterpret_cast<BoolExp*>(static_cast<uintptr_t>(lit) + 1);
+}
+
+static inline AigWord *toAig(BVExp *exp)
+{
+    return reinterpret_cast<AigWord*>(exp);
+}
+
+static inline BVExp *toBVExp(AigWord *word)
+{
+    return reinterpret_cast<BVExp*>(word);
+}
+
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef SMT_AIG_SAT_H
+#define SMT_AIG_SAT_H
+
+#include "Common.h"
+
+namespace SMT
+{
+
+/// \brief Propositional connectives as AIG edges
+///
+/// Edges need no reference counting, copy and release do nothing.
+class AigSatCore : public SatCore
+{
+public:
+    AigSatCore(Aig &aig)
+      : m_aig(aig)
+    {}
+
+    BoolExp *mk_free(const std::string &name)
+    {
+        return toBoolExp(m_aig.mkInput(name, 0));
+    }
+
+    BoolExp *mk_true()
+    {
+        return toBoolExp(AigTrue);
+    }
+
+    BoolExp *mk_false()
+    {
+        return toBoolExp(AigFalse);
+    }
+
+    BoolExp *mk_not(BoolExp *exp)
+    {
+        return toBoolExp(aigNot(toAig(exp)));
+    }
+
+    BoolExp *mk_and(BoolExp *exp1, BoolExp *exp2)
+    {
+        return toBoolExp(m_aig.mkAnd(toAig(exp1), toAig(exp2)));
+    }
+
+    BoolExp *mk_or(BoolExp *exp1, BoolExp *exp2)
+    {
+        return toBoolExp(m_aig.mkOr(toAig(exp1), toAig(exp2)));
+    }
+
+    BoolExp *mk_xor(BoolExp *exp1, BoolExp *exp2)
+    {
+        return toBoolExp(m_aig.mkXor(toAig(exp1), toAig(exp2)));
+    }
+
+    BoolExp *mk_implies(BoolExp *exp1, BoolExp *exp2)
+    {
+        return toBoolExp(m_aig.mkOr(aigNot(toAig(exp1)), toAig(exp2)));
+    }
+
+    BoolExp *mk_iff(BoolExp *exp1, BoolExp *exp2)
+    {
+        return toBoolExp(m_aig.mkIff(toAig(exp1), toAig(exp2)));
+    }
+
+    BoolExp *mk_cond(BoolExp *cond, BoolExp *exp1, BoolExp *exp2)
+    {
+        return toBoolExp(m_aig.mkMux(toAig(cond), toAig(exp1), toAig(exp2)));
+    }
+
+    BoolExp *copy(BoolExp *exp)
+    {
+        return exp;
+    }
+
+    void release(BoolExp *)
+    {}
+
+private:
+    AigSatCore(const AigSatCore&);
+    AigSatCore &operator=(const AigSatCore&);
+
+    Aig &m_aig;
+};
+
+}
+
+#endif
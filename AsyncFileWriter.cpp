@@ -0,0 +1,104 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "AsyncFileWriter.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+
+AsyncFileWriter::AsyncFileWriter(const std::string &path, size_t bufferSize)
+        : m_path(path), m_file(NULL), m_bufferSize(bufferSize), m_pending(false), m_closing(false),
+          m_failed(false) {
+    m_file = fopen(path.c_str(), "wb");
+    if (m_file == NULL) {
+        throw LLBMCException("Cannot create " + path);
+    }
+    // whole buffers are written at once, stdio buffering would only copy them
+    setvbuf(m_file, NULL, _IONBF, 0);
+    m_filling.reserve(bufferSize);
+    m_draining.reserve(bufferSize);
+    m_thread = std::thread(&AsyncFileWriter::drain, this);
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    if (m_file != NULL) {
+        try {
+            close();
+        } catch (const LLBMCException &) {
+        }
+    }
+}
+
+void AsyncFileWriter::write(const char *data, size_t size) {
+    m_filling.insert(m_filling.end(), data, data + size);
+    if (m_filling.size() >= m_bufferSize) {
+        handOff();
+    }
+}
+
+void AsyncFileWriter::write(const std::string &text) {
+    write(text.data(), text.size());
+}
+
+void AsyncFileWriter::write(char c) {
+    m_filling.push_back(c);
+    if (m_filling.size() >= m_bufferSize) {
+        handOff();
+    }
+}
+
+void AsyncFileWriter::close() {
+    if (m_file == NULL) {
+        return;
+    }
+    handOff();
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_closing = true;
+    }
+    m_changed.notify_all();
+    m_thread.join();
+
+    bool failed = m_failed;
+    if (fclose(m_file) != 0) {
+        failed = true;
+    }
+    m_file = NULL;
+    if (failed) {
+        throw LLBMCException("Cannot write " + m_path);
+    }
+}
+
+void AsyncFileWriter::handOff() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_pending) {
+        m_changed.wait(lock);
+    }
+    m_filling.swap(m_draining);
+    m_filling.clear();
+    m_pending = true;
+    lock.unlock();
+    m_changed.notify_all();
+}
+
+void AsyncFileWriter::drain() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        while (!m_pending && !m_closing) {
+            m_changed.wait(lock);
+        }
+        if (!m_pending) {
+            return;
+        }
+        lock.unlock();
+        // nobody touches m_draining while it is pending
+        bool written = m_draining.empty() || fwrite(&m_draining[0], 1, m_draining.size(), m_file) == m_draining.size();
+        lock.lock();
+        if (!written) {
+            m_failed = true;
+        }
+        m_pending = false;
+        m_changed.notify_all();
+    }
+}
@@ -0,0 +1,66 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_ASYNCFILEWRITER_H
+#define TRANSFORMERSOLVER_ASYNCFILEWRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/*
+ * Writes a file through two large buffers: the caller fills one while a
+ * background thread writes the other, so formatting and disk I/O
+ * overlap. The caller only waits if it fills a buffer before the previous
+ * one is on disk.
+ */
+class AsyncFileWriter {
+public:
+    /* throws LLBMCException if the file cannot be created */
+    explicit AsyncFileWriter(const std::string &path, size_t bufferSize = 4 << 20);
+
+    /* closes the writer if close() was not called, errors are lost then */
+    ~AsyncFileWriter();
+
+    void write(const char *data, size_t size);
+
+    void write(const std::string &text);
+
+    void write(char c);
+
+    /* writes what is buffered and closes the file, throws LLBMCException on I/O errors */
+    void close();
+
+private:
+    AsyncFileWriter(const AsyncFileWriter &);
+    AsyncFileWriter &operator=(const AsyncFileWriter &);
+
+    /* hands the filled buffer to the background thread */
+    void handOff();
+
+    /* the background thread */
+    void drain();
+
+    std::string m_path;
+    FILE *m_file;
+    size_t m_bufferSize;
+    std::vector<char> m_filling;
+    std::vector<char> m_draining;
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    /* m_draining holds data not written yet */
+    bool m_pending;
+    bool m_closing;
+    bool m_failed;
+    std::thread m_thread;
+};
+
+
+#endif //TRANSFORMERSOLVER_ASYNCFILEWRITER_H
@@ -0,0 +1,236 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "BatchRunner.h"
+#include "SolverPool.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+
+void BatchRunner::Deque::push(Query &query) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queries.push_back(Query());
+    std::swap(m_queries.back(), query);
+}
+
+bool BatchRunner::Deque::pop(Query &query) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_queries.empty()) {
+        return false;
+    }
+    std::swap(query, m_queries.back());
+    m_queries.pop_back();
+    return true;
+}
+
+bool BatchRunner::Deque::steal(Query &query) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_queries.empty()) {
+        return false;
+    }
+    std::swap(query, m_queries.front());
+    m_queries.pop_front();
+    return true;
+}
+
+BatchRunner::BatchRunner(QueryFormat &format, Solver::SMTSolver backend, unsigned int workers, std::ostream &out)
+        : m_format(format), m_backend(backend), m_workerCount(std::max(workers, 1u)), m_out(out), m_nextDeque(0),
+          m_queued(0), m_inputDone(false) {
+    for (unsigned int i = 0; i < m_workerCount; ++i) {
+        m_deques.push_back(new Deque());
+    }
+}
+
+BatchRunner::~BatchRunner() {
+    for (std::vector<Deque *>::iterator it = m_deques.begin(); it != m_deques.end(); ++it) {
+        delete *it;
+    }
+}
+
+void BatchRunner::addFormat(const std::string &extension, QueryFormat &format) {
+    m_extensionFormats.push_back(std::make_pair(extension, &format));
+}
+
+void BatchRunner::runDirectory(const std::string &directory) {
+    DIR *dir = opendir(directory.c_str());
+    if (dir == NULL) {
+        throw LLBMCException("Cannot open directory " + directory);
+    }
+    std::vector<std::string> names;
+    while (dirent *entry = readdir(dir)) {
+        std::string path = directory + "/" + entry->d_name;
+        struct stat info;
+        if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    start();
+    for (std::vector<std::string>::iterator it = names.begin(); it != names.end(); ++it) {
+        Query query;
+        query.name = *it;
+        query.payload = directory + "/" + *it;
+        query.isFile = true;
+        query.format = &m_format;
+        for (size_t i = 0; i < m_extensionFormats.size(); ++i) {
+            const std::string &extension = m_extensionFormats[i].first;
+            if (it->size() > extension.size()
+                && it->compare(it->size() - extension.size(), extension.size(), extension) == 0) {
+                query.format = m_extensionFormats[i].second;
+                break;
+            }
+        }
+        add(query);
+    }
+    finish();
+}
+
+void BatchRunner::runStream(std::istream &in) {
+    start();
+    std::string line;
+    unsigned long number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        if (line.empty()) {
+            continue;
+        }
+        Query query;
+        std::ostringstream name;
+        name << number;
+        query.name = name.str();
+        query.payload.swap(line);
+        query.isFile = false;
+        query.format = &m_format;
+        add(query);
+    }
+    finish();
+}
+
+void BatchRunner::start() {
+    m_inputDone = false;
+    m_queued = 0;
+    for (unsigned int i = 0; i < m_workerCount; ++i) {
+        m_workers.push_back(std::thread(&BatchRunner::work, this, i));
+    }
+}
+
+void BatchRunner::add(Query &query) {
+    m_deques[m_nextDeque]->push(query);
+    m_nextDeque = (m_nextDeque + 1) % m_workerCount;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_queued;
+    }
+    m_available.notify_one();
+}
+
+void BatchRunner::finish() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_inputDone = true;
+    }
+    m_available.notify_all();
+    for (std::vector<std::thread>::iterator it = m_workers.begin(); it != m_workers.end(); ++it) {
+        it->join();
+    }
+    m_workers.clear();
+}
+
+bool BatchRunner::take(unsigned int worker, Query &query) {
+    for (;;) {
+        bool found = m_deques[worker]->pop(query);
+        for (unsigned int i = 1; !found && i < m_workerCount; ++i) {
+            found = m_deques[(worker + i) % m_workerCount]->steal(query);
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (found) {
+            --m_queued;
+            return true;
+        }
+        if (m_inputDone && m_queued == 0) {
+            return false;
+        }
+        // queued work may sit in a deque this worker has already looked at, look again then
+        if (m_queued == 0) {
+            m_available.wait(lock, [this] { return m_inputDone || m_queued > 0; });
+        }
+    }
+}
+
+void BatchRunner::work(unsigned int worker) {
+    SolverPool::Instance *instance = NULL;
+    Query query;
+    while (take(worker, query)) {
+        std::ostringstream record;
+        record << query.name << " ";
+        try {
+            if (query.isFile) {
+                std::ifstream file(query.payload.c_str(), std::ios::in | std::ios::binary);
+                if (!file) {
+                    throw LLBMCException("cannot read " + query.payload);
+                }
+                std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                query.payload.swap(contents);
+            }
+
+            if (instance == NULL) {
+                instance = SolverPool::create(m_backend);
+            }
+            if (instance->reusable) {
+                instance->solver->push();
+            }
+            query.format->assertQuery(query.payload.data(), query.payload.size(), *instance->translator, *instance->solver);
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            instance->solver->solve();
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            record << Solver::getResultName(instance->solver->getResult()) << " "
+                   << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+            if (!SolverPool::reset(instance)) {
+                SolverPool::destroy(instance);
+                instance = NULL;
+            }
+        } catch (const LLBMCException &e) {
+            record << "error " << e.getMessage();
+            // the solver may be left inside a push, start over with a new one
+            if (instance != NULL) {
+                SolverPool::destroy(instance);
+                instance = NULL;
+            }
+        } catch (const std::exception &e) {
+            // e.g. bad_alloc from a huge query, nothing may escape the worker thread
+            record << "error " << e.what();
+            if (instance != NULL) {
+                SolverPool::destroy(instance);
+                instance = NULL;
+            }
+        }
+        report(record.str());
+    }
+
+    if (instance != NULL) {
+        SolverPool::destroy(instance);
+    }
+}
+
+void BatchRunner::report(const std::string &record) {
+    std::lock_guard<std::mutex> lock(m_outMutex);
+    m_out << record << "\n";
+    m_out.flush();
+}
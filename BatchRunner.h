@@ -0,0 +1,108 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_BATCHRUNNER_H
+#define TRANSFORMERSOLVER_BATCHRUNNER_H
+
+#include "QueryFormat.h"
+#include "Solver.h"
+
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+/*
+ * Solves many queries on a fixed number of worker threads. Every worker
+ * owns one solver instance (reused through push/pop where the backend has
+ * it) and a deque of queries: it takes work from the back of its own deque
+ * and, when that runs dry, steals from the front of the others. Queries
+ * are dealt round-robin as they are read, so a stream can be processed
+ * while it is still being read.
+ *
+ * One record is written per query as soon as it is done:
+ *
+ *   <name> <result> <solve microseconds>
+ *
+ * or "<name> error <message>".
+ */
+class BatchRunner {
+public:
+    BatchRunner(QueryFormat &format, Solver::SMTSolver backend, unsigned int workers, std::ostream &out);
+
+    ~BatchRunner();
+
+    /* files whose name ends in extension (e.g. ".smt2") are read with format instead of the default one */
+    void addFormat(const std::string &extension, QueryFormat &format);
+
+    /* every regular file in directory is one query, named by its file name */
+    void runDirectory(const std::string &directory);
+
+    /* every line of in is one query, named by its line number */
+    void runStream(std::istream &in);
+
+private:
+    BatchRunner(const BatchRunner &);
+    BatchRunner &operator=(const BatchRunner &);
+
+    struct Query {
+        std::string name;
+        /* the query itself, or the file to read it from */
+        std::string payload;
+        bool isFile;
+        QueryFormat *format;
+    };
+
+    /* Work-stealing deque: the owner works at the back, thieves at the front. */
+    class Deque {
+    public:
+        void push(Query &query);
+
+        bool pop(Query &query);
+
+        bool steal(Query &query);
+
+    private:
+        std::mutex m_mutex;
+        std::deque<Query> m_queries;
+    };
+
+    void start();
+
+    void add(Query &query);
+
+    void finish();
+
+    bool take(unsigned int worker, Query &query);
+
+    void work(unsigned int worker);
+
+    void report(const std::string &record);
+
+    QueryFormat &m_format;
+    std::vector<std::pair<std::string, QueryFormat *> > m_extensionFormats;
+    Solver::SMTSolver m_backend;
+    unsigned int m_workerCount;
+    std::ostream &m_out;
+
+    std::vector<Deque *> m_deques;
+    std::vector<std::thread> m_workers;
+    unsigned int m_nextDeque;
+
+    std::mutex m_mutex;
+    std::condition_variable m_available;
+    size_t m_queued;
+    bool m_inputDone;
+
+    std::mutex m_outMutex;
+};
+
+
+#endif //TRANSFORMERSOLVER_BATCHRUNNER_H
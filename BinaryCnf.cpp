@@ -0,0 +1,237 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "BinaryCnf.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+    const size_t BufferSize = 1 << 20;
+
+    /* maps a literal to 2 * variable + sign, so sorting groups a variable's literals */
+    uint64_t encodeLiteral(int literal) {
+        return literal < 0 ? 2 * static_cast<uint64_t>(-static_cast<int64_t>(literal)) + 1
+                           : 2 * static_cast<uint64_t>(literal);
+    }
+
+    /* code >> 1 must be a variable of the file, the header check bounds those by INT_MAX */
+    int decodeLiteral(uint64_t code) {
+        int variable = static_cast<int>(code >> 1);
+        return (code & 1) ? -variable : variable;
+    }
+}
+
+const char BinaryCnf::Magic[8] = {'T', 'S', 'B', 'I', 'N', 'C', 'N', 'F'};
+
+BinaryCnf::BinaryCnf(const std::string &path) : m_path(path), m_data(NULL), m_size(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw LLBMCException("Cannot open " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        close(fd);
+        throw LLBMCException("Not a binary CNF: " + path);
+    }
+    m_size = static_cast<size_t>(info.st_size);
+    void *data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw LLBMCException("Cannot map " + path);
+    }
+    m_data = static_cast<const unsigned char *>(data);
+    // clauses are mostly read front to back
+    madvise(data, m_size, MADV_SEQUENTIAL);
+
+    memcpy(&m_header, m_data, sizeof(Header));
+    if (memcmp(m_header.magic, Magic, sizeof(Magic)) != 0 || m_header.version != Version
+        || m_header.indexOffset < sizeof(Header) || m_header.indexOffset > m_size
+        || m_header.clauses > (m_size - m_header.indexOffset) / sizeof(uint64_t)
+        // literals are ints, and replay() adds every variable, so a tiny file must not declare billions
+        || m_header.variables > static_cast<uint64_t>(INT_MAX) || m_header.variables > m_size) {
+        munmap(data, m_size);
+        throw LLBMCException("Not a binary CNF: " + path);
+    }
+}
+
+BinaryCnf::~BinaryCnf() {
+    munmap(const_cast<unsigned char *>(m_data), m_size);
+}
+
+uint64_t BinaryCnf::getVariableCount() const {
+    return m_header.variables;
+}
+
+uint64_t BinaryCnf::getClauseCount() const {
+    return m_header.clauses;
+}
+
+void BinaryCnf::getClause(uint64_t index, std::vector<int> &literals) const {
+    if (index >= m_header.clauses) {
+        throw LLBMCException("Clause index out of range in " + m_path);
+    }
+    uint64_t offset;
+    memcpy(&offset, m_data + m_header.indexOffset + index * sizeof(uint64_t), sizeof(offset));
+    decodeClause(offset, literals);
+}
+
+void BinaryCnf::replay(ClauseSink &sink) const {
+    for (uint64_t i = 0; i < m_header.variables; ++i) {
+        sink.addVariable();
+    }
+    std::vector<int> literals;
+    uint64_t offset = sizeof(Header);
+    for (uint64_t i = 0; i < m_header.clauses; ++i) {
+        offset = decodeClause(offset, literals);
+        sink.addClause(literals);
+    }
+}
+
+uint64_t BinaryCnf::decodeClause(uint64_t offset, std::vector<int> &literals) const {
+    uint64_t size = readVarint(offset);
+    if (size > m_header.indexOffset - offset) {
+        throw LLBMCException("Corrupt clause in " + m_path);
+    }
+    literals.resize(static_cast<size_t>(size));
+    uint64_t code = 0;
+    for (uint64_t i = 0; i < size; ++i) {
+        code += readVarint(offset);
+        if ((code >> 1) == 0 || (code >> 1) > m_header.variables) {
+            throw LLBMCException("Corrupt clause in " + m_path);
+        }
+        literals[i] = decodeLiteral(code);
+    }
+    return offset;
+}
+
+uint64_t BinaryCnf::readVarint(uint64_t &offset) const {
+    uint64_t value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+        if (offset >= m_header.indexOffset) {
+            break;
+        }
+        unsigned char byte = m_data[offset++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw LLBMCException("Corrupt varint in " + m_path);
+}
+
+BinaryCnfWriter::BinaryCnfWriter(const std::string &path)
+        : m_path(path), m_file(NULL), m_buffer(NULL), m_offset(0), m_variables(0) {
+    m_file = fopen(path.c_str(), "wb");
+    if (m_file == NULL) {
+        throw LLBMCException("Cannot create " + path);
+    }
+    m_buffer = new char[BufferSize];
+    setvbuf(m_file, m_buffer, _IOFBF, BufferSize);
+
+    // placeholder, close() writes the real header
+    BinaryCnf::Header header;
+    memset(&header, 0, sizeof(header));
+    write(&header, sizeof(header));
+}
+
+BinaryCnfWriter::~BinaryCnfWriter() {
+    if (m_file != NULL) {
+        try {
+            close();
+        } catch (const LLBMCException &) {
+        }
+    }
+    delete[] m_buffer;
+}
+
+int BinaryCnfWriter::addVariable(const std::string &name, unsigned int bit) {
+    (void) name;
+    (void) bit;
+    return addVariable();
+}
+
+int BinaryCnfWriter::addVariable() {
+    return static_cast<int>(++m_variables);
+}
+
+void BinaryCnfWriter::addClause(const int *literals, size_t size) {
+    m_index.push_back(m_offset);
+
+    m_codes.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        m_codes[i] = encodeLiteral(literals[i]);
+    }
+    std::sort(m_codes.begin(), m_codes.end());
+
+    m_encoded.clear();
+    writeVarint(size);
+    uint64_t previous = 0;
+    for (size_t i = 0; i < size; ++i) {
+        writeVarint(m_codes[i] - previous);
+        previous = m_codes[i];
+    }
+    write(&m_encoded[0], m_encoded.size());
+}
+
+void BinaryCnfWriter::writeVarint(uint64_t value) {
+    while (value >= 0x80) {
+        m_encoded.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    m_encoded.push_back(static_cast<unsigned char>(value));
+}
+
+void BinaryCnfWriter::write(const void *data, size_t size) {
+    if (fwrite(data, 1, size, m_file) != size) {
+        throw LLBMCException("Cannot write " + m_path);
+    }
+    m_offset += size;
+}
+
+void BinaryCnfWriter::close() {
+    if (m_file == NULL) {
+        return;
+    }
+    FILE *file = m_file;
+    try {
+        static const char padding[sizeof(uint64_t)] = {0};
+        size_t misalignment = static_cast<size_t>(m_offset % sizeof(uint64_t));
+        if (misalignment != 0) {
+            write(padding, sizeof(padding) - misalignment);
+        }
+
+        BinaryCnf::Header header;
+        memcpy(header.magic, BinaryCnf::Magic, sizeof(header.magic));
+        header.version = BinaryCnf::Version;
+        header.reserved = 0;
+        header.variables = m_variables;
+        header.clauses = m_index.size();
+        header.indexOffset = m_offset;
+
+        if (!m_index.empty()) {
+            write(&m_index[0], m_index.size() * sizeof(uint64_t));
+        }
+        if (fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1) {
+            throw LLBMCException("Cannot write " + m_path);
+        }
+    } catch (...) {
+        m_file = NULL;
+        fclose(file);
+        throw;
+    }
+    m_file = NULL;
+    if (fclose(file) != 0) {
+        throw LLBMCException("Cannot write " + m_path);
+    }
+}
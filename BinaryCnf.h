@@ -0,0 +1,120 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_BINARYCNF_H
+#define TRANSFORMERSOLVER_BINARYCNF_H
+
+#include "ClauseSink.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+/*
+ * A CNF in a compact binary file that is mapped instead of parsed. The
+ * file is a Header, the clauses, and an index with the file offset of
+ * every clause (8-byte aligned, host byte order like the header). A clause
+ * is its size followed by its literals, sorted by 2 * variable + sign and
+ * stored as deltas of that code, all as LEB128 varints.
+ *
+ * Literals come back sorted, not in the order they were added.
+ */
+class BinaryCnf {
+public:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t variables;
+        uint64_t clauses;
+        uint64_t indexOffset;
+    };
+
+    enum {
+        Version = 1
+    };
+
+    static const char Magic[8];
+
+    /*
+     * maps the file at path, throws LLBMCException if it is not a valid binary
+     * CNF; that includes more variables than INT_MAX or than the file has bytes
+     */
+    explicit BinaryCnf(const std::string &path);
+
+    ~BinaryCnf();
+
+    uint64_t getVariableCount() const;
+
+    uint64_t getClauseCount() const;
+
+    /* the literals of clause index */
+    void getClause(uint64_t index, std::vector<int> &literals) const;
+
+    /* adds all variables, then all clauses to sink */
+    void replay(ClauseSink &sink) const;
+
+private:
+    BinaryCnf(const BinaryCnf &);
+    BinaryCnf &operator=(const BinaryCnf &);
+
+    /* decodes the clause at offset and returns the offset behind it */
+    uint64_t decodeClause(uint64_t offset, std::vector<int> &literals) const;
+
+    uint64_t readVarint(uint64_t &offset) const;
+
+    std::string m_path;
+    const unsigned char *m_data;
+    size_t m_size;
+    Header m_header;
+};
+
+/*
+ * Writes a BinaryCnf while the clauses are produced. The index is kept in
+ * memory (8 bytes per clause) and appended by close(), which also writes
+ * the final header. Variable names are not stored; use a CnfWriter for a
+ * variable map.
+ */
+class BinaryCnfWriter : public ClauseSink {
+public:
+    /* throws LLBMCException if the file cannot be created */
+    explicit BinaryCnfWriter(const std::string &path);
+
+    /* closes the writer if close() was not called, errors are lost then */
+    ~BinaryCnfWriter();
+
+    using ClauseSink::addClause;
+
+    int addVariable(const std::string &name, unsigned int bit);
+
+    int addVariable();
+
+    void addClause(const int *literals, size_t size);
+
+    /* throws LLBMCException on I/O errors */
+    void close();
+
+private:
+    BinaryCnfWriter(const BinaryCnfWriter &);
+    BinaryCnfWriter &operator=(const BinaryCnfWriter &);
+
+    void writeVarint(uint64_t value);
+
+    void write(const void *data, size_t size);
+
+    std::string m_path;
+    FILE *m_file;
+    char *m_buffer;
+    uint64_t m_offset;
+    uint64_t m_variables;
+    std::vector<uint64_t> m_index;
+    std::vector<uint64_t> m_codes;
+    std::vector<unsigned char> m_encoded;
+};
+
+
+#endif //TRANSFORMERSOLVER_BINARYCNF_H
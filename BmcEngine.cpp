@@ -0,0 +1,98 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "BmcEngine.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+
+BmcEngine::BmcEngine(const TransitionSystem &system, SMTTranslator &translator, SMT::Solver &solver, Mode mode)
+        : m_system(system), m_translator(translator), m_solver(solver), m_sat(*solver.getSatCore()), m_mode(mode),
+          m_assume(solver.hasCapability(SMT::Solver::CapAssume)), m_depth(0) {
+    if (!m_assume && !solver.hasCapability(SMT::Solver::CapPushPop)) {
+        throw LLBMCException("BMC needs a solver with assume or push/pop!");
+    }
+    m_solver.enableIncrementalSolving();
+
+    addFrame();
+    if (m_mode == BaseCase) {
+        SMT::BoolExp *init = m_system.init(m_translator, m_sat, m_frames[0]);
+        m_solver.assertConstraint(init);
+        m_sat.release(init);
+    }
+}
+
+BmcEngine::~BmcEngine() {
+    for (std::vector<TransitionSystem::State>::iterator it = m_frames.begin(); it != m_frames.end(); ++it) {
+        TransitionSystem::releaseFrame(m_solver, *it);
+    }
+}
+
+SMT::Solver::Result BmcEngine::checkNext() {
+    unsigned int k = m_depth;
+    while (m_frames.size() <= k) {
+        addFrame();
+    }
+
+    SMT::BoolExp *bad = m_system.bad(m_translator, m_sat, m_frames[k]);
+    SMT::Solver::Result result = solveUnder(bad);
+
+    bool next = result == SMT::Solver::Unsatisfiable || (m_mode == StepCase && result == SMT::Solver::Satisfiable);
+    if (next) {
+        SMT::BoolExp *notBad = m_sat.mk_not(bad);
+        m_solver.assertConstraint(notBad);
+        m_sat.release(notBad);
+        ++m_depth;
+    }
+    m_sat.release(bad);
+    return result;
+}
+
+BmcEngine::Result BmcEngine::check(unsigned int maxDepth) {
+    while (m_depth <= maxDepth) {
+        switch (checkNext()) {
+            case SMT::Solver::Satisfiable:
+                return Unsafe;
+            case SMT::Solver::Unsatisfiable:
+                break;
+            default:
+                return Unknown;
+        }
+    }
+    return Safe;
+}
+
+unsigned int BmcEngine::getDepth() const {
+    return m_depth;
+}
+
+const TransitionSystem::State &BmcEngine::getFrame(unsigned int k) const {
+    return m_frames.at(k);
+}
+
+void BmcEngine::addFrame() {
+    m_frames.push_back(m_system.frame(m_translator, static_cast<unsigned int>(m_frames.size())));
+    if (m_frames.size() > 1) {
+        const TransitionSystem::State &current = m_frames[m_frames.size() - 2];
+        SMT::BoolExp *trans = m_system.trans(m_translator, m_sat, current, m_frames.back());
+        m_solver.assertConstraint(trans);
+        m_sat.release(trans);
+    }
+}
+
+SMT::Solver::Result BmcEngine::solveUnder(SMT::BoolExp *exp) {
+    if (m_assume) {
+        m_solver.assume(exp);
+        m_solver.solve();
+        return m_solver.getResult();
+    }
+
+    m_solver.push();
+    m_solver.assertConstraint(exp);
+    m_solver.solve();
+    SMT::Solver::Result result = m_solver.getResult();
+    // the model of a counterexample is lost by pop
+    m_solver.pop();
+    return result;
+}
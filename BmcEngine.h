@@ -0,0 +1,80 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_BMCENGINE_H
+#define TRANSFORMERSOLVER_BMCENGINE_H
+
+#include "TransitionSystem.h"
+
+#include <vector>
+
+
+/*
+ * Incremental bounded model checking on one solver instance. The unrolling
+ * init(0) and trans(0, 1) ... trans(k-1, k) stays asserted, each depth adds
+ * one transition and checks bad(k) under an assumption (or inside a
+ * push/pop pair if the solver has no assume). After depth k turned out safe,
+ * not bad(k) is asserted as well, which is sound and prunes later queries.
+ *
+ * In StepCase mode init is left out and not bad(k) is asserted after every
+ * depth, whatever the answer was. Unsatisfiable at depth k then means that
+ * k good states in a row are always followed by a good one, i.e. the
+ * inductive step of k-induction holds.
+ */
+class BmcEngine {
+public:
+    enum Result {
+        Unsafe,
+        Safe,
+        Unknown
+    };
+
+    enum Mode {
+        BaseCase,
+        StepCase
+    };
+
+    BmcEngine(const TransitionSystem &system, SMTTranslator &translator, SMT::Solver &solver, Mode mode = BaseCase);
+
+    ~BmcEngine();
+
+    /*
+     * Checks the next depth. In BaseCase mode Satisfiable means a bad state
+     * is reachable in exactly that many steps, the unrolling then stays at
+     * that depth.
+     */
+    SMT::Solver::Result checkNext();
+
+    /* Checks all depths up to maxDepth, continuing where the last call stopped. */
+    Result check(unsigned int maxDepth);
+
+    /*
+     * number of depths done, i.e. found safe (BaseCase) or assumed good
+     * for the following depths (StepCase)
+     */
+    unsigned int getDepth() const;
+
+    /* frame k of the unrolling, e.g. to read a counterexample from the model */
+    const TransitionSystem::State &getFrame(unsigned int k) const;
+
+private:
+    BmcEngine(const BmcEngine &);
+    BmcEngine &operator=(const BmcEngine &);
+
+    void addFrame();
+
+    SMT::Solver::Result solveUnder(SMT::BoolExp *exp);
+
+    const TransitionSystem &m_system;
+    SMTTranslator &m_translator;
+    SMT::Solver &m_solver;
+    SMT::SatCore &m_sat;
+    Mode m_mode;
+    bool m_assume;
+    std::vector<TransitionSystem::State> m_frames;
+    unsigned int m_depth;
+};
+
+
+#endif //TRANSFORMERSOLVER_BMCENGINE_H
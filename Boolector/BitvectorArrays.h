@@ -2,6 +2,7 @@
 #define SMT_BOOLECTOR_BITVECTOR_ARRAYS_H
 
 #include "Common.h"
+#include "Sorts.h"
 
 #include <llbmc/Util/LLBMCException.h>
 
@@ -11,16 +12,14 @@ namespace SMT
 class BoolectorBVArrays : public BitvectorTheoryOfArrays
 {
 public:
-    BoolectorBVArrays(Btor *btor)
-      : m_btor(btor)
+    BoolectorBVArrays(Btor *btor, BoolectorSorts &sorts)
+      : m_btor(btor),
+        m_sorts(sorts)
     {}
 
     AExp *array(unsigned int indexWidth, unsigned int elementWidth, const std::string &name)
     {
-        BoolectorSort arraySort = boolector_array_sort(m_btor,
-            boolector_bitvec_sort(m_btor, static_cast<int>(indexWidth)),
-            boolector_bitvec_sort(m_btor, static_cast<int>(elementWidth)));
-        return toAExp(boolector_array(m_btor, arraySort, name.c_str()));
+        return toAExp(boolector_array(m_btor, m_sorts.array(indexWidth, elementWidth), name.c_str()));
     }
 
     AExp *copy(AExp* exp)
@@ -73,6 +72,7 @@ private:
     BoolectorBVArrays &operator=(const BoolectorBVArrays&);
 
     Btor *m_btor;
+    BoolectorSorts &m_sorts;
 };
 
 }
@@ -2,6 +2,7 @@
 #define SMT_BOOLECTOR_BITVECTOR_UFS_H
 
 #include "Common.h"
+#include "Sorts.h"
 
 #include <llbmc/SMT/TheoryOfUFs.h>
 
@@ -11,28 +12,14 @@ namespace SMT
 class BoolectorBVUFs : public BitvectorTheoryOfUFs
 {
 public:
-    BoolectorBVUFs(Btor *btor)
-      : m_btor(btor)
+    BoolectorBVUFs(Btor *btor, BoolectorSorts &sorts)
+      : m_btor(btor),
+        m_sorts(sorts)
     {}
 
     UFExp *uf(unsigned int resSize, std::list<unsigned int> &argSizes, const std::string &name)
     {
-        unsigned int num_args = argSizes.size();
-        BoolectorSort *domain = new BoolectorSort[num_args];
-        std::list<unsigned int>::iterator it = argSizes.begin();
-        for (unsigned int i = 0; i < num_args; ++i, ++it) {
-            domain[i] = boolector_bitvec_sort(m_btor, static_cast<int>(*it));
-        }
-        BoolectorSort codomain = boolector_bitvec_sort(m_btor, static_cast<int>(resSize));
-        BoolectorSort sort = boolector_fun_sort(m_btor, domain, static_cast<int>(num_args), codomain);
-        for (unsigned int i = 0; i < num_args; ++i) {
-            boolector_release_sort(m_btor, domain[i]);
-        }
-        boolector_release_sort(m_btor, codomain);
-        delete [] domain;
-        UFExp *res = toUFExp(boolector_uf(m_btor, sort, name.c_str()));
-        boolector_release_sort(m_btor, sort);
-        return res;
+        return toUFExp(boolector_uf(m_btor, m_sorts.fun(argSizes, resSize), name.c_str()));
     }
 
     UFExp *copy(UFExp *exp)
@@ -68,6 +55,7 @@ private:
     BoolectorBVUFs &operator=(const BoolectorBVUFs&);
 
     Btor *m_btor;
+    BoolectorSorts &m_sorts;
 };
 
 }
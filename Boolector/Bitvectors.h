@@ -1,6 +1,8 @@
 #ifndef SMT_BOOLECTOR_BITVECTORS_H
 #define SMT_BOOLECTOR_BITVECTORS_H
 
+#include "Sorts.h"
+
 #include <llbmc/Util/LLBMCException.h>
 
 // round up n to the next power of two (helper for shifts)
@@ -29,14 +31,14 @@ namespace SMT
 class BoolectorBitvectors : public TheoryOfBitvectors
 {
 public:
-    BoolectorBitvectors(Btor *btor)
-      : m_btor(btor)
+    BoolectorBitvectors(Btor *btor, BoolectorSorts &sorts)
+      : m_btor(btor),
+        m_sorts(sorts)
     {}
 
     BVExp *bitvector(unsigned int bvWidth, const std::string &name)
     {
-        BoolectorSort bvSort = boolector_bitvec_sort(m_btor, static_cast<int>(bvWidth));
-        return toBVExp(boolector_var(m_btor, bvSort, name.c_str()));
+        return toBVExp(boolector_var(m_btor, m_sorts.bitvec(bvWidth), name.c_str()));
     }
 
     BVExp *copy(BVExp *exp)
@@ -220,8 +222,7 @@ public:
     {
         unsigned int bvWidth = bv->getWidth();
         if (bvWidth <= 8*sizeof(unsigned int)) {
-            BoolectorSort bvSort = boolector_bitvec_sort(m_btor, static_cast<int>(bvWidth));
-            return toBVExp(boolector_unsigned_int(m_btor, static_cast<unsigned int>(bv->getUnsigned()), bvSort));
+            return toBVExp(boolector_unsigned_int(m_btor, static_cast<unsigned int>(bv->getUnsigned()), m_sorts.bitvec(bvWidth)));
         }
 
         // convert value into 0-1 string
@@ -241,14 +242,12 @@ public:
 
     BVExp *bvzeros(unsigned int bvWidth)
     {
-        BoolectorSort bvSort = boolector_bitvec_sort(m_btor, static_cast<int>(bvWidth));
-        return toBVExp(boolector_zero(m_btor, bvSort));
+        return toBVExp(boolector_zero(m_btor, m_sorts.bitvec(bvWidth)));
     }
 
     BVExp *bvones(unsigned int bvWidth)
     {
-        BoolectorSort bvSort = boolector_bitvec_sort(m_btor, static_cast<int>(bvWidth));
-        return toBVExp(boolector_ones(m_btor, bvSort));
+        return toBVExp(boolector_ones(m_btor, m_sorts.bitvec(bvWidth)));
     }
 
     BVExp *uext(BVExp *exp, unsigned int newWidth)
@@ -441,6 +440,7 @@ private:
     BoolectorBitvectors &operator=(const BoolectorBitvectors&);
 
     Btor *m_btor;
+    BoolectorSorts &m_sorts;
 };
 
 }
@@ -3,7 +3,9 @@
 #include "Bitvectors.h"
 #include "Boolector.h"
 #include "SatCore.h"
+#include "Sorts.h"
 
+#include <algorithm>
 #include <cstring>
 #include <cstdlib>
 
@@ -12,50 +14,71 @@ namespace SMT
 
 Boolector::Boolector(SATSolver solver)
   : m_btor(boolector_new()),
+    m_sorts(new BoolectorSorts(m_btor)),
     m_result(Solver::Unknown),
-    m_sat(new BoolectorSatCore(m_btor)),
-    m_bvs(new BoolectorBitvectors(m_btor)),
+    m_sat(new BoolectorSatCore(m_btor, *m_sorts)),
+    m_bvs(new BoolectorBitvectors(m_btor, *m_sorts)),
     m_ufs(NULL),
     m_bvArrays(NULL),
     m_description(),
     m_incremental(false),
+    m_solved(false),
+    m_depth(0),
+    m_cancelled(false),
+    m_timeoutMs(0),
+    m_deadline(),
     m_lastBoolExp(NULL),
     m_lastBoolVal(false),
     m_lastBoolMask(false)
 {
+    const char *satSolver = NULL;
+    const char *unsupported = NULL;
     switch (solver) {
     case PicoSAT:
 #ifdef PICOSAT
-        boolector_set_sat_solver(m_btor, "PicoSAT");
-        m_description = "Boolector with PicoSAT";
+        satSolver = "PicoSAT";
 #else
-        throw LLBMCException("No PicoSAT support for Boolector");
+        unsupported = "No PicoSAT support for Boolector";
 #endif
         break;
     case MiniSat:
 #ifdef BOOLECTOR_MINISAT
-        boolector_set_sat_solver(m_btor, "MiniSat");
-        m_description = "Boolector with MiniSat";
+        satSolver = "MiniSat";
 #else
-        throw LLBMCException("No MiniSat support for Boolector");
+        unsupported = "No MiniSat support for Boolector";
 #endif
         break;
     case Lingeling:
-        boolector_set_sat_solver(m_btor, "Lingeling");
-        m_description = "Boolector with Lingeling";
+        satSolver = "Lingeling";
         break;
     default:
-        throw LLBMCException("Unknown SAT solver");
+        unsupported = "Unknown SAT solver";
     }
+    if (unsupported != NULL) {
+        // the destructor does not run for a constructor that throws
+        release();
+        throw LLBMCException(unsupported);
+    }
+    boolector_set_sat_solver(m_btor, satSolver);
+    m_description = std::string("Boolector with ") + satSolver;
     boolector_set_opt(m_btor, BTOR_OPT_MODEL_GEN, 1);
+    boolector_set_term(m_btor, &Boolector::terminate, this);
 }
 
 Boolector::~Boolector()
+{
+    release();
+}
+
+void Boolector::release()
 {
     delete m_bvArrays;
+    delete m_ufs;
     delete m_bvs;
     delete m_sat;
 
+    // the sorts must be released while the btor object is still alive
+    delete m_sorts;
     boolector_delete(m_btor);
 }
 
@@ -67,16 +90,16 @@ int Boolector::getNumUnreleasedExps() const
 bool Boolector::hasCapability(Capability cap) const
 {
     switch (cap) {
-    case CapPushPop:
     case CapTheoryOfHeaps:
     case CapArraySetAndCopy:
     case CapTheoryOfFPs:
     case CapTheoryOfLIA:
-    case CapTimeout:
         return false;
     case CapSMTSolving:
     case CapIncrementalSolving:
     case CapAssume:
+    case CapPushPop:
+    case CapTimeout:
     case CapTheoryOfArrays:
     case CapTheoryOfBitvectors:
     case CapTheoryOfUninterpretedFunctions:
@@ -99,7 +122,7 @@ TheoryOfBitvectors *Boolector::getTheoryOfBitvectors()
 BitvectorTheoryOfArrays *Boolector::getBitvectorTheoryOfArrays()
 {
     if (m_bvArrays == NULL) {
-        m_bvArrays = new BoolectorBVArrays(m_btor);
+        m_bvArrays = new BoolectorBVArrays(m_btor, *m_sorts);
     }
     return m_bvArrays;
 }
@@ -107,7 +130,7 @@ BitvectorTheoryOfArrays *Boolector::getBitvectorTheoryOfArrays()
 BitvectorTheoryOfUFs *Boolector::getBitvectorTheoryOfUFs()
 {
     if (m_ufs == NULL) {
-        m_ufs = new BoolectorBVUFs(m_btor);
+        m_ufs = new BoolectorBVUFs(m_btor, *m_sorts);
     }
     return m_ufs;
 }
@@ -165,73 +188,135 @@ bool Boolector::getBooleanMask(BoolExp *exp) const
     return m_lastBoolMask;
 }
 
-void Boolector::parseBitvector(Bitvector &bv, const char *str) const
+namespace
 {
-    unsigned int width = bv.getWidth();
-    unsigned int length = static_cast<unsigned int>(strlen(str));
 
-    if (width != length) {
-        bv = Bitvector();
+const uint64_t ASCII_ZEROS = 0x3030303030303030ULL;
+const uint64_t LOW_BITS = 0x0101010101010101ULL;
+// multiplying moves the low bit of byte k to bit 63-k
+const uint64_t GATHER_BITS = 0x8040201008040201ULL;
+
+// load 8 model characters so that byte k holds str[k]
+inline uint64_t loadChars(const char *str)
+{
+    uint64_t chunk;
+    memcpy(&chunk, str, sizeof(chunk));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    chunk = __builtin_bswap64(chunk);
+#endif
+    return chunk;
+}
+
+inline uint64_t decodeChar(char c, bool treatXAsZero, bool &valid)
+{
+    switch (c) {
+    case '0':
+        return 0;
+    case '1':
+        return 1;
+    case 'x':
+    case 'X':
+        if (!treatXAsZero) {
+            valid = false;
+        }
+        return 0;
+    default:
+        throw LLBMCException("Unexpected character in bitvector model!");
+    }
+}
+
+// Decode a model string of exactly width characters, most significant bit
+// first, into (width + 63) / 64 words, least significant word first.
+// Returns false if the value is undefined. Eight characters are decoded at
+// a time, only chunks containing something else than '0'/'1' take the
+// per-character path.
+bool decodeBits(const char *str, unsigned int width, uint64_t *words, bool treatXAsZero)
+{
+    if (memchr(str, '\0', width) != NULL || str[width] != '\0') {
         throw LLBMCException("Unexpected width of bitvector model!");
     }
 
-    for (unsigned int i = 0; i < width; ++i) {
-        char c = str[i];
-        switch (c) {
-        case '0':
-            bv.setBit(width-i-1, 0);
-            break;
-        case '1':
-            bv.setBit(width-i-1, 1);
-            break;
-        case 'x':
-        case 'X':
-            bv = Bitvector();
-            break;
-        case '\0':
-            bv = Bitvector();
-            throw LLBMCException("Unexpected end of bitvector model!");
-        default:
-            bv = Bitvector();
-            throw LLBMCException("Unexpected character in bitvector model!");
+    std::fill(words, words + (width + 63) / 64, 0);
+    bool valid = true;
+
+    unsigned int end = width;
+    while (end >= 8) {
+        unsigned int pos = end - 8;
+        // bit index of str[end - 1]
+        unsigned int offset = width - end;
+
+        uint64_t bits = loadChars(str + pos) ^ ASCII_ZEROS;
+        uint64_t byte;
+        if ((bits & ~LOW_BITS) == 0) {
+            byte = (bits * GATHER_BITS) >> 56;
+        } else {
+            byte = 0;
+            for (unsigned int k = 0; k < 8; ++k) {
+                byte |= decodeChar(str[pos + k], treatXAsZero, valid) << (7 - k);
+            }
+        }
+
+        words[offset / 64] |= byte << (offset % 64);
+        if (offset % 64 > 56) {
+            words[offset / 64 + 1] |= byte >> (64 - offset % 64);
         }
+        end = pos;
     }
+
+    for (unsigned int i = 0; i < end; ++i) {
+        unsigned int bit = width - i - 1;
+        words[bit / 64] |= decodeChar(str[i], treatXAsZero, valid) << (bit % 64);
+    }
+
+    return valid;
 }
 
-void Boolector::parseBitvectorTreatXAsZero(Bitvector &bv, const char *str) const
+// number of characters of a UF index, the arguments are separated by blanks
+unsigned int countNonBlanks(const char *str)
 {
-    unsigned int width = bv.getWidth();
-    unsigned int length = static_cast<unsigned int>(strlen(str));
-
-    if (width != length) {
-        bv = Bitvector();
-        throw LLBMCException("Unexpected width of bitvector model!");
+    unsigned int res = 0;
+    for (; *str != 0; ++str) {
+        if (*str != ' ') {
+            ++res;
+        }
     }
+    return res;
+}
 
-    for (unsigned int i = 0; i < width; ++i) {
-        char c = str[i];
-        switch (c) {
-        case '0':
-        case 'x':
-        case 'X':
-            bv.setBit(width-i-1, 0);
-            break;
-        case '1':
-            bv.setBit(width-i-1, 1);
-            break;
-        default:
-            bv = Bitvector();
-            throw LLBMCException("Unexpected character in bitvector model!");
+// copy str without the blanks into res, reusing res' storage
+void stripBlanks(const char *str, std::string &res)
+{
+    res.clear();
+    for (; *str != 0; ++str) {
+        if (*str != ' ') {
+            res.push_back(*str);
         }
     }
 }
 
+}
+
 void Boolector::parseBitvector(Bitvector &bv, const char *str, bool treatXAsZero) const
 {
-    if (treatXAsZero) {
-        parseBitvectorTreatXAsZero(bv, str);
+    unsigned int width = bv.getWidth();
+    m_modelWords.resize((width + 63) / 64);
+
+    bool valid;
+    try {
+        valid = decodeBits(str, width, m_modelWords.data(), treatXAsZero);
+    } catch (const LLBMCException &) {
+        bv = Bitvector();
+        throw;
+    }
+
+    if (!valid) {
+        bv = Bitvector();
+    } else if (width <= 64) {
+        bv = Bitvector(m_modelWords[0], width);
     } else {
-        parseBitvector(bv, str);
+        for (unsigned int i = 0; i < width; ++i) {
+            bv.setBit(i, (m_modelWords[i / 64] >> (i % 64)) & 1);
+        }
     }
 }
 
@@ -239,7 +324,7 @@ const Bitvector *Boolector::getBitvector(BVExp *exp, bool treatXAsZero) const
 {
     const char *str = boolector_bv_assignment(m_btor, toBtor(exp));
 
-    Bitvector *res = new Bitvector(0, static_cast<unsigned int>(strlen(str)));
+    Bitvector *res = new Bitvector(0, width(exp));
     parseBitvector(*res, str, treatXAsZero);
     boolector_free_bv_assignment(m_btor, str);
 
@@ -256,6 +341,61 @@ const Bitvector *Boolector::getBitvector(BVExp *exp) const
     return getBitvector(exp, true);
 }
 
+unsigned int Boolector::width(BVExp *exp) const
+{
+    return static_cast<unsigned int>(boolector_get_width(m_btor, toBtor(exp)));
+}
+
+void Boolector::getBitvectors(BVExp *const *exps, size_t count, std::vector<uint64_t> &buffer) const
+{
+    // size the buffer once, decoding then writes in place
+    size_t offset = buffer.size();
+    size_t total = offset;
+    for (size_t i = 0; i != count; ++i) {
+        total += (width(exps[i]) + 63) / 64;
+    }
+    buffer.resize(total);
+
+    for (size_t i = 0; i != count; ++i) {
+        unsigned int bvWidth = width(exps[i]);
+        const char *str = boolector_bv_assignment(m_btor, toBtor(exps[i]));
+        decodeBits(str, bvWidth, &buffer[offset], true);
+        boolector_free_bv_assignment(m_btor, str);
+        offset += (bvWidth + 63) / 64;
+    }
+}
+
+void Boolector::getBVArrays(AExp *const *exps, size_t count, std::vector<uint64_t> &buffer) const
+{
+    for (size_t i = 0; i != count; ++i) {
+        unsigned int valueWidth = static_cast<unsigned int>(boolector_get_width(m_btor, toBtor(exps[i])));
+        unsigned int indexWidth = static_cast<unsigned int>(boolector_get_index_width(m_btor, toBtor(exps[i])));
+        size_t indexWords = (indexWidth + 63) / 64;
+        size_t valueWords = (valueWidth + 63) / 64;
+
+        char **indices = NULL;
+        char **values = NULL;
+        int size;
+
+        boolector_array_assignment(m_btor, toBtor(exps[i]), &indices, &values, &size);
+
+        size_t offset = buffer.size();
+        buffer.resize(offset + 1 + static_cast<size_t>(size) * (indexWords + valueWords));
+        buffer[offset++] = static_cast<uint64_t>(size);
+
+        for (int j = 0; j != size; ++j) {
+            decodeBits(indices[j], indexWidth, &buffer[offset], true);
+            offset += indexWords;
+            decodeBits(values[j], valueWidth, &buffer[offset], true);
+            offset += valueWords;
+        }
+
+        if (size != 0) {
+            boolector_free_array_assignment(m_btor, indices, values, size);
+        }
+    }
+}
+
 const BVArray *Boolector::getBVArray(AExp *exp, bool treatXAsZero) const
 {
     unsigned int indexWidth;
@@ -298,22 +438,6 @@ const BVArray *Boolector::getBVArray(AExp *exp) const
     return getBVArray(exp, true);
 }
 
-namespace
-{
-std::string filter_blanks(const char *str)
-{
-    std::string res;
-    while (*str != 0) {
-        if (*str != ' ') {
-            res.append(1, *str);
-        }
-        ++str;
-    }
-    return res;
-}
-
-}
-
 const BVArray *Boolector::getBVUF(UFExp *exp, bool treatXAsZero) const
 {
     unsigned int indexWidth;
@@ -331,14 +455,17 @@ const BVArray *Boolector::getBVUF(UFExp *exp, bool treatXAsZero) const
         return ret;
     }
 
-    indexWidth = filter_blanks(indices[0]).length();
+    indexWidth = countNonBlanks(indices[0]);
 
     Bitvector index(0, indexWidth);
     Bitvector value(0, valueWidth);
+    std::string compact;
+    compact.reserve(indexWidth);
 
     // convert Bitvectors
     for (int i = 0; i != size; ++i) {
-        parseBitvector(index, filter_blanks(indices[i]).c_str(), treatXAsZero);
+        stripBlanks(indices[i], compact);
+        parseBitvector(index, compact.c_str(), treatXAsZero);
         parseBitvector(value, values[i], treatXAsZero);
 
         if (index.isValid() && value.isValid()) {
@@ -366,8 +493,45 @@ void Boolector::assume(BoolExp *exp)
     boolector_assume(m_btor, toBtor(exp));
 }
 
+void Boolector::push()
+{
+    if (!m_incremental) {
+        enableIncrementalSolving();
+    }
+    boolector_push(m_btor, 1);
+    ++m_depth;
+    m_result = Solver::Unknown;
+}
+
+void Boolector::pop()
+{
+    if (m_depth == 0) {
+        throw LLBMCException("Boolector: pop without matching push!");
+    }
+    boolector_pop(m_btor, 1);
+    --m_depth;
+    m_result = Solver::Unknown;
+    m_lastBoolExp = NULL;
+}
+
 void Boolector::solve()
 {
+    // the cached boolean belongs to the previous model
+    m_lastBoolExp = NULL;
+
+    if (m_cancelled) {
+        m_result = Solver::Timeout;
+        return;
+    }
+    if (m_timeoutMs != 0) {
+        m_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_timeoutMs);
+    }
+
+    if (m_solved && !m_incremental) {
+        throw LLBMCException("Boolector: solving again needs enableIncrementalSolving() before the first solve!");
+    }
+    m_solved = true;
+
     // call boolector sat and store result
     int result = boolector_sat(m_btor);
 
@@ -375,11 +539,47 @@ void Boolector::solve()
         m_result = Solver::Unsatisfiable;
     } else if (result == BOOLECTOR_SAT) {
         m_result = Solver::Satisfiable;
+    } else if (isExpired()) {
+        m_result = Solver::Timeout;
     } else {
         m_result = Solver::Unknown;
     }
 }
 
+void Boolector::setTimeout(int seconds)
+{
+    setTimeoutMs(seconds > 0 ? static_cast<unsigned long>(seconds) * 1000 : 0);
+}
+
+void Boolector::setTimeoutMs(unsigned long milliseconds)
+{
+    m_timeoutMs = milliseconds;
+}
+
+void Boolector::cancel()
+{
+    m_cancelled = true;
+}
+
+void Boolector::resetCancel()
+{
+    m_cancelled = false;
+}
+
+bool Boolector::isExpired() const
+{
+    if (m_cancelled) {
+        return true;
+    }
+    return m_timeoutMs != 0 && std::chrono::steady_clock::now() >= m_deadline;
+}
+
+int Boolector::terminate(void *state)
+{
+    // called by boolector from within boolector_sat, i.e. on the solving thread
+    return static_cast<Boolector*>(state)->isExpired() ? 1 : 0;
+}
+
 Solver::Result Boolector::getResult() const
 {
     return m_result;
@@ -392,7 +592,15 @@ const std::string &Boolector::getDescription() const
 
 void Boolector::enableIncrementalSolving()
 {
+    if (m_incremental) {
+        return;
+    }
+    if (m_solved) {
+        // Boolector itself would abort
+        throw LLBMCException("Boolector: incremental solving has to be enabled before the first solve!");
+    }
     boolector_set_opt(m_btor, BTOR_OPT_INCREMENTAL, 1);
+    m_incremental = true;
 }
 
 Solver *createBoolectorLingelingSolver()
@@ -4,13 +4,19 @@
 #include <llbmc/SMT/Solver.h>
 #include <llbmc/SMT/Model.h>
 
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
 #include <string>
+#include <vector>
 
 struct Btor;
 
 namespace SMT
 {
 
+class BoolectorSorts;
+
 /// \brief Boolector SMT::Solver implementation
 ///
 /// This is an implementation of the Solver interface and a wrapper around
@@ -53,34 +59,85 @@ public:
 
     virtual const BVArray *getBVUF(UFExp*) const;
 
+    /// \brief Decode the model values of \a count bitvectors in one go
+    ///
+    /// The values are appended to \a buffer in the order of \a exps, each
+    /// one taking (width + 63) / 64 words, least significant word first.
+    /// Undefined bits are zero. \a buffer is owned by the caller and can
+    /// be reused across calls to avoid allocations.
+    void getBitvectors(BVExp *const *exps, size_t count, std::vector<uint64_t> &buffer) const;
+
+    /// \brief Decode the model values of \a count arrays in one go
+    ///
+    /// Each array is appended to \a buffer as its number of entries n
+    /// followed by n pairs of index and value, packed like getBitvectors.
+    void getBVArrays(AExp *const *exps, size_t count, std::vector<uint64_t> &buffer) const;
+
     virtual void assertConstraint(BoolExp *exp);
 
     virtual void assume(BoolExp *exp);
 
+    /// \brief Open a new assertion context
+    ///
+    /// Uses Boolector's own context levels, assertions made after the push
+    /// are removed by the matching pop(). Incremental solving is enabled on
+    /// the first push; after a non-incremental solve() it throws, call
+    /// enableIncrementalSolving() before solving then.
+    virtual void push();
+
+    /// \brief Drop all assertions since the matching push()
+    virtual void pop();
+
     virtual void solve();
 
     virtual Result getResult() const;
 
     virtual const std::string &getDescription() const;
 
+    /// \brief Allow push() and repeated solve(), only before the first solve()
     virtual void enableIncrementalSolving();
 
+    /// \brief Limit each solve() to \a seconds of wall-clock time
+    virtual void setTimeout(int seconds);
+
+    /// \brief Limit each solve() to \a milliseconds of wall-clock time
+    ///
+    /// A value of 0 disables the limit. solve() reports Timeout if the limit
+    /// is hit.
+    void setTimeoutMs(unsigned long milliseconds);
+
+    /// \brief Abort the running solve() with Timeout
+    ///
+    /// May be called from any thread. The request is sticky: a later
+    /// solve() returns Timeout right away until resetCancel() is called.
+    void cancel();
+
+    /// \brief Allow solving again after cancel()
+    void resetCancel();
+
 private:
     Boolector(const Boolector &);
     Boolector &operator=(const Boolector &);
 
+    /// \brief Free the theories and the btor object
+    void release();
+
     void valuateBoolean(BoolExp*) const;
 
-    void parseBitvector(Bitvector &bv, const char *str) const;
-    void parseBitvectorTreatXAsZero(Bitvector &bv, const char *str) const;
+    /// \brief Termination callback registered with boolector_set_term
+    static int terminate(void *state);
+    bool isExpired() const;
+
     void parseBitvector(Bitvector &bv, const char *str, bool treatXAsZero) const;
     const Bitvector *getBitvector(BVExp*, bool) const;
+    unsigned int width(BVExp*) const;
 
     const BVArray *getBVArray(AExp*, bool) const;
     const BVArray *getBVUF(UFExp*, bool) const;
 
 protected:
     Btor *m_btor;
+    BoolectorSorts *m_sorts;
 
 private:
     Result m_result;
@@ -96,10 +153,22 @@ protected:
 
 private:
     bool m_incremental;
+    /// whether boolector_sat has been called, Boolector aborts on enabling incremental mode after it
+    bool m_solved;
+    /// number of open push() contexts
+    unsigned int m_depth;
+
+    std::atomic<bool> m_cancelled;
+    unsigned long m_timeoutMs;
+    /// end of the running solve(), only valid if m_timeoutMs != 0
+    std::chrono::steady_clock::time_point m_deadline;
 
     mutable BoolExp *m_lastBoolExp;
     mutable bool m_lastBoolVal;
     mutable bool m_lastBoolMask;
+
+    /// scratch words for parseBitvector, kept to avoid allocations
+    mutable std::vector<uint64_t> m_modelWords;
 };
 
 }
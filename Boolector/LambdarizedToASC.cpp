@@ -24,9 +24,10 @@ bool BoolectorLambdarizedToASC::hasCapability(Capability cap) const
 class BoolectorLambdarizedToASC::BitvectorArraysWithLambdarizedToASC : public BoolectorBVArrays
 {
 public:
-    BitvectorArraysWithLambdarizedToASC(Btor *p)
-      : BoolectorBVArrays(p),
-        m_btor(p)
+    BitvectorArraysWithLambdarizedToASC(Btor *p, BoolectorSorts &sorts)
+      : BoolectorBVArrays(p, sorts),
+        m_btor(p),
+        m_sorts(sorts)
     {}
 
     ~BitvectorArraysWithLambdarizedToASC()
@@ -40,6 +41,7 @@ private:
     BitvectorArraysWithLambdarizedToASC &operator=(const BitvectorArraysWithLambdarizedToASC&);
 
     Btor *m_btor;
+    BoolectorSorts &m_sorts;
 };
 
 AExp *BoolectorLambdarizedToASC::BitvectorArraysWithLambdarizedToASC::memcpy(AExp *dstA, BVExp *dstI, AExp *srcA, BVExp *srcI, BVExp *size)
@@ -60,7 +62,7 @@ AExp *BoolectorLambdarizedToASC::BitvectorArraysWithLambdarizedToASC::memcpy(AEx
     BoolectorNode *s = toBtor(size);
 
     // r
-    BoolectorSort bvSort = boolector_bitvec_sort(m_btor, boolector_get_width(m_btor, toBtor(srcI)));
+    BoolectorSort bvSort = m_sorts.bitvec(static_cast<unsigned int>(boolector_get_width(m_btor, toBtor(srcI))));
     BoolectorNode *r = boolector_param(m_btor, bvSort, "r");
 
     BoolectorNode *cond1 = boolector_ulte(m_btor, p, r);
@@ -105,7 +107,7 @@ AExp *BoolectorLambdarizedToASC::BitvectorArraysWithLambdarizedToASC::memset(AEx
     BoolectorNode *s = toBtor(size);
 
     // r
-    BoolectorSort bvSort = boolector_bitvec_sort(m_btor, boolector_get_width(m_btor, toBtor(dstI)));
+    BoolectorSort bvSort = m_sorts.bitvec(static_cast<unsigned int>(boolector_get_width(m_btor, toBtor(dstI))));
     BoolectorNode *r = boolector_param(m_btor, bvSort, "r");
 
     BoolectorNode *cond1 = boolector_ulte(m_btor, p, r);
@@ -146,7 +148,7 @@ BoolectorLambdarizedToASC::~BoolectorLambdarizedToASC()
 BitvectorTheoryOfArrays *BoolectorLambdarizedToASC::getBitvectorTheoryOfArrays()
 {
     if (m_bvArrays == NULL) {
-        m_bvArrays = new BitvectorArraysWithLambdarizedToASC(m_btor);
+        m_bvArrays = new BitvectorArraysWithLambdarizedToASC(m_btor, *m_sorts);
     }
     return m_bvArrays;
 }
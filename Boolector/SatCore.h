@@ -2,6 +2,7 @@
 #define SMT_BOOLECTOR_SAT_H
 
 #include "Common.h"
+#include "Sorts.h"
 
 namespace SMT
 {
@@ -9,23 +10,24 @@ namespace SMT
 class BoolectorSatCore : public SatCore
 {
 public:
-    BoolectorSatCore(Btor *btor)
-      : m_btor(btor)
+    BoolectorSatCore(Btor *btor, BoolectorSorts &sorts)
+      : m_btor(btor),
+        m_sorts(sorts)
     {}
 
     BoolExp *mk_free(const std::string &name)
     {
-        return toBoolExp(boolector_var(m_btor, boolector_bitvec_sort(m_btor, 1), name.c_str()));
+        return toBoolExp(boolector_var(m_btor, m_sorts.bitvec(1), name.c_str()));
     }
 
     BoolExp *mk_true()
     {
-        return toBoolExp(boolector_ones(m_btor, boolector_bitvec_sort(m_btor, 1)));
+        return toBoolExp(boolector_ones(m_btor, m_sorts.bitvec(1)));
     }
 
     BoolExp *mk_false()
     {
-        return toBoolExp(boolector_zero(m_btor, boolector_bitvec_sort(m_btor, 1)));
+        return toBoolExp(boolector_zero(m_btor, m_sorts.bitvec(1)));
     }
 
     BoolExp *mk_not(BoolExp *exp)
@@ -78,6 +80,7 @@ private:
     BoolectorSatCore &operator=(const BoolectorSatCore&);
 
     Btor *m_btor;
+    BoolectorSorts &m_sorts;
 };
 
 }
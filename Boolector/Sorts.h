@@ -0,0 +1,100 @@
+#ifndef SMT_BOOLECTOR_SORTS_H
+#define SMT_BOOLECTOR_SORTS_H
+
+#include "Common.h"
+
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace SMT
+{
+
+/// \brief Sort cache of one Boolector instance
+///
+/// Every bitvector, array and function sort is created once and handed out
+/// as a borrowed handle, i.e. callers must not release it. All sorts are
+/// released when the cache is destroyed, which must happen before the btor
+/// object is deleted.
+/// \ingroup SMT
+class BoolectorSorts
+{
+public:
+    BoolectorSorts(Btor *btor)
+      : m_btor(btor)
+    {}
+
+    ~BoolectorSorts()
+    {
+        for (std::vector<BoolectorSort>::iterator it = m_bitvecs.begin(); it != m_bitvecs.end(); ++it) {
+            if (*it != NULL) {
+                boolector_release_sort(m_btor, *it);
+            }
+        }
+        for (std::map<std::pair<unsigned int, unsigned int>, BoolectorSort>::iterator it = m_arrays.begin(); it != m_arrays.end(); ++it) {
+            boolector_release_sort(m_btor, it->second);
+        }
+        for (std::map<std::vector<unsigned int>, BoolectorSort>::iterator it = m_funs.begin(); it != m_funs.end(); ++it) {
+            boolector_release_sort(m_btor, it->second);
+        }
+    }
+
+    BoolectorSort bitvec(unsigned int width)
+    {
+        if (width >= m_bitvecs.size()) {
+            m_bitvecs.resize(width + 1, NULL);
+        }
+        if (m_bitvecs[width] == NULL) {
+            m_bitvecs[width] = boolector_bitvec_sort(m_btor, static_cast<int>(width));
+        }
+        return m_bitvecs[width];
+    }
+
+    BoolectorSort array(unsigned int indexWidth, unsigned int elementWidth)
+    {
+        std::pair<unsigned int, unsigned int> key(indexWidth, elementWidth);
+        std::map<std::pair<unsigned int, unsigned int>, BoolectorSort>::iterator it = m_arrays.find(key);
+        if (it != m_arrays.end()) {
+            return it->second;
+        }
+        BoolectorSort sort = boolector_array_sort(m_btor, bitvec(indexWidth), bitvec(elementWidth));
+        m_arrays.insert(std::make_pair(key, sort));
+        return sort;
+    }
+
+    BoolectorSort fun(const std::list<unsigned int> &argWidths, unsigned int resWidth)
+    {
+        // key: the argument widths followed by the result width
+        std::vector<unsigned int> key(argWidths.begin(), argWidths.end());
+        key.push_back(resWidth);
+        std::map<std::vector<unsigned int>, BoolectorSort>::iterator it = m_funs.find(key);
+        if (it != m_funs.end()) {
+            return it->second;
+        }
+
+        std::vector<BoolectorSort> domain;
+        domain.reserve(argWidths.size());
+        for (std::list<unsigned int>::const_iterator arg = argWidths.begin(); arg != argWidths.end(); ++arg) {
+            domain.push_back(bitvec(*arg));
+        }
+        BoolectorSort sort = boolector_fun_sort(m_btor, domain.empty() ? NULL : &domain[0], static_cast<int>(domain.size()), bitvec(resWidth));
+        m_funs.insert(std::make_pair(key, sort));
+        return sort;
+    }
+
+private:
+    BoolectorSorts(const BoolectorSorts&);
+    BoolectorSorts &operator=(const BoolectorSorts&);
+
+    Btor *m_btor;
+
+    /// bitvector sorts indexed by width, NULL if not created yet
+    std::vector<BoolectorSort> m_bitvecs;
+    std::map<std::pair<unsigned int, unsigned int>, BoolectorSort> m_arrays;
+    std::map<std::vector<unsigned int>, BoolectorSort> m_funs;
+};
+
+}
+
+#endif
@@ -0,0 +1,36 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_CLAUSESINK_H
+#define TRANSFORMERSOLVER_CLAUSESINK_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+/*
+ * Receives a CNF clause by clause, e.g. from a bit-blaster or a replayed
+ * BinaryCnf. Variables are numbered from 1 in the order they are added,
+ * literals are DIMACS literals.
+ */
+class ClauseSink {
+public:
+    virtual ~ClauseSink() {}
+
+    /* new variable standing for bit of the bitvector name */
+    virtual int addVariable(const std::string &name, unsigned int bit) = 0;
+
+    /* new auxiliary variable */
+    virtual int addVariable() = 0;
+
+    virtual void addClause(const int *literals, size_t size) = 0;
+
+    void addClause(const std::vector<int> &literals) {
+        addClause(literals.empty() ? NULL : &literals[0], literals.size());
+    }
+};
+
+
+#endif //TRANSFORMERSOLVER_CLAUSESINK_H
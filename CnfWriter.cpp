@@ -0,0 +1,324 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "CnfWriter.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
+
+namespace {
+    const size_t BufferSize = 1 << 20;
+
+    /* "p cnf " and two numbers of HeaderDigits digits, padded with spaces */
+    const size_t HeaderDigits = 20;
+    const size_t HeaderSize = 6 + HeaderDigits + 1 + HeaderDigits + 1;
+
+    /* gzip member header, stored deflate block header, header line, crc32 and size */
+    const size_t GzipHeaderMemberSize = 10 + 5 + HeaderSize + 8;
+
+    /* longest literal plus the separating space */
+    const size_t MaxNumberSize = 21;
+
+    void writeAll(int fd, const char *data, size_t size, const std::string &path) {
+        while (size > 0) {
+            ssize_t res = ::write(fd, data, size);
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+            if (res <= 0) {
+                throw LLBMCException("Cannot write " + path);
+            }
+            data += res;
+            size -= static_cast<size_t>(res);
+        }
+    }
+
+    void writeAt(int fd, off_t offset, const char *data, size_t size, const std::string &path) {
+        while (size > 0) {
+            ssize_t res = pwrite(fd, data, size, offset);
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+            if (res <= 0) {
+                throw LLBMCException("Cannot write " + path);
+            }
+            data += res;
+            offset += res;
+            size -= static_cast<size_t>(res);
+        }
+    }
+
+    void putLittleEndian(unsigned char *out, unsigned long value, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) {
+            out[i] = static_cast<unsigned char>(value >> (8 * i));
+        }
+    }
+}
+
+/* A file written through one large buffer, deflated into gzip if compressed. */
+class CnfWriter::Output {
+public:
+    Output(const std::string &path, bool compress) : m_path(path), m_fd(-1), m_used(0), m_compress(compress) {
+#ifndef WITH_ZLIB
+        if (compress) {
+            throw LLBMCException("No zlib support, cannot compress " + path);
+        }
+#endif
+        m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0) {
+            throw LLBMCException("Cannot create " + path);
+        }
+        m_buffer = new char[BufferSize];
+#ifdef WITH_ZLIB
+        if (compress) {
+            m_deflated = new char[BufferSize];
+            memset(&m_stream, 0, sizeof(m_stream));
+            // level 1: the dump is supposed to be cheap next to solving, windowBits + 16 for gzip
+            if (deflateInit2(&m_stream, 1, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                ::close(m_fd);
+                delete[] m_buffer;
+                delete[] m_deflated;
+                throw LLBMCException("Cannot initialize zlib for " + path);
+            }
+        }
+#endif
+    }
+
+    ~Output() {
+#ifdef WITH_ZLIB
+        if (m_compress) {
+            deflateEnd(&m_stream);
+            delete[] m_deflated;
+        }
+#endif
+        delete[] m_buffer;
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+    /* room for size more bytes, to be taken with commit() */
+    char *reserve(size_t size) {
+        if (BufferSize - m_used < size) {
+            flush(false);
+        }
+        return m_buffer + m_used;
+    }
+
+    void commit(size_t size) {
+        m_used += size;
+    }
+
+    void append(const char *data, size_t size) {
+        while (size > 0) {
+            if (m_used == BufferSize) {
+                flush(false);
+            }
+            size_t chunk = std::min(size, BufferSize - m_used);
+            memcpy(m_buffer + m_used, data, chunk);
+            m_used += chunk;
+            data += chunk;
+            size -= chunk;
+        }
+    }
+
+    /* written before the buffer, bypassing compression */
+    void writeRaw(const char *data, size_t size) {
+        writeAll(m_fd, data, size, m_path);
+    }
+
+    void patch(off_t offset, const char *data, size_t size) {
+        writeAt(m_fd, offset, data, size, m_path);
+    }
+
+    /* writes out the buffer, finish also ends the gzip member */
+    void flush(bool finish) {
+        if (!m_compress) {
+            writeAll(m_fd, m_buffer, m_used, m_path);
+            m_used = 0;
+            return;
+        }
+#ifdef WITH_ZLIB
+        m_stream.next_in = reinterpret_cast<Bytef *>(m_buffer);
+        m_stream.avail_in = static_cast<uInt>(m_used);
+        int res;
+        do {
+            m_stream.next_out = reinterpret_cast<Bytef *>(m_deflated);
+            m_stream.avail_out = static_cast<uInt>(BufferSize);
+            res = deflate(&m_stream, finish ? Z_FINISH : Z_NO_FLUSH);
+            if (res == Z_STREAM_ERROR) {
+                throw LLBMCException("Cannot compress " + m_path);
+            }
+            writeAll(m_fd, m_deflated, BufferSize - m_stream.avail_out, m_path);
+        } while (m_stream.avail_out == 0 || (finish && res != Z_STREAM_END));
+        m_used = 0;
+#else
+        (void) finish;
+#endif
+    }
+
+    /* closes the file, throws if the data did not make it */
+    void finish() {
+        int fd = m_fd;
+        m_fd = -1;
+        if (::close(fd) != 0) {
+            throw LLBMCException("Cannot write " + m_path);
+        }
+    }
+
+private:
+    std::string m_path;
+    int m_fd;
+    char *m_buffer;
+    size_t m_used;
+    bool m_compress;
+#ifdef WITH_ZLIB
+    z_stream m_stream;
+    char *m_deflated;
+#endif
+};
+
+CnfWriter::CnfWriter(const std::string &prefix, bool compress)
+        : m_path(prefix + (compress ? ".cnf.gz" : ".cnf")), m_compress(compress), m_cnf(NULL), m_map(NULL),
+          m_variables(0), m_clauses(0) {
+    m_cnf = new Output(m_path, compress);
+    try {
+        m_map = new Output(prefix + ".map", false);
+    } catch (...) {
+        delete m_cnf;
+        throw;
+    }
+
+    // placeholder for the header, close() writes the real one
+    char placeholder[GzipHeaderMemberSize];
+    memset(placeholder, ' ', sizeof(placeholder));
+    m_cnf->writeRaw(placeholder, compress ? GzipHeaderMemberSize : HeaderSize);
+}
+
+CnfWriter::~CnfWriter() {
+    if (m_cnf != NULL) {
+        try {
+            close();
+        } catch (const LLBMCException &) {
+        }
+    }
+    delete m_cnf;
+    delete m_map;
+}
+
+int CnfWriter::addVariable(const std::string &name, unsigned int bit) {
+    int variable = addVariable();
+    char line[64];
+    int size = snprintf(line, sizeof(line), "%d ", variable);
+    m_map->append(line, static_cast<size_t>(size));
+    m_map->append(name.data(), name.size());
+    size = snprintf(line, sizeof(line), " %u\n", bit);
+    m_map->append(line, static_cast<size_t>(size));
+    return variable;
+}
+
+int CnfWriter::addVariable() {
+    return static_cast<int>(++m_variables);
+}
+
+void CnfWriter::addClause(const int *literals, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        appendNumber(literals[i]);
+    }
+    char *out = m_cnf->reserve(2);
+    out[0] = '0';
+    out[1] = '\n';
+    m_cnf->commit(2);
+    ++m_clauses;
+}
+
+void CnfWriter::appendNumber(long value) {
+    char *out = m_cnf->reserve(MaxNumberSize);
+    size_t size = 0;
+    unsigned long magnitude = static_cast<unsigned long>(value);
+    if (value < 0) {
+        out[size++] = '-';
+        magnitude = 0 - magnitude;
+    }
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    while (count > 0) {
+        out[size++] = digits[--count];
+    }
+    out[size++] = ' ';
+    m_cnf->commit(size);
+}
+
+void CnfWriter::close() {
+    if (m_cnf == NULL) {
+        return;
+    }
+    Output *cnf = m_cnf;
+    Output *map = m_map;
+    m_cnf = NULL;
+    m_map = NULL;
+    try {
+        cnf->flush(true);
+        map->flush(true);
+
+        char header[HeaderSize + 1];
+        snprintf(header, sizeof(header), "p cnf %-20lu %-20lu\n", m_variables, m_clauses);
+
+        if (m_compress) {
+#ifdef WITH_ZLIB
+            unsigned char member[GzipHeaderMemberSize];
+            static const unsigned char gzipHeader[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+            memcpy(member, gzipHeader, sizeof(gzipHeader));
+            // one final stored block
+            member[10] = 1;
+            putLittleEndian(member + 11, HeaderSize, 2);
+            putLittleEndian(member + 13, ~HeaderSize & 0xffff, 2);
+            memcpy(member + 15, header, HeaderSize);
+            unsigned long crc = crc32(crc32(0, Z_NULL, 0), reinterpret_cast<const Bytef *>(header), HeaderSize);
+            putLittleEndian(member + 15 + HeaderSize, crc, 4);
+            putLittleEndian(member + 19 + HeaderSize, HeaderSize, 4);
+            cnf->patch(0, reinterpret_cast<const char *>(member), GzipHeaderMemberSize);
+#endif
+        } else {
+            cnf->patch(0, header, HeaderSize);
+        }
+
+        cnf->finish();
+        map->finish();
+    } catch (...) {
+        delete cnf;
+        delete map;
+        throw;
+    }
+    delete cnf;
+    delete map;
+}
+
+unsigned long CnfWriter::getVariableCount() const {
+    return m_variables;
+}
+
+unsigned long CnfWriter::getClauseCount() const {
+    return m_clauses;
+}
+
+const std::string &CnfWriter::getPath() const {
+    return m_path;
+}
@@ -0,0 +1,69 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_CNFWRITER_H
+#define TRANSFORMERSOLVER_CNFWRITER_H
+
+#include "ClauseSink.h"
+
+#include <cstddef>
+#include <string>
+
+
+/*
+ * Streams a DIMACS CNF to <prefix>.cnf, or to <prefix>.cnf.gz if compressed
+ * (needs WITH_ZLIB), without knowing the number of variables and clauses up
+ * front: the "p cnf" line is written with fixed-width fields and patched in
+ * place by close(). A compressed file starts with a gzip member of fixed size
+ * that only holds the header, so it can be patched the same way; gzip readers
+ * decode the concatenated members as one stream.
+ *
+ * Variables made for a bitvector bit are listed in <prefix>.map, one
+ * "<cnf variable> <bitvector> <bit>" line each.
+ */
+class CnfWriter : public ClauseSink {
+public:
+    /* throws LLBMCException if a file cannot be created */
+    CnfWriter(const std::string &prefix, bool compress);
+
+    /* closes the writer if close() was not called, errors are lost then */
+    ~CnfWriter();
+
+    using ClauseSink::addClause;
+
+    /* listed in the map */
+    int addVariable(const std::string &name, unsigned int bit);
+
+    /* not listed in the map */
+    int addVariable();
+
+    void addClause(const int *literals, size_t size);
+
+    /* flushes everything and patches the header, throws LLBMCException on I/O errors */
+    void close();
+
+    unsigned long getVariableCount() const;
+
+    unsigned long getClauseCount() const;
+
+    const std::string &getPath() const;
+
+private:
+    CnfWriter(const CnfWriter &);
+    CnfWriter &operator=(const CnfWriter &);
+
+    class Output;
+
+    void appendNumber(long value);
+
+    std::string m_path;
+    bool m_compress;
+    Output *m_cnf;
+    Output *m_map;
+    unsigned long m_variables;
+    unsigned long m_clauses;
+};
+
+
+#endif //TRANSFORMERSOLVER_CNFWRITER_H
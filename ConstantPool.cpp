@@ -0,0 +1,76 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "ConstantPool.h"
+
+
+ConstantPool::ConstantPool(SMT::TheoryOfBitvectors &bvs) : m_bvs(bvs) {
+
+}
+
+ConstantPool::~ConstantPool() {
+    for (std::unordered_map<SmallKey, SMT::BVExp *, SmallKeyHash>::iterator it = m_small.begin(); it != m_small.end(); ++it) {
+        m_bvs.release(it->second);
+    }
+    for (std::map<std::pair<unsigned int, std::string>, WideConstant>::iterator it = m_wide.begin(); it != m_wide.end(); ++it) {
+        m_bvs.release(it->second.exp);
+        delete it->second.value;
+    }
+}
+
+SMT::BVExp *ConstantPool::get(uint64_t value, unsigned int width) {
+    if (width > 64) {
+        return get(Bitvector(value, width));
+    }
+
+    // values of different sign extension are the same constant
+    if (width < 64) {
+        value &= (static_cast<uint64_t>(1) << width) - 1;
+    }
+
+    SmallKey key(value, width);
+    std::unordered_map<SmallKey, SMT::BVExp *, SmallKeyHash>::iterator it = m_small.find(key);
+    if (it != m_small.end()) {
+        return m_bvs.copy(it->second);
+    }
+
+    Bitvector constant(value, width);
+    SMT::BVExp *exp = m_bvs.bv2bv(&constant);
+    m_small.insert(std::make_pair(key, exp));
+    return m_bvs.copy(exp);
+}
+
+SMT::BVExp *ConstantPool::get(const Bitvector &value) {
+    unsigned int width = value.getWidth();
+    if (width <= 64) {
+        return get(value.getUnsigned(), width);
+    }
+
+    std::string bits(width, '0');
+    for (unsigned int i = 0; i < width; ++i) {
+        if (value.getBit(i)) {
+            bits[width - i - 1] = '1';
+        }
+    }
+
+    std::pair<unsigned int, std::string> key(width, bits);
+    std::map<std::pair<unsigned int, std::string>, WideConstant>::iterator it = m_wide.find(key);
+    if (it != m_wide.end()) {
+        return m_bvs.copy(it->second.exp);
+    }
+
+    WideConstant constant;
+    constant.value = new Bitvector(value);
+    constant.exp = m_bvs.bv2bv(constant.value);
+    m_wide.insert(std::make_pair(key, constant));
+    return m_bvs.copy(constant.exp);
+}
+
+size_t ConstantPool::size() const {
+    return m_small.size() + m_wide.size();
+}
+
+size_t ConstantPool::SmallKeyHash::operator()(const SmallKey &key) const {
+    return std::hash<uint64_t>()(key.first) * 31 + key.second;
+}
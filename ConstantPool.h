@@ -0,0 +1,59 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_CONSTANTPOOL_H
+#define TRANSFORMERSOLVER_CONSTANTPOOL_H
+
+#include <llbmc/SMT/TheoryOfBitvectors.h>
+#include <llbmc/Util/Bitvector.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+
+/*
+ * Interned bitvector constants of one SMT context. Every (value, width)
+ * is handed to bv2bv once. The pool keeps that handle and returns copy()
+ * of it afterwards. Constants of at most 64 bits are keyed by their value
+ * and built from a Bitvector on the stack. Wider constants are stored in
+ * Bitvectors owned by the pool. Everything is released in the destructor,
+ * so the pool must not outlive the solver.
+ */
+class ConstantPool {
+public:
+    ConstantPool(SMT::TheoryOfBitvectors &bvs);
+
+    ~ConstantPool();
+
+    SMT::BVExp *get(uint64_t value, unsigned int width);
+
+    SMT::BVExp *get(const Bitvector &value);
+
+    size_t size() const;
+
+private:
+    ConstantPool(const ConstantPool &);
+    ConstantPool &operator=(const ConstantPool &);
+
+    typedef std::pair<uint64_t, unsigned int> SmallKey;
+
+    struct SmallKeyHash {
+        size_t operator()(const SmallKey &key) const;
+    };
+
+    struct WideConstant {
+        Bitvector *value;
+        SMT::BVExp *exp;
+    };
+
+    SMT::TheoryOfBitvectors &m_bvs;
+    std::unordered_map<SmallKey, SMT::BVExp *, SmallKeyHash> m_small;
+    std::map<std::pair<unsigned int, std::string>, WideConstant> m_wide;
+};
+
+
+#endif //TRANSFORMERSOLVER_CONSTANTPOOL_H
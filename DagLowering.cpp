@@ -0,0 +1,240 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "DagLowering.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <algorithm>
+
+
+DagLowering::DagLowering(const TermDag &dag, SMT::Solver &solver)
+        : m_dag(dag), m_solver(solver), m_sat(*solver.getSatCore()), m_bvs(*solver.getTheoryOfBitvectors()),
+          m_arrays(solver.getBitvectorTheoryOfArrays()), m_lowered(0) {
+
+}
+
+DagLowering::~DagLowering() {
+    for (size_t id = 0; id < m_handles.size(); ++id) {
+        if (m_handles[id] == NULL) {
+            continue;
+        }
+        switch (TermDag::getSort(m_dag.getNode(static_cast<TermDag::NodeId>(id)).op)) {
+            case TermDag::SortBool:
+                m_sat.release(static_cast<SMT::BoolExp *>(m_handles[id]));
+                break;
+            case TermDag::SortBitvector:
+                m_bvs.release(static_cast<SMT::BVExp *>(m_handles[id]));
+                break;
+            case TermDag::SortArray:
+                m_arrays->release(static_cast<SMT::AExp *>(m_handles[id]));
+                break;
+        }
+    }
+}
+
+SMT::BoolExp *DagLowering::lowerBool(TermDag::NodeId id) {
+    return static_cast<SMT::BoolExp *>(lower(id));
+}
+
+SMT::BVExp *DagLowering::lowerBitvector(TermDag::NodeId id) {
+    return static_cast<SMT::BVExp *>(lower(id));
+}
+
+SMT::AExp *DagLowering::lowerArray(TermDag::NodeId id) {
+    return static_cast<SMT::AExp *>(lower(id));
+}
+
+void DagLowering::assertAll() {
+    const std::vector<TermDag::NodeId> &assertions = m_dag.getAssertions();
+    for (std::vector<TermDag::NodeId>::const_iterator it = assertions.begin(); it != assertions.end(); ++it) {
+        m_solver.assertConstraint(lowerBool(*it));
+    }
+}
+
+size_t DagLowering::getLoweredCount() const {
+    return m_lowered;
+}
+
+void *DagLowering::lower(TermDag::NodeId id) {
+    if (m_handles.size() < m_dag.size()) {
+        m_handles.resize(m_dag.size(), NULL);
+        m_queued.resize(m_dag.size(), false);
+    }
+    if (m_handles[id] != NULL) {
+        return m_handles[id];
+    }
+
+    // collect what is missing below id, then build it bottom-up
+    std::vector<TermDag::NodeId> missing;
+    m_pending.push_back(id);
+    m_queued[id] = true;
+    while (!m_pending.empty()) {
+        TermDag::NodeId next = m_pending.back();
+        m_pending.pop_back();
+        missing.push_back(next);
+        const TermDag::Node &node = m_dag.getNode(next);
+        for (unsigned int i = 0; i < node.arity; ++i) {
+            TermDag::NodeId operand = m_dag.getOperand(next, i);
+            if (m_handles[operand] == NULL && !m_queued[operand]) {
+                m_queued[operand] = true;
+                m_pending.push_back(operand);
+            }
+        }
+    }
+    std::sort(missing.begin(), missing.end());
+
+    for (std::vector<TermDag::NodeId>::const_iterator it = missing.begin(); it != missing.end(); ++it) {
+        m_handles[*it] = build(*it);
+        m_queued[*it] = false;
+        ++m_lowered;
+    }
+    return m_handles[id];
+}
+
+void *DagLowering::build(TermDag::NodeId id) {
+    const TermDag::Node &node = m_dag.getNode(id);
+    switch (node.op) {
+        case TermDag::OpTrue:
+            return m_sat.mk_true();
+        case TermDag::OpFalse:
+            return m_sat.mk_false();
+        case TermDag::OpFree:
+            return m_sat.mk_free(m_dag.getName(id));
+        case TermDag::OpNot:
+            return m_sat.mk_not(boolOperand(id, 0));
+        case TermDag::OpAnd:
+            return m_sat.mk_and(boolOperand(id, 0), boolOperand(id, 1));
+        case TermDag::OpOr:
+            return m_sat.mk_or(boolOperand(id, 0), boolOperand(id, 1));
+        case TermDag::OpXor:
+            return m_sat.mk_xor(boolOperand(id, 0), boolOperand(id, 1));
+        case TermDag::OpImplies:
+            return m_sat.mk_implies(boolOperand(id, 0), boolOperand(id, 1));
+        case TermDag::OpIff:
+            return m_sat.mk_iff(boolOperand(id, 0), boolOperand(id, 1));
+        case TermDag::OpCond:
+            return m_sat.mk_cond(boolOperand(id, 0), boolOperand(id, 1), boolOperand(id, 2));
+        case TermDag::OpBV12Bool:
+            return m_bvs.bv12bool(bvOperand(id, 0));
+        case TermDag::OpEq:
+            return m_bvs.eq(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpNe:
+            return m_bvs.bvne(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpUlt:
+            return m_bvs.bvult(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpUle:
+            return m_bvs.bvule(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpUgt:
+            return m_bvs.bvugt(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpUge:
+            return m_bvs.bvuge(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpSlt:
+            return m_bvs.bvslt(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpSle:
+            return m_bvs.bvsle(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpSgt:
+            return m_bvs.bvsgt(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpSge:
+            return m_bvs.bvsge(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpUaddo:
+            return m_bvs.bvuaddo(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpUsubo:
+            return m_bvs.bvusubo(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpUmulo:
+            return m_bvs.bvumulo(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpSaddo:
+            return m_bvs.bvsaddo(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpSsubo:
+            return m_bvs.bvssubo(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpSmulo:
+            return m_bvs.bvsmulo(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpSdivo:
+            return m_bvs.bvsdivo(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpArrayEq:
+            return arrays().eq(arrayOperand(id, 0), arrayOperand(id, 1));
+        case TermDag::OpBitvector:
+            return m_bvs.bitvector(node.width, m_dag.getName(id));
+        case TermDag::OpConst:
+            return m_bvs.bv2bv(&m_dag.getConstant(id));
+        case TermDag::OpBool2BV1:
+            return m_bvs.bool2bv1(boolOperand(id, 0));
+        case TermDag::OpConcat:
+            return m_bvs.concat(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpExtract:
+            return m_bvs.extract(node.aux + node.width - 1, node.aux, bvOperand(id, 0));
+        case TermDag::OpUext:
+            return m_bvs.uext(bvOperand(id, 0), node.width);
+        case TermDag::OpSext:
+            return m_bvs.sext(bvOperand(id, 0), node.width);
+        case TermDag::OpBVNot:
+            return m_bvs.bvnot(bvOperand(id, 0));
+        case TermDag::OpBVNeg:
+            return m_bvs.bvneg(bvOperand(id, 0));
+        case TermDag::OpBVAnd:
+            return m_bvs.bvand(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpBVOr:
+            return m_bvs.bvor(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpBVXor:
+            return m_bvs.bvxor(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpBVImplies:
+            return m_bvs.bvimplies(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpBVCond:
+            return m_bvs.bvcond(boolOperand(id, 0), bvOperand(id, 1), bvOperand(id, 2));
+        case TermDag::OpAdd:
+            return m_bvs.bvadd(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpSub:
+            return m_bvs.bvsub(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpMul:
+            return m_bvs.bvmul(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpUdiv:
+            return m_bvs.bvudiv(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpUrem:
+            return m_bvs.bvurem(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpSdiv:
+            return m_bvs.bvsdiv(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpSrem:
+            return m_bvs.bvsrem(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpShl:
+            return m_bvs.bvshl(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpLshr:
+            return m_bvs.bvlshr(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpAshr:
+            return m_bvs.bvashr(bvOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpRead:
+            return arrays().read(arrayOperand(id, 0), bvOperand(id, 1));
+        case TermDag::OpArray:
+            return arrays().array(m_dag.getIndexWidth(id), node.width, m_dag.getName(id));
+        case TermDag::OpWrite:
+            return arrays().write(arrayOperand(id, 0), bvOperand(id, 1), bvOperand(id, 2));
+        case TermDag::OpMemcpy:
+            return arrays().memcpy(arrayOperand(id, 0), bvOperand(id, 1), arrayOperand(id, 2), bvOperand(id, 3),
+                                   bvOperand(id, 4));
+        case TermDag::OpMemset:
+            return arrays().memset(arrayOperand(id, 0), bvOperand(id, 1), bvOperand(id, 2), bvOperand(id, 3));
+        case TermDag::OpArrayCond:
+            return arrays().acond(boolOperand(id, 0), arrayOperand(id, 1), arrayOperand(id, 2));
+        default:
+            throw LLBMCException("DagLowering: unknown operator");
+    }
+}
+
+SMT::BoolExp *DagLowering::boolOperand(TermDag::NodeId id, unsigned int i) const {
+    return static_cast<SMT::BoolExp *>(m_handles[m_dag.getOperand(id, i)]);
+}
+
+SMT::BVExp *DagLowering::bvOperand(TermDag::NodeId id, unsigned int i) const {
+    return static_cast<SMT::BVExp *>(m_handles[m_dag.getOperand(id, i)]);
+}
+
+SMT::AExp *DagLowering::arrayOperand(TermDag::NodeId id, unsigned int i) const {
+    return static_cast<SMT::AExp *>(m_handles[m_dag.getOperand(id, i)]);
+}
+
+SMT::BitvectorTheoryOfArrays &DagLowering::arrays() {
+    if (m_arrays == NULL) {
+        throw LLBMCException(m_solver.getDescription() + " does not support arrays");
+    }
+    return *m_arrays;
+}
@@ -0,0 +1,72 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_DAGLOWERING_H
+#define TRANSFORMERSOLVER_DAGLOWERING_H
+
+#include "TermDag.h"
+
+#include <llbmc/SMT/Solver.h>
+
+#include <vector>
+
+
+/*
+ * Replays a TermDag into the theories of one SMT::Solver. A node is
+ * lowered once, together with everything below it that is not lowered
+ * yet, in increasing id order, which is topological order for a TermDag.
+ * The solver's handles are kept until the lowering is destroyed, so it
+ * must live as long as the solver uses them, e.g. until solve() returned.
+ * The DAG is only read; several lowerings of one DAG may run in parallel.
+ */
+class DagLowering {
+public:
+    DagLowering(const TermDag &dag, SMT::Solver &solver);
+
+    ~DagLowering();
+
+    SMT::BoolExp *lowerBool(TermDag::NodeId id);
+
+    SMT::BVExp *lowerBitvector(TermDag::NodeId id);
+
+    SMT::AExp *lowerArray(TermDag::NodeId id);
+
+    /* asserts all assertions of the DAG on the solver */
+    void assertAll();
+
+    /* nodes lowered so far */
+    size_t getLoweredCount() const;
+
+private:
+    DagLowering(const DagLowering &);
+    DagLowering &operator=(const DagLowering &);
+
+    void *lower(TermDag::NodeId id);
+
+    /* builds the node, its operands are lowered already */
+    void *build(TermDag::NodeId id);
+
+    SMT::BoolExp *boolOperand(TermDag::NodeId id, unsigned int i) const;
+
+    SMT::BVExp *bvOperand(TermDag::NodeId id, unsigned int i) const;
+
+    SMT::AExp *arrayOperand(TermDag::NodeId id, unsigned int i) const;
+
+    SMT::BitvectorTheoryOfArrays &arrays();
+
+    const TermDag &m_dag;
+    SMT::Solver &m_solver;
+    SMT::SatCore &m_sat;
+    SMT::TheoryOfBitvectors &m_bvs;
+    SMT::BitvectorTheoryOfArrays *m_arrays;
+
+    /* solver handle per node id, NULL if not lowered */
+    std::vector<void *> m_handles;
+    std::vector<bool> m_queued;
+    std::vector<TermDag::NodeId> m_pending;
+    size_t m_lowered;
+};
+
+
+#endif //TRANSFORMERSOLVER_DAGLOWERING_H
@@ -0,0 +1,628 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "FormulaFile.h"
+#include "DagLowering.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <cstring>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+    const size_t BufferSize = 1 << 20;
+
+    const unsigned int MaxArity = 5;
+
+    /* operand sorts per operator: b(ool), v(bitvector), a(rray) */
+    const char *const Signatures[] = {
+            // Bool
+            "", "", "", "b", "bb", "bb", "bb", "bb", "bb", "bbb", "v",
+            "vv", "vv", "vv", "vv", "vv", "vv", "vv", "vv", "vv", "vv",
+            "vv", "vv", "vv", "vv", "vv", "vv", "vv", "aa",
+            // bitvector
+            "", "", "b", "vv", "v", "v", "v", "v", "v", "vv", "vv", "vv", "vv", "bvv",
+            "vv", "vv", "vv", "vv", "vv", "vv", "vv", "vv", "vv", "vv", "av",
+            // array
+            "", "avv", "avavv", "avvv", "baa"
+    };
+
+    static_assert(sizeof(Signatures) / sizeof(Signatures[0]) == TermDag::OpCount,
+                  "one signature per TermDag operator");
+
+    TermDag::Sort getOperandSort(char signature) {
+        switch (signature) {
+            case 'b':
+                return TermDag::SortBool;
+            case 'v':
+                return TermDag::SortBitvector;
+            default:
+                return TermDag::SortArray;
+        }
+    }
+
+    bool hasName(TermDag::Op op) {
+        return op == TermDag::OpFree || op == TermDag::OpBitvector || op == TermDag::OpArray;
+    }
+
+    /* whether the operand widths fit together, so that no backend is handed an ill-sorted term */
+    bool checkWidths(const TermDag &dag, TermDag::Op op, const TermDag::NodeId *operands,
+                     const uint32_t *indexWidths, uint32_t width, uint32_t low) {
+        uint64_t widths[MaxArity];
+        for (unsigned int i = 0; Signatures[op][i] != '\0'; ++i) {
+            widths[i] = dag.getNode(operands[i]).width;
+        }
+        switch (op) {
+            case TermDag::OpBV12Bool:
+                return widths[0] == 1;
+            case TermDag::OpConcat:
+                return widths[0] + widths[1] <= TermDag::MaxWidth;
+            case TermDag::OpExtract:
+                return low < widths[0] && width <= widths[0] - low;
+            case TermDag::OpUext:
+            case TermDag::OpSext:
+                return width >= widths[0];
+            case TermDag::OpBVCond:
+                return widths[1] == widths[2];
+            case TermDag::OpArrayEq:
+                return widths[0] == widths[1] && indexWidths[0] == indexWidths[1];
+            case TermDag::OpArrayCond:
+                return widths[1] == widths[2] && indexWidths[1] == indexWidths[2];
+            case TermDag::OpRead:
+                return widths[1] == indexWidths[0];
+            case TermDag::OpWrite:
+                return widths[1] == indexWidths[0] && widths[2] == widths[0];
+            case TermDag::OpMemcpy:
+                return widths[0] == widths[2] && indexWidths[0] == indexWidths[2] && widths[1] == indexWidths[0]
+                       && widths[3] == indexWidths[0];
+            case TermDag::OpMemset:
+                return widths[1] == indexWidths[0] && widths[2] == widths[0];
+            default:
+                // the remaining two-operand words and predicates take equally wide operands
+                return strcmp(Signatures[op], "vv") != 0 || widths[0] == widths[1];
+        }
+    }
+}
+
+const char FormulaFile::Magic[8] = {'T', 'S', 'F', 'O', 'R', 'M', 'U', 'L'};
+
+FormulaFile::FormulaFile(const std::string &path) : m_path(path), m_data(NULL), m_size(0), m_mapped(false) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw LLBMCException("Cannot open " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        close(fd);
+        throw LLBMCException("Not a formula file: " + path);
+    }
+    m_size = static_cast<size_t>(info.st_size);
+    void *data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw LLBMCException("Cannot map " + path);
+    }
+    m_data = static_cast<const unsigned char *>(data);
+    m_mapped = true;
+    // the sections are decoded front to back
+    madvise(data, m_size, MADV_SEQUENTIAL);
+
+    try {
+        readHeader();
+    } catch (...) {
+        munmap(data, m_size);
+        throw;
+    }
+}
+
+FormulaFile::FormulaFile(const char *data, size_t size)
+        : m_path("payload"), m_data(reinterpret_cast<const unsigned char *>(data)), m_size(size), m_mapped(false) {
+    readHeader();
+}
+
+FormulaFile::~FormulaFile() {
+    if (m_mapped) {
+        munmap(const_cast<unsigned char *>(m_data), m_size);
+    }
+}
+
+uint64_t FormulaFile::getNodeCount() const {
+    return m_header.nodes;
+}
+
+uint64_t FormulaFile::getAssertionCount() const {
+    return m_header.assertions;
+}
+
+void FormulaFile::load(TermDag &dag) const {
+    uint64_t offset = sizeof(Header);
+
+    std::vector<std::string> names(static_cast<size_t>(m_header.names));
+    for (std::vector<std::string>::iterator it = names.begin(); it != names.end(); ++it) {
+        uint64_t length = readVarint(offset);
+        if (length > m_size - offset) {
+            throw LLBMCException("Corrupt name in " + m_path);
+        }
+        it->assign(reinterpret_cast<const char *>(m_data + offset), static_cast<size_t>(length));
+        offset += length;
+    }
+
+    std::vector<Bitvector> constants;
+    constants.reserve(static_cast<size_t>(m_header.constants));
+    for (uint64_t i = 0; i < m_header.constants; ++i) {
+        constants.push_back(decodeConstant(offset));
+    }
+
+    // file index to DAG id; the DAG may already hold some of the nodes
+    std::vector<TermDag::NodeId> ids;
+    std::vector<uint32_t> indexWidths;
+    ids.reserve(static_cast<size_t>(m_header.nodes));
+    indexWidths.reserve(static_cast<size_t>(m_header.nodes));
+    for (uint64_t i = 0; i < m_header.nodes; ++i) {
+        ids.push_back(decodeNode(dag, offset, names, constants, ids, indexWidths));
+    }
+
+    for (uint64_t i = 0; i < m_header.assertions; ++i) {
+        TermDag::NodeId id = ids[readIndex(offset, ids.size())];
+        if (TermDag::getSort(dag.getNode(id).op) != TermDag::SortBool) {
+            throw LLBMCException("Corrupt assertion in " + m_path);
+        }
+        dag.addAssertion(id);
+    }
+}
+
+void FormulaFile::replay(SMT::Solver &solver) const {
+    TermDag dag;
+    load(dag);
+    // asserted constraints stay with the solver, the lowered handles are not needed afterwards
+    DagLowering lowering(dag, solver);
+    lowering.assertAll();
+}
+
+void FormulaFile::readHeader() {
+    if (m_size < sizeof(Header)) {
+        throw LLBMCException("Not a formula file: " + m_path);
+    }
+    memcpy(&m_header, m_data, sizeof(Header));
+    // every entry takes at least one byte
+    uint64_t limit = m_size - sizeof(Header);
+    if (memcmp(m_header.magic, Magic, sizeof(Magic)) != 0 || m_header.version != Version
+        || m_header.names > limit || m_header.constants > limit || m_header.nodes > limit
+        || m_header.nodes > UINT32_MAX || m_header.assertions > limit) {
+        throw LLBMCException("Not a formula file: " + m_path);
+    }
+}
+
+TermDag::NodeId FormulaFile::decodeNode(TermDag &dag, uint64_t &offset, const std::vector<std::string> &names,
+                                        const std::vector<Bitvector> &constants,
+                                        const std::vector<TermDag::NodeId> &ids,
+                                        std::vector<uint32_t> &indexWidths) const {
+    if (offset >= m_size || m_data[offset] >= TermDag::OpCount) {
+        throw LLBMCException("Corrupt node in " + m_path);
+    }
+    TermDag::Op op = static_cast<TermDag::Op>(m_data[offset++]);
+
+    uint32_t name = 0;
+    uint32_t constant = 0;
+    uint32_t width = 0;
+    uint32_t low = 0;
+    uint32_t indexWidth = 0;
+    if (hasName(op)) {
+        name = readIndex(offset, names.size());
+    }
+    switch (op) {
+        case TermDag::OpBitvector:
+        case TermDag::OpUext:
+        case TermDag::OpSext:
+            width = readWidth(offset);
+            break;
+        case TermDag::OpArray:
+            indexWidth = readWidth(offset);
+            width = readWidth(offset);
+            break;
+        case TermDag::OpConst:
+            constant = readIndex(offset, constants.size());
+            break;
+        case TermDag::OpExtract:
+            low = readIndex(offset, UINT32_MAX);
+            width = readWidth(offset);
+            break;
+        default:
+            break;
+    }
+
+    TermDag::NodeId operands[MaxArity];
+    uint32_t operandIndexWidths[MaxArity];
+    SMT::BoolExp *b[MaxArity];
+    SMT::BVExp *v[MaxArity];
+    SMT::AExp *a[MaxArity];
+    for (unsigned int i = 0; Signatures[op][i] != '\0'; ++i) {
+        uint32_t distance = readIndex(offset, ids.size() + 1);
+        if (distance == 0) {
+            throw LLBMCException("Corrupt node in " + m_path);
+        }
+        operands[i] = ids[ids.size() - distance];
+        operandIndexWidths[i] = indexWidths[ids.size() - distance];
+        if (TermDag::getSort(dag.getNode(operands[i]).op) != getOperandSort(Signatures[op][i])) {
+            throw LLBMCException("Ill-sorted node in " + m_path);
+        }
+        b[i] = TermDag::toBoolExp(operands[i]);
+        v[i] = TermDag::toBVExp(operands[i]);
+        a[i] = TermDag::toAExp(operands[i]);
+    }
+    if (!checkWidths(dag, op, operands, operandIndexWidths, width, low)) {
+        throw LLBMCException("Ill-sorted node in " + m_path);
+    }
+    // array operations keep the index width of their first array operand
+    if (op == TermDag::OpArray) {
+        indexWidths.push_back(indexWidth);
+    } else if (op == TermDag::OpArrayCond) {
+        indexWidths.push_back(operandIndexWidths[1]);
+    } else if (TermDag::getSort(op) == TermDag::SortArray) {
+        indexWidths.push_back(operandIndexWidths[0]);
+    } else {
+        indexWidths.push_back(0);
+    }
+
+    switch (op) {
+        case TermDag::OpTrue:
+            return TermDag::toId(dag.mk_true());
+        case TermDag::OpFalse:
+            return TermDag::toId(dag.mk_false());
+        case TermDag::OpFree:
+            return TermDag::toId(dag.mk_free(names[name]));
+        case TermDag::OpNot:
+            return TermDag::toId(dag.mk_not(b[0]));
+        case TermDag::OpAnd:
+            return TermDag::toId(dag.mk_and(b[0], b[1]));
+        case TermDag::OpOr:
+            return TermDag::toId(dag.mk_or(b[0], b[1]));
+        case TermDag::OpXor:
+            return TermDag::toId(dag.mk_xor(b[0], b[1]));
+        case TermDag::OpImplies:
+            return TermDag::toId(dag.mk_implies(b[0], b[1]));
+        case TermDag::OpIff:
+            return TermDag::toId(dag.mk_iff(b[0], b[1]));
+        case TermDag::OpCond:
+            return TermDag::toId(dag.mk_cond(b[0], b[1], b[2]));
+        case TermDag::OpBV12Bool:
+            return TermDag::toId(dag.bv12bool(v[0]));
+        case TermDag::OpEq:
+            return TermDag::toId(dag.eq(v[0], v[1]));
+        case TermDag::OpNe:
+            return TermDag::toId(dag.bvne(v[0], v[1]));
+        case TermDag::OpUlt:
+            return TermDag::toId(dag.bvult(v[0], v[1]));
+        case TermDag::OpUle:
+            return TermDag::toId(dag.bvule(v[0], v[1]));
+        case TermDag::OpUgt:
+            return TermDag::toId(dag.bvugt(v[0], v[1]));
+        case TermDag::OpUge:
+            return TermDag::toId(dag.bvuge(v[0], v[1]));
+        case TermDag::OpSlt:
+            return TermDag::toId(dag.bvslt(v[0], v[1]));
+        case TermDag::OpSle:
+            return TermDag::toId(dag.bvsle(v[0], v[1]));
+        case TermDag::OpSgt:
+            return TermDag::toId(dag.bvsgt(v[0], v[1]));
+        case TermDag::OpSge:
+            return TermDag::toId(dag.bvsge(v[0], v[1]));
+        case TermDag::OpUaddo:
+            return TermDag::toId(dag.bvuaddo(v[0], v[1]));
+        case TermDag::OpUsubo:
+            return TermDag::toId(dag.bvusubo(v[0], v[1]));
+        case TermDag::OpUmulo:
+            return TermDag::toId(dag.bvumulo(v[0], v[1]));
+        case TermDag::OpSaddo:
+            return TermDag::toId(dag.bvsaddo(v[0], v[1]));
+        case TermDag::OpSsubo:
+            return TermDag::toId(dag.bvssubo(v[0], v[1]));
+        case TermDag::OpSmulo:
+            return TermDag::toId(dag.bvsmulo(v[0], v[1]));
+        case TermDag::OpSdivo:
+            return TermDag::toId(dag.bvsdivo(v[0], v[1]));
+        case TermDag::OpArrayEq:
+            return TermDag::toId(dag.eq(a[0], a[1]));
+        case TermDag::OpBitvector:
+            return TermDag::toId(dag.bitvector(width, names[name]));
+        case TermDag::OpConst:
+            return TermDag::toId(dag.bv2bv(&constants[constant]));
+        case TermDag::OpBool2BV1:
+            return TermDag::toId(dag.bool2bv1(b[0]));
+        case TermDag::OpConcat:
+            return TermDag::toId(dag.concat(v[0], v[1]));
+        case TermDag::OpExtract:
+            return TermDag::toId(dag.extract(low + width - 1, low, v[0]));
+        case TermDag::OpUext:
+            return TermDag::toId(dag.uext(v[0], width));
+        case TermDag::OpSext:
+            return TermDag::toId(dag.sext(v[0], width));
+        case TermDag::OpBVNot:
+            return TermDag::toId(dag.bvnot(v[0]));
+        case TermDag::OpBVNeg:
+            return TermDag::toId(dag.bvneg(v[0]));
+        case TermDag::OpBVAnd:
+            return TermDag::toId(dag.bvand(v[0], v[1]));
+        case TermDag::OpBVOr:
+            return TermDag::toId(dag.bvor(v[0], v[1]));
+        case TermDag::OpBVXor:
+            return TermDag::toId(dag.bvxor(v[0], v[1]));
+        case TermDag::OpBVImplies:
+            return TermDag::toId(dag.bvimplies(v[0], v[1]));
+        case TermDag::OpBVCond:
+            return TermDag::toId(dag.bvcond(b[0], v[1], v[2]));
+        case TermDag::OpAdd:
+            return TermDag::toId(dag.bvadd(v[0], v[1]));
+        case TermDag::OpSub:
+            return TermDag::toId(dag.bvsub(v[0], v[1]));
+        case TermDag::OpMul:
+            return TermDag::toId(dag.bvmul(v[0], v[1]));
+        case TermDag::OpUdiv:
+            return TermDag::toId(dag.bvudiv(v[0], v[1]));
+        case TermDag::OpUrem:
+            return TermDag::toId(dag.bvurem(v[0], v[1]));
+        case TermDag::OpSdiv:
+            return TermDag::toId(dag.bvsdiv(v[0], v[1]));
+        case TermDag::OpSrem:
+            return TermDag::toId(dag.bvsrem(v[0], v[1]));
+        case TermDag::OpShl:
+            return TermDag::toId(dag.bvshl(v[0], v[1]));
+        case TermDag::OpLshr:
+            return TermDag::toId(dag.bvlshr(v[0], v[1]));
+        case TermDag::OpAshr:
+            return TermDag::toId(dag.bvashr(v[0], v[1]));
+        case TermDag::OpRead:
+            return TermDag::toId(dag.read(a[0], v[1]));
+        case TermDag::OpArray:
+            return TermDag::toId(dag.array(indexWidth, width, names[name]));
+        case TermDag::OpWrite:
+            return TermDag::toId(dag.write(a[0], v[1], v[2]));
+        case TermDag::OpMemcpy:
+            return TermDag::toId(dag.memcpy(a[0], v[1], a[2], v[3], v[4]));
+        case TermDag::OpMemset:
+            return TermDag::toId(dag.memset(a[0], v[1], v[2], v[3]));
+        case TermDag::OpArrayCond:
+            return TermDag::toId(dag.acond(b[0], a[1], a[2]));
+        default:
+            throw LLBMCException("Corrupt node in " + m_path);
+    }
+}
+
+Bitvector FormulaFile::decodeConstant(uint64_t &offset) const {
+    uint32_t width = readWidth(offset);
+    uint64_t bytes = (static_cast<uint64_t>(width) + 7) / 8;
+    if (bytes > m_size - offset) {
+        throw LLBMCException("Corrupt constant in " + m_path);
+    }
+    const unsigned char *data = m_data + offset;
+    offset += bytes;
+
+    if (width <= 64) {
+        uint64_t bits = 0;
+        for (uint64_t i = 0; i < bytes; ++i) {
+            bits |= static_cast<uint64_t>(data[i]) << (8 * i);
+        }
+        if (width < 64) {
+            bits &= (static_cast<uint64_t>(1) << width) - 1;
+        }
+        return Bitvector(bits, width);
+    }
+    Bitvector value(0, width);
+    for (unsigned int i = 0; i < width; ++i) {
+        if ((data[i / 8] >> (i % 8)) & 1) {
+            value.setBit(i, true);
+        }
+    }
+    return value;
+}
+
+uint32_t FormulaFile::readWidth(uint64_t &offset) const {
+    uint32_t width = readIndex(offset, static_cast<uint64_t>(UINT32_MAX) + 1);
+    if (width == 0) {
+        throw LLBMCException("Zero width in " + m_path);
+    }
+    // a few bytes must not make the backend allocate gigabytes
+    if (width > TermDag::MaxWidth) {
+        throw LLBMCException("Width " + std::to_string(width) + " too large in " + m_path);
+    }
+    return width;
+}
+
+uint64_t FormulaFile::readVarint(uint64_t &offset) const {
+    uint64_t value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+        if (offset >= m_size) {
+            break;
+        }
+        unsigned char byte = m_data[offset++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw LLBMCException("Corrupt varint in " + m_path);
+}
+
+uint32_t FormulaFile::readIndex(uint64_t &offset, uint64_t limit) const {
+    uint64_t value = readVarint(offset);
+    if (value >= limit) {
+        throw LLBMCException("Index out of range in " + m_path);
+    }
+    return static_cast<uint32_t>(value);
+}
+
+FormulaWriter::FormulaWriter(const std::string &path) : m_path(path), m_file(NULL), m_buffer(NULL) {
+    m_file = fopen(path.c_str(), "wb");
+    if (m_file == NULL) {
+        throw LLBMCException("Cannot create " + path);
+    }
+    m_buffer = new char[BufferSize];
+    setvbuf(m_file, m_buffer, _IOFBF, BufferSize);
+}
+
+FormulaWriter::~FormulaWriter() {
+    if (m_file != NULL) {
+        fclose(m_file);
+    }
+    delete[] m_buffer;
+}
+
+void FormulaWriter::write(const TermDag &dag) {
+    if (m_file == NULL) {
+        throw LLBMCException("Already written: " + m_path);
+    }
+    const std::vector<TermDag::NodeId> &assertions = dag.getAssertions();
+
+    // operands have smaller ids, one pass downwards finds everything below the assertions
+    std::vector<bool> live(dag.size(), false);
+    for (std::vector<TermDag::NodeId>::const_iterator it = assertions.begin(); it != assertions.end(); ++it) {
+        live[*it] = true;
+    }
+    for (size_t id = dag.size(); id-- > 0;) {
+        if (!live[id]) {
+            continue;
+        }
+        TermDag::NodeId node = static_cast<TermDag::NodeId>(id);
+        for (unsigned int i = 0; i < dag.getNode(node).arity; ++i) {
+            live[dag.getOperand(node, i)] = true;
+        }
+    }
+
+    // number the live nodes, their names and constants in id order
+    std::vector<uint32_t> index(dag.size(), 0);
+    std::unordered_map<uint32_t, uint32_t> names;
+    std::unordered_map<uint32_t, uint32_t> constants;
+    std::vector<TermDag::NodeId> nameNodes;
+    std::vector<TermDag::NodeId> constantNodes;
+    uint32_t nodes = 0;
+    for (size_t id = 0; id < dag.size(); ++id) {
+        if (!live[id]) {
+            continue;
+        }
+        TermDag::NodeId node = static_cast<TermDag::NodeId>(id);
+        index[id] = nodes++;
+        const TermDag::Node &data = dag.getNode(node);
+        if (hasName(data.op) && names.insert(std::make_pair(data.aux, nameNodes.size())).second) {
+            nameNodes.push_back(node);
+        } else if (data.op == TermDag::OpConst
+                   && constants.insert(std::make_pair(data.aux, constantNodes.size())).second) {
+            constantNodes.push_back(node);
+        }
+    }
+
+    FormulaFile::Header header;
+    memcpy(header.magic, FormulaFile::Magic, sizeof(header.magic));
+    header.version = FormulaFile::Version;
+    header.reserved = 0;
+    header.names = nameNodes.size();
+    header.constants = constantNodes.size();
+    header.nodes = nodes;
+    header.assertions = assertions.size();
+    m_encoded.assign(reinterpret_cast<const unsigned char *>(&header),
+                     reinterpret_cast<const unsigned char *>(&header) + sizeof(header));
+    flush();
+
+    for (std::vector<TermDag::NodeId>::const_iterator it = nameNodes.begin(); it != nameNodes.end(); ++it) {
+        const std::string &name = dag.getName(*it);
+        writeVarint(name.size());
+        m_encoded.insert(m_encoded.end(), name.begin(), name.end());
+        flush();
+    }
+
+    for (std::vector<TermDag::NodeId>::const_iterator it = constantNodes.begin(); it != constantNodes.end(); ++it) {
+        const Bitvector &value = dag.getConstant(*it);
+        unsigned int width = value.getWidth();
+        writeVarint(width);
+        for (unsigned int i = 0; i < width; i += 8) {
+            unsigned char byte = 0;
+            for (unsigned int bit = 0; bit < 8 && i + bit < width; ++bit) {
+                if (value.getBit(i + bit)) {
+                    byte |= static_cast<unsigned char>(1 << bit);
+                }
+            }
+            m_encoded.push_back(byte);
+        }
+        flush();
+    }
+
+    for (size_t id = 0; id < dag.size(); ++id) {
+        if (!live[id]) {
+            continue;
+        }
+        TermDag::NodeId node = static_cast<TermDag::NodeId>(id);
+        const TermDag::Node &data = dag.getNode(node);
+        m_encoded.push_back(static_cast<unsigned char>(data.op));
+        if (hasName(data.op)) {
+            writeVarint(names[data.aux]);
+        }
+        switch (data.op) {
+            case TermDag::OpBitvector:
+            case TermDag::OpUext:
+            case TermDag::OpSext:
+                writeVarint(data.width);
+                break;
+            case TermDag::OpArray:
+                writeVarint(dag.getIndexWidth(node));
+                writeVarint(data.width);
+                break;
+            case TermDag::OpConst:
+                writeVarint(constants[data.aux]);
+                break;
+            case TermDag::OpExtract:
+                writeVarint(data.aux);
+                writeVarint(data.width);
+                break;
+            default:
+                break;
+        }
+        for (unsigned int i = 0; i < data.arity; ++i) {
+            writeVarint(index[id] - index[dag.getOperand(node, i)]);
+        }
+        flush();
+    }
+
+    for (std::vector<TermDag::NodeId>::const_iterator it = assertions.begin(); it != assertions.end(); ++it) {
+        writeVarint(index[*it]);
+    }
+    flush();
+    close();
+}
+
+void FormulaWriter::writeVarint(uint64_t value) {
+    while (value >= 0x80) {
+        m_encoded.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    m_encoded.push_back(static_cast<unsigned char>(value));
+}
+
+void FormulaWriter::flush() {
+    if (!m_encoded.empty() && fwrite(&m_encoded[0], 1, m_encoded.size(), m_file) != m_encoded.size()) {
+        throw LLBMCException("Cannot write " + m_path);
+    }
+    m_encoded.clear();
+}
+
+void FormulaWriter::close() {
+    FILE *file = m_file;
+    m_file = NULL;
+    if (fclose(file) != 0) {
+        throw LLBMCException("Cannot write " + m_path);
+    }
+}
+
+FormulaSink::FormulaSink(const std::string &path) : m_path(path) {
+
+}
+
+void FormulaSink::solve() {
+    FormulaWriter writer(m_path);
+    writer.write(*getDag());
+}
@@ -0,0 +1,146 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_FORMULAFILE_H
+#define TRANSFORMERSOLVER_FORMULAFILE_H
+
+#include "TermDag.h"
+
+#include <llbmc/SMT/Solver.h>
+#include <llbmc/Util/Bitvector.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+/*
+ * The assertions of a TermDag in a compact binary file that is mapped
+ * instead of parsed. The file is a Header (host byte order) followed by
+ * four sections, everything in them LEB128 varints:
+ *
+ *  - names: length and bytes of every variable name
+ *  - constants: width and the value's bytes, least significant first
+ *  - nodes: operator byte, the operator's fields, then every operand as
+ *    the distance back to it in the node section (operands come first)
+ *  - assertions: node indices
+ *
+ * Fields are the name of variables, the widths of bitvector and array
+ * variables, the constant of OpConst, low bit and width of OpExtract and
+ * the width of OpUext/OpSext; other widths follow from the operands.
+ * Only nodes below an assertion are written.
+ */
+class FormulaFile {
+public:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t names;
+        uint64_t constants;
+        uint64_t nodes;
+        uint64_t assertions;
+    };
+
+    enum {
+        Version = 1
+    };
+
+    static const char Magic[8];
+
+    /* maps the file at path, throws LLBMCException if it is not a formula file */
+    explicit FormulaFile(const std::string &path);
+
+    /* reads a formula from memory owned by the caller, e.g. a query payload */
+    FormulaFile(const char *data, size_t size);
+
+    ~FormulaFile();
+
+    uint64_t getNodeCount() const;
+
+    uint64_t getAssertionCount() const;
+
+    /* adds the nodes and assertions to dag, throws LLBMCException for corrupt input */
+    void load(TermDag &dag) const;
+
+    /* asserts the formula on solver */
+    void replay(SMT::Solver &solver) const;
+
+private:
+    FormulaFile(const FormulaFile &);
+    FormulaFile &operator=(const FormulaFile &);
+
+    void readHeader();
+
+    /* decodes the next node into dag; ids and indexWidths hold the DAG id and array index width per file node */
+    TermDag::NodeId decodeNode(TermDag &dag, uint64_t &offset, const std::vector<std::string> &names,
+                               const std::vector<Bitvector> &constants, const std::vector<TermDag::NodeId> &ids,
+                               std::vector<uint32_t> &indexWidths) const;
+
+    Bitvector decodeConstant(uint64_t &offset) const;
+
+    /* a non-zero bitvector or array width */
+    uint32_t readWidth(uint64_t &offset) const;
+
+    uint64_t readVarint(uint64_t &offset) const;
+
+    /* a varint that must be below limit */
+    uint32_t readIndex(uint64_t &offset, uint64_t limit) const;
+
+    std::string m_path;
+    const unsigned char *m_data;
+    size_t m_size;
+    bool m_mapped;
+    Header m_header;
+};
+
+/*
+ * Writes the assertions of a TermDag as a FormulaFile. The header is
+ * known up front, so the file is written front to back in one pass.
+ */
+class FormulaWriter {
+public:
+    /* throws LLBMCException if the file cannot be created */
+    explicit FormulaWriter(const std::string &path);
+
+    ~FormulaWriter();
+
+    /* writes dag and closes the file, throws LLBMCException on I/O errors */
+    void write(const TermDag &dag);
+
+private:
+    FormulaWriter(const FormulaWriter &);
+    FormulaWriter &operator=(const FormulaWriter &);
+
+    void writeVarint(uint64_t value);
+
+    /* writes the encoded bytes */
+    void flush();
+
+    void close();
+
+    std::string m_path;
+    FILE *m_file;
+    char *m_buffer;
+    std::vector<unsigned char> m_encoded;
+};
+
+/*
+ * A TermDagSolver whose solve() writes the recorded formula to a
+ * FormulaFile instead of solving it; the result stays Unknown.
+ */
+class FormulaSink : public TermDagSolver {
+public:
+    explicit FormulaSink(const std::string &path);
+
+    void solve();
+
+private:
+    std::string m_path;
+};
+
+
+#endif //TRANSFORMERSOLVER_FORMULAFILE_H
@@ -0,0 +1,180 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "KInduction.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+
+struct KInduction::Shared {
+    enum Case {
+        Base,
+        Step
+    };
+
+    const TransitionSystem &system;
+    Solver::SMTSolver backend;
+
+    std::mutex mutex;
+    std::atomic<bool> done;
+    // depths 0 .. baseDepth-1 are safe
+    unsigned int baseDepth;
+    bool stepFound;
+    unsigned int stepK;
+    Result result;
+    unsigned int k;
+    // solvers of the running cases, to interrupt them
+    SMT::Solver *solvers[2];
+
+    Shared(const TransitionSystem &system, Solver::SMTSolver backend)
+            : system(system), backend(backend), done(false), baseDepth(0), stepFound(false), stepK(0),
+              result(Unknown), k(0) {
+        solvers[Base] = NULL;
+        solvers[Step] = NULL;
+    }
+
+    /* call with mutex held */
+    void conclude(Result conclusion, unsigned int atK) {
+        if (done) {
+            return;
+        }
+        result = conclusion;
+        k = atK;
+        done = true;
+        for (unsigned int i = 0; i < 2; ++i) {
+            if (solvers[i] != NULL) {
+                Solver::interruptSolver(backend, solvers[i]);
+            }
+        }
+    }
+
+    /* call with mutex held */
+    void checkProof() {
+        if (stepFound && baseDepth >= stepK) {
+            conclude(Safe, stepK);
+        }
+    }
+};
+
+KInduction::KInduction(const TransitionSystem &system, Solver::SMTSolver backend)
+        : m_system(system), m_backend(backend), m_k(0) {
+
+}
+
+KInduction::Result KInduction::prove(unsigned int maxK) {
+    std::shared_ptr<Shared> shared(new Shared(m_system, m_backend));
+
+    std::thread base(&KInduction::runBase, shared, maxK);
+    std::thread step(&KInduction::runStep, shared, maxK);
+    base.join();
+    step.join();
+
+    m_k = shared->k;
+    return shared->result;
+}
+
+unsigned int KInduction::getK() const {
+    return m_k;
+}
+
+/*
+ * One case of the proof with its own solver. The solver is registered in
+ * Shared::solvers for its whole lifetime, so it can be interrupted.
+ */
+class KInduction::CaseRunner {
+public:
+    CaseRunner(Shared &shared, Shared::Case which, BmcEngine::Mode mode)
+            : m_shared(shared), m_case(which), m_solver(Solver::createSolver(shared.backend)),
+              m_context(new llbmc::SMTContext(m_solver, 4)), m_translator(new SMTTranslator(*m_context)) {
+        m_bmc.reset(new BmcEngine(shared.system, *m_translator, *m_solver, mode));
+
+        std::lock_guard<std::mutex> lock(m_shared.mutex);
+        m_shared.solvers[m_case] = m_solver;
+        if (m_shared.done) {
+            Solver::interruptSolver(m_shared.backend, m_solver);
+        }
+    }
+
+    ~CaseRunner() {
+        {
+            std::lock_guard<std::mutex> lock(m_shared.mutex);
+            m_shared.solvers[m_case] = NULL;
+        }
+        m_bmc.reset();
+        delete m_translator;
+        delete m_context;
+        delete m_solver;
+    }
+
+    BmcEngine &bmc() {
+        return *m_bmc;
+    }
+
+private:
+    Shared &m_shared;
+    Shared::Case m_case;
+    SMT::Solver *m_solver;
+    llbmc::SMTContext *m_context;
+    SMTTranslator *m_translator;
+    std::unique_ptr<BmcEngine> m_bmc;
+};
+
+void KInduction::runBase(std::shared_ptr<Shared> shared, unsigned int maxK) {
+    try {
+        CaseRunner runner(*shared, Shared::Base, BmcEngine::BaseCase);
+
+        while (!shared->done && runner.bmc().getDepth() <= maxK) {
+            unsigned int depth = runner.bmc().getDepth();
+            SMT::Solver::Result result = runner.bmc().checkNext();
+
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            if (result == SMT::Solver::Satisfiable) {
+                shared->conclude(Unsafe, depth);
+            } else if (result == SMT::Solver::Unsatisfiable) {
+                shared->baseDepth = runner.bmc().getDepth();
+                shared->checkProof();
+            } else {
+                break;
+            }
+        }
+    } catch (const LLBMCException &) {
+        // without a base case the step case cannot conclude anything
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->conclude(Unknown, shared->baseDepth);
+    } catch (const std::exception &) {
+        // e.g. bad_alloc, nothing may escape the thread
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->conclude(Unknown, shared->baseDepth);
+    }
+}
+
+void KInduction::runStep(std::shared_ptr<Shared> shared, unsigned int maxK) {
+    try {
+        CaseRunner runner(*shared, Shared::Step, BmcEngine::StepCase);
+
+        while (!shared->done && runner.bmc().getDepth() <= maxK) {
+            unsigned int k = runner.bmc().getDepth();
+            SMT::Solver::Result result = runner.bmc().checkNext();
+
+            if (result == SMT::Solver::Unsatisfiable) {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                shared->stepFound = true;
+                shared->stepK = k;
+                shared->checkProof();
+                break;
+            } else if (result != SMT::Solver::Satisfiable) {
+                break;
+            }
+        }
+    } catch (const LLBMCException &) {
+        // the base case can still find a counterexample
+    } catch (const std::exception &) {
+        // likewise, the step case just stays unknown
+    }
+}
@@ -0,0 +1,57 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_KINDUCTION_H
+#define TRANSFORMERSOLVER_KINDUCTION_H
+
+#include "BmcEngine.h"
+#include "Solver.h"
+
+#include <memory>
+
+
+/*
+ * k-induction with the base case and the inductive step running on two
+ * threads, each with its own incremental solver, SMTContext and
+ * SMTTranslator. The base case is plain BMC, the step case an unrolling
+ * without init (BmcEngine::StepCase). The property is proved at k once the
+ * step holds for k and the base case has shown depths 0 .. k-1 safe. A
+ * counterexample in the base case disproves it. Whichever thread concludes
+ * stops the other one; solvers that can be interrupted are interrupted
+ * inside solve().
+ *
+ * No simple-path constraints are added, so some properties are only
+ * proved at a larger k than necessary or not at all.
+ */
+class KInduction {
+public:
+    enum Result {
+        Unsafe,
+        Safe,
+        Unknown
+    };
+
+    KInduction(const TransitionSystem &system, Solver::SMTSolver backend);
+
+    /* tries k = 0 .. maxK */
+    Result prove(unsigned int maxK);
+
+    /* k of the proof, or the depth of the counterexample */
+    unsigned int getK() const;
+
+private:
+    struct Shared;
+    class CaseRunner;
+
+    static void runBase(std::shared_ptr<Shared> shared, unsigned int maxK);
+
+    static void runStep(std::shared_ptr<Shared> shared, unsigned int maxK);
+
+    const TransitionSystem &m_system;
+    Solver::SMTSolver m_backend;
+    unsigned int m_k;
+};
+
+
+#endif //TRANSFORMERSOLVER_KINDUCTION_H
@@ -0,0 +1,378 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "PdrEngine.h"
+
+#include <llbmc/SMT/Model.h>
+#include <llbmc/Util/Bitvector.h>
+#include <llbmc/Util/LLBMCException.h>
+
+#include <memory>
+#include <queue>
+#include <sstream>
+
+
+namespace {
+    /* a frame solver answered neither sat nor unsat; unlike an LLBMCException this is no error */
+    struct SolverGaveUp {
+    };
+}
+
+
+/*
+ * Solver, context and translator of one frame, together with the state
+ * variables of the current and the next step.
+ */
+class PdrEngine::Frame {
+public:
+    Frame(const TransitionSystem &system, Solver::SMTSolver backend, unsigned int index, unsigned int &queries);
+
+    ~Frame();
+
+    /* conjunction of the literals of cube over the current or the next state */
+    SMT::BoolExp *mkCube(const Cube &cube, bool next);
+
+    /* bad(cur) */
+    SMT::BoolExp *mkBad();
+
+    /* adds the clause not cube over the current state */
+    void assertClause(const Cube &cube);
+
+    /* Satisfiable under the assumptions (released here) and, if withTrans, trans */
+    bool isSatisfiable(std::vector<SMT::BoolExp *> &assumptions, bool withTrans);
+
+    /* every bit of the current state in the last model */
+    Cube getModelCube();
+
+    SMT::SatCore &sat() {
+        return m_sat;
+    }
+
+private:
+    Frame(const Frame &);
+    Frame &operator=(const Frame &);
+
+    const TransitionSystem &m_system;
+    // released in reverse order, also when the constructor throws
+    std::unique_ptr<SMT::Solver> m_solver;
+    std::unique_ptr<llbmc::SMTContext> m_context;
+    std::unique_ptr<SMTTranslator> m_translator;
+    SMT::SatCore &m_sat;
+    TransitionSystem::State m_current;
+    TransitionSystem::State m_next;
+    SMT::BoolExp *m_transActive;
+    unsigned int &m_queries;
+};
+
+PdrEngine::Frame::Frame(const TransitionSystem &system, Solver::SMTSolver backend, unsigned int index,
+                        unsigned int &queries)
+        : m_system(system), m_solver(Solver::createSolver(backend)),
+          m_context(new llbmc::SMTContext(m_solver.get(), 4)),
+          m_translator(new SMTTranslator(*m_context)), m_sat(*m_solver->getSatCore()), m_transActive(NULL),
+          m_queries(queries) {
+    if (!m_solver->hasCapability(SMT::Solver::CapAssume)) {
+        throw LLBMCException("PDR needs a solver with assume!");
+    }
+    m_solver->enableIncrementalSolving();
+
+    m_current = m_system.frame(*m_translator, "cur");
+    m_next = m_system.frame(*m_translator, "next");
+
+    // actT --> trans(cur, next)
+    std::ostringstream name;
+    name << "pdr.trans@" << index;
+    m_transActive = m_sat.mk_free(name.str());
+    SMT::BoolExp *trans = m_system.trans(*m_translator, m_sat, m_current, m_next);
+    SMT::BoolExp *guarded = m_sat.mk_implies(m_transActive, trans);
+    m_solver->assertConstraint(guarded);
+    m_sat.release(guarded);
+    m_sat.release(trans);
+
+    if (index == 0) {
+        SMT::BoolExp *init = m_system.init(*m_translator, m_sat, m_current);
+        m_solver->assertConstraint(init);
+        m_sat.release(init);
+    }
+}
+
+PdrEngine::Frame::~Frame() {
+    m_sat.release(m_transActive);
+    TransitionSystem::releaseFrame(*m_solver, m_current);
+    TransitionSystem::releaseFrame(*m_solver, m_next);
+}
+
+SMT::BoolExp *PdrEngine::Frame::mkCube(const Cube &cube, bool next) {
+    const TransitionSystem::State &state = next ? m_next : m_current;
+    SMT::BoolExp *ret = m_sat.mk_true();
+    for (Cube::const_iterator it = cube.begin(); it != cube.end(); ++it) {
+        SMT::BoolExp *literal = m_translator->testBit(state[it->var], it->bit);
+        if (!it->value) {
+            SMT::BoolExp *negated = m_sat.mk_not(literal);
+            m_sat.release(literal);
+            literal = negated;
+        }
+        SMT::BoolExp *conjunction = m_sat.mk_and(ret, literal);
+        m_sat.release(ret);
+        m_sat.release(literal);
+        ret = conjunction;
+    }
+    return ret;
+}
+
+SMT::BoolExp *PdrEngine::Frame::mkBad() {
+    return m_system.bad(*m_translator, m_sat, m_current);
+}
+
+void PdrEngine::Frame::assertClause(const Cube &cube) {
+    SMT::BoolExp *exp = mkCube(cube, false);
+    SMT::BoolExp *clause = m_sat.mk_not(exp);
+    m_solver->assertConstraint(clause);
+    m_sat.release(clause);
+    m_sat.release(exp);
+}
+
+bool PdrEngine::Frame::isSatisfiable(std::vector<SMT::BoolExp *> &assumptions, bool withTrans) {
+    ++m_queries;
+    for (std::vector<SMT::BoolExp *>::iterator it = assumptions.begin(); it != assumptions.end(); ++it) {
+        m_solver->assume(*it);
+    }
+    if (withTrans) {
+        m_solver->assume(m_transActive);
+    }
+    m_solver->solve();
+
+    for (std::vector<SMT::BoolExp *>::iterator it = assumptions.begin(); it != assumptions.end(); ++it) {
+        m_sat.release(*it);
+    }
+    assumptions.clear();
+
+    switch (m_solver->getResult()) {
+        case SMT::Solver::Satisfiable:
+            return true;
+        case SMT::Solver::Unsatisfiable:
+            return false;
+        default:
+            throw SolverGaveUp();
+    }
+}
+
+PdrEngine::Cube PdrEngine::Frame::getModelCube() {
+    SMT::Model *model = m_solver->getModel();
+    const std::vector<TransitionSystem::StateVar> &vars = m_system.getStateVars();
+
+    Cube cube;
+    for (unsigned int var = 0; var < vars.size(); ++var) {
+        const Bitvector *value = model->getBitvector(m_current[var]);
+        for (unsigned int bit = 0; bit < vars[var].width; ++bit) {
+            Literal literal;
+            literal.var = var;
+            literal.bit = bit;
+            // bits the model leaves open are taken as 0
+            literal.value = value != NULL && value->isValid() && value->getBit(bit);
+            cube.push_back(literal);
+        }
+        delete value;
+    }
+    return cube;
+}
+
+
+//----------- engine -----------//
+
+PdrEngine::Statistics::Statistics()
+        : frames(0), lemmas(0), propagatedLemmas(0), blockedCubes(0), droppedLiterals(0), queries(0) {
+
+}
+
+bool PdrEngine::Obligation::operator<(const Obligation &other) const {
+    // std::priority_queue pops the largest element, the lowest level has to come first
+    return level > other.level;
+}
+
+PdrEngine::PdrEngine(const TransitionSystem &system, Solver::SMTSolver backend)
+        : m_system(system), m_backend(backend), m_invariantFrame(0) {
+
+}
+
+PdrEngine::~PdrEngine() {
+    for (std::vector<Frame *>::iterator it = m_frames.begin(); it != m_frames.end(); ++it) {
+        delete *it;
+    }
+}
+
+PdrEngine::Result PdrEngine::prove(unsigned int maxFrames) {
+    try {
+        if (m_frames.empty()) {
+            // F_0 is init, blocking bad there finds counterexamples of length 0
+            addFrame();
+            if (!blockBad()) {
+                return Unsafe;
+            }
+            addFrame();
+        }
+
+        while (m_frames.size() <= maxFrames) {
+            if (!blockBad()) {
+                return Unsafe;
+            }
+            addFrame();
+            if (propagate()) {
+                return Safe;
+            }
+        }
+    } catch (const SolverGaveUp &) {
+        // errors such as a backend without assume are LLBMCExceptions and reach the caller
+    }
+    return Unknown;
+}
+
+unsigned int PdrEngine::getInvariantFrame() const {
+    return m_invariantFrame;
+}
+
+const PdrEngine::Statistics &PdrEngine::getStatistics() const {
+    return m_statistics;
+}
+
+void PdrEngine::printStatistics(std::ostream &out) const {
+    out << "PDR frames:" << m_statistics.frames << "\n";
+    out << "PDR lemmas:" << m_statistics.lemmas << " (" << m_statistics.propagatedLemmas << " propagated)" << "\n";
+    out << "PDR blocked cubes:" << m_statistics.blockedCubes << "\n";
+    out << "PDR dropped literals:" << m_statistics.droppedLiterals << "\n";
+    out << "PDR solver queries:" << m_statistics.queries << "\n";
+}
+
+void PdrEngine::addFrame() {
+    unsigned int index = static_cast<unsigned int>(m_frames.size());
+    m_frames.push_back(new Frame(m_system, m_backend, index, m_statistics.queries));
+    m_lemmas.push_back(std::vector<Cube>());
+    ++m_statistics.frames;
+}
+
+bool PdrEngine::blockBad() {
+    Frame &top = *m_frames.back();
+    for (;;) {
+        std::vector<SMT::BoolExp *> assumptions;
+        assumptions.push_back(top.mkBad());
+        if (!top.isSatisfiable(assumptions, false)) {
+            return true;
+        }
+        if (!block(top.getModelCube())) {
+            return false;
+        }
+    }
+}
+
+bool PdrEngine::block(const Cube &bad) {
+    unsigned int top = static_cast<unsigned int>(m_frames.size() - 1);
+    // bad states in F_0 or in init are reachable right away
+    if (top == 0 || intersectsInit(bad)) {
+        return false;
+    }
+
+    std::priority_queue<Obligation> obligations;
+    Obligation first;
+    first.level = top;
+    first.cube = bad;
+    obligations.push(first);
+
+    while (!obligations.empty()) {
+        Obligation obligation = obligations.top();
+
+        Obligation predecessor;
+        if (!isRelativeInductive(obligation.cube, obligation.level - 1, &predecessor.cube)) {
+            // an initial predecessor (always the case in F_0) completes a counterexample
+            if (obligation.level == 1 || intersectsInit(predecessor.cube)) {
+                return false;
+            }
+            predecessor.level = obligation.level - 1;
+            obligations.push(predecessor);
+            continue;
+        }
+
+        obligations.pop();
+        addLemma(generalize(obligation.cube, obligation.level - 1), obligation.level);
+        ++m_statistics.blockedCubes;
+
+        // the cube may also be reachable in more steps, block it further up as well
+        if (obligation.level < top) {
+            ++obligation.level;
+            obligations.push(obligation);
+        }
+    }
+    return true;
+}
+
+bool PdrEngine::isRelativeInductive(const Cube &cube, unsigned int level, Cube *predecessor) {
+    // F_level and not cube and trans and cube' is unsatisfiable
+    Frame &frame = *m_frames[level];
+    std::vector<SMT::BoolExp *> assumptions;
+    SMT::BoolExp *current = frame.mkCube(cube, false);
+    assumptions.push_back(frame.sat().mk_not(current));
+    frame.sat().release(current);
+    assumptions.push_back(frame.mkCube(cube, true));
+
+    if (!frame.isSatisfiable(assumptions, true)) {
+        return true;
+    }
+    if (predecessor != NULL) {
+        *predecessor = frame.getModelCube();
+    }
+    return false;
+}
+
+bool PdrEngine::intersectsInit(const Cube &cube) {
+    Frame &init = *m_frames[0];
+    std::vector<SMT::BoolExp *> assumptions;
+    assumptions.push_back(init.mkCube(cube, false));
+    return init.isSatisfiable(assumptions, false);
+}
+
+PdrEngine::Cube PdrEngine::generalize(const Cube &cube, unsigned int level) {
+    Cube generalized = cube;
+    unsigned int i = 0;
+    while (i < generalized.size() && generalized.size() > 1) {
+        Cube candidate = generalized;
+        candidate.erase(candidate.begin() + i);
+        if (!intersectsInit(candidate) && isRelativeInductive(candidate, level, NULL)) {
+            generalized.swap(candidate);
+            ++m_statistics.droppedLiterals;
+        } else {
+            ++i;
+        }
+    }
+    return generalized;
+}
+
+void PdrEngine::addLemma(const Cube &cube, unsigned int level) {
+    m_lemmas[level].push_back(cube);
+    for (unsigned int i = 1; i <= level; ++i) {
+        m_frames[i]->assertClause(cube);
+    }
+    ++m_statistics.lemmas;
+}
+
+bool PdrEngine::propagate() {
+    unsigned int top = static_cast<unsigned int>(m_frames.size() - 1);
+    for (unsigned int i = 1; i < top; ++i) {
+        std::vector<Cube> kept;
+        for (std::vector<Cube>::iterator it = m_lemmas[i].begin(); it != m_lemmas[i].end(); ++it) {
+            if (isRelativeInductive(*it, i, NULL)) {
+                m_lemmas[i + 1].push_back(*it);
+                m_frames[i + 1]->assertClause(*it);
+                ++m_statistics.propagatedLemmas;
+            } else {
+                kept.push_back(*it);
+            }
+        }
+        m_lemmas[i].swap(kept);
+
+        if (m_lemmas[i].empty()) {
+            // F_i = F_i+1, i.e. F_i is an inductive invariant
+            m_invariantFrame = i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,112 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_PDRENGINE_H
+#define TRANSFORMERSOLVER_PDRENGINE_H
+
+#include "Solver.h"
+#include "TransitionSystem.h"
+
+#include <ostream>
+#include <vector>
+
+
+/*
+ * Property directed reachability (IC3) over the bits of the state
+ * variables. Every frame F_i has its own incremental solver with
+ * trans(cur, next) asserted behind an activation literal made by
+ * SatCore::mk_free, so the same solver answers queries on F_i alone and on
+ * F_i and trans. Frame 0 also holds init. Lemmas are stored by the highest
+ * frame they were proved for and asserted into the solvers of all frames
+ * up to that one, so no solver is ever rebuilt.
+ *
+ * Cubes are conjunctions of single state bits taken from the model of a
+ * counterexample to induction. They are generalized by dropping literals
+ * as long as the cube stays disjoint from init and relatively inductive.
+ */
+class PdrEngine {
+public:
+    enum Result {
+        Unsafe,
+        Safe,
+        Unknown
+    };
+
+    struct Statistics {
+        unsigned int frames;
+        unsigned int lemmas;
+        unsigned int propagatedLemmas;
+        unsigned int blockedCubes;
+        unsigned int droppedLiterals;
+        unsigned int queries;
+
+        Statistics();
+    };
+
+    PdrEngine(const TransitionSystem &system, Solver::SMTSolver backend);
+
+    ~PdrEngine();
+
+    /*
+     * gives up after maxFrames frames, a later call continues; Unknown also if
+     * a solver gives up. Throws LLBMCException for a backend without assume.
+     */
+    Result prove(unsigned int maxFrames);
+
+    /* index of the frame that is an inductive invariant, after Safe */
+    unsigned int getInvariantFrame() const;
+
+    const Statistics &getStatistics() const;
+
+    void printStatistics(std::ostream &out) const;
+
+private:
+    PdrEngine(const PdrEngine &);
+    PdrEngine &operator=(const PdrEngine &);
+
+    /* state bit var[bit] equals value */
+    struct Literal {
+        unsigned int var;
+        unsigned int bit;
+        bool value;
+    };
+
+    typedef std::vector<Literal> Cube;
+
+    struct Obligation {
+        unsigned int level;
+        Cube cube;
+
+        bool operator<(const Obligation &other) const;
+    };
+
+    class Frame;
+
+    void addFrame();
+
+    bool blockBad();
+
+    bool block(const Cube &bad);
+
+    bool isRelativeInductive(const Cube &cube, unsigned int level, Cube *predecessor);
+
+    bool intersectsInit(const Cube &cube);
+
+    Cube generalize(const Cube &cube, unsigned int level);
+
+    void addLemma(const Cube &cube, unsigned int level);
+
+    bool propagate();
+
+    const TransitionSystem &m_system;
+    Solver::SMTSolver m_backend;
+    std::vector<Frame *> m_frames;
+    // m_lemmas[i]: cubes blocked in F_1 .. F_i but not yet in F_i+1
+    std::vector<std::vector<Cube> > m_lemmas;
+    unsigned int m_invariantFrame;
+    Statistics m_statistics;
+};
+
+
+#endif //TRANSFORMERSOLVER_PDRENGINE_H
@@ -0,0 +1,167 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "QueryCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+const char CacheMagic[8] = {'T', 'S', 'Q', 'C', 'A', 'C', 'H', 'E'};
+const uint32_t CacheVersion = 2;
+
+}
+
+QueryCache::Entry::Entry() : result(SMT::Solver::Unknown), hasModel(false) {
+
+}
+
+QueryCache::QueryCache(const std::string &path, uint32_t slotCount)
+        : m_fd(-1), m_data(NULL), m_size(sizeof(Header) + sizeof(Slot) * static_cast<size_t>(slotCount)),
+          m_slotCount(slotCount) {
+    if (slotCount == 0) {
+        return;
+    }
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0) {
+        return;
+    }
+
+    struct stat info;
+    if (fstat(m_fd, &info) != 0) {
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+
+    // look at the header before touching the file, only our own caches are rewritten
+    bool matches = false;
+    if (info.st_size != 0) {
+        Header header;
+        if (static_cast<size_t>(info.st_size) < sizeof(Header)
+            || pread(m_fd, &header, sizeof(Header), 0) != static_cast<ssize_t>(sizeof(Header))
+            || memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) != 0) {
+            close(m_fd);
+            m_fd = -1;
+            return;
+        }
+        matches = header.version == CacheVersion && header.slotCount == slotCount
+                  && header.modelWords == ModelWords && static_cast<size_t>(info.st_size) == m_size;
+    }
+    if (!matches && !initialize(slotCount)) {
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+
+    void *data = mmap(NULL, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) {
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    m_data = data;
+}
+
+bool QueryCache::initialize(uint32_t slotCount) {
+    // truncating to 0 first zeroes all slots
+    if (ftruncate(m_fd, 0) != 0 || ftruncate(m_fd, static_cast<off_t>(m_size)) != 0) {
+        return false;
+    }
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+    header.version = CacheVersion;
+    header.slotCount = slotCount;
+    header.modelWords = ModelWords;
+    return pwrite(m_fd, &header, sizeof(Header), 0) == static_cast<ssize_t>(sizeof(Header));
+}
+
+QueryCache::~QueryCache() {
+    if (m_data != NULL) {
+        munmap(m_data, m_size);
+    }
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+bool QueryCache::isOpen() const {
+    return m_data != NULL;
+}
+
+bool QueryCache::lookup(uint64_t key, uint64_t check, Entry &entry) const {
+    if (m_data == NULL) {
+        return false;
+    }
+    key = slotKey(key);
+    for (uint32_t probe = 0; probe < MaxProbes; ++probe) {
+        const Slot *current = slot(static_cast<uint32_t>((key + probe) % m_slotCount));
+        if (current->key == 0) {
+            return false;
+        }
+        if (current->key != key) {
+            continue;
+        }
+        if (current->check != check) {
+            // another query with the same key
+            return false;
+        }
+
+        entry.result = static_cast<SMT::Solver::Result>(current->result);
+        entry.hasModel = current->modelSize != NoModel && current->modelSize <= ModelWords;
+        entry.model.clear();
+        if (entry.hasModel) {
+            entry.model.assign(current->model, current->model + current->modelSize);
+        }
+        return true;
+    }
+    return false;
+}
+
+void QueryCache::store(uint64_t key, uint64_t check, const Entry &entry) {
+    if (m_data == NULL) {
+        return;
+    }
+    if (entry.result != SMT::Solver::Satisfiable && entry.result != SMT::Solver::Unsatisfiable) {
+        return;
+    }
+    key = slotKey(key);
+
+    Slot *target = slot(static_cast<uint32_t>(key % m_slotCount));
+    for (uint32_t probe = 0; probe < MaxProbes; ++probe) {
+        Slot *current = slot(static_cast<uint32_t>((key + probe) % m_slotCount));
+        if (current->key == 0 || current->key == key) {
+            target = current;
+            break;
+        }
+    }
+
+    target->check = check;
+    target->result = static_cast<uint32_t>(entry.result);
+    if (entry.hasModel && entry.model.size() <= ModelWords) {
+        target->modelSize = static_cast<uint32_t>(entry.model.size());
+        std::copy(entry.model.begin(), entry.model.end(), target->model);
+    } else {
+        target->modelSize = NoModel;
+    }
+    target->key = key;
+}
+
+uint64_t QueryCache::slotKey(uint64_t key) {
+    // 0 marks an empty slot
+    return key == 0 ? 1 : key;
+}
+
+QueryCache::Slot *QueryCache::slot(uint32_t index) const {
+    char *base = static_cast<char *>(m_data) + sizeof(Header);
+    return reinterpret_cast<Slot *>(base) + index;
+}
@@ -0,0 +1,93 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_QUERYCACHE_H
+#define TRANSFORMERSOLVER_QUERYCACHE_H
+
+#include <llbmc/SMT/Solver.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/*
+ * Results of earlier queries, keyed by SMTTranslator::getQueryHash and kept
+ * in a memory-mapped file so they survive the process. The file is a
+ * header followed by a fixed number of slots, open addressing with a short
+ * probe sequence; when all probed slots are taken the first one is
+ * overwritten. Each slot also keeps the check hash of its query, a hit
+ * needs both to match. Only Satisfiable and Unsatisfiable are stored, with
+ * the values of the query variables if all of them fit into 64 bits.
+ *
+ * An existing file that is not a query cache is left alone and the cache
+ * stays disabled. There is no locking, the file is meant for one process
+ * at a time.
+ */
+class QueryCache {
+public:
+    struct Entry {
+        SMT::Solver::Result result;
+        bool hasModel;
+        /* one word per variable, in the order of SMTTranslator::getVariables */
+        std::vector<uint64_t> model;
+
+        Entry();
+    };
+
+    enum {
+        ModelWords = 16,
+        MaxProbes = 8
+    };
+
+    /* a file that cannot be opened, mapped or is no query cache leaves the cache disabled */
+    QueryCache(const std::string &path, uint32_t slotCount = 65536);
+
+    ~QueryCache();
+
+    bool isOpen() const;
+
+    bool lookup(uint64_t key, uint64_t check, Entry &entry) const;
+
+    void store(uint64_t key, uint64_t check, const Entry &entry);
+
+private:
+    QueryCache(const QueryCache &);
+    QueryCache &operator=(const QueryCache &);
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t slotCount;
+        uint32_t modelWords;
+        uint32_t reserved;
+    };
+
+    struct Slot {
+        uint64_t key;
+        uint64_t check;
+        uint32_t result;
+        /* number of model words, NoModel if the model was not stored */
+        uint32_t modelSize;
+        uint64_t model[ModelWords];
+    };
+
+    static const uint32_t NoModel = 0xffffffff;
+
+    static uint64_t slotKey(uint64_t key);
+
+    /* sets up the header and slots of an empty or outdated cache file */
+    bool initialize(uint32_t slotCount);
+
+    Slot *slot(uint32_t index) const;
+
+    int m_fd;
+    void *m_data;
+    size_t m_size;
+    uint32_t m_slotCount;
+};
+
+
+#endif //TRANSFORMERSOLVER_QUERYCACHE_H
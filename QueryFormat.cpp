@@ -0,0 +1,59 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "QueryFormat.h"
+#include "DagLowering.h"
+#include "FormulaFile.h"
+#include "SmtLib2Parser.h"
+#include "Solver.h"
+
+
+QueryFormat::~QueryFormat() {
+
+}
+
+BuiltinQueryFormat::BuiltinQueryFormat() : m_name("builtin") {
+
+}
+
+const std::string &BuiltinQueryFormat::getName() const {
+    return m_name;
+}
+
+void BuiltinQueryFormat::assertQuery(const char *, size_t, SMTTranslator &translator, SMT::Solver &solver) {
+    Solver::assertConstraints(translator, solver);
+}
+
+BinaryQueryFormat::BinaryQueryFormat() : m_name("binary") {
+
+}
+
+const std::string &BinaryQueryFormat::getName() const {
+    return m_name;
+}
+
+void BinaryQueryFormat::assertQuery(const char *data, size_t size, SMTTranslator &translator, SMT::Solver &solver) {
+    FormulaFile file(data, size);
+    TermDag dag;
+    file.load(dag);
+    DagLowering lowering(dag, solver);
+    const std::vector<TermDag::NodeId> &assertions = dag.getAssertions();
+    for (std::vector<TermDag::NodeId>::const_iterator it = assertions.begin(); it != assertions.end(); ++it) {
+        translator.assertConstraint(solver, lowering.lowerBool(*it));
+    }
+}
+
+SmtLib2QueryFormat::SmtLib2QueryFormat() : m_name("smtlib2") {
+
+}
+
+const std::string &SmtLib2QueryFormat::getName() const {
+    return m_name;
+}
+
+void SmtLib2QueryFormat::assertQuery(const char *data, size_t size, SMTTranslator &translator, SMT::Solver &solver) {
+    SmtLib2Parser parser(translator, solver);
+    parser.setSolveOnCheckSat(false);
+    parser.parse(data, size);
+}
@@ -0,0 +1,78 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_QUERYFORMAT_H
+#define TRANSFORMERSOLVER_QUERYFORMAT_H
+
+#include "SMTTranslator.h"
+
+#include <llbmc/SMT/Solver.h>
+
+#include <cstddef>
+#include <string>
+
+
+/*
+ * Turns the payload of a query into constraints. Implementations assert
+ * everything through SMTTranslator::assertConstraint and throw an
+ * LLBMCException for malformed input.
+ */
+class QueryFormat {
+public:
+    virtual ~QueryFormat();
+
+    /* the name clients select the format with */
+    virtual const std::string &getName() const = 0;
+
+    virtual void assertQuery(const char *data, size_t size, SMTTranslator &translator, SMT::Solver &solver) = 0;
+};
+
+
+/* The constraints of Solver::assertConstraints, the payload is ignored. */
+class BuiltinQueryFormat : public QueryFormat {
+public:
+    BuiltinQueryFormat();
+
+    virtual const std::string &getName() const;
+
+    virtual void assertQuery(const char *data, size_t size, SMTTranslator &translator, SMT::Solver &solver);
+
+private:
+    std::string m_name;
+};
+
+
+/* A FormulaFile in the payload, lowered into the solver of the query. */
+class BinaryQueryFormat : public QueryFormat {
+public:
+    BinaryQueryFormat();
+
+    virtual const std::string &getName() const;
+
+    virtual void assertQuery(const char *data, size_t size, SMTTranslator &translator, SMT::Solver &solver);
+
+private:
+    std::string m_name;
+};
+
+
+/*
+ * An SMT-LIB2 script in the payload, see SmtLib2Parser. The query is solved
+ * once after the script, so scripts with push, pop, several check-sat or
+ * asserts after the check-sat are rejected.
+ */
+class SmtLib2QueryFormat : public QueryFormat {
+public:
+    SmtLib2QueryFormat();
+
+    virtual const std::string &getName() const;
+
+    virtual void assertQuery(const char *data, size_t size, SMTTranslator &translator, SMT::Solver &solver);
+
+private:
+    std::string m_name;
+};
+
+
+#endif //TRANSFORMERSOLVER_QUERYFORMAT_H
@@ -1,9 +1,23 @@
-#include <llbmc/SMT/QF_ABV.h>
+#include "QF_ABV.h"
 #include <llbmc/Util/LLBMCException.h>
 
 namespace SMT
 {
 
+QF_ABV::QF_ABV()
+  : m_shiftEncoding(BarrelShiftEncoding)
+{}
+
+void QF_ABV::setShiftEncoding(ShiftEncoding encoding)
+{
+    m_shiftEncoding = encoding;
+}
+
+QF_ABV::ShiftEncoding QF_ABV::getShiftEncoding() const
+{
+    return m_shiftEncoding;
+}
+
 BoolExp *QF_ABV::bvne(BVExp *exp1, BVExp *exp2)
 {
     BoolExp *equal = eq(exp1, exp2);
@@ -14,11 +28,10 @@ BoolExp *QF_ABV::bvne(BVExp *exp1, BVExp *exp2)
 
 BoolExp *QF_ABV::bvule(BVExp *exp1, BVExp *exp2)
 {
-    BoolExp *ult = bvult(exp1, exp2);
-    BoolExp *equal = eq(exp1, exp2);
-    BoolExp *ret = mk_or(ult, equal);
-    release(ult);
-    release(equal);
+    // exp1 <= exp2  <=>  !(exp2 < exp1), one comparator and no equality
+    BoolExp *ugt = bvult(exp2, exp1);
+    BoolExp *ret = mk_not(ugt);
+    release(ugt);
     return ret;
 }
 
@@ -34,7 +47,18 @@ BoolExp *QF_ABV::bvuge(BVExp *exp1, BVExp *exp2)
 
 BoolExp *QF_ABV::bvslt(BVExp *exp1, BVExp *exp2)
 {
+    // a ripple comparator costs the same 4w-3 gates on sign-flipped operands
+    // as this lowering does, so it is kept; only one bit needs its own case
     unsigned int w = width(exp1);
+    if (w == 1) {
+        // a single bit is the sign, only -1 < 0
+        BVExp *pos2 = bvnot(exp2);
+        BVExp *neg1pos2 = bvand(exp1, pos2);
+        BoolExp *ret = bv12bool(neg1pos2);
+        release(neg1pos2);
+        release(pos2);
+        return ret;
+    }
 
     // are exp1 and exp2 positive or negative
     BVExp *neg1 = extract(w - 1, w - 1, exp1);
@@ -77,11 +101,9 @@ BoolExp *QF_ABV::bvslt(BVExp *exp1, BVExp *exp2)
 
 BoolExp *QF_ABV::bvsle(BVExp *exp1, BVExp *exp2)
 {
-    BoolExp *slt = bvslt(exp1, exp2);
-    BoolExp *equal = eq(exp1, exp2);
-    BoolExp *ret = mk_or(slt, equal);
-    release(slt);
-    release(equal);
+    BoolExp *sgt = bvslt(exp2, exp1);
+    BoolExp *ret = mk_not(sgt);
+    release(sgt);
     return ret;
 }
 
@@ -95,6 +117,42 @@ BoolExp *QF_ABV::bvsge(BVExp *exp1, BVExp *exp2)
     return bvsle(exp2, exp1);
 }
 
+namespace
+{
+
+// sizes in 2-input gates of a ripple bit-blasting, inverters are free
+unsigned int ultGates(unsigned int w)
+{
+    // bit 0: !a & b, every further bit: xnor, two ands and an or
+    return 4 * w - 3;
+}
+
+unsigned int eqGates(unsigned int w)
+{
+    return 2 * w - 1;
+}
+
+unsigned int sltGates(unsigned int w)
+{
+    // sign and, sign eq, mk_and, mk_or plus the comparator on the value bits
+    return w == 1 ? 1 : 4 + ultGates(w - 1);
+}
+
+}
+
+void QF_ABV::reportComparisonEncodings(std::ostream &out, unsigned int maxWidth)
+{
+    out << "comparison encoding size in 2-input gates (old -> new)\n";
+    out << "width\tule/uge\t\tsle/sge\n";
+    for (unsigned int w = 1; w <= maxWidth; w *= 2) {
+        unsigned int oldUle = ultGates(w) + eqGates(w) + 1;
+        unsigned int oldSle = sltGates(w) + eqGates(w) + 1;
+        out << w
+            << "\t" << oldUle << " -> " << ultGates(w)
+            << "\t" << oldSle << " -> " << sltGates(w) << "\n";
+    }
+}
+
 BoolExp *QF_ABV::bvuaddo(BVExp *exp1, BVExp *exp2)
 {
     unsigned int bvw = width(exp1);
@@ -225,7 +283,8 @@ BoolExp *QF_ABV::bvsmulo(BVExp *exp1, BVExp *exp2)
 {
     unsigned int bvw = width(exp1);
     if (bvw == 1) {
-        BVExp *tmp = bvor(exp1, exp2);
+        // only -1 * -1 leaves the range
+        BVExp *tmp = bvand(exp1, exp2);
         BoolExp *res = bv12bool(tmp);
         release(tmp);
         return res;
@@ -304,11 +363,16 @@ BoolExp *QF_ABV::bvsmulo(BVExp *exp1, BVExp *exp2)
 BoolExp *QF_ABV::bvsdivo(BVExp *exp1, BVExp *exp2)
 {
     unsigned int bvw = width(exp1);
-    BVExp *tmp1 = bvones(bvw-1);
-    BVExp *tmp2 = uext(tmp1, bvw);
-    BVExp *tmp3 = bvones(1);
-    BVExp *tmp4 = uext(tmp3, bvw);
-    BVExp *min = bvadd(tmp2, tmp4);
+    // the smallest value is the sign bit alone, on one bit it is the sign bit itself
+    BVExp *sign = bvones(1);
+    BVExp *min;
+    if (bvw == 1) {
+        min = copy(sign);
+    } else {
+        BVExp *zeros = bvzeros(bvw-1);
+        min = concat(sign, zeros);
+        release(zeros);
+    }
     BVExp *ones = bvones(bvw);
     BoolExp *isMin1 = eq(exp1, min);
     BoolExp *isOnes2 = eq(exp2, ones);
@@ -317,9 +381,7 @@ BoolExp *QF_ABV::bvsdivo(BVExp *exp1, BVExp *exp2)
     release(isMin1);
     release(ones);
     release(min);
-    release(tmp3);
-    release(tmp2);
-    release(tmp1);
+    release(sign);
     return res;
 }
 
@@ -385,86 +447,113 @@ BVExp *QF_ABV::bvsub(BVExp *exp1, BVExp *exp2)
 
 BVExp *QF_ABV::bvsdiv(BVExp *exp1, BVExp *exp2)
 {
-    unsigned int bvw = width(exp1);
-    BVExp *sign1 = extract(bvw-1, bvw-1, exp1);
-    BoolExp *sign1bool = bv12bool(sign1);
-    BVExp *sign2 = extract(bvw-1, bvw-1, exp2);
-    BoolExp *sign2bool = bv12bool(sign2);
-
-    // xor: must result be signed?
-    BVExp *signxor = bvxor(sign1, sign2);
-    BoolExp *signxorbool = bv12bool(signxor);
+    SignedDivision &div = signedDivision(exp1, exp2);
+    if (div.quotient == NULL) {
+        // sign result if necessary
+        BVExp *udivneg = bvneg(div.udiv);
+        div.quotient = bvcond(div.signxor, udivneg, div.udiv);
+        release(udivneg);
+    }
+    return copy(div.quotient);
+}
 
-    // normalize exp1 and exp2
-    BVExp *negexp1 = bvneg(exp1);
-    BVExp *condexp1 = bvcond(sign1bool, negexp1, exp1);
-    BVExp *negexp2 = bvneg(exp2);
-    BVExp *condexp2 = bvcond(sign2bool, negexp2, exp2);
+BVExp *QF_ABV::bvsrem(BVExp *exp1, BVExp *exp2)
+{
+    SignedDivision &div = signedDivision(exp1, exp2);
+    if (div.remainder == NULL) {
+        // derive the unsigned remainder from the shared quotient:
+        // urem = norm1 - udiv * norm2
+        BVExp *prod = bvmul(div.udiv, div.norm2);
+        BVExp *urem = bvsub(div.norm1, prod);
+
+        // the remainder takes the sign of the dividend
+        BVExp *uremneg = bvneg(urem);
+        div.remainder = bvcond(div.sign1, uremneg, urem);
+
+        release(uremneg);
+        release(urem);
+        release(prod);
+    }
+    return copy(div.remainder);
+}
 
-    // unsigned divide
-    BVExp *udiv = bvudiv(condexp1, condexp2);
+QF_ABV::SignedDivision &QF_ABV::signedDivision(BVExp *exp1, BVExp *exp2)
+{
+    for (SignedDivisionCache::iterator it = m_signedDivisions.begin(); it != m_signedDivisions.end(); ++it) {
+        if (it->dividend == exp1 && it->divisor == exp2) {
+            return *it;
+        }
+    }
 
-    // sign result if necessary
-    BVExp *udivneg = bvneg(udiv);
-    BVExp *res = bvcond(signxorbool, udivneg, udiv);
+    // forget the oldest operand pair
+    if (m_signedDivisions.size() >= MaxSignedDivisions) {
+        releaseDivision(m_signedDivisions.front());
+        m_signedDivisions.pop_front();
+    }
 
-    // cleanup
-    release(udivneg);
-    release(udiv);
-    release(condexp2);
-    release(negexp2);
-    release(condexp1);
-    release(negexp1);
-    release(signxorbool);
-    release(signxor);
-    release(sign2bool);
-    release(sign2);
-    release(sign1bool);
-    release(sign1);
+    unsigned int bvw = width(exp1);
+    SignedDivision div;
 
-    return res;
-}
+    // keep the operands alive, their handles are the key
+    div.dividend = copy(exp1);
+    div.divisor = copy(exp2);
 
-BVExp *QF_ABV::bvsrem(BVExp *exp1, BVExp *exp2)
-{
-    unsigned int bvw = width(exp1);
     BVExp *sign1 = extract(bvw-1, bvw-1, exp1);
-    BoolExp *sign1bool = bv12bool(sign1);
+    div.sign1 = bv12bool(sign1);
     BVExp *sign2 = extract(bvw-1, bvw-1, exp2);
     BoolExp *sign2bool = bv12bool(sign2);
 
-    // xor: must result be signed?
+    // xor: must the quotient be signed?
     BVExp *signxor = bvxor(sign1, sign2);
-    BoolExp *signxorbool = bv12bool(signxor);
+    div.signxor = bv12bool(signxor);
 
     // normalize exp1 and exp2
     BVExp *negexp1 = bvneg(exp1);
-    BVExp *condexp1 = bvcond(sign1bool, negexp1, exp1);
+    div.norm1 = bvcond(div.sign1, negexp1, exp1);
     BVExp *negexp2 = bvneg(exp2);
-    BVExp *condexp2 = bvcond(sign2bool, negexp2, exp2);
+    div.norm2 = bvcond(sign2bool, negexp2, exp2);
 
-    // unsigned remainder
-    BVExp *urem = bvurem(condexp1, condexp2);
+    // the one unsigned divider shared by quotient and remainder
+    div.udiv = bvudiv(div.norm1, div.norm2);
 
-    // sign result if necessary
-    BVExp *uremneg = bvneg(urem);
-    BVExp *res = bvcond(signxorbool, uremneg, urem);
+    div.quotient = NULL;
+    div.remainder = NULL;
 
     // cleanup
-    release(uremneg);
-    release(urem);
-    release(condexp2);
     release(negexp2);
-    release(condexp1);
     release(negexp1);
-    release(signxorbool);
     release(signxor);
     release(sign2bool);
     release(sign2);
-    release(sign1bool);
     release(sign1);
 
-    return res;
+    m_signedDivisions.push_back(div);
+    return m_signedDivisions.back();
+}
+
+void QF_ABV::clearDivisionCache()
+{
+    for (SignedDivisionCache::iterator it = m_signedDivisions.begin(); it != m_signedDivisions.end(); ++it) {
+        releaseDivision(*it);
+    }
+    m_signedDivisions.clear();
+}
+
+void QF_ABV::releaseDivision(SignedDivision &div)
+{
+    if (div.remainder != NULL) {
+        release(div.remainder);
+    }
+    if (div.quotient != NULL) {
+        release(div.quotient);
+    }
+    release(div.udiv);
+    release(div.norm2);
+    release(div.norm1);
+    release(div.signxor);
+    release(div.sign1);
+    release(div.divisor);
+    release(div.dividend);
 }
 
 // round up n to the next power of two (helper for shifts)
@@ -523,6 +612,37 @@ BVExp *QF_ABV::bvArithRightShift(BVExp *exp, unsigned int amount, BoolExp *isSig
 }
 
 BVExp *QF_ABV::bvashr(BVExp *exp1, BVExp *exp2)
+{
+    unsigned int bvw = width(exp1);
+    if (bvw == 1) {
+        // the only bit is the sign bit, shifting keeps it
+        return copy(exp1);
+    }
+
+    BVExp *shifted;
+    if (m_shiftEncoding == LinearShiftEncoding) {
+        shifted = bvashrLinear(exp1, exp2);
+    } else {
+        shifted = bvashrBarrel(exp1, exp2);
+    }
+
+    //both encodings only look at the low log2(npo2(bvw)) bits of the shift
+    //amount, amounts >= bvw shift out everything but the sign
+    Bitvector widthbv(bvw, width(exp2));
+    BVExp *widthexp = bv2bv(&widthbv);
+    BoolExp *shiftOut = bvuge(exp2, widthexp);
+    BVExp *sign = extract(bvw-1, bvw-1, exp1);
+    BVExp *fill = sext(sign, bvw);
+    BVExp *res = bvcond(shiftOut, fill, shifted);
+    release(fill);
+    release(sign);
+    release(shiftOut);
+    release(widthexp);
+    release(shifted);
+    return res;
+}
+
+BVExp *QF_ABV::bvashrLinear(BVExp *exp1, BVExp *exp2)
 {
     unsigned int bvw = width(exp1);
     BVExp *res = copy(exp1);
@@ -539,12 +659,14 @@ BVExp *QF_ABV::bvashr(BVExp *exp1, BVExp *exp2)
     //construct a big if-then-elif-elif-... with one case per possible shift amount
     for (unsigned int i = bvw-1; i != 0; --i) {
         Bitvector tmpbv(i, shiftBits);
-        BoolExp *isEq = eq(shift, bv2bv(&tmpbv));
+        BVExp *amount = bv2bv(&tmpbv);
+        BoolExp *isEq = eq(shift, amount);
         BVExp *then = bvArithRightShift(exp1, i, signBool, shiftBits);
         BVExp *tmp = bvcond(isEq, then, res);
         release(res);
         release(then);
         release(isEq);
+        release(amount);
         res = tmp;
     }
 
@@ -554,5 +676,39 @@ BVExp *QF_ABV::bvashr(BVExp *exp1, BVExp *exp2)
     return res;
 }
 
+BVExp *QF_ABV::bvashrBarrel(BVExp *exp1, BVExp *exp2)
+{
+    unsigned int bvw = width(exp1);
+    unsigned int shiftBits = getShiftBits(bvw);
+
+    //all bits equal to the sign bit, sliced to fill the vacated positions
+    BVExp *sign = extract(bvw-1, bvw-1, exp1);
+    BVExp *fill = sext(sign, bvw);
+
+    //layer i shifts by 2^i if bit i of the shift amount is set. The largest
+    //layer shifts by npo2(bvw)/2 which is always < bvw; bvashr handles
+    //amounts >= bvw.
+    BVExp *res = copy(exp1);
+    for (unsigned int i = 0; i < shiftBits; ++i) {
+        unsigned int amount = static_cast<unsigned int>(1) << i;
+        BVExp *bit = extract(i, i, exp2);
+        BoolExp *doShift = bv12bool(bit);
+        BVExp *pad = extract(amount - 1, 0, fill);
+        BVExp *slice = extract(bvw - 1, amount, res);
+        BVExp *shifted = concat(pad, slice);
+        BVExp *tmp = bvcond(doShift, shifted, res);
+        release(shifted);
+        release(slice);
+        release(pad);
+        release(doShift);
+        release(bit);
+        release(res);
+        res = tmp;
+    }
+
+    release(fill);
+    release(sign);
+    return res;
 }
 
+}
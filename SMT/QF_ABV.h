@@ -5,6 +5,9 @@
 #include "TheoryOfBitvectors.h"
 #include "TheoryOfArrays.h"
 
+#include <deque>
+#include <ostream>
+
 namespace SMT
 {
 
@@ -27,6 +30,21 @@ public:
     using SatCore::copy;
     using TheoryOfBitvectors::copy;
 
+    /// \brief Encodings available for bvashr
+    enum ShiftEncoding
+    {
+        /// one bvcond per possible shift amount, O(w) comparators
+        LinearShiftEncoding,
+        /// one mux layer per bit of the shift amount, O(log w) muxes
+        BarrelShiftEncoding
+    };
+
+    QF_ABV();
+
+    /// Select the encoding used by bvashr, the linear one is kept for benchmarking.
+    void setShiftEncoding(ShiftEncoding encoding);
+    ShiftEncoding getShiftEncoding() const;
+
     BoolExp *bvne(BVExp*, BVExp*);
     BoolExp *bvule(BVExp*, BVExp*);
     BoolExp *bvugt(BVExp*, BVExp*);
@@ -56,8 +74,47 @@ public:
 
     BVExp *bvashr(BVExp*, BVExp*);
 
+    /// Print the size of the non-strict comparison lowerings before and after
+    /// the single-comparator rewrite for the power-of-two widths up to \a maxWidth.
+    /// bvslt is not listed, its lowering already costs one comparator.
+    static void reportComparisonEncodings(std::ostream &out, unsigned int maxWidth = 64);
+
+    /// Release the divider circuits shared by bvsdiv and bvsrem. Backends
+    /// call this on pop(), since the cached circuits may belong to the popped
+    /// level, and before they release their context.
+    void clearDivisionCache();
+
 private:
+    /// bvsdiv and bvsrem of the same operands are usually built right after
+    /// each other, a few recent operand pairs are enough to share the divider
+    static const unsigned int MaxSignedDivisions = 16;
+
+    /// \brief Signed division of one operand pair, built around one bvudiv.
+    /// Quotient and remainder are derived on first use.
+    struct SignedDivision
+    {
+        BVExp *dividend;
+        BVExp *divisor;
+        BoolExp *sign1;
+        BoolExp *signxor;
+        BVExp *norm1;
+        BVExp *norm2;
+        BVExp *udiv;
+        BVExp *quotient;
+        BVExp *remainder;
+    };
+
+    typedef std::deque<SignedDivision> SignedDivisionCache;
+
+    SignedDivision &signedDivision(BVExp *exp1, BVExp *exp2);
+    void releaseDivision(SignedDivision &div);
+
     BVExp *bvArithRightShift(BVExp *exp, unsigned int amount, BoolExp *isSigned, unsigned int shiftBits);
+    BVExp *bvashrLinear(BVExp*, BVExp*);
+    BVExp *bvashrBarrel(BVExp*, BVExp*);
+
+    ShiftEncoding m_shiftEncoding;
+    SignedDivisionCache m_signedDivisions;
 
 };
 
@@ -2,20 +2,33 @@
 // Created by marko on 23.06.17.
 //
 
+#include <algorithm>
 #include <iostream>
+#include <functional>
 #include "SMTTranslator.h"
 
-SMTTranslator::SMTTranslator(llbmc::SMTContext &context) : SMTTranslatorBase(context) {
+#include <llbmc/Util/LLBMCException.h>
 
+SMTTranslator::SMTTranslator(llbmc::SMTContext &context)
+        : SMTTranslatorBase(context), m_simplifier(SMTTranslatorBase::bv(), SMTTranslatorBase::sat()),
+          m_constants(m_simplifier), m_hits(0), m_misses(0), m_unknownAssertion(false) {
+
+}
+
+SMTTranslator::~SMTTranslator() {
+    for (ExpCache::iterator it = m_cache.begin(); it != m_cache.end(); ++it) {
+        releaseExp(it->first.op, it->second);
+        releaseOperands(it->first);
+    }
 }
 
 SMT::BVExp *SMTTranslator::createBV(std::string name, int width){
-    SMT::BVExp *s = bv().bitvector(width, name);
+    SMT::BVExp *s = mkBitvector(width, name);
     return s;
 }
 
 SMT::BVExp *SMTTranslator::createConst(int value, int width) {
-    SMT::BVExp *constant = bv().bv2bv(new Bitvector(value, width));
+    SMT::BVExp *constant = mkConst(value, width);
     return constant;
 }
 
@@ -24,31 +37,82 @@ SMT::BVExp *SMTTranslator::createConst(int value, int width) {
 
 SMT::BoolExp *SMTTranslator::bvAssignValue(SMT::BVExp *bitvector, int value) {
     SMT::BVExp *s = bitvector;
-    SMT::BVExp *constant = bv().bv2bv(new Bitvector(value, bv().width(bitvector)));
-    SMT::BoolExp *an = bv().eq(s, constant);
+    SMT::BVExp *constant = mkConst(value, bv().width(bitvector));
+    SMT::BoolExp *an = mkBool(OpEq, s, constant);
     return an;
 }
 
 SMT::BoolExp *SMTTranslator::bvAssignValueNeg(SMT::BVExp *bitvector, int value) {
     SMT::BVExp *s = bitvector;
-    SMT::BVExp *constant = bv().bv2bv(new Bitvector(value, bv().width(bitvector)));
-    SMT::BoolExp *an = bv().bvne(s, constant);
+    SMT::BVExp *constant = mkConst(value, bv().width(bitvector));
+    SMT::BoolExp *an = mkBool(OpNe, s, constant);
     return an;
 }
 
 SMT::BoolExp *SMTTranslator::bvAssignNegationValue(SMT::BVExp *bitvector, int value) {
     SMT::BVExp *s = bitvector;
-    SMT::BVExp *constant = bv().bv2bv(new Bitvector(value, bv().width(bitvector)));
-    SMT::BVExp *negation = bv().bvneg(constant);
-    SMT::BoolExp *an = bv().eq(s, negation);
+    SMT::BVExp *constant = mkConst(value, bv().width(bitvector));
+    SMT::BVExp *negation = mkBV(OpNeg, constant, NULL);
+    SMT::BoolExp *an = mkBool(OpEq, s, negation);
     return an;
 }
 
 SMT::BoolExp *SMTTranslator::compareSlt(SMT::BVExp *a, SMT::BVExp *b){
-    SMT::BoolExp *ret = bv().bvslt(a,b);
+    SMT::BoolExp *ret = mkBool(OpSlt, a, b);
+    return ret;
+}
+
+SMT::BoolExp *SMTTranslator::compareEq(SMT::BVExp *a, SMT::BVExp *b){
+    SMT::BoolExp *ret = mkBool(OpEq, a, b);
+    return ret;
+}
+
+SMT::BoolExp *SMTTranslator::testBit(SMT::BVExp *a, unsigned int bit){
+    SMT::BoolExp *ret = mkTestBit(a, bit);
+    return ret;
+}
+
+SMT::BoolExp *SMTTranslator::boolImplies(SMT::BoolExp *a, SMT::BoolExp *b){
+    SMT::BoolExp *ret = mkConnective(OpBoolImplies, a, b);
     return ret;
 }
 
+void SMTTranslator::assertConstraint(SMT::Solver &solver, SMT::BoolExp *exp) {
+    Structure structure;
+    if (findStructure(exp, structure)) {
+        m_assertions.push_back(structure);
+    } else {
+        m_unknownAssertion = true;
+    }
+    solver.assertConstraint(exp);
+}
+
+bool SMTTranslator::getQueryHash(uint64_t &hash, uint64_t &check) const {
+    if (m_unknownAssertion) {
+        return false;
+    }
+    // the order of the assertions does not change the query
+    std::vector<Structure> assertions(m_assertions);
+    std::sort(assertions.begin(), assertions.end());
+    Structure query = mixStructure(Structure(0, 0), assertions.size());
+    for (std::vector<Structure>::const_iterator it = assertions.begin(); it != assertions.end(); ++it) {
+        query.first = mixHash(query.first, it->first);
+        query.second = mixCheck(query.second, it->second);
+    }
+    hash = query.first;
+    check = query.second;
+    return true;
+}
+
+void SMTTranslator::clearAssertions() {
+    m_assertions.clear();
+    m_unknownAssertion = false;
+}
+
+const std::vector<SMTTranslator::Variable> &SMTTranslator::getVariables() const {
+    return m_variables;
+}
+
 
 
 
@@ -57,17 +121,17 @@ SMT::BoolExp *SMTTranslator::compareSlt(SMT::BVExp *a, SMT::BVExp *b){
 
 SMT::BoolExp *SMTTranslator::bvImplies(SMT::BVExp *an, SMT::BVExp *cn, SMT::SatCore *pCore) {
 
-    SMT::BVExp * neg = bv().bvnot(an);
-    SMT::BVExp *orAC = bv().bvor(neg, cn);
-    SMT::BoolExp *bo = bv().bv12bool(orAC);
+    SMT::BVExp * neg = mkBV(OpNot, an, NULL);
+    SMT::BVExp *orAC = mkBV(OpOr, neg, cn);
+    SMT::BoolExp *bo = mkBool(OpBV12Bool, orAC, NULL);
     return  bo;
 }
 
 SMT::BoolExp *SMTTranslator::archiv() {
     SMT::BVExp *s = bv().bitvector(4, "s");
     SMT::BVExp *sDash = bv().bitvector(4, "sDash");
-    SMT::BVExp *const3 = bv().bv2bv(new Bitvector(3, 4));
-    SMT::BVExp *const4 = bv().bv2bv(new Bitvector(4, 4));
+    SMT::BVExp *const3 = mkConst(3, 4);
+    SMT::BVExp *const4 = mkConst(4, 4);
 
     SMT::BoolExp *an = bv().eq(s, const3);
     SMT::BoolExp *cn = bv().eq(sDash, const4);
@@ -86,8 +150,8 @@ SMT::BoolExp *SMTTranslator::archiv() {
 
     SMT::BoolExp *f = bv().bv12bool(e);
 
-    SMT::BVExp *const5 = bv().bv2bv(new Bitvector(5, 4));
-    SMT::BVExp *const6 = bv().bv2bv(new Bitvector(6, 4));
+    SMT::BVExp *const5 = mkConst(5, 4);
+    SMT::BVExp *const6 = mkConst(6, 4);
     SMT::BoolExp *eqUnsat = bv().eq(const5, const6);
 
     return eqUnsat;
@@ -97,43 +161,340 @@ SMT::BoolExp *SMTTranslator::archiv() {
  * returns: s=3 --> s'= 4
  */
 SMT::BoolExp *SMTTranslator::visitSimpleBranch() {
-    SMT::BVExp *s = bv().bitvector(4, "s");
-    SMT::BVExp *sDash = bv().bitvector(4, "sDash");
-    SMT::BVExp *const3 = bv().bv2bv(new Bitvector(3, 4));
-    SMT::BVExp *const4 = bv().bv2bv(new Bitvector(4, 4));
+    SMT::BVExp *s = mkBitvector(4, "s");
+    SMT::BVExp *sDash = mkBitvector(4, "sDash");
+    SMT::BVExp *const3 = mkConst(3, 4);
+    SMT::BVExp *const4 = mkConst(4, 4);
 
-    SMT::BoolExp *an = bv().eq(s, const3);
-    SMT::BoolExp *cn = bv().eq(sDash, const4);
+    SMT::BoolExp *an = mkBool(OpEq, s, const3);
+    SMT::BoolExp *cn = mkBool(OpEq, sDash, const4);
 
-    SMT::BVExp *anBV = bv().bool2bv1(an);
-    SMT::BVExp *cnBV = bv().bool2bv1(cn);
-    SMT::BVExp *anda = bv().bvmul(anBV, cnBV);
-    SMT::BVExp *branch = bv().bvimplies(anBV, cnBV);
+    SMT::BVExp *anBV = mkBool2BV1(an);
+    SMT::BVExp *cnBV = mkBool2BV1(cn);
+    SMT::BVExp *anda = mkBV(OpMul, anBV, cnBV);
+    SMT::BVExp *branch = mkBV(OpImplies, anBV, cnBV);
 
-    SMT::BoolExp *outSat = bv().bv12bool(branch);
+    SMT::BoolExp *outSat = mkBool(OpBV12Bool, branch, NULL);
     return outSat;
 }
 
 SMT::BoolExp *SMTTranslator::visitSimpleBranchCorrect() {
-    SMT::BVExp *s = bv().bitvector(4, "s");
-    SMT::BVExp *sDash = bv().bitvector(4, "sDash");
-    SMT::BVExp *const3 = bv().bv2bv(new Bitvector(3, 4));
-    SMT::BVExp *const4 = bv().bv2bv(new Bitvector(4, 4));
+    SMT::BVExp *s = mkBitvector(4, "s");
+    SMT::BVExp *sDash = mkBitvector(4, "sDash");
+    SMT::BVExp *const3 = mkConst(3, 4);
+    SMT::BVExp *const4 = mkConst(4, 4);
 
-    SMT::BoolExp *an = bv().eq(s, const3);
-    SMT::BoolExp *cn = bv().eq(sDash, const4);
+    SMT::BoolExp *an = mkBool(OpEq, s, const3);
+    SMT::BoolExp *cn = mkBool(OpEq, sDash, const4);
 
-    SMT::BVExp *branch = bv().bvimplies(s, sDash);
+    SMT::BVExp *branch = mkBV(OpImplies, s, sDash);
 
-    SMT::BoolExp *outSat = bv().bv12bool(branch);
+    SMT::BoolExp *outSat = mkBool(OpBV12Bool, branch, NULL);
     return outSat;
 }
 
+unsigned long SMTTranslator::getCacheHits() const {
+    return m_hits;
+}
+
+unsigned long SMTTranslator::getCacheMisses() const {
+    return m_misses;
+}
+
+const Simplifier &SMTTranslator::getSimplifier() const {
+    return m_simplifier;
+}
+
+SMT::SatCore &SMTTranslator::getSatCore() {
+    return m_simplifier;
+}
+
+SMT::TheoryOfBitvectors &SMTTranslator::getTheoryOfBitvectors() {
+    return m_simplifier;
+}
+
+SMT::TheoryOfBitvectors &SMTTranslator::bv() {
+    return m_simplifier;
+}
+
+SMT::SatCore &SMTTranslator::sat() {
+    return m_simplifier;
+}
+
+
+
+
+
+//----------- hash-consing -----------//
+
+SMTTranslator::ExpKey::ExpKey(Operator op, void *operand1, void *operand2, unsigned int width,
+                              const std::string &name)
+        : op(op), operand1(operand1), operand2(operand2), width(width), name(name) {
+
+}
+
+bool SMTTranslator::ExpKey::operator==(const ExpKey &other) const {
+    return op == other.op && operand1 == other.operand1 && operand2 == other.operand2 && width == other.width
+           && name == other.name;
+}
+
+size_t SMTTranslator::ExpKeyHash::operator()(const ExpKey &key) const {
+    size_t h = std::hash<int>()(key.op);
+    h = h * 31 + std::hash<void *>()(key.operand1);
+    h = h * 31 + std::hash<void *>()(key.operand2);
+    h = h * 31 + std::hash<unsigned int>()(key.width);
+    if (!key.name.empty()) {
+        h = h * 31 + std::hash<std::string>()(key.name);
+    }
+    return h;
+}
+
+SMT::BVExp *SMTTranslator::mkBitvector(unsigned int width, const std::string &name) {
+    ExpKey key(OpBitvector, NULL, NULL, width, name);
+    if (void *hit = lookup(key)) {
+        return static_cast<SMT::BVExp *>(hit);
+    }
+    return static_cast<SMT::BVExp *>(insert(key, bv().bitvector(width, name)));
+}
+
+SMT::BVExp *SMTTranslator::mkConst(int value, unsigned int width) {
+    uint64_t bits = static_cast<uint64_t>(static_cast<int64_t>(value));
+    if (width < 64) {
+        bits &= (static_cast<uint64_t>(1) << width) - 1;
+    }
+    SMT::BVExp *exp = m_constants.get(bits, width);
+    m_structure.insert(std::make_pair(exp, mixStructure(mixStructure(Structure(OpConst, OpConst), bits), width)));
+    return exp;
+}
+
+SMT::BVExp *SMTTranslator::mkBV(Operator op, SMT::BVExp *a, SMT::BVExp *b) {
+    // commutative operators share one entry for both operand orders
+    if ((op == OpOr || op == OpMul) && std::less<SMT::BVExp *>()(b, a)) {
+        std::swap(a, b);
+    }
+    ExpKey key(op, a, b, 0, "");
+    if (void *hit = lookup(key)) {
+        return static_cast<SMT::BVExp *>(hit);
+    }
+
+    SMT::BVExp *exp = NULL;
+    switch (op) {
+        case OpNot:
+            exp = bv().bvnot(a);
+            break;
+        case OpNeg:
+            exp = bv().bvneg(a);
+            break;
+        case OpOr:
+            exp = bv().bvor(a, b);
+            break;
+        case OpMul:
+            exp = bv().bvmul(a, b);
+            break;
+        case OpImplies:
+            exp = bv().bvimplies(a, b);
+            break;
+        default:
+            throw LLBMCException("Not a bitvector operator!");
+    }
+    return static_cast<SMT::BVExp *>(insert(key, exp));
+}
+
+SMT::BoolExp *SMTTranslator::mkBool(Operator op, SMT::BVExp *a, SMT::BVExp *b) {
+    if ((op == OpEq || op == OpNe) && std::less<SMT::BVExp *>()(b, a)) {
+        std::swap(a, b);
+    }
+    ExpKey key(op, a, b, 0, "");
+    if (void *hit = lookup(key)) {
+        return static_cast<SMT::BoolExp *>(hit);
+    }
+
+    SMT::BoolExp *exp = NULL;
+    switch (op) {
+        case OpEq:
+            exp = bv().eq(a, b);
+            break;
+        case OpNe:
+            exp = bv().bvne(a, b);
+            break;
+        case OpSlt:
+            exp = bv().bvslt(a, b);
+            break;
+        case OpBV12Bool:
+            exp = bv().bv12bool(a);
+            break;
+        default:
+            throw LLBMCException("Not a predicate operator!");
+    }
+    return static_cast<SMT::BoolExp *>(insert(key, exp));
+}
+
+SMT::BVExp *SMTTranslator::mkBool2BV1(SMT::BoolExp *a) {
+    ExpKey key(OpBool2BV1, a, NULL, 0, "");
+    if (void *hit = lookup(key)) {
+        return static_cast<SMT::BVExp *>(hit);
+    }
+    return static_cast<SMT::BVExp *>(insert(key, bv().bool2bv1(a)));
+}
+
+SMT::BoolExp *SMTTranslator::mkTestBit(SMT::BVExp *a, unsigned int bit) {
+    // the bit index takes the place of the width in the key
+    ExpKey key(OpTestBit, a, NULL, bit, "");
+    if (void *hit = lookup(key)) {
+        return static_cast<SMT::BoolExp *>(hit);
+    }
+    SMT::BVExp *extracted = bv().extract(bit, bit, a);
+    SMT::BoolExp *exp = bv().bv12bool(extracted);
+    bv().release(extracted);
+    return static_cast<SMT::BoolExp *>(insert(key, exp));
+}
+
+SMT::BoolExp *SMTTranslator::mkConnective(Operator op, SMT::BoolExp *a, SMT::BoolExp *b) {
+    ExpKey key(op, a, b, 0, "");
+    if (void *hit = lookup(key)) {
+        return static_cast<SMT::BoolExp *>(hit);
+    }
+
+    SMT::BoolExp *exp = NULL;
+    switch (op) {
+        case OpBoolImplies:
+            exp = sat().mk_implies(a, b);
+            break;
+        default:
+            throw LLBMCException("Not a propositional connective!");
+    }
+    return static_cast<SMT::BoolExp *>(insert(key, exp));
+}
+
+void *SMTTranslator::lookup(const ExpKey &key) {
+    ExpCache::iterator it = m_cache.find(key);
+    if (it == m_cache.end()) {
+        ++m_misses;
+        return NULL;
+    }
+    ++m_hits;
+    return copyExp(key.op, it->second);
+}
+
+void *SMTTranslator::insert(const ExpKey &key, void *exp) {
+    // the cache keeps the reference it got from the backend, the caller gets a copy
+    copyOperands(key);
+    m_cache.insert(std::make_pair(key, exp));
+    recordStructure(key, exp);
+    return copyExp(key.op, exp);
+}
+
+bool SMTTranslator::isBoolResult(Operator op) {
+    return op == OpEq || op == OpNe || op == OpSlt || op == OpBV12Bool || op == OpTestBit || op == OpBoolImplies;
+}
+
+bool SMTTranslator::hasBoolOperands(Operator op) {
+    return op == OpBool2BV1 || op == OpBoolImplies;
+}
 
+uint64_t SMTTranslator::mixHash(uint64_t hash, uint64_t value) {
+    // splitmix64 finalizer over the combined value
+    uint64_t z = hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
 
+uint64_t SMTTranslator::mixCheck(uint64_t check, uint64_t value) {
+    // FNV-1a step followed by the murmur3 finalizer, unrelated to mixHash
+    uint64_t z = (check ^ value) * 0x100000001b3ULL + 0xcbf29ce484222325ULL;
+    z = (z ^ (z >> 33)) * 0xff51afd7ed558ccdULL;
+    z = (z ^ (z >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+    return z ^ (z >> 33);
+}
 
+SMTTranslator::Structure SMTTranslator::mixStructure(const Structure &structure, uint64_t value) {
+    return Structure(mixHash(structure.first, value), mixCheck(structure.second, value));
+}
 
+void SMTTranslator::recordStructure(const ExpKey &key, void *exp) {
+    Structure structure = mixStructure(Structure(0, 0), key.op);
+    if (key.op == OpBitvector) {
+        // alpha-renaming: the name is replaced by the creation order
+        structure = mixStructure(mixStructure(structure, key.width), m_variables.size());
+        Variable variable;
+        variable.name = key.name;
+        variable.width = key.width;
+        variable.exp = static_cast<SMT::BVExp *>(exp);
+        m_variables.push_back(variable);
+        m_structure.insert(std::make_pair(exp, structure));
+        return;
+    }
+
+    Structure operands[2];
+    void *pointers[2] = {key.operand1, key.operand2};
+    for (unsigned int i = 0; i < 2; ++i) {
+        if (pointers[i] != NULL && !findStructure(pointers[i], operands[i])) {
+            // built outside of the translator, the node has no known structure
+            return;
+        }
+    }
+    // commutative operands are ordered by pointer in the key, which differs between runs
+    if (key.op == OpOr || key.op == OpMul || key.op == OpEq || key.op == OpNe) {
+        if (operands[1] < operands[0]) {
+            std::swap(operands[0], operands[1]);
+        }
+    }
+    structure.first = mixHash(mixHash(mixHash(structure.first, operands[0].first), operands[1].first), key.width);
+    structure.second = mixCheck(mixCheck(mixCheck(structure.second, operands[0].second), operands[1].second),
+                                key.width);
+    // backends may return an operand itself (e.g. bv12bool on Boolector), the first hash stays
+    m_structure.insert(std::make_pair(exp, structure));
+}
 
+bool SMTTranslator::findStructure(void *exp, Structure &structure) const {
+    std::unordered_map<void *, Structure>::const_iterator it = m_structure.find(exp);
+    if (it == m_structure.end()) {
+        return false;
+    }
+    structure = it->second;
+    return true;
+}
 
+void *SMTTranslator::copyExp(Operator op, void *exp) {
+    if (isBoolResult(op)) {
+        return sat().copy(static_cast<SMT::BoolExp *>(exp));
+    }
+    return bv().copy(static_cast<SMT::BVExp *>(exp));
+}
 
+void SMTTranslator::releaseExp(Operator op, void *exp) {
+    if (isBoolResult(op)) {
+        sat().release(static_cast<SMT::BoolExp *>(exp));
+    } else {
+        bv().release(static_cast<SMT::BVExp *>(exp));
+    }
+}
 
+void SMTTranslator::copyOperands(const ExpKey &key) {
+    void *operands[] = {key.operand1, key.operand2};
+    for (unsigned int i = 0; i < 2; ++i) {
+        if (operands[i] == NULL) {
+            continue;
+        }
+        if (hasBoolOperands(key.op)) {
+            sat().copy(static_cast<SMT::BoolExp *>(operands[i]));
+        } else {
+            bv().copy(static_cast<SMT::BVExp *>(operands[i]));
+        }
+    }
+}
+
+void SMTTranslator::releaseOperands(const ExpKey &key) {
+    void *operands[] = {key.operand1, key.operand2};
+    for (unsigned int i = 0; i < 2; ++i) {
+        if (operands[i] == NULL) {
+            continue;
+        }
+        if (hasBoolOperands(key.op)) {
+            sat().release(static_cast<SMT::BoolExp *>(operands[i]));
+        } else {
+            bv().release(static_cast<SMT::BVExp *>(operands[i]));
+        }
+    }
+}
@@ -8,6 +8,15 @@
 
 #include <llbmc/Solver/DefaultSMTTranslator.h>
 
+#include "ConstantPool.h"
+#include "Simplifier.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 
 class SMTTranslator  : public llbmc::SMTTranslatorBase {
 
@@ -15,6 +24,8 @@ public:
 
     SMTTranslator(llbmc::SMTContext &context);
 
+    ~SMTTranslator();
+
     SMT::BoolExp * visitSimpleBranch();
 
     SMT::BoolExp *archiv();
@@ -27,6 +38,38 @@ public:
 
     SMT::BoolExp *compareSlt(SMT::BVExp *a, SMT::BVExp *b);
 
+    SMT::BoolExp *compareEq(SMT::BVExp *a, SMT::BVExp *b);
+
+    /* bit number bit of a is 1 */
+    SMT::BoolExp *testBit(SMT::BVExp *a, unsigned int bit);
+
+    SMT::BoolExp *boolImplies(SMT::BoolExp *a, SMT::BoolExp *b);
+
+    /* asserts exp on solver and adds it to the query hash */
+    void assertConstraint(SMT::Solver &solver, SMT::BoolExp *exp);
+
+    /*
+     * Structural hash of everything asserted through assertConstraint.
+     * Variables enter by the order they were created in, not by name, so
+     * queries that only differ in variable names hash the same. check is a
+     * second hash of the same structure with an unrelated mixing function,
+     * for callers that must tell collisions of hash apart. Returns false if
+     * some asserted constraint was not built by this translator.
+     */
+    bool getQueryHash(uint64_t &hash, uint64_t &check) const;
+
+    /* forgets the asserted constraints, e.g. after the solver popped them */
+    void clearAssertions();
+
+    struct Variable {
+        std::string name;
+        unsigned int width;
+        SMT::BVExp *exp;
+    };
+
+    /* all variables in the order they entered the query hash */
+    const std::vector<Variable> &getVariables() const;
+
     SMT::BoolExp *bvImplies(SMT::BVExp *an, SMT::BVExp *cn, SMT::SatCore *pCore);
 
     SMT::BVExp *createConst();
@@ -36,6 +79,131 @@ public:
     SMT::BoolExp *bvAssignNegationValue(SMT::BVExp *pExp, int i);
 
     SMT::BoolExp *bvAssignValueNeg(SMT::BVExp *pExp, int i);
+
+    unsigned long getCacheHits() const;
+
+    unsigned long getCacheMisses() const;
+
+    const Simplifier &getSimplifier() const;
+
+    /*
+     * The theories the translator builds through, for front-ends that need
+     * more than the helpers above. Handles are those of the backend.
+     */
+    SMT::SatCore &getSatCore();
+
+    SMT::TheoryOfBitvectors &getTheoryOfBitvectors();
+
+private:
+    /*
+     * Everything is built through m_simplifier. These hide the backend's
+     * theories of SMTTranslatorBase on purpose.
+     */
+    SMT::TheoryOfBitvectors &bv();
+
+    SMT::SatCore &sat();
+
+    /*
+     * Hash-consing: every node built through the helpers below is cached
+     * by (operator, operands, width/name); constants are interned in
+     * m_constants. An identical request returns a copy() of the cached
+     * node instead of building it again. The cache holds one reference on
+     * each node and on its operands, so handles in the keys cannot be
+     * recycled by the backend while cached.
+     */
+    enum Operator {
+        OpBitvector,
+        OpEq,
+        OpNe,
+        OpSlt,
+        OpNot,
+        OpNeg,
+        OpOr,
+        OpMul,
+        OpImplies,
+        OpBool2BV1,
+        OpBV12Bool,
+        OpTestBit,
+        OpBoolImplies,
+        OpConst
+    };
+
+    struct ExpKey {
+        Operator op;
+        void *operand1;
+        void *operand2;
+        unsigned int width;
+        std::string name;
+
+        ExpKey(Operator op, void *operand1, void *operand2, unsigned int width, const std::string &name);
+
+        bool operator==(const ExpKey &other) const;
+    };
+
+    struct ExpKeyHash {
+        size_t operator()(const ExpKey &key) const;
+    };
+
+    typedef std::unordered_map<ExpKey, void *, ExpKeyHash> ExpCache;
+
+    SMT::BVExp *mkBitvector(unsigned int width, const std::string &name);
+
+    SMT::BVExp *mkConst(int value, unsigned int width);
+
+    SMT::BVExp *mkBV(Operator op, SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *mkBool(Operator op, SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *mkBool2BV1(SMT::BoolExp *a);
+
+    SMT::BoolExp *mkTestBit(SMT::BVExp *a, unsigned int bit);
+
+    SMT::BoolExp *mkConnective(Operator op, SMT::BoolExp *a, SMT::BoolExp *b);
+
+    void *lookup(const ExpKey &key);
+
+    void *insert(const ExpKey &key, void *exp);
+
+    static bool isBoolResult(Operator op);
+
+    static bool hasBoolOperands(Operator op);
+
+    /* the structural hash of a node and its independent check hash */
+    typedef std::pair<uint64_t, uint64_t> Structure;
+
+    static uint64_t mixHash(uint64_t hash, uint64_t value);
+
+    static uint64_t mixCheck(uint64_t check, uint64_t value);
+
+    static Structure mixStructure(const Structure &structure, uint64_t value);
+
+    void recordStructure(const ExpKey &key, void *exp);
+
+    bool findStructure(void *exp, Structure &structure) const;
+
+    void *copyExp(Operator op, void *exp);
+
+    void releaseExp(Operator op, void *exp);
+
+    void copyOperands(const ExpKey &key);
+
+    void releaseOperands(const ExpKey &key);
+
+    Simplifier m_simplifier;
+    ConstantPool m_constants;
+    ExpCache m_cache;
+    unsigned long m_hits;
+    unsigned long m_misses;
+
+    /*
+     * Alpha-renamed structural hash of every node built by the helpers.
+     * All of them are kept alive by m_cache or m_constants, so the
+     * pointers cannot be reused while the translator lives.
+     */
+    std::unordered_map<void *, Structure> m_structure;
+    std::vector<Variable> m_variables;
+    std::vector<Structure> m_assertions;
+    bool m_unknownAssertion;
 };
 
 
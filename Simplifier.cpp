@@ -0,0 +1,1050 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "Simplifier.h"
+
+
+Simplifier::Simplifier(SMT::TheoryOfBitvectors &bvs, SMT::SatCore &sat)
+        : m_bvs(bvs), m_sat(sat), m_pool(bvs), m_true(NULL), m_false(NULL) {
+    for (int i = 0; i < RuleCount; ++i) {
+        m_hits[i] = 0;
+    }
+}
+
+Simplifier::~Simplifier() {
+    for (std::unordered_set<void *>::iterator it = m_heldWords.begin(); it != m_heldWords.end(); ++it) {
+        m_bvs.release(static_cast<SMT::BVExp *>(*it));
+    }
+    for (std::unordered_set<void *>::iterator it = m_heldBools.begin(); it != m_heldBools.end(); ++it) {
+        m_sat.release(static_cast<SMT::BoolExp *>(*it));
+    }
+    if (m_true != NULL) {
+        m_sat.release(m_true);
+    }
+    if (m_false != NULL) {
+        m_sat.release(m_false);
+    }
+}
+
+unsigned long Simplifier::getRuleHits(Rule rule) const {
+    return m_hits[rule];
+}
+
+const char *Simplifier::getRuleName(Rule rule) {
+    switch (rule) {
+        case RuleConstantFold:
+            return "constant folding";
+        case RuleRoundTrip:
+            return "bool round trip";
+        case RuleBoolLift:
+            return "bool lifting";
+        case RuleIdempotence:
+            return "idempotence";
+        case RuleAbsorption:
+            return "absorption";
+        case RuleComplement:
+            return "complement";
+        case RuleEqualOperands:
+            return "equal operands";
+        case RuleNegation:
+            return "negation";
+        case RuleNeutral:
+            return "neutral element";
+        default:
+            return "unknown";
+    }
+}
+
+void Simplifier::printStatistics(std::ostream &out) const {
+    out << "Simplifier:";
+    for (int i = 0; i < RuleCount; ++i) {
+        out << (i == 0 ? " " : ", ") << getRuleName(static_cast<Rule>(i)) << " " << m_hits[i];
+    }
+    out << "\n";
+}
+
+// TheoryOfBitvectors
+
+SMT::BVExp *Simplifier::bitvector(unsigned int width, const std::string &name) {
+    return m_bvs.bitvector(width, name);
+}
+
+SMT::BVExp *Simplifier::copy(SMT::BVExp *exp) {
+    return m_bvs.copy(exp);
+}
+
+SMT::BVExp *Simplifier::bool2bv1(SMT::BoolExp *exp) {
+    if (isBoolConstant(exp, true)) {
+        return hit(RuleConstantFold, constant(1, 1));
+    }
+    if (isBoolConstant(exp, false)) {
+        return hit(RuleConstantFold, constant(0, 1));
+    }
+    const Info *info = find(exp);
+    if (info != NULL && info->kind == KindBV12Bool) {
+        return hit(RuleRoundTrip, m_bvs.copy(static_cast<SMT::BVExp *>(info->operand1)));
+    }
+    return track(m_bvs.bool2bv1(exp), KindBool2BV1, exp, NULL, 0);
+}
+
+SMT::BoolExp *Simplifier::bv12bool(SMT::BVExp *exp) {
+    uint64_t value;
+    if (getConstant(exp, value)) {
+        return hit(RuleConstantFold, boolConstant(value != 0));
+    }
+
+    SMT::BoolExp *a = getBool2BV1Operand(exp);
+    if (a != NULL) {
+        return hit(RuleRoundTrip, m_sat.copy(a));
+    }
+
+    // bitwise operators on bool2bv1 results are connectives in disguise
+    const Info *info = find(exp);
+    if (info != NULL && info->kind == KindNot) {
+        a = getBool2BV1Operand(static_cast<SMT::BVExp *>(info->operand1));
+        if (a != NULL) {
+            return hit(RuleBoolLift, mk_not(a));
+        }
+    }
+    SMT::BoolExp *b;
+    if (isLiftable(exp, KindAnd, a, b)) {
+        return hit(RuleBoolLift, mk_and(a, b));
+    }
+    if (isLiftable(exp, KindOr, a, b)) {
+        return hit(RuleBoolLift, mk_or(a, b));
+    }
+    if (isLiftable(exp, KindXor, a, b)) {
+        return hit(RuleBoolLift, mk_xor(a, b));
+    }
+    if (isLiftable(exp, KindImplies, a, b)) {
+        return hit(RuleBoolLift, mk_implies(a, b));
+    }
+
+    return track(m_bvs.bv12bool(exp), KindBV12Bool, exp);
+}
+
+SMT::BoolExp *Simplifier::eq(SMT::BVExp *a, SMT::BVExp *b) {
+    uint64_t valueA, valueB;
+    if (getConstants(a, b, valueA, valueB)) {
+        return hit(RuleConstantFold, boolConstant(valueA == valueB));
+    }
+    if (a == b) {
+        return hit(RuleEqualOperands, boolConstant(true));
+    }
+    if (areComplements(a, b)) {
+        return hit(RuleComplement, boolConstant(false));
+    }
+    return m_bvs.eq(a, b);
+}
+
+SMT::BVExp *Simplifier::concat(SMT::BVExp *a, SMT::BVExp *b) {
+    uint64_t valueA, valueB;
+    if (getConstants(a, b, valueA, valueB)) {
+        unsigned int widthA = m_bvs.width(a);
+        unsigned int widthB = m_bvs.width(b);
+        if (widthA + widthB <= 64) {
+            return hit(RuleConstantFold, constant(valueA << widthB | valueB, widthA + widthB));
+        }
+    }
+    return m_bvs.concat(a, b);
+}
+
+SMT::BVExp *Simplifier::extract(unsigned int i, unsigned int j, SMT::BVExp *exp) {
+    if (j == 0 && i + 1 == m_bvs.width(exp)) {
+        return hit(RuleNeutral, m_bvs.copy(exp));
+    }
+    uint64_t value;
+    if (getConstant(exp, value)) {
+        return hit(RuleConstantFold, constant(value >> j, i - j + 1));
+    }
+    return m_bvs.extract(i, j, exp);
+}
+
+SMT::BVExp *Simplifier::bvnot(SMT::BVExp *exp) {
+    uint64_t value;
+    if (getConstant(exp, value)) {
+        return hit(RuleConstantFold, constant(~value, m_bvs.width(exp)));
+    }
+    const Info *info = find(exp);
+    if (info != NULL && info->kind == KindNot) {
+        return hit(RuleNegation, m_bvs.copy(static_cast<SMT::BVExp *>(info->operand1)));
+    }
+    return track(m_bvs.bvnot(exp), KindNot, exp, NULL, 0);
+}
+
+SMT::BVExp *Simplifier::bvneg(SMT::BVExp *exp) {
+    uint64_t value;
+    if (getConstant(exp, value)) {
+        return hit(RuleConstantFold, constant(0 - value, m_bvs.width(exp)));
+    }
+    // on one bit -x = x, which turns c & -c into c & c
+    if (m_bvs.width(exp) == 1) {
+        return hit(RuleNegation, m_bvs.copy(exp));
+    }
+    const Info *info = find(exp);
+    if (info != NULL && info->kind == KindNeg) {
+        return hit(RuleNegation, m_bvs.copy(static_cast<SMT::BVExp *>(info->operand1)));
+    }
+    return track(m_bvs.bvneg(exp), KindNeg, exp, NULL, 0);
+}
+
+SMT::BVExp *Simplifier::bvand(SMT::BVExp *a, SMT::BVExp *b) {
+    return binary(KindAnd, a, b);
+}
+
+SMT::BVExp *Simplifier::bvor(SMT::BVExp *a, SMT::BVExp *b) {
+    return binary(KindOr, a, b);
+}
+
+SMT::BVExp *Simplifier::bvadd(SMT::BVExp *a, SMT::BVExp *b) {
+    return binary(KindAdd, a, b);
+}
+
+SMT::BVExp *Simplifier::bvmul(SMT::BVExp *a, SMT::BVExp *b) {
+    return binary(KindMul, a, b);
+}
+
+SMT::BVExp *Simplifier::bvudiv(SMT::BVExp *a, SMT::BVExp *b) {
+    return binary(KindUdiv, a, b);
+}
+
+SMT::BVExp *Simplifier::bvurem(SMT::BVExp *a, SMT::BVExp *b) {
+    return binary(KindUrem, a, b);
+}
+
+SMT::BVExp *Simplifier::bvshl(SMT::BVExp *a, SMT::BVExp *b) {
+    return binary(KindShl, a, b);
+}
+
+SMT::BVExp *Simplifier::bvlshr(SMT::BVExp *a, SMT::BVExp *b) {
+    return binary(KindLshr, a, b);
+}
+
+SMT::BoolExp *Simplifier::bvult(SMT::BVExp *a, SMT::BVExp *b) {
+    return order(&SMT::TheoryOfBitvectors::bvult, a, b, false, false, false);
+}
+
+SMT::BVExp *Simplifier::bv2bv(const Bitvector *bv) {
+    if (bv->getWidth() <= 64) {
+        return constant(bv->getUnsigned(), bv->getWidth());
+    }
+    return m_pool.get(*bv);
+}
+
+SMT::BVExp *Simplifier::bvzeros(unsigned int width) {
+    return zeros(width);
+}
+
+SMT::BVExp *Simplifier::bvones(unsigned int width) {
+    return ones(width);
+}
+
+SMT::BVExp *Simplifier::uext(SMT::BVExp *exp, unsigned int newWidth) {
+    if (newWidth == m_bvs.width(exp)) {
+        return hit(RuleNeutral, m_bvs.copy(exp));
+    }
+    uint64_t value;
+    if (newWidth <= 64 && getConstant(exp, value)) {
+        return hit(RuleConstantFold, constant(value, newWidth));
+    }
+    return m_bvs.uext(exp, newWidth);
+}
+
+SMT::BVExp *Simplifier::sext(SMT::BVExp *exp, unsigned int newWidth) {
+    unsigned int width = m_bvs.width(exp);
+    if (newWidth == width) {
+        return hit(RuleNeutral, m_bvs.copy(exp));
+    }
+    uint64_t value;
+    if (newWidth <= 64 && getConstant(exp, value)) {
+        return hit(RuleConstantFold, constant(static_cast<uint64_t>(toSigned(value, width)), newWidth));
+    }
+    return m_bvs.sext(exp, newWidth);
+}
+
+SMT::BoolExp *Simplifier::bvne(SMT::BVExp *a, SMT::BVExp *b) {
+    uint64_t valueA, valueB;
+    if (getConstants(a, b, valueA, valueB)) {
+        return hit(RuleConstantFold, boolConstant(valueA != valueB));
+    }
+    if (a == b) {
+        return hit(RuleEqualOperands, boolConstant(false));
+    }
+    if (areComplements(a, b)) {
+        return hit(RuleComplement, boolConstant(true));
+    }
+    return m_bvs.bvne(a, b);
+}
+
+SMT::BVExp *Simplifier::bvxor(SMT::BVExp *a, SMT::BVExp *b) {
+    return binary(KindXor, a, b);
+}
+
+SMT::BVExp *Simplifier::bvimplies(SMT::BVExp *a, SMT::BVExp *b) {
+    return binary(KindImplies, a, b);
+}
+
+SMT::BVExp *Simplifier::bvcond(SMT::BoolExp *cond, SMT::BVExp *a, SMT::BVExp *b) {
+    if (isBoolConstant(cond, true)) {
+        return hit(RuleConstantFold, m_bvs.copy(a));
+    }
+    if (isBoolConstant(cond, false)) {
+        return hit(RuleConstantFold, m_bvs.copy(b));
+    }
+    if (a == b) {
+        return hit(RuleIdempotence, m_bvs.copy(a));
+    }
+    return m_bvs.bvcond(cond, a, b);
+}
+
+SMT::BVExp *Simplifier::bvsub(SMT::BVExp *a, SMT::BVExp *b) {
+    return binary(KindSub, a, b);
+}
+
+SMT::BVExp *Simplifier::bvsdiv(SMT::BVExp *a, SMT::BVExp *b) {
+    return binary(KindSdiv, a, b);
+}
+
+SMT::BVExp *Simplifier::bvsrem(SMT::BVExp *a, SMT::BVExp *b) {
+    return binary(KindSrem, a, b);
+}
+
+SMT::BVExp *Simplifier::bvashr(SMT::BVExp *a, SMT::BVExp *b) {
+    return binary(KindAshr, a, b);
+}
+
+SMT::BoolExp *Simplifier::bvuaddo(SMT::BVExp *a, SMT::BVExp *b) {
+    return overflow(&SMT::TheoryOfBitvectors::bvuaddo, a, b, KindAdd, false);
+}
+
+SMT::BoolExp *Simplifier::bvusubo(SMT::BVExp *a, SMT::BVExp *b) {
+    return overflow(&SMT::TheoryOfBitvectors::bvusubo, a, b, KindSub, false);
+}
+
+SMT::BoolExp *Simplifier::bvumulo(SMT::BVExp *a, SMT::BVExp *b) {
+    return overflow(&SMT::TheoryOfBitvectors::bvumulo, a, b, KindMul, false);
+}
+
+SMT::BoolExp *Simplifier::bvsaddo(SMT::BVExp *a, SMT::BVExp *b) {
+    return overflow(&SMT::TheoryOfBitvectors::bvsaddo, a, b, KindAdd, true);
+}
+
+SMT::BoolExp *Simplifier::bvssubo(SMT::BVExp *a, SMT::BVExp *b) {
+    return overflow(&SMT::TheoryOfBitvectors::bvssubo, a, b, KindSub, true);
+}
+
+SMT::BoolExp *Simplifier::bvsmulo(SMT::BVExp *a, SMT::BVExp *b) {
+    return overflow(&SMT::TheoryOfBitvectors::bvsmulo, a, b, KindMul, true);
+}
+
+SMT::BoolExp *Simplifier::bvsdivo(SMT::BVExp *a, SMT::BVExp *b) {
+    return overflow(&SMT::TheoryOfBitvectors::bvsdivo, a, b, KindSdiv, true);
+}
+
+SMT::BoolExp *Simplifier::bvule(SMT::BVExp *a, SMT::BVExp *b) {
+    return order(&SMT::TheoryOfBitvectors::bvule, a, b, false, true, false);
+}
+
+SMT::BoolExp *Simplifier::bvugt(SMT::BVExp *a, SMT::BVExp *b) {
+    return order(&SMT::TheoryOfBitvectors::bvugt, a, b, false, false, true);
+}
+
+SMT::BoolExp *Simplifier::bvuge(SMT::BVExp *a, SMT::BVExp *b) {
+    return order(&SMT::TheoryOfBitvectors::bvuge, a, b, false, true, true);
+}
+
+SMT::BoolExp *Simplifier::bvslt(SMT::BVExp *a, SMT::BVExp *b) {
+    return order(&SMT::TheoryOfBitvectors::bvslt, a, b, true, false, false);
+}
+
+SMT::BoolExp *Simplifier::bvsle(SMT::BVExp *a, SMT::BVExp *b) {
+    return order(&SMT::TheoryOfBitvectors::bvsle, a, b, true, true, false);
+}
+
+SMT::BoolExp *Simplifier::bvsgt(SMT::BVExp *a, SMT::BVExp *b) {
+    return order(&SMT::TheoryOfBitvectors::bvsgt, a, b, true, false, true);
+}
+
+SMT::BoolExp *Simplifier::bvsge(SMT::BVExp *a, SMT::BVExp *b) {
+    return order(&SMT::TheoryOfBitvectors::bvsge, a, b, true, true, true);
+}
+
+void Simplifier::release(SMT::BVExp *exp) {
+    m_bvs.release(exp);
+}
+
+unsigned int Simplifier::width(SMT::BVExp *exp) {
+    return m_bvs.width(exp);
+}
+
+// SatCore
+
+SMT::BoolExp *Simplifier::mk_free(const std::string &name) {
+    return m_sat.mk_free(name);
+}
+
+SMT::BoolExp *Simplifier::mk_true() {
+    return boolConstant(true);
+}
+
+SMT::BoolExp *Simplifier::mk_false() {
+    return boolConstant(false);
+}
+
+SMT::BoolExp *Simplifier::mk_not(SMT::BoolExp *exp) {
+    if (isBoolConstant(exp, true)) {
+        return hit(RuleConstantFold, boolConstant(false));
+    }
+    if (isBoolConstant(exp, false)) {
+        return hit(RuleConstantFold, boolConstant(true));
+    }
+    const Info *info = find(exp);
+    if (info != NULL && info->kind == KindBoolNot) {
+        return hit(RuleNegation, m_sat.copy(static_cast<SMT::BoolExp *>(info->operand1)));
+    }
+    return track(m_sat.mk_not(exp), KindBoolNot, exp);
+}
+
+SMT::BoolExp *Simplifier::mk_and(SMT::BoolExp *a, SMT::BoolExp *b) {
+    if (isBoolConstant(a, false) || isBoolConstant(b, false)) {
+        return hit(RuleNeutral, boolConstant(false));
+    }
+    if (isBoolConstant(a, true)) {
+        return hit(RuleNeutral, m_sat.copy(b));
+    }
+    if (isBoolConstant(b, true)) {
+        return hit(RuleNeutral, m_sat.copy(a));
+    }
+    if (a == b) {
+        return hit(RuleIdempotence, m_sat.copy(a));
+    }
+    if (areComplements(a, b)) {
+        return hit(RuleComplement, boolConstant(false));
+    }
+    return m_sat.mk_and(a, b);
+}
+
+SMT::BoolExp *Simplifier::mk_or(SMT::BoolExp *a, SMT::BoolExp *b) {
+    if (isBoolConstant(a, true) || isBoolConstant(b, true)) {
+        return hit(RuleNeutral, boolConstant(true));
+    }
+    if (isBoolConstant(a, false)) {
+        return hit(RuleNeutral, m_sat.copy(b));
+    }
+    if (isBoolConstant(b, false)) {
+        return hit(RuleNeutral, m_sat.copy(a));
+    }
+    if (a == b) {
+        return hit(RuleIdempotence, m_sat.copy(a));
+    }
+    if (areComplements(a, b)) {
+        return hit(RuleComplement, boolConstant(true));
+    }
+    return m_sat.mk_or(a, b);
+}
+
+SMT::BoolExp *Simplifier::mk_xor(SMT::BoolExp *a, SMT::BoolExp *b) {
+    if (isBoolConstant(a, false)) {
+        return hit(RuleNeutral, m_sat.copy(b));
+    }
+    if (isBoolConstant(b, false)) {
+        return hit(RuleNeutral, m_sat.copy(a));
+    }
+    if (isBoolConstant(a, true)) {
+        return hit(RuleNeutral, mk_not(b));
+    }
+    if (isBoolConstant(b, true)) {
+        return hit(RuleNeutral, mk_not(a));
+    }
+    if (a == b) {
+        return hit(RuleEqualOperands, boolConstant(false));
+    }
+    if (areComplements(a, b)) {
+        return hit(RuleComplement, boolConstant(true));
+    }
+    return m_sat.mk_xor(a, b);
+}
+
+SMT::BoolExp *Simplifier::mk_implies(SMT::BoolExp *a, SMT::BoolExp *b) {
+    if (isBoolConstant(a, false) || isBoolConstant(b, true)) {
+        return hit(RuleNeutral, boolConstant(true));
+    }
+    if (isBoolConstant(a, true)) {
+        return hit(RuleNeutral, m_sat.copy(b));
+    }
+    if (isBoolConstant(b, false)) {
+        return hit(RuleNeutral, mk_not(a));
+    }
+    if (a == b) {
+        return hit(RuleEqualOperands, boolConstant(true));
+    }
+    // !a -> a and a -> !a are both the consequence
+    if (areComplements(a, b)) {
+        return hit(RuleComplement, m_sat.copy(b));
+    }
+    return m_sat.mk_implies(a, b);
+}
+
+SMT::BoolExp *Simplifier::mk_iff(SMT::BoolExp *a, SMT::BoolExp *b) {
+    if (isBoolConstant(a, true)) {
+        return hit(RuleNeutral, m_sat.copy(b));
+    }
+    if (isBoolConstant(b, true)) {
+        return hit(RuleNeutral, m_sat.copy(a));
+    }
+    if (isBoolConstant(a, false)) {
+        return hit(RuleNeutral, mk_not(b));
+    }
+    if (isBoolConstant(b, false)) {
+        return hit(RuleNeutral, mk_not(a));
+    }
+    if (a == b) {
+        return hit(RuleEqualOperands, boolConstant(true));
+    }
+    if (areComplements(a, b)) {
+        return hit(RuleComplement, boolConstant(false));
+    }
+    return m_sat.mk_iff(a, b);
+}
+
+SMT::BoolExp *Simplifier::mk_cond(SMT::BoolExp *cond, SMT::BoolExp *a, SMT::BoolExp *b) {
+    if (isBoolConstant(cond, true)) {
+        return hit(RuleConstantFold, m_sat.copy(a));
+    }
+    if (isBoolConstant(cond, false)) {
+        return hit(RuleConstantFold, m_sat.copy(b));
+    }
+    if (a == b) {
+        return hit(RuleIdempotence, m_sat.copy(a));
+    }
+    if (isBoolConstant(a, true) && isBoolConstant(b, false)) {
+        return hit(RuleNeutral, m_sat.copy(cond));
+    }
+    return m_sat.mk_cond(cond, a, b);
+}
+
+SMT::BoolExp *Simplifier::copy(SMT::BoolExp *exp) {
+    return m_sat.copy(exp);
+}
+
+void Simplifier::release(SMT::BoolExp *exp) {
+    m_sat.release(exp);
+}
+
+// rules
+
+SMT::BVExp *Simplifier::hit(Rule rule, SMT::BVExp *exp) {
+    ++m_hits[rule];
+    return exp;
+}
+
+SMT::BoolExp *Simplifier::hit(Rule rule, SMT::BoolExp *exp) {
+    ++m_hits[rule];
+    return exp;
+}
+
+SMT::BVExp *Simplifier::binary(Kind kind, SMT::BVExp *a, SMT::BVExp *b) {
+    unsigned int width = m_bvs.width(a);
+    uint64_t valueA, valueB, result;
+    if (getConstants(a, b, valueA, valueB) && foldBinary(kind, valueA, valueB, width, result)) {
+        return hit(RuleConstantFold, constant(result, width));
+    }
+
+    switch (kind) {
+        case KindAnd:
+            if (a == b) {
+                return hit(RuleIdempotence, m_bvs.copy(a));
+            }
+            if (isConstant(a, 0) || isConstant(b, 0)) {
+                return hit(RuleNeutral, zeros(width));
+            }
+            if (isOnes(a)) {
+                return hit(RuleNeutral, m_bvs.copy(b));
+            }
+            if (isOnes(b)) {
+                return hit(RuleNeutral, m_bvs.copy(a));
+            }
+            if (areComplements(a, b)) {
+                return hit(RuleComplement, zeros(width));
+            }
+            if (isKind(b, KindOr, a)) {
+                return hit(RuleAbsorption, m_bvs.copy(a));
+            }
+            if (isKind(a, KindOr, b)) {
+                return hit(RuleAbsorption, m_bvs.copy(b));
+            }
+            break;
+        case KindOr:
+            if (a == b) {
+                return hit(RuleIdempotence, m_bvs.copy(a));
+            }
+            if (isOnes(a) || isOnes(b)) {
+                return hit(RuleNeutral, ones(width));
+            }
+            if (isConstant(a, 0)) {
+                return hit(RuleNeutral, m_bvs.copy(b));
+            }
+            if (isConstant(b, 0)) {
+                return hit(RuleNeutral, m_bvs.copy(a));
+            }
+            if (areComplements(a, b)) {
+                return hit(RuleComplement, ones(width));
+            }
+            if (isKind(b, KindAnd, a)) {
+                return hit(RuleAbsorption, m_bvs.copy(a));
+            }
+            if (isKind(a, KindAnd, b)) {
+                return hit(RuleAbsorption, m_bvs.copy(b));
+            }
+            break;
+        case KindXor:
+            if (a == b) {
+                return hit(RuleEqualOperands, zeros(width));
+            }
+            if (isConstant(a, 0)) {
+                return hit(RuleNeutral, m_bvs.copy(b));
+            }
+            if (isConstant(b, 0)) {
+                return hit(RuleNeutral, m_bvs.copy(a));
+            }
+            if (areComplements(a, b)) {
+                return hit(RuleComplement, ones(width));
+            }
+            break;
+        case KindImplies:
+            if (a == b) {
+                return hit(RuleEqualOperands, ones(width));
+            }
+            if (isConstant(a, 0) || isOnes(b)) {
+                return hit(RuleNeutral, ones(width));
+            }
+            if (isOnes(a)) {
+                return hit(RuleNeutral, m_bvs.copy(b));
+            }
+            if (isConstant(b, 0)) {
+                return hit(RuleNeutral, bvnot(a));
+            }
+            // ~x -> x and x -> ~x are both the consequence
+            if (areComplements(a, b)) {
+                return hit(RuleComplement, m_bvs.copy(b));
+            }
+            break;
+        case KindAdd:
+            if (isConstant(a, 0)) {
+                return hit(RuleNeutral, m_bvs.copy(b));
+            }
+            if (isConstant(b, 0)) {
+                return hit(RuleNeutral, m_bvs.copy(a));
+            }
+            break;
+        case KindSub:
+            if (a == b) {
+                return hit(RuleEqualOperands, zeros(width));
+            }
+            if (isConstant(b, 0)) {
+                return hit(RuleNeutral, m_bvs.copy(a));
+            }
+            break;
+        case KindMul:
+            if (isConstant(a, 0) || isConstant(b, 0)) {
+                return hit(RuleNeutral, zeros(width));
+            }
+            if (isConstant(a, 1)) {
+                return hit(RuleNeutral, m_bvs.copy(b));
+            }
+            if (isConstant(b, 1)) {
+                return hit(RuleNeutral, m_bvs.copy(a));
+            }
+            break;
+        case KindUdiv:
+        case KindSdiv:
+            if (isConstant(b, 1)) {
+                return hit(RuleNeutral, m_bvs.copy(a));
+            }
+            break;
+        case KindUrem:
+        case KindSrem:
+            if (isConstant(b, 1)) {
+                return hit(RuleNeutral, zeros(width));
+            }
+            break;
+        case KindShl:
+        case KindLshr:
+        case KindAshr:
+            if (isConstant(b, 0)) {
+                return hit(RuleNeutral, m_bvs.copy(a));
+            }
+            if (isConstant(a, 0)) {
+                return hit(RuleNeutral, zeros(width));
+            }
+            break;
+        default:
+            break;
+    }
+    return build(kind, a, b);
+}
+
+SMT::BVExp *Simplifier::build(Kind kind, SMT::BVExp *a, SMT::BVExp *b) {
+    switch (kind) {
+        case KindAnd:
+            return track(m_bvs.bvand(a, b), KindAnd, a, b, 0);
+        case KindOr:
+            return track(m_bvs.bvor(a, b), KindOr, a, b, 0);
+        case KindXor:
+            return track(m_bvs.bvxor(a, b), KindXor, a, b, 0);
+        case KindImplies:
+            return track(m_bvs.bvimplies(a, b), KindImplies, a, b, 0);
+        case KindAdd:
+            return m_bvs.bvadd(a, b);
+        case KindSub:
+            return m_bvs.bvsub(a, b);
+        case KindMul:
+            return m_bvs.bvmul(a, b);
+        case KindUdiv:
+            return m_bvs.bvudiv(a, b);
+        case KindUrem:
+            return m_bvs.bvurem(a, b);
+        case KindSdiv:
+            return m_bvs.bvsdiv(a, b);
+        case KindSrem:
+            return m_bvs.bvsrem(a, b);
+        case KindShl:
+            return m_bvs.bvshl(a, b);
+        case KindLshr:
+            return m_bvs.bvlshr(a, b);
+        case KindAshr:
+            return m_bvs.bvashr(a, b);
+        default:
+            return NULL;
+    }
+}
+
+SMT::BoolExp *Simplifier::order(Predicate predicate, SMT::BVExp *a, SMT::BVExp *b, bool isSigned, bool orEqual,
+                                bool greater) {
+    SMT::BVExp *low = greater ? b : a;
+    SMT::BVExp *high = greater ? a : b;
+    uint64_t valueLow, valueHigh;
+    if (getConstants(low, high, valueLow, valueHigh)) {
+        bool less;
+        if (isSigned) {
+            unsigned int width = m_bvs.width(low);
+            less = toSigned(valueLow, width) < toSigned(valueHigh, width);
+        } else {
+            less = valueLow < valueHigh;
+        }
+        return hit(RuleConstantFold, boolConstant(less || (orEqual && valueLow == valueHigh)));
+    }
+    if (low == high) {
+        return hit(RuleEqualOperands, boolConstant(orEqual));
+    }
+    if (!isSigned && !orEqual && isConstant(high, 0)) {
+        return hit(RuleNeutral, boolConstant(false));
+    }
+    if (!isSigned && orEqual && isConstant(low, 0)) {
+        return hit(RuleNeutral, boolConstant(true));
+    }
+    return (m_bvs.*predicate)(a, b);
+}
+
+SMT::BoolExp *Simplifier::overflow(Predicate predicate, SMT::BVExp *a, SMT::BVExp *b, Kind kind, bool isSigned) {
+    uint64_t valueA, valueB;
+    bool result;
+    if (getConstants(a, b, valueA, valueB)
+        && foldOverflow(kind, isSigned, valueA, valueB, m_bvs.width(a), result)) {
+        return hit(RuleConstantFold, boolConstant(result));
+    }
+    return (m_bvs.*predicate)(a, b);
+}
+
+bool Simplifier::foldBinary(Kind kind, uint64_t a, uint64_t b, unsigned int width, uint64_t &result) {
+    switch (kind) {
+        case KindAnd:
+            result = a & b;
+            break;
+        case KindOr:
+            result = a | b;
+            break;
+        case KindXor:
+            result = a ^ b;
+            break;
+        case KindImplies:
+            result = ~a | b;
+            break;
+        case KindAdd:
+            result = a + b;
+            break;
+        case KindSub:
+            result = a - b;
+            break;
+        case KindMul:
+            result = a * b;
+            break;
+        case KindUdiv:
+        case KindUrem:
+            // division by zero is left to the backend
+            if (b == 0) {
+                return false;
+            }
+            result = kind == KindUdiv ? a / b : a % b;
+            break;
+        case KindSdiv:
+        case KindSrem: {
+            int64_t signedA = toSigned(a, width);
+            int64_t signedB = toSigned(b, width);
+            if (signedB == 0) {
+                return false;
+            }
+            // -1 separately, INT64_MIN / -1 traps
+            if (signedB == -1) {
+                result = kind == KindSdiv ? 0 - a : 0;
+            } else {
+                result = static_cast<uint64_t>(kind == KindSdiv ? signedA / signedB : signedA % signedB);
+            }
+            break;
+        }
+        case KindShl:
+            result = b >= width ? 0 : a << b;
+            break;
+        case KindLshr:
+            result = b >= width ? 0 : a >> b;
+            break;
+        case KindAshr: {
+            int64_t signedA = toSigned(a, width);
+            if (b >= width) {
+                result = signedA < 0 ? ~static_cast<uint64_t>(0) : 0;
+            } else {
+                result = static_cast<uint64_t>(signedA >> b);
+            }
+            break;
+        }
+        default:
+            return false;
+    }
+    result = mask(result, width);
+    return true;
+}
+
+bool Simplifier::foldOverflow(Kind kind, bool isSigned, uint64_t a, uint64_t b, unsigned int width, bool &result) {
+    if (!isSigned) {
+        switch (kind) {
+            case KindAdd:
+                result = mask(a + b, width) < a;
+                return true;
+            case KindSub:
+                result = a < b;
+                return true;
+            case KindMul:
+                result = b != 0 && a > mask(~static_cast<uint64_t>(0), width) / b;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    int64_t signedA = toSigned(a, width);
+    int64_t signedB = toSigned(b, width);
+    int64_t min = toSigned(static_cast<uint64_t>(1) << (width - 1), width);
+    int64_t max = -(min + 1);
+    switch (kind) {
+        case KindAdd:
+        case KindSub: {
+            // the exact result needs one more bit
+            if (width >= 64) {
+                return false;
+            }
+            int64_t exact = kind == KindAdd ? signedA + signedB : signedA - signedB;
+            result = exact < min || exact > max;
+            return true;
+        }
+        case KindMul: {
+            if (width > 32) {
+                return false;
+            }
+            int64_t exact = signedA * signedB;
+            result = exact < min || exact > max;
+            return true;
+        }
+        case KindSdiv:
+            result = signedA == min && signedB == -1;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// bookkeeping
+
+SMT::BVExp *Simplifier::constant(uint64_t value, unsigned int width) {
+    value = mask(value, width);
+    return track(m_pool.get(value, width), KindConst, NULL, NULL, value);
+}
+
+SMT::BVExp *Simplifier::zeros(unsigned int width) {
+    if (width <= 64) {
+        return constant(0, width);
+    }
+    return m_bvs.bvzeros(width);
+}
+
+SMT::BVExp *Simplifier::ones(unsigned int width) {
+    if (width <= 64) {
+        return constant(~static_cast<uint64_t>(0), width);
+    }
+    return m_bvs.bvones(width);
+}
+
+SMT::BoolExp *Simplifier::boolConstant(bool value) {
+    SMT::BoolExp *&exp = value ? m_true : m_false;
+    if (exp == NULL) {
+        exp = track(value ? m_sat.mk_true() : m_sat.mk_false(), value ? KindTrue : KindFalse, NULL);
+    }
+    return m_sat.copy(exp);
+}
+
+bool Simplifier::getConstant(SMT::BVExp *exp, uint64_t &value) const {
+    const Info *info = find(exp);
+    if (info == NULL || info->kind != KindConst) {
+        return false;
+    }
+    value = info->value;
+    return true;
+}
+
+bool Simplifier::getConstants(SMT::BVExp *a, SMT::BVExp *b, uint64_t &valueA, uint64_t &valueB) const {
+    return getConstant(a, valueA) && getConstant(b, valueB);
+}
+
+bool Simplifier::isConstant(SMT::BVExp *exp, uint64_t value) const {
+    uint64_t constantValue;
+    return getConstant(exp, constantValue) && constantValue == value;
+}
+
+bool Simplifier::isOnes(SMT::BVExp *exp) {
+    uint64_t value;
+    return getConstant(exp, value) && value == mask(~static_cast<uint64_t>(0), m_bvs.width(exp));
+}
+
+bool Simplifier::isBoolConstant(SMT::BoolExp *exp, bool value) const {
+    const Info *info = find(exp);
+    return info != NULL && info->kind == (value ? KindTrue : KindFalse);
+}
+
+const Simplifier::Info *Simplifier::find(SMT::BVExp *exp) const {
+    InfoMap::const_iterator it = m_words.find(exp);
+    return it != m_words.end() ? &it->second : NULL;
+}
+
+const Simplifier::Info *Simplifier::find(SMT::BoolExp *exp) const {
+    InfoMap::const_iterator it = m_bools.find(exp);
+    return it != m_bools.end() ? &it->second : NULL;
+}
+
+bool Simplifier::isKind(SMT::BVExp *exp, Kind kind, SMT::BVExp *operand) const {
+    const Info *info = find(exp);
+    return info != NULL && info->kind == kind && (info->operand1 == operand || info->operand2 == operand);
+}
+
+bool Simplifier::isLiftable(SMT::BVExp *exp, Kind kind, SMT::BoolExp *&a, SMT::BoolExp *&b) const {
+    const Info *info = find(exp);
+    if (info == NULL || info->kind != kind) {
+        return false;
+    }
+    a = getBool2BV1Operand(static_cast<SMT::BVExp *>(info->operand1));
+    b = getBool2BV1Operand(static_cast<SMT::BVExp *>(info->operand2));
+    return a != NULL && b != NULL;
+}
+
+SMT::BoolExp *Simplifier::getBool2BV1Operand(SMT::BVExp *exp) const {
+    const Info *info = find(exp);
+    if (info == NULL || info->kind != KindBool2BV1) {
+        return NULL;
+    }
+    return static_cast<SMT::BoolExp *>(info->operand1);
+}
+
+bool Simplifier::areComplements(SMT::BVExp *a, SMT::BVExp *b) const {
+    const Info *info = find(a);
+    if (info != NULL && info->kind == KindNot && info->operand1 == b) {
+        return true;
+    }
+    info = find(b);
+    return info != NULL && info->kind == KindNot && info->operand1 == a;
+}
+
+bool Simplifier::areComplements(SMT::BoolExp *a, SMT::BoolExp *b) const {
+    const Info *info = find(a);
+    if (info != NULL && info->kind == KindBoolNot && info->operand1 == b) {
+        return true;
+    }
+    info = find(b);
+    return info != NULL && info->kind == KindBoolNot && info->operand1 == a;
+}
+
+SMT::BVExp *Simplifier::track(SMT::BVExp *exp, Kind kind, void *operand1, void *operand2, uint64_t value) {
+    // the first record of a handle stays, a backend may return an operand itself
+    if (m_words.count(exp) != 0) {
+        return exp;
+    }
+    Info info;
+    info.kind = kind;
+    info.operand1 = operand1;
+    info.operand2 = operand2;
+    info.value = value;
+    m_words.insert(std::make_pair(static_cast<void *>(exp), info));
+
+    holdWord(exp);
+    if (kind == KindBool2BV1) {
+        holdBool(static_cast<SMT::BoolExp *>(operand1));
+    } else {
+        holdWord(static_cast<SMT::BVExp *>(operand1));
+        holdWord(static_cast<SMT::BVExp *>(operand2));
+    }
+    return exp;
+}
+
+SMT::BoolExp *Simplifier::track(SMT::BoolExp *exp, Kind kind, void *operand1) {
+    if (m_bools.count(exp) != 0) {
+        return exp;
+    }
+    Info info;
+    info.kind = kind;
+    info.operand1 = operand1;
+    info.operand2 = NULL;
+    info.value = 0;
+    m_bools.insert(std::make_pair(static_cast<void *>(exp), info));
+
+    holdBool(exp);
+    if (kind == KindBV12Bool) {
+        holdWord(static_cast<SMT::BVExp *>(operand1));
+    } else {
+        holdBool(static_cast<SMT::BoolExp *>(operand1));
+    }
+    return exp;
+}
+
+void Simplifier::holdWord(SMT::BVExp *exp) {
+    if (exp != NULL && m_heldWords.insert(exp).second) {
+        m_bvs.copy(exp);
+    }
+}
+
+void Simplifier::holdBool(SMT::BoolExp *exp) {
+    if (exp != NULL && m_heldBools.insert(exp).second) {
+        m_sat.copy(exp);
+    }
+}
+
+uint64_t Simplifier::mask(uint64_t value, unsigned int width) {
+    if (width >= 64) {
+        return value;
+    }
+    return value & ((static_cast<uint64_t>(1) << width) - 1);
+}
+
+int64_t Simplifier::toSigned(uint64_t value, unsigned int width) {
+    if (width < 64 && (value >> (width - 1) & 1) != 0) {
+        value |= ~((static_cast<uint64_t>(1) << width) - 1);
+    }
+    return static_cast<int64_t>(value);
+}
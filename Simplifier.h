@@ -0,0 +1,315 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_SIMPLIFIER_H
+#define TRANSFORMERSOLVER_SIMPLIFIER_H
+
+#include <llbmc/SMT/SatCore.h>
+#include <llbmc/SMT/TheoryOfBitvectors.h>
+
+#include "ConstantPool.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+
+/*
+ * Word-level rewriting in front of a backend's TheoryOfBitvectors and
+ * SatCore. Every expression is simplified when it is built, before the
+ * backend sees it:
+ *
+ *  - constant folding of everything up to 64 bits,
+ *  - bool2bv1/bv12bool round trips, and bitwise operators on bool2bv1
+ *    results under bv12bool are lifted to propositional connectives,
+ *  - idempotence and absorption (x & x, x & (x | y), ...),
+ *  - complements (x & ~x, x | ~x, x = ~x, ...),
+ *  - equal operands (x ^ x, x - x, x = x, x < x, ...),
+ *  - ~~x, --x and -x = x on one bit,
+ *  - neutral and absorbing constants.
+ *
+ * The returned expressions are the backend's own, so they can be asserted
+ * and read from the model directly. The structure the rules need is kept
+ * in side tables; the simplifier holds a reference on every expression in
+ * them so that the backend cannot hand the same handle out again.
+ */
+class Simplifier : public SMT::TheoryOfBitvectors, public SMT::SatCore {
+public:
+    enum Rule {
+        RuleConstantFold,
+        RuleRoundTrip,
+        RuleBoolLift,
+        RuleIdempotence,
+        RuleAbsorption,
+        RuleComplement,
+        RuleEqualOperands,
+        RuleNegation,
+        RuleNeutral,
+        RuleCount
+    };
+
+    Simplifier(SMT::TheoryOfBitvectors &bvs, SMT::SatCore &sat);
+
+    ~Simplifier();
+
+    unsigned long getRuleHits(Rule rule) const;
+
+    static const char *getRuleName(Rule rule);
+
+    void printStatistics(std::ostream &out) const;
+
+    // TheoryOfBitvectors
+
+    SMT::BVExp *bitvector(unsigned int width, const std::string &name);
+
+    SMT::BVExp *copy(SMT::BVExp *exp);
+
+    SMT::BVExp *bool2bv1(SMT::BoolExp *exp);
+
+    SMT::BoolExp *bv12bool(SMT::BVExp *exp);
+
+    SMT::BoolExp *eq(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *concat(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *extract(unsigned int i, unsigned int j, SMT::BVExp *exp);
+
+    SMT::BVExp *bvnot(SMT::BVExp *exp);
+
+    SMT::BVExp *bvneg(SMT::BVExp *exp);
+
+    SMT::BVExp *bvand(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvor(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvadd(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvmul(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvudiv(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvurem(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvshl(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvlshr(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvult(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bv2bv(const Bitvector *bv);
+
+    SMT::BVExp *bvzeros(unsigned int width);
+
+    SMT::BVExp *bvones(unsigned int width);
+
+    SMT::BVExp *uext(SMT::BVExp *exp, unsigned int newWidth);
+
+    SMT::BVExp *sext(SMT::BVExp *exp, unsigned int newWidth);
+
+    SMT::BoolExp *bvne(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvxor(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvimplies(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvcond(SMT::BoolExp *cond, SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvsub(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvsdiv(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvsrem(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvashr(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvuaddo(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvusubo(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvumulo(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvsaddo(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvssubo(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvsmulo(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvsdivo(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvule(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvugt(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvuge(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvslt(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvsle(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvsgt(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvsge(SMT::BVExp *a, SMT::BVExp *b);
+
+    void release(SMT::BVExp *exp);
+
+    unsigned int width(SMT::BVExp *exp);
+
+    // SatCore
+
+    SMT::BoolExp *mk_free(const std::string &name);
+
+    SMT::BoolExp *mk_true();
+
+    SMT::BoolExp *mk_false();
+
+    SMT::BoolExp *mk_not(SMT::BoolExp *exp);
+
+    SMT::BoolExp *mk_and(SMT::BoolExp *a, SMT::BoolExp *b);
+
+    SMT::BoolExp *mk_or(SMT::BoolExp *a, SMT::BoolExp *b);
+
+    SMT::BoolExp *mk_xor(SMT::BoolExp *a, SMT::BoolExp *b);
+
+    SMT::BoolExp *mk_implies(SMT::BoolExp *a, SMT::BoolExp *b);
+
+    SMT::BoolExp *mk_iff(SMT::BoolExp *a, SMT::BoolExp *b);
+
+    SMT::BoolExp *mk_cond(SMT::BoolExp *cond, SMT::BoolExp *a, SMT::BoolExp *b);
+
+    SMT::BoolExp *copy(SMT::BoolExp *exp);
+
+    void release(SMT::BoolExp *exp);
+
+private:
+    Simplifier(const Simplifier &);
+    Simplifier &operator=(const Simplifier &);
+
+    enum Kind {
+        KindConst,
+        KindNot,
+        KindNeg,
+        KindAnd,
+        KindOr,
+        KindXor,
+        KindImplies,
+        KindAdd,
+        KindSub,
+        KindMul,
+        KindUdiv,
+        KindUrem,
+        KindSdiv,
+        KindSrem,
+        KindShl,
+        KindLshr,
+        KindAshr,
+        KindBool2BV1,
+        KindBV12Bool,
+        KindTrue,
+        KindFalse,
+        KindBoolNot
+    };
+
+    /*
+     * What an expression was built from, only kept for the kinds the rules
+     * look at. The operand of KindBool2BV1 and KindBoolNot is a BoolExp.
+     */
+    struct Info {
+        Kind kind;
+        void *operand1;
+        void *operand2;
+        uint64_t value;
+    };
+
+    typedef std::unordered_map<void *, Info> InfoMap;
+
+    /* the rule fired, exp is the result */
+    SMT::BVExp *hit(Rule rule, SMT::BVExp *exp);
+
+    SMT::BoolExp *hit(Rule rule, SMT::BoolExp *exp);
+
+    SMT::BVExp *constant(uint64_t value, unsigned int width);
+
+    SMT::BVExp *zeros(unsigned int width);
+
+    SMT::BVExp *ones(unsigned int width);
+
+    SMT::BoolExp *boolConstant(bool value);
+
+    bool getConstant(SMT::BVExp *exp, uint64_t &value) const;
+
+    bool getConstants(SMT::BVExp *a, SMT::BVExp *b, uint64_t &valueA, uint64_t &valueB) const;
+
+    bool isConstant(SMT::BVExp *exp, uint64_t value) const;
+
+    bool isOnes(SMT::BVExp *exp);
+
+    bool isBoolConstant(SMT::BoolExp *exp, bool value) const;
+
+    const Info *find(SMT::BVExp *exp) const;
+
+    const Info *find(SMT::BoolExp *exp) const;
+
+    /* exp is kind(operand, _) or kind(_, operand) */
+    bool isKind(SMT::BVExp *exp, Kind kind, SMT::BVExp *operand) const;
+
+    /* exp is kind(bool2bv1(_), bool2bv1(_)), the BoolExps are returned */
+    bool isLiftable(SMT::BVExp *exp, Kind kind, SMT::BoolExp *&a, SMT::BoolExp *&b) const;
+
+    SMT::BoolExp *getBool2BV1Operand(SMT::BVExp *exp) const;
+
+    /* a is ~b or b is ~a */
+    bool areComplements(SMT::BVExp *a, SMT::BVExp *b) const;
+
+    bool areComplements(SMT::BoolExp *a, SMT::BoolExp *b) const;
+
+    /* records the structure of exp, a fresh reference that is returned */
+    SMT::BVExp *track(SMT::BVExp *exp, Kind kind, void *operand1, void *operand2, uint64_t value);
+
+    SMT::BoolExp *track(SMT::BoolExp *exp, Kind kind, void *operand1);
+
+    void holdWord(SMT::BVExp *exp);
+
+    void holdBool(SMT::BoolExp *exp);
+
+    static uint64_t mask(uint64_t value, unsigned int width);
+
+    static int64_t toSigned(uint64_t value, unsigned int width);
+
+    /* folds a binary operator on two constants, false if it cannot be folded */
+    static bool foldBinary(Kind kind, uint64_t a, uint64_t b, unsigned int width, uint64_t &result);
+
+    /* folding and the rules shared by all binary word operators */
+    SMT::BVExp *binary(Kind kind, SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *build(Kind kind, SMT::BVExp *a, SMT::BVExp *b);
+
+    typedef SMT::BoolExp *(SMT::TheoryOfBitvectors::*Predicate)(SMT::BVExp *, SMT::BVExp *);
+
+    /* a < b or a <= b, b < a or b <= a if greater; predicate builds it in the backend */
+    SMT::BoolExp *order(Predicate predicate, SMT::BVExp *a, SMT::BVExp *b, bool isSigned, bool orEqual,
+                        bool greater);
+
+    /* kind is KindAdd, KindSub, KindMul or (signed only) KindSdiv */
+    SMT::BoolExp *overflow(Predicate predicate, SMT::BVExp *a, SMT::BVExp *b, Kind kind, bool isSigned);
+
+    static bool foldOverflow(Kind kind, bool isSigned, uint64_t a, uint64_t b, unsigned int width, bool &result);
+
+    SMT::TheoryOfBitvectors &m_bvs;
+    SMT::SatCore &m_sat;
+
+    InfoMap m_words;
+    InfoMap m_bools;
+    std::unordered_set<void *> m_heldWords;
+    std::unordered_set<void *> m_heldBools;
+    ConstantPool m_pool;
+    SMT::BoolExp *m_true;
+    SMT::BoolExp *m_false;
+
+    unsigned long m_hits[RuleCount];
+};
+
+
+#endif //TRANSFORMERSOLVER_SIMPLIFIER_H
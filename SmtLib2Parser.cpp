@@ -0,0 +1,1161 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "SmtLib2Parser.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+    /* symbols interned first, in this order, so that their ids are fixed */
+    enum Reserved : uint32_t {
+        FnNot,
+        FnAnd,
+        FnOr,
+        FnXor,
+        FnImplies,
+        FnEq,
+        FnDistinct,
+        FnIte,
+        FnConcat,
+        FnExtract,
+        FnZeroExtend,
+        FnSignExtend,
+        FnBVNot,
+        FnBVNeg,
+        FnBVAnd,
+        FnBVOr,
+        FnBVXor,
+        FnBVNand,
+        FnBVNor,
+        FnBVXnor,
+        FnAdd,
+        FnSub,
+        FnMul,
+        FnUdiv,
+        FnUrem,
+        FnSdiv,
+        FnSrem,
+        FnShl,
+        FnLshr,
+        FnAshr,
+        FnUlt,
+        FnUle,
+        FnUgt,
+        FnUge,
+        FnSlt,
+        FnSle,
+        FnSgt,
+        FnSge,
+        FnUaddo,
+        FnUsubo,
+        FnUmulo,
+        FnSaddo,
+        FnSsubo,
+        FnSmulo,
+        FnSdivo,
+        FnSelect,
+        FnStore,
+        FunctionCount,
+        SymLet = FunctionCount,
+        SymUnderscore,
+        SymTrue,
+        SymFalse,
+        SymBool,
+        SymBitVec,
+        SymArray,
+        SymSetLogic,
+        SymSetInfo,
+        SymSetOption,
+        SymDeclareFun,
+        SymDeclareConst,
+        SymDefineFun,
+        SymAssert,
+        SymCheckSat,
+        SymPush,
+        SymPop,
+        SymExit,
+        SymGetModel,
+        SymGetValue,
+        SymGetInfo,
+        SymEcho,
+        ReservedCount
+    };
+
+    const char *const ReservedNames[] = {
+            "not", "and", "or", "xor", "=>", "=", "distinct", "ite",
+            "concat", "extract", "zero_extend", "sign_extend",
+            "bvnot", "bvneg", "bvand", "bvor", "bvxor", "bvnand", "bvnor", "bvxnor",
+            "bvadd", "bvsub", "bvmul", "bvudiv", "bvurem", "bvsdiv", "bvsrem", "bvshl", "bvlshr", "bvashr",
+            "bvult", "bvule", "bvugt", "bvuge", "bvslt", "bvsle", "bvsgt", "bvsge",
+            "bvuaddo", "bvusubo", "bvumulo", "bvsaddo", "bvssubo", "bvsmulo", "bvsdivo",
+            "select", "store",
+            "let", "_", "true", "false", "Bool", "BitVec", "Array",
+            "set-logic", "set-info", "set-option", "declare-fun", "declare-const", "define-fun",
+            "assert", "check-sat", "push", "pop", "exit", "get-model", "get-value", "get-info", "echo"
+    };
+
+    static_assert(sizeof(ReservedNames) / sizeof(ReservedNames[0]) == ReservedCount,
+                  "one name per reserved symbol");
+
+    bool isLeftAssociative(uint32_t function) {
+        switch (function) {
+            case FnAnd:
+            case FnOr:
+            case FnXor:
+            case FnConcat:
+            case FnBVAnd:
+            case FnBVOr:
+            case FnBVXor:
+            case FnAdd:
+            case FnMul:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool isDelimiter(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '(' || c == ')' || c == ';' || c == '|'
+               || c == '"';
+    }
+
+    /* bits holds the value least significant bit first, at least width bits of it */
+    Bitvector toBitvector(const std::vector<uint32_t> &bits, unsigned int width) {
+        if (width <= 64) {
+            uint64_t value = bits[0];
+            if (bits.size() > 1) {
+                value |= static_cast<uint64_t>(bits[1]) << 32;
+            }
+            if (width < 64) {
+                value &= (static_cast<uint64_t>(1) << width) - 1;
+            }
+            return Bitvector(value, width);
+        }
+        Bitvector value(0, width);
+        for (unsigned int i = 0; i < width; ++i) {
+            if ((bits[i / 32] >> (i % 32)) & 1) {
+                value.setBit(i, true);
+            }
+        }
+        return value;
+    }
+}
+
+size_t SmtLib2Parser::SliceHash::operator()(const Slice &slice) const {
+    // FNV-1a
+    size_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < slice.length; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(slice.text[i])) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool SmtLib2Parser::SliceEqual::operator()(const Slice &a, const Slice &b) const {
+    return a.length == b.length && memcmp(a.text, b.text, a.length) == 0;
+}
+
+SmtLib2Parser::SmtLib2Parser(SMTTranslator &translator, SMT::Solver &solver)
+        : m_translator(translator), m_solver(solver), m_sat(translator.getSatCore()),
+          m_bvs(translator.getTheoryOfBitvectors()), m_arrays(solver.getBitvectorTheoryOfArrays()), m_solve(true),
+          m_checked(false), m_begin(NULL), m_position(NULL), m_end(NULL) {
+    for (uint32_t i = 0; i < ReservedCount; ++i) {
+        intern(ReservedNames[i], strlen(ReservedNames[i]));
+    }
+}
+
+SmtLib2Parser::~SmtLib2Parser() {
+    // a script without its final pops must not leave a pooled solver deeper than it was
+    try {
+        while (!m_levels.empty()) {
+            m_solver.pop();
+            m_levels.pop_back();
+        }
+    } catch (...) {
+        // the solver is broken anyway, its owner finds out on the next call
+    }
+    unbind(0);
+}
+
+void SmtLib2Parser::setSolveOnCheckSat(bool solve) {
+    m_solve = solve;
+}
+
+void SmtLib2Parser::parse(const char *data, size_t size) {
+    m_begin = data;
+    m_position = data;
+    m_end = data + size;
+    while (peek().kind != TokenEnd) {
+        size_t mark = m_bindings.size();
+        try {
+            command();
+        } catch (...) {
+            discard(mark);
+            throw;
+        }
+    }
+}
+
+void SmtLib2Parser::parseFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw LLBMCException("Cannot open " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw LLBMCException("Cannot open " + path);
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    if (size == 0) {
+        close(fd);
+        return;
+    }
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw LLBMCException("Cannot map " + path);
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+    try {
+        parse(static_cast<const char *>(data), size);
+    } catch (...) {
+        munmap(data, size);
+        throw;
+    }
+    munmap(data, size);
+}
+
+const std::vector<SMT::Solver::Result> &SmtLib2Parser::getResults() const {
+    return m_results;
+}
+
+void SmtLib2Parser::command() {
+    expect(TokenOpen);
+    uint32_t name = expectSymbol();
+    switch (name) {
+        case SymSetLogic:
+            expectSymbol();
+            expect(TokenClose);
+            break;
+        case SymSetInfo:
+        case SymSetOption:
+        case SymGetModel:
+        case SymGetValue:
+        case SymGetInfo:
+        case SymEcho:
+            skip();
+            break;
+        case SymDeclareFun:
+        case SymDeclareConst: {
+            uint32_t symbol = expectSymbol();
+            if (name == SymDeclareFun) {
+                expect(TokenOpen);
+                if (next().kind != TokenClose) {
+                    fail("uninterpreted functions are not supported");
+                }
+            }
+            Value declared = declare(m_symbolNames[symbol], sort());
+            bind(symbol, declared);
+            expect(TokenClose);
+            break;
+        }
+        case SymDefineFun: {
+            uint32_t symbol = expectSymbol();
+            expect(TokenOpen);
+            if (next().kind != TokenClose) {
+                fail("define-fun with parameters is not supported");
+            }
+            Value expected = sort();
+            Value value = term();
+            // bound before the checks, so that an error releases it
+            bind(symbol, value);
+            if (value.sort != expected.sort || value.width != expected.width
+                || value.indexWidth != expected.indexWidth) {
+                fail("define-fun " + m_symbolNames[symbol] + " does not have its declared sort");
+            }
+            expect(TokenClose);
+            break;
+        }
+        case SymAssert: {
+            if (!m_solve && m_checked) {
+                fail("assert after check-sat needs solving at check-sat");
+            }
+            Value value = term();
+            m_values.push_back(value);
+            if (value.sort != SortBool) {
+                fail("assert of a non-Bool term");
+            }
+            expect(TokenClose);
+            m_translator.assertConstraint(m_solver, static_cast<SMT::BoolExp *>(value.exp));
+            m_values.pop_back();
+            release(value);
+            break;
+        }
+        case SymCheckSat:
+            expect(TokenClose);
+            if (!m_solve && m_checked) {
+                fail("a second check-sat needs solving at check-sat");
+            }
+            m_checked = true;
+            if (m_solve) {
+                m_solver.solve();
+                m_results.push_back(m_solver.getResult());
+            }
+            break;
+        case SymPush:
+        case SymPop: {
+            unsigned int levels = peek().kind == TokenNumeral ? expectNumeral() : 1;
+            expect(TokenClose);
+            if (!m_solve) {
+                fail(m_symbolNames[name] + " needs solving at check-sat");
+            }
+            if (name == SymPush) {
+                push(levels);
+            } else {
+                pop(levels);
+            }
+            break;
+        }
+        case SymExit:
+            expect(TokenClose);
+            m_position = m_end;
+            break;
+        default:
+            fail("unsupported command " + m_symbolNames[name]);
+    }
+}
+
+SmtLib2Parser::Value SmtLib2Parser::term() {
+    size_t frames = m_frames.size();
+    while (true) {
+        Value value;
+        Token token = next();
+        if (token.kind == TokenOpen) {
+            Token head = next();
+            if (head.kind == TokenOpen) {
+                // ((_ extract i j) x) and the extensions
+                if (expectSymbol() != SymUnderscore) {
+                    fail("expected an indexed function");
+                }
+                Frame frame;
+                frame.kind = FrameApplication;
+                frame.function = expectSymbol();
+                if (frame.function == FnExtract) {
+                    frame.indices[0] = expectNumeral();
+                    frame.indices[1] = expectNumeral();
+                } else if (frame.function == FnZeroExtend || frame.function == FnSignExtend) {
+                    frame.indices[0] = expectNumeral();
+                } else {
+                    fail("unsupported indexed function " + m_symbolNames[frame.function]);
+                }
+                expect(TokenClose);
+                frame.base = m_values.size();
+                m_frames.push_back(frame);
+                continue;
+            }
+            if (head.kind != TokenSymbol) {
+                fail("expected a function");
+            }
+            uint32_t symbol = intern(head.text, head.length);
+            if (symbol == SymUnderscore) {
+                // (_ bv<value> width)
+                Token digits = next();
+                if (digits.kind != TokenSymbol || digits.length < 3 || strncmp(digits.text, "bv", 2) != 0) {
+                    fail("expected a bitvector literal");
+                }
+                unsigned int width = expectNumeral();
+                expect(TokenClose);
+                value = constant(parseDecimal(digits.text + 2, digits.length - 2, width));
+            } else if (symbol == SymLet) {
+                expect(TokenOpen);
+                expect(TokenOpen);
+                Frame frame;
+                frame.kind = FrameLetBindings;
+                frame.base = m_letValues.size();
+                frame.mark = m_bindings.size();
+                frame.symbol = expectSymbol();
+                m_frames.push_back(frame);
+                continue;
+            } else {
+                if (symbol >= FunctionCount || symbol == FnExtract || symbol == FnZeroExtend
+                    || symbol == FnSignExtend) {
+                    fail("unknown function " + m_symbolNames[symbol]);
+                }
+                Frame frame;
+                frame.kind = FrameApplication;
+                frame.function = symbol;
+                frame.base = m_values.size();
+                m_frames.push_back(frame);
+                continue;
+            }
+        } else if (token.kind == TokenClose) {
+            if (m_frames.size() == frames || m_frames.back().kind != FrameApplication) {
+                fail("unexpected )");
+            }
+            value = apply(m_frames.back());
+            m_frames.pop_back();
+        } else {
+            value = atom(token);
+        }
+
+        // hand the finished term to the enclosing ones
+        while (true) {
+            if (m_frames.size() == frames) {
+                return value;
+            }
+            Frame &top = m_frames.back();
+            if (top.kind == FrameApplication) {
+                m_values.push_back(value);
+                break;
+            }
+            if (top.kind == FrameLetBindings) {
+                Binding binding = {top.symbol, -1, value};
+                m_letValues.push_back(binding);
+                expect(TokenClose);
+                Token following = next();
+                if (following.kind == TokenOpen) {
+                    top.symbol = expectSymbol();
+                    break;
+                }
+                if (following.kind != TokenClose) {
+                    fail("expected a let binding");
+                }
+                // let binds in parallel, nothing is visible before all are parsed
+                for (size_t i = top.base; i < m_letValues.size(); ++i) {
+                    bind(m_letValues[i].symbol, m_letValues[i].value);
+                }
+                m_letValues.resize(top.base);
+                top.kind = FrameLetBody;
+                break;
+            }
+            m_values.push_back(value);
+            expect(TokenClose);
+            m_values.pop_back();
+            size_t mark = top.mark;
+            m_frames.pop_back();
+            unbind(mark);
+        }
+    }
+}
+
+SmtLib2Parser::Value SmtLib2Parser::atom(const Token &token) {
+    Value value;
+    switch (token.kind) {
+        case TokenSymbol: {
+            uint32_t symbol = intern(token.text, token.length);
+            if (symbol == SymTrue || symbol == SymFalse) {
+                value.exp = symbol == SymTrue ? m_sat.mk_true() : m_sat.mk_false();
+                value.sort = SortBool;
+                value.width = 0;
+                value.indexWidth = 0;
+                return value;
+            }
+            if (m_visible[symbol] < 0) {
+                fail("unknown symbol " + m_symbolNames[symbol]);
+            }
+            return copy(m_bindings[m_visible[symbol]].value);
+        }
+        case TokenBinary:
+            return constant(parseBinary(token));
+        case TokenHexadecimal:
+            return constant(parseHexadecimal(token));
+        default:
+            fail("expected a term");
+            return value;
+    }
+}
+
+SmtLib2Parser::Value SmtLib2Parser::apply(const Frame &frame) {
+    size_t count = m_values.size() - frame.base;
+    const Value *operands = count != 0 ? &m_values[frame.base] : NULL;
+    if (count == 0) {
+        fail("function " + m_symbolNames[frame.function] + " without arguments");
+    }
+    Value result;
+    switch (frame.function) {
+        case FnNot:
+            if (count != 1 || operands[0].sort != SortBool) {
+                fail("not takes one Bool");
+            }
+            result = operands[0];
+            result.exp = m_sat.mk_not(static_cast<SMT::BoolExp *>(operands[0].exp));
+            break;
+        case FnBVNot:
+        case FnBVNeg:
+        case FnExtract:
+        case FnZeroExtend:
+        case FnSignExtend: {
+            if (count != 1 || operands[0].sort != SortBitvector) {
+                fail(m_symbolNames[frame.function] + " takes one bitvector");
+            }
+            SMT::BVExp *exp = static_cast<SMT::BVExp *>(operands[0].exp);
+            result = operands[0];
+            if (frame.function == FnBVNot) {
+                result.exp = m_bvs.bvnot(exp);
+            } else if (frame.function == FnBVNeg) {
+                result.exp = m_bvs.bvneg(exp);
+            } else if (frame.function == FnExtract) {
+                if (frame.indices[1] > frame.indices[0] || frame.indices[0] >= operands[0].width) {
+                    fail("extract out of range");
+                }
+                result.exp = m_bvs.extract(frame.indices[0], frame.indices[1], exp);
+                result.width = frame.indices[0] - frame.indices[1] + 1;
+            } else {
+                result.width = checkWidth(static_cast<uint64_t>(operands[0].width) + frame.indices[0]);
+                result.exp = frame.function == FnZeroExtend ? m_bvs.uext(exp, result.width)
+                                                            : m_bvs.sext(exp, result.width);
+            }
+            break;
+        }
+        case FnIte:
+            if (count != 3 || operands[0].sort != SortBool || operands[1].sort != operands[2].sort
+                || operands[1].width != operands[2].width || operands[1].indexWidth != operands[2].indexWidth) {
+                fail("ite takes a Bool and two terms of one sort");
+            }
+            result = operands[1];
+            switch (operands[1].sort) {
+                case SortBool:
+                    result.exp = m_sat.mk_cond(static_cast<SMT::BoolExp *>(operands[0].exp),
+                                               static_cast<SMT::BoolExp *>(operands[1].exp),
+                                               static_cast<SMT::BoolExp *>(operands[2].exp));
+                    break;
+                case SortBitvector:
+                    result.exp = m_bvs.bvcond(static_cast<SMT::BoolExp *>(operands[0].exp),
+                                              static_cast<SMT::BVExp *>(operands[1].exp),
+                                              static_cast<SMT::BVExp *>(operands[2].exp));
+                    break;
+                case SortArray:
+                    result.exp = arrays().acond(static_cast<SMT::BoolExp *>(operands[0].exp),
+                                                static_cast<SMT::AExp *>(operands[1].exp),
+                                                static_cast<SMT::AExp *>(operands[2].exp));
+                    break;
+            }
+            break;
+        case FnSelect:
+            if (count != 2 || operands[0].sort != SortArray || operands[1].sort != SortBitvector
+                || operands[1].width != operands[0].indexWidth) {
+                fail("select takes an array and an index of its index width");
+            }
+            result.exp = arrays().read(static_cast<SMT::AExp *>(operands[0].exp),
+                                       static_cast<SMT::BVExp *>(operands[1].exp));
+            result.sort = SortBitvector;
+            result.width = operands[0].width;
+            result.indexWidth = 0;
+            break;
+        case FnStore:
+            if (count != 3 || operands[0].sort != SortArray || operands[1].sort != SortBitvector
+                || operands[2].sort != SortBitvector || operands[1].width != operands[0].indexWidth
+                || operands[2].width != operands[0].width) {
+                fail("store takes an array, an index and an element of its widths");
+            }
+            result = operands[0];
+            result.exp = arrays().write(static_cast<SMT::AExp *>(operands[0].exp),
+                                        static_cast<SMT::BVExp *>(operands[1].exp),
+                                        static_cast<SMT::BVExp *>(operands[2].exp));
+            break;
+        case FnEq:
+        case FnDistinct: {
+            if (count < 2) {
+                fail(m_symbolNames[frame.function] + " takes at least two terms");
+            }
+            // = is chainable, distinct pairwise; both are conjunctions of binary ones
+            result.exp = NULL;
+            for (size_t i = 0; i + 1 < count; ++i) {
+                size_t last = frame.function == FnEq ? i + 1 : count - 1;
+                for (size_t j = i + 1; j <= last; ++j) {
+                    Value pair = applyBinary(frame.function, operands[i], operands[j]);
+                    if (result.exp == NULL) {
+                        result = pair;
+                    } else {
+                        Value conjunction = applyBinary(FnAnd, result, pair);
+                        release(result);
+                        release(pair);
+                        result = conjunction;
+                    }
+                }
+            }
+            break;
+        }
+        case FnImplies:
+            // right associative
+            result = copy(operands[count - 1]);
+            for (size_t i = count - 1; i-- > 0;) {
+                Value implication = applyBinary(FnImplies, operands[i], result);
+                release(result);
+                result = implication;
+            }
+            break;
+        default:
+            if (count != 2 && !isLeftAssociative(frame.function)) {
+                fail(m_symbolNames[frame.function] + " takes two terms");
+            }
+            result = copy(operands[0]);
+            for (size_t i = 1; i < count; ++i) {
+                Value combined = applyBinary(frame.function, result, operands[i]);
+                release(result);
+                result = combined;
+            }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        release(operands[i]);
+    }
+    m_values.resize(frame.base);
+    return result;
+}
+
+SmtLib2Parser::Value SmtLib2Parser::applyBinary(uint32_t function, const Value &a, const Value &b) {
+    if (a.sort != b.sort || a.indexWidth != b.indexWidth
+        || (a.width != b.width && function != FnConcat)) {
+        fail("operands of " + m_symbolNames[function] + " differ in sort");
+    }
+    Value result = a;
+    result.indexWidth = 0;
+
+    if (function == FnEq || function == FnDistinct) {
+        result.sort = SortBool;
+        result.width = 0;
+        switch (a.sort) {
+            case SortBool:
+                result.exp = function == FnEq
+                             ? m_sat.mk_iff(static_cast<SMT::BoolExp *>(a.exp), static_cast<SMT::BoolExp *>(b.exp))
+                             : m_sat.mk_xor(static_cast<SMT::BoolExp *>(a.exp), static_cast<SMT::BoolExp *>(b.exp));
+                break;
+            case SortBitvector:
+                result.exp = function == FnEq
+                             ? m_bvs.eq(static_cast<SMT::BVExp *>(a.exp), static_cast<SMT::BVExp *>(b.exp))
+                             : m_bvs.bvne(static_cast<SMT::BVExp *>(a.exp), static_cast<SMT::BVExp *>(b.exp));
+                break;
+            case SortArray: {
+                SMT::BoolExp *equal = arrays().eq(static_cast<SMT::AExp *>(a.exp), static_cast<SMT::AExp *>(b.exp));
+                if (function == FnEq) {
+                    result.exp = equal;
+                } else {
+                    result.exp = m_sat.mk_not(equal);
+                    m_sat.release(equal);
+                }
+                break;
+            }
+        }
+        return result;
+    }
+
+    if (function == FnAnd || function == FnOr || function == FnXor || function == FnImplies) {
+        if (a.sort != SortBool) {
+            fail(m_symbolNames[function] + " takes Bools");
+        }
+        SMT::BoolExp *x = static_cast<SMT::BoolExp *>(a.exp);
+        SMT::BoolExp *y = static_cast<SMT::BoolExp *>(b.exp);
+        switch (function) {
+            case FnAnd:
+                result.exp = m_sat.mk_and(x, y);
+                break;
+            case FnOr:
+                result.exp = m_sat.mk_or(x, y);
+                break;
+            case FnXor:
+                result.exp = m_sat.mk_xor(x, y);
+                break;
+            default:
+                result.exp = m_sat.mk_implies(x, y);
+        }
+        return result;
+    }
+
+    if (a.sort != SortBitvector) {
+        fail(m_symbolNames[function] + " takes bitvectors");
+    }
+    SMT::BVExp *x = static_cast<SMT::BVExp *>(a.exp);
+    SMT::BVExp *y = static_cast<SMT::BVExp *>(b.exp);
+    if (function >= FnUlt && function <= FnSdivo) {
+        result.sort = SortBool;
+        result.width = 0;
+    }
+    switch (function) {
+        case FnConcat:
+            result.width = checkWidth(static_cast<uint64_t>(a.width) + b.width);
+            result.exp = m_bvs.concat(x, y);
+            break;
+        case FnBVAnd:
+            result.exp = m_bvs.bvand(x, y);
+            break;
+        case FnBVOr:
+            result.exp = m_bvs.bvor(x, y);
+            break;
+        case FnBVXor:
+            result.exp = m_bvs.bvxor(x, y);
+            break;
+        case FnBVNand:
+        case FnBVNor:
+        case FnBVXnor: {
+            SMT::BVExp *inner = function == FnBVNand ? m_bvs.bvand(x, y)
+                                                     : function == FnBVNor ? m_bvs.bvor(x, y) : m_bvs.bvxor(x, y);
+            result.exp = m_bvs.bvnot(inner);
+            m_bvs.release(inner);
+            break;
+        }
+        case FnAdd:
+            result.exp = m_bvs.bvadd(x, y);
+            break;
+        case FnSub:
+            result.exp = m_bvs.bvsub(x, y);
+            break;
+        case FnMul:
+            result.exp = m_bvs.bvmul(x, y);
+            break;
+        case FnUdiv:
+            result.exp = m_bvs.bvudiv(x, y);
+            break;
+        case FnUrem:
+            result.exp = m_bvs.bvurem(x, y);
+            break;
+        case FnSdiv:
+            result.exp = m_bvs.bvsdiv(x, y);
+            break;
+        case FnSrem:
+            result.exp = m_bvs.bvsrem(x, y);
+            break;
+        case FnShl:
+            result.exp = m_bvs.bvshl(x, y);
+            break;
+        case FnLshr:
+            result.exp = m_bvs.bvlshr(x, y);
+            break;
+        case FnAshr:
+            result.exp = m_bvs.bvashr(x, y);
+            break;
+        case FnUlt:
+            result.exp = m_bvs.bvult(x, y);
+            break;
+        case FnUle:
+            result.exp = m_bvs.bvule(x, y);
+            break;
+        case FnUgt:
+            result.exp = m_bvs.bvugt(x, y);
+            break;
+        case FnUge:
+            result.exp = m_bvs.bvuge(x, y);
+            break;
+        case FnSlt:
+            result.exp = m_bvs.bvslt(x, y);
+            break;
+        case FnSle:
+            result.exp = m_bvs.bvsle(x, y);
+            break;
+        case FnSgt:
+            result.exp = m_bvs.bvsgt(x, y);
+            break;
+        case FnSge:
+            result.exp = m_bvs.bvsge(x, y);
+            break;
+        case FnUaddo:
+            result.exp = m_bvs.bvuaddo(x, y);
+            break;
+        case FnUsubo:
+            result.exp = m_bvs.bvusubo(x, y);
+            break;
+        case FnUmulo:
+            result.exp = m_bvs.bvumulo(x, y);
+            break;
+        case FnSaddo:
+            result.exp = m_bvs.bvsaddo(x, y);
+            break;
+        case FnSsubo:
+            result.exp = m_bvs.bvssubo(x, y);
+            break;
+        case FnSmulo:
+            result.exp = m_bvs.bvsmulo(x, y);
+            break;
+        case FnSdivo:
+            result.exp = m_bvs.bvsdivo(x, y);
+            break;
+        default:
+            fail(m_symbolNames[function] + " does not take bitvectors");
+    }
+    return result;
+}
+
+SmtLib2Parser::Value SmtLib2Parser::constant(const Bitvector &value) {
+    Value result;
+    result.exp = m_bvs.bv2bv(&value);
+    result.sort = SortBitvector;
+    result.width = value.getWidth();
+    result.indexWidth = 0;
+    return result;
+}
+
+SmtLib2Parser::Value SmtLib2Parser::declare(const std::string &name, const Value &sort) {
+    Value result = sort;
+    switch (sort.sort) {
+        case SortBool:
+            result.exp = m_sat.mk_free(name);
+            break;
+        case SortBitvector:
+            // through the translator, so that models list it
+            result.exp = m_translator.createBV(name, static_cast<int>(sort.width));
+            break;
+        case SortArray:
+            result.exp = arrays().array(sort.indexWidth, sort.width, name);
+            break;
+    }
+    return result;
+}
+
+SmtLib2Parser::Value SmtLib2Parser::sort() {
+    Value result;
+    result.exp = NULL;
+    result.width = 0;
+    result.indexWidth = 0;
+    Token token = next();
+    if (token.kind == TokenSymbol && intern(token.text, token.length) == SymBool) {
+        result.sort = SortBool;
+        return result;
+    }
+    if (token.kind != TokenOpen) {
+        fail("expected a sort");
+    }
+    uint32_t head = expectSymbol();
+    if (head == SymUnderscore) {
+        if (expectSymbol() != SymBitVec) {
+            fail("expected BitVec");
+        }
+        result.sort = SortBitvector;
+        result.width = checkWidth(expectNumeral());
+    } else if (head == SymArray) {
+        Value index = sort();
+        Value element = sort();
+        if (index.sort != SortBitvector || element.sort != SortBitvector) {
+            fail("only arrays from bitvectors to bitvectors are supported");
+        }
+        result.sort = SortArray;
+        result.width = element.width;
+        result.indexWidth = index.width;
+    } else {
+        fail("unsupported sort " + m_symbolNames[head]);
+    }
+    expect(TokenClose);
+    return result;
+}
+
+void SmtLib2Parser::bind(uint32_t symbol, const Value &value) {
+    Binding binding = {symbol, m_visible[symbol], value};
+    m_visible[symbol] = static_cast<int32_t>(m_bindings.size());
+    m_bindings.push_back(binding);
+}
+
+void SmtLib2Parser::unbind(size_t mark) {
+    while (m_bindings.size() > mark) {
+        const Binding &binding = m_bindings.back();
+        m_visible[binding.symbol] = binding.previous;
+        release(binding.value);
+        m_bindings.pop_back();
+    }
+}
+
+void SmtLib2Parser::push(unsigned int levels) {
+    if (!m_solver.hasCapability(SMT::Solver::CapPushPop)) {
+        fail(m_solver.getDescription() + " cannot push");
+    }
+    for (unsigned int i = 0; i < levels; ++i) {
+        m_solver.push();
+        m_levels.push_back(m_bindings.size());
+    }
+}
+
+void SmtLib2Parser::pop(unsigned int levels) {
+    if (levels > m_levels.size()) {
+        fail("pop without push");
+    }
+    for (unsigned int i = 0; i < levels; ++i) {
+        m_solver.pop();
+        unbind(m_levels.back());
+        m_levels.pop_back();
+    }
+}
+
+void SmtLib2Parser::discard(size_t mark) {
+    for (std::vector<Value>::const_iterator it = m_values.begin(); it != m_values.end(); ++it) {
+        release(*it);
+    }
+    m_values.clear();
+    for (std::vector<Binding>::const_iterator it = m_letValues.begin(); it != m_letValues.end(); ++it) {
+        release(it->value);
+    }
+    m_letValues.clear();
+    m_frames.clear();
+    unbind(mark);
+}
+
+SmtLib2Parser::Value SmtLib2Parser::copy(const Value &value) {
+    Value result = value;
+    switch (value.sort) {
+        case SortBool:
+            result.exp = m_sat.copy(static_cast<SMT::BoolExp *>(value.exp));
+            break;
+        case SortBitvector:
+            result.exp = m_bvs.copy(static_cast<SMT::BVExp *>(value.exp));
+            break;
+        case SortArray:
+            result.exp = arrays().copy(static_cast<SMT::AExp *>(value.exp));
+            break;
+    }
+    return result;
+}
+
+void SmtLib2Parser::release(const Value &value) {
+    switch (value.sort) {
+        case SortBool:
+            m_sat.release(static_cast<SMT::BoolExp *>(value.exp));
+            break;
+        case SortBitvector:
+            m_bvs.release(static_cast<SMT::BVExp *>(value.exp));
+            break;
+        case SortArray:
+            m_arrays->release(static_cast<SMT::AExp *>(value.exp));
+            break;
+    }
+}
+
+SMT::BitvectorTheoryOfArrays &SmtLib2Parser::arrays() {
+    if (m_arrays == NULL) {
+        fail(m_solver.getDescription() + " does not support arrays");
+    }
+    return *m_arrays;
+}
+
+SmtLib2Parser::Token SmtLib2Parser::next() {
+    while (m_position < m_end) {
+        char c = *m_position;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            ++m_position;
+        } else if (c == ';') {
+            const char *newline = static_cast<const char *>(memchr(m_position, '\n', m_end - m_position));
+            m_position = newline != NULL ? newline : m_end;
+        } else {
+            break;
+        }
+    }
+
+    Token token;
+    token.text = m_position;
+    token.length = 0;
+    if (m_position == m_end) {
+        token.kind = TokenEnd;
+        return token;
+    }
+
+    const char *start = m_position++;
+    switch (*start) {
+        case '(':
+            token.kind = TokenOpen;
+            return token;
+        case ')':
+            token.kind = TokenClose;
+            return token;
+        case '|': {
+            const char *bar = static_cast<const char *>(memchr(m_position, '|', m_end - m_position));
+            if (bar == NULL) {
+                fail("unterminated |symbol|");
+            }
+            token.kind = TokenSymbol;
+            token.text = m_position;
+            token.length = static_cast<size_t>(bar - m_position);
+            m_position = bar + 1;
+            return token;
+        }
+        case '"':
+            // "" is an escaped quote
+            while (true) {
+                const char *quote = static_cast<const char *>(memchr(m_position, '"', m_end - m_position));
+                if (quote == NULL) {
+                    fail("unterminated string");
+                }
+                m_position = quote + 1;
+                if (m_position == m_end || *m_position != '"') {
+                    break;
+                }
+                ++m_position;
+            }
+            token.kind = TokenString;
+            return token;
+        case '#': {
+            if (m_position == m_end || (*m_position != 'b' && *m_position != 'x')) {
+                fail("expected #b or #x");
+            }
+            token.kind = *m_position == 'b' ? TokenBinary : TokenHexadecimal;
+            token.text = ++m_position;
+            while (m_position < m_end && !isDelimiter(*m_position)) {
+                ++m_position;
+            }
+            token.length = static_cast<size_t>(m_position - token.text);
+            return token;
+        }
+        default:
+            break;
+    }
+
+    while (m_position < m_end && !isDelimiter(*m_position)) {
+        ++m_position;
+    }
+    if (*start == ':') {
+        token.kind = TokenKeyword;
+    } else if (*start >= '0' && *start <= '9') {
+        token.kind = TokenNumeral;
+    } else {
+        token.kind = TokenSymbol;
+    }
+    token.text = start;
+    token.length = static_cast<size_t>(m_position - start);
+    return token;
+}
+
+SmtLib2Parser::Token SmtLib2Parser::peek() {
+    const char *position = m_position;
+    Token token = next();
+    m_position = position;
+    return token;
+}
+
+void SmtLib2Parser::expect(TokenKind kind) {
+    if (next().kind != kind) {
+        fail(kind == TokenOpen ? "expected (" : kind == TokenClose ? "expected )" : "unexpected token");
+    }
+}
+
+uint32_t SmtLib2Parser::expectSymbol() {
+    Token token = next();
+    if (token.kind != TokenSymbol) {
+        fail("expected a symbol");
+    }
+    return intern(token.text, token.length);
+}
+
+unsigned int SmtLib2Parser::expectNumeral() {
+    Token token = next();
+    if (token.kind != TokenNumeral) {
+        fail("expected a numeral");
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < token.length; ++i) {
+        char c = token.text[i];
+        if (c < '0' || c > '9' || value > (UINT32_MAX - (c - '0')) / 10) {
+            fail("bad numeral");
+        }
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return static_cast<unsigned int>(value);
+}
+
+void SmtLib2Parser::skip() {
+    unsigned int depth = 1;
+    while (depth > 0) {
+        Token token = next();
+        if (token.kind == TokenOpen) {
+            ++depth;
+        } else if (token.kind == TokenClose) {
+            --depth;
+        } else if (token.kind == TokenEnd) {
+            fail("unexpected end of input");
+        }
+    }
+}
+
+uint32_t SmtLib2Parser::intern(const char *text, size_t length) {
+    Slice slice = {text, length};
+    std::unordered_map<Slice, uint32_t, SliceHash, SliceEqual>::const_iterator it = m_symbols.find(slice);
+    if (it != m_symbols.end()) {
+        return it->second;
+    }
+    // the key must outlive the input, it points into our own copy
+    m_symbolNames.push_back(std::string(text, length));
+    uint32_t id = static_cast<uint32_t>(m_visible.size());
+    Slice owned = {m_symbolNames.back().data(), length};
+    m_symbols.insert(std::make_pair(owned, id));
+    m_visible.push_back(-1);
+    return id;
+}
+
+Bitvector SmtLib2Parser::parseBinary(const Token &token) const {
+    unsigned int width = checkWidth(token.length);
+    std::vector<uint32_t> bits(width / 32 + 2, 0);
+    for (unsigned int i = 0; i < width; ++i) {
+        char c = token.text[width - 1 - i];
+        if (c != '0' && c != '1') {
+            fail("bad binary literal");
+        }
+        bits[i / 32] |= static_cast<uint32_t>(c - '0') << (i % 32);
+    }
+    return toBitvector(bits, width);
+}
+
+Bitvector SmtLib2Parser::parseHexadecimal(const Token &token) const {
+    unsigned int digits = checkWidth(4 * static_cast<uint64_t>(token.length)) / 4;
+    std::vector<uint32_t> bits(digits / 8 + 2, 0);
+    for (unsigned int i = 0; i < digits; ++i) {
+        char c = token.text[digits - 1 - i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = static_cast<uint32_t>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            digit = static_cast<uint32_t>(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            digit = static_cast<uint32_t>(c - 'A' + 10);
+        } else {
+            fail("bad hexadecimal literal");
+            return Bitvector();
+        }
+        bits[i / 8] |= digit << (4 * (i % 8));
+    }
+    return toBitvector(bits, 4 * digits);
+}
+
+Bitvector SmtLib2Parser::parseDecimal(const char *digits, size_t length, unsigned int width) const {
+    checkWidth(width);
+    std::vector<uint32_t> bits(width / 32 + 2, 0);
+    for (size_t i = 0; i < length; ++i) {
+        if (digits[i] < '0' || digits[i] > '9') {
+            fail("bad bitvector literal");
+        }
+        uint64_t carry = static_cast<uint64_t>(digits[i] - '0');
+        for (std::vector<uint32_t>::iterator it = bits.begin(); it != bits.end(); ++it) {
+            uint64_t product = static_cast<uint64_t>(*it) * 10 + carry;
+            *it = static_cast<uint32_t>(product);
+            carry = product >> 32;
+        }
+        if (carry != 0) {
+            fail("bitvector literal does not fit its width");
+        }
+    }
+    // the value must fit into width bits
+    for (size_t bit = width; bit < bits.size() * 32; ++bit) {
+        if ((bits[bit / 32] >> (bit % 32)) & 1) {
+            fail("bitvector literal does not fit its width");
+        }
+    }
+    return toBitvector(bits, width);
+}
+
+unsigned int SmtLib2Parser::checkWidth(uint64_t width) const {
+    if (width == 0) {
+        fail("bitvectors have at least one bit");
+    }
+    if (width > MaxWidth) {
+        fail("bitvector of " + std::to_string(width) + " bits, at most " + std::to_string(MaxWidth) + " are supported");
+    }
+    return static_cast<unsigned int>(width);
+}
+
+void SmtLib2Parser::fail(const std::string &message) const {
+    size_t line = static_cast<size_t>(std::count(m_begin, m_position, '\n')) + 1;
+    throw LLBMCException("line " + std::to_string(line) + ": " + message);
+}
@@ -0,0 +1,233 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_SMTLIB2PARSER_H
+#define TRANSFORMERSOLVER_SMTLIB2PARSER_H
+
+#include "SMTTranslator.h"
+#include "TermDag.h"
+
+#include <llbmc/SMT/Solver.h>
+#include <llbmc/Util/Bitvector.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+/*
+ * Reads SMT-LIB2 scripts in QF_BV and QF_ABV and builds them through the
+ * SMTTranslator's theories into its solver as they are parsed; no syntax
+ * tree is kept. The lexer works on the input buffer (mapped for files)
+ * without copying, symbols are interned once and keep a small id.
+ * Terms are parsed with explicit stacks, so deeply nested input does not
+ * exhaust the C++ stack.
+ *
+ * Supported: set-logic, set-info, set-option, declare-fun and
+ * declare-const of Bool, bitvector and array constants, define-fun without
+ * parameters, assert, check-sat, push, pop, exit; let, the core and
+ * bitvector functions, extract, zero_extend, sign_extend, select, store and
+ * the SMT-LIB 2.7 overflow predicates. Anything else throws an
+ * LLBMCException naming the line, as do bitvectors wider than MaxWidth.
+ *
+ * Levels still pushed at the end are popped by the destructor, so the
+ * solver is left as it was found.
+ */
+class SmtLib2Parser {
+public:
+    enum {
+        MaxWidth = TermDag::MaxWidth
+    };
+
+    SmtLib2Parser(SMTTranslator &translator, SMT::Solver &solver);
+
+    ~SmtLib2Parser();
+
+    /*
+     * Whether check-sat solves, true by default. If not, the caller solves
+     * once the script is read; the script may then hold at most one
+     * check-sat with no assert after it, and no push or pop, since their
+     * answers would differ from the caller's single solve.
+     */
+    void setSolveOnCheckSat(bool solve);
+
+    /* parses and executes script, it must stay valid during the call */
+    void parse(const char *data, size_t size);
+
+    /* maps the file at path and parses it */
+    void parseFile(const std::string &path);
+
+    /* the result of every check-sat that solved, in order */
+    const std::vector<SMT::Solver::Result> &getResults() const;
+
+private:
+    SmtLib2Parser(const SmtLib2Parser &);
+    SmtLib2Parser &operator=(const SmtLib2Parser &);
+
+    enum TokenKind {
+        TokenOpen,
+        TokenClose,
+        TokenSymbol,
+        TokenNumeral,
+        TokenBinary,
+        TokenHexadecimal,
+        TokenKeyword,
+        TokenString,
+        TokenEnd
+    };
+
+    struct Token {
+        TokenKind kind;
+        const char *text;
+        size_t length;
+    };
+
+    enum SortKind {
+        SortBool,
+        SortBitvector,
+        SortArray
+    };
+
+    /* an owned handle with its sort; width is the element width of arrays */
+    struct Value {
+        void *exp;
+        SortKind sort;
+        unsigned int width;
+        unsigned int indexWidth;
+    };
+
+    /* a symbol's bound value; previous is the binding it shadows, -1 if none */
+    struct Binding {
+        uint32_t symbol;
+        int32_t previous;
+        Value value;
+    };
+
+    enum FrameKind {
+        FrameApplication,
+        FrameLetBindings,
+        FrameLetBody
+    };
+
+    /* a term whose operands are being parsed */
+    struct Frame {
+        FrameKind kind;
+        uint32_t function;
+        unsigned int indices[2];
+        /* first operand on m_values, first binding on m_letValues */
+        size_t base;
+        /* m_bindings before the let */
+        size_t mark;
+        uint32_t symbol;
+    };
+
+    /* an interned symbol, pointing into m_symbolNames */
+    struct Slice {
+        const char *text;
+        size_t length;
+    };
+
+    struct SliceHash {
+        size_t operator()(const Slice &slice) const;
+    };
+
+    struct SliceEqual {
+        bool operator()(const Slice &a, const Slice &b) const;
+    };
+
+    void command();
+
+    Value term();
+
+    Value atom(const Token &token);
+
+    Value apply(const Frame &frame);
+
+    Value applyBinary(uint32_t function, const Value &a, const Value &b);
+
+    Value constant(const Bitvector &value);
+
+    Value declare(const std::string &name, const Value &sort);
+
+    Value sort();
+
+    void bind(uint32_t symbol, const Value &value);
+
+    /* removes the bindings made since mark */
+    void unbind(size_t mark);
+
+    void push(unsigned int levels);
+
+    void pop(unsigned int levels);
+
+    /* drops the partly parsed term after an error */
+    void discard(size_t mark);
+
+    Value copy(const Value &value);
+
+    void release(const Value &value);
+
+    SMT::BitvectorTheoryOfArrays &arrays();
+
+    Token next();
+
+    Token peek();
+
+    void expect(TokenKind kind);
+
+    uint32_t expectSymbol();
+
+    unsigned int expectNumeral();
+
+    /* skips the rest of the current s-expression, including its ')' */
+    void skip();
+
+    uint32_t intern(const char *text, size_t length);
+
+    Bitvector parseBinary(const Token &token) const;
+
+    Bitvector parseHexadecimal(const Token &token) const;
+
+    /* the value of (_ bv<digits> width) */
+    Bitvector parseDecimal(const char *digits, size_t length, unsigned int width) const;
+
+    /* width if it is in 1..MaxWidth, fails otherwise */
+    unsigned int checkWidth(uint64_t width) const;
+
+    /* throws an LLBMCException for the current line */
+    void fail(const std::string &message) const;
+
+    SMTTranslator &m_translator;
+    SMT::Solver &m_solver;
+    SMT::SatCore &m_sat;
+    SMT::TheoryOfBitvectors &m_bvs;
+    SMT::BitvectorTheoryOfArrays *m_arrays;
+    bool m_solve;
+    /* a check-sat was read */
+    bool m_checked;
+    std::vector<SMT::Solver::Result> m_results;
+
+    const char *m_begin;
+    const char *m_position;
+    const char *m_end;
+
+    std::deque<std::string> m_symbolNames;
+    std::unordered_map<Slice, uint32_t, SliceHash, SliceEqual> m_symbols;
+
+    /* index into m_bindings of every symbol's visible binding, -1 if none */
+    std::vector<int32_t> m_visible;
+    std::vector<Binding> m_bindings;
+    /* m_bindings at every open push */
+    std::vector<size_t> m_levels;
+
+    std::vector<Frame> m_frames;
+    std::vector<Value> m_values;
+    std::vector<Binding> m_letValues;
+};
+
+
+#endif //TRANSFORMERSOLVER_SMTLIB2PARSER_H
@@ -0,0 +1,356 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "SmtLib2Writer.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace {
+    const char *getOperatorName(TermDag::Op op) {
+        switch (op) {
+            case TermDag::OpNot:
+                return "not";
+            case TermDag::OpAnd:
+                return "and";
+            case TermDag::OpOr:
+                return "or";
+            case TermDag::OpXor:
+                return "xor";
+            case TermDag::OpImplies:
+                return "=>";
+            case TermDag::OpIff:
+            case TermDag::OpEq:
+            case TermDag::OpArrayEq:
+                return "=";
+            case TermDag::OpCond:
+            case TermDag::OpBVCond:
+            case TermDag::OpArrayCond:
+                return "ite";
+            case TermDag::OpNe:
+                return "distinct";
+            case TermDag::OpUlt:
+                return "bvult";
+            case TermDag::OpUle:
+                return "bvule";
+            case TermDag::OpUgt:
+                return "bvugt";
+            case TermDag::OpUge:
+                return "bvuge";
+            case TermDag::OpSlt:
+                return "bvslt";
+            case TermDag::OpSle:
+                return "bvsle";
+            case TermDag::OpSgt:
+                return "bvsgt";
+            case TermDag::OpSge:
+                return "bvsge";
+            case TermDag::OpUaddo:
+                return "bvuaddo";
+            case TermDag::OpUsubo:
+                return "bvusubo";
+            case TermDag::OpUmulo:
+                return "bvumulo";
+            case TermDag::OpSaddo:
+                return "bvsaddo";
+            case TermDag::OpSsubo:
+                return "bvssubo";
+            case TermDag::OpSmulo:
+                return "bvsmulo";
+            case TermDag::OpSdivo:
+                return "bvsdivo";
+            case TermDag::OpConcat:
+                return "concat";
+            case TermDag::OpBVNot:
+                return "bvnot";
+            case TermDag::OpBVNeg:
+                return "bvneg";
+            case TermDag::OpBVAnd:
+                return "bvand";
+            case TermDag::OpBVOr:
+                return "bvor";
+            case TermDag::OpBVXor:
+                return "bvxor";
+            case TermDag::OpAdd:
+                return "bvadd";
+            case TermDag::OpSub:
+                return "bvsub";
+            case TermDag::OpMul:
+                return "bvmul";
+            case TermDag::OpUdiv:
+                return "bvudiv";
+            case TermDag::OpUrem:
+                return "bvurem";
+            case TermDag::OpSdiv:
+                return "bvsdiv";
+            case TermDag::OpSrem:
+                return "bvsrem";
+            case TermDag::OpShl:
+                return "bvshl";
+            case TermDag::OpLshr:
+                return "bvlshr";
+            case TermDag::OpAshr:
+                return "bvashr";
+            case TermDag::OpRead:
+                return "select";
+            case TermDag::OpWrite:
+                return "store";
+            default:
+                return NULL;
+        }
+    }
+
+    bool isVariable(TermDag::Op op) {
+        return op == TermDag::OpFree || op == TermDag::OpBitvector || op == TermDag::OpArray;
+    }
+
+    /* whether name can be written without quotes */
+    bool isSimpleSymbol(const std::string &name) {
+        static const char *const extra = "~!@$%^&*_-+=<>.?/";
+        bool simple = !name.empty() && !(name[0] >= '0' && name[0] <= '9');
+        for (std::string::const_iterator it = name.begin(); simple && it != name.end(); ++it) {
+            simple = (*it >= 'a' && *it <= 'z') || (*it >= 'A' && *it <= 'Z') || (*it >= '0' && *it <= '9')
+                     || strchr(extra, *it) != NULL;
+        }
+        return simple;
+    }
+
+    /* reserved words and the function names the writer uses, no declared symbol may be one of them */
+    const char *const Reserved[] = {
+            "!", "_", "as", "assert", "BINARY", "DECIMAL", "exists", "forall", "HEXADECIMAL", "let", "match",
+            "NUMERAL", "par", "STRING", "true", "false", "extract", "zero_extend", "sign_extend", "Bool", "BitVec",
+            "Array"
+    };
+}
+
+SmtLib2Writer::SmtLib2Writer(const std::string &path) : m_out(path), m_definitions(0) {
+
+}
+
+std::string SmtLib2Writer::makeSymbol(const std::string &name) {
+    // |a|b| cannot be written, the bars and backslashes of a quoted symbol become _
+    std::string base = name;
+    if (!isSimpleSymbol(base)) {
+        std::replace(base.begin(), base.end(), '|', '_');
+        std::replace(base.begin(), base.end(), '\\', '_');
+    }
+    // x and |x| are the same symbol, so uniqueness is decided before quoting
+    std::string symbol = base;
+    for (unsigned int suffix = 1; !m_used.insert(symbol).second; ++suffix) {
+        symbol = base + "!" + std::to_string(suffix);
+    }
+    return isSimpleSymbol(symbol) ? symbol : "|" + symbol + "|";
+}
+
+void SmtLib2Writer::write(const TermDag &dag) {
+    const std::vector<TermDag::NodeId> &assertions = dag.getAssertions();
+
+    // uses of every node below the assertions, saturated at two
+    std::vector<unsigned char> uses(dag.size(), 0);
+    for (std::vector<TermDag::NodeId>::const_iterator it = assertions.begin(); it != assertions.end(); ++it) {
+        uses[*it] = 1;
+    }
+    bool arrays = false;
+    for (size_t id = dag.size(); id-- > 0;) {
+        if (uses[id] == 0) {
+            continue;
+        }
+        TermDag::NodeId node = static_cast<TermDag::NodeId>(id);
+        const TermDag::Node &data = dag.getNode(node);
+        if (data.op == TermDag::OpMemcpy || data.op == TermDag::OpMemset) {
+            throw LLBMCException("SMT-LIB2 has no memcpy or memset");
+        }
+        arrays = arrays || TermDag::getSort(data.op) == TermDag::SortArray;
+        for (unsigned int i = 0; i < data.arity; ++i) {
+            unsigned char &operandUses = uses[dag.getOperand(node, i)];
+            if (operandUses < 2) {
+                ++operandUses;
+            }
+        }
+    }
+
+    m_defined.assign(dag.size(), false);
+    m_indexWidths.assign(dag.size(), 0);
+    m_symbols.clear();
+    m_used.clear();
+    m_used.insert(Reserved, Reserved + sizeof(Reserved) / sizeof(Reserved[0]));
+    for (unsigned int op = 0; op < TermDag::OpCount; ++op) {
+        const char *name = getOperatorName(static_cast<TermDag::Op>(op));
+        if (name != NULL) {
+            m_used.insert(name);
+        }
+    }
+    m_out.write(arrays ? "(set-logic QF_ABV)\n" : "(set-logic QF_BV)\n");
+
+    // variables first, a name taken before (e.g. by a variable of another sort) gets a suffix
+    for (size_t id = 0; id < dag.size(); ++id) {
+        TermDag::NodeId node = static_cast<TermDag::NodeId>(id);
+        const TermDag::Node &data = dag.getNode(node);
+        if (data.op == TermDag::OpArray) {
+            m_indexWidths[id] = dag.getIndexWidth(node);
+        } else if (data.op == TermDag::OpArrayCond) {
+            m_indexWidths[id] = m_indexWidths[dag.getOperand(node, 1)];
+        } else if (TermDag::getSort(data.op) == TermDag::SortArray) {
+            m_indexWidths[id] = m_indexWidths[dag.getOperand(node, 0)];
+        }
+        if (uses[id] == 0 || !isVariable(data.op)) {
+            continue;
+        }
+        m_symbols[node] = makeSymbol(dag.getName(node));
+        writeDeclaration(dag, node);
+    }
+
+    for (size_t id = 0; id < dag.size(); ++id) {
+        TermDag::NodeId node = static_cast<TermDag::NodeId>(id);
+        if (uses[id] < 2 || dag.getNode(node).arity == 0) {
+            continue;
+        }
+        m_symbols[node] = makeSymbol("?t" + std::to_string(id));
+        m_out.write("(define-fun " + m_symbols[node] + " () ");
+        writeSort(dag, node);
+        m_out.write(' ');
+        writeTerm(dag, node);
+        m_out.write(")\n");
+        m_defined[id] = true;
+        ++m_definitions;
+    }
+
+    for (std::vector<TermDag::NodeId>::const_iterator it = assertions.begin(); it != assertions.end(); ++it) {
+        m_out.write("(assert ");
+        writeTerm(dag, *it);
+        m_out.write(")\n");
+    }
+    m_out.write("(check-sat)\n(exit)\n");
+    m_out.close();
+}
+
+size_t SmtLib2Writer::getDefinitionCount() const {
+    return m_definitions;
+}
+
+void SmtLib2Writer::writeDeclaration(const TermDag &dag, TermDag::NodeId id) {
+    m_out.write("(declare-fun " + m_symbols[id] + " () ");
+    writeSort(dag, id);
+    m_out.write(")\n");
+}
+
+void SmtLib2Writer::writeSort(const TermDag &dag, TermDag::NodeId id) {
+    const TermDag::Node &node = dag.getNode(id);
+    switch (TermDag::getSort(node.op)) {
+        case TermDag::SortBool:
+            m_out.write("Bool");
+            break;
+        case TermDag::SortBitvector:
+            m_out.write("(_ BitVec " + std::to_string(node.width) + ")");
+            break;
+        case TermDag::SortArray:
+            m_out.write("(Array (_ BitVec " + std::to_string(m_indexWidths[id]) + ") (_ BitVec "
+                        + std::to_string(node.width) + "))");
+            break;
+    }
+}
+
+void SmtLib2Writer::writeTerm(const TermDag &dag, TermDag::NodeId root) {
+    Frame first = {root, 0};
+    m_stack.push_back(first);
+    while (!m_stack.empty()) {
+        Frame &top = m_stack.back();
+        if (top.next == 0 && writeAtom(dag, top.id)) {
+            m_stack.pop_back();
+            continue;
+        }
+        writePiece(dag, top.id, top.next);
+        if (top.next == dag.getNode(top.id).arity) {
+            m_stack.pop_back();
+            continue;
+        }
+        Frame operand = {dag.getOperand(top.id, top.next), 0};
+        ++top.next;
+        m_stack.push_back(operand);
+    }
+}
+
+bool SmtLib2Writer::writeAtom(const TermDag &dag, TermDag::NodeId id) {
+    const TermDag::Node &node = dag.getNode(id);
+    switch (node.op) {
+        case TermDag::OpTrue:
+            m_out.write("true");
+            return true;
+        case TermDag::OpFalse:
+            m_out.write("false");
+            return true;
+        case TermDag::OpFree:
+        case TermDag::OpBitvector:
+        case TermDag::OpArray:
+            m_out.write(m_symbols[id]);
+            return true;
+        case TermDag::OpConst: {
+            const Bitvector &value = dag.getConstant(id);
+            m_out.write("#b");
+            for (unsigned int i = value.getWidth(); i-- > 0;) {
+                m_out.write(value.getBit(i) ? '1' : '0');
+            }
+            return true;
+        }
+        default:
+            if (!m_defined[id]) {
+                return false;
+            }
+            m_out.write(m_symbols[id]);
+            return true;
+    }
+}
+
+void SmtLib2Writer::writePiece(const TermDag &dag, TermDag::NodeId id, unsigned int i) {
+    const TermDag::Node &node = dag.getNode(id);
+    switch (node.op) {
+        case TermDag::OpBV12Bool:
+            m_out.write(i == 0 ? "(= " : " #b1)");
+            return;
+        case TermDag::OpBool2BV1:
+            m_out.write(i == 0 ? "(ite " : " #b1 #b0)");
+            return;
+        case TermDag::OpBVImplies:
+            m_out.write(i == 0 ? "(bvor (bvnot " : i == 1 ? ") " : ")");
+            return;
+        case TermDag::OpExtract:
+            if (i == 0) {
+                m_out.write("((_ extract " + std::to_string(node.aux + node.width - 1) + " "
+                            + std::to_string(node.aux) + ") ");
+            } else {
+                m_out.write(')');
+            }
+            return;
+        case TermDag::OpUext:
+        case TermDag::OpSext:
+            if (i == 0) {
+                unsigned int extension = node.width - dag.getNode(dag.getOperand(id, 0)).width;
+                m_out.write(std::string(node.op == TermDag::OpUext ? "((_ zero_extend " : "((_ sign_extend ")
+                            + std::to_string(extension) + ") ");
+            } else {
+                m_out.write(')');
+            }
+            return;
+        default:
+            if (i == 0) {
+                m_out.write('(');
+                m_out.write(getOperatorName(node.op));
+                m_out.write(' ');
+            } else {
+                m_out.write(i < node.arity ? ' ' : ')');
+            }
+    }
+}
+
+SmtLib2Sink::SmtLib2Sink(const std::string &path) : m_path(path) {
+
+}
+
+void SmtLib2Sink::solve() {
+    SmtLib2Writer writer(m_path);
+    writer.write(*getDag());
+}
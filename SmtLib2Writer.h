@@ -0,0 +1,95 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_SMTLIB2WRITER_H
+#define TRANSFORMERSOLVER_SMTLIB2WRITER_H
+
+#include "AsyncFileWriter.h"
+#include "TermDag.h"
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+
+/*
+ * Writes the assertions of a TermDag as an SMT-LIB2 script. Every
+ * operation used more than once becomes a define-fun named ?t<id> and is
+ * referenced by name, the others are printed inline, so the script grows
+ * with the DAG and not with the tree it unfolds to. Terms are printed
+ * with an explicit stack, deep formulas do not exhaust the C++ stack.
+ *
+ * Every declared or defined symbol is unique: a variable name that clashes
+ * with another symbol, a reserved word or a function name gets a suffix !<n>.
+ *
+ * Overflow predicates use the SMT-LIB 2.7 names (bvuaddo, ...). memcpy
+ * and memset have no SMT-LIB counterpart and are rejected.
+ */
+class SmtLib2Writer {
+public:
+    /* throws LLBMCException if the file cannot be created */
+    explicit SmtLib2Writer(const std::string &path);
+
+    /*
+     * writes dag followed by (check-sat) and closes the file, throws
+     * LLBMCException for memcpy/memset and on I/O errors
+     */
+    void write(const TermDag &dag);
+
+    /* define-funs written for shared terms */
+    size_t getDefinitionCount() const;
+
+private:
+    SmtLib2Writer(const SmtLib2Writer &);
+    SmtLib2Writer &operator=(const SmtLib2Writer &);
+
+    struct Frame {
+        TermDag::NodeId id;
+        unsigned int next;
+    };
+
+    /* an unused symbol for name, quoted if needed, and marks it as used */
+    std::string makeSymbol(const std::string &name);
+
+    void writeDeclaration(const TermDag &dag, TermDag::NodeId id);
+
+    void writeSort(const TermDag &dag, TermDag::NodeId id);
+
+    void writeTerm(const TermDag &dag, TermDag::NodeId root);
+
+    /* writes a leaf or the name of a defined term, false for other nodes */
+    bool writeAtom(const TermDag &dag, TermDag::NodeId id);
+
+    /* the text before operand i of an operation, i == arity for the closing text */
+    void writePiece(const TermDag &dag, TermDag::NodeId id, unsigned int i);
+
+    AsyncFileWriter m_out;
+    std::vector<bool> m_defined;
+    /* index width of every array node */
+    std::vector<uint32_t> m_indexWidths;
+    /* SMT-LIB symbol of every variable and defined term */
+    std::unordered_map<TermDag::NodeId, std::string> m_symbols;
+    /* symbols taken so far, unquoted */
+    std::unordered_set<std::string> m_used;
+    std::vector<Frame> m_stack;
+    size_t m_definitions;
+};
+
+/*
+ * A TermDagSolver whose solve() writes the recorded formula as SMT-LIB2
+ * instead of solving it; the result stays Unknown.
+ */
+class SmtLib2Sink : public TermDagSolver {
+public:
+    explicit SmtLib2Sink(const std::string &path);
+
+    void solve();
+
+private:
+    std::string m_path;
+};
+
+
+#endif //TRANSFORMERSOLVER_SMTLIB2WRITER_H
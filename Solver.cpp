@@ -3,50 +3,502 @@
 //
 
 #include "Solver.h"
+#include "BatchRunner.h"
+#include "BinaryCnf.h"
+#include "BmcEngine.h"
+#include "CnfWriter.h"
+#include "FormulaFile.h"
+#include "KInduction.h"
+#include "PdrEngine.h"
+#include "QueryCache.h"
+#include "SmtLib2Parser.h"
+#include "SmtLib2Writer.h"
+#include "SolverDaemon.h"
+#include "SolverPortfolio.h"
+#include "TermDag.h"
+
+#include <llbmc/SMT/Solvers.h>
+#include <llbmc/Util/LLBMCException.h>
+
+#include <atomic>
+#include <memory>
+#include <sstream>
+
+#include <unistd.h>
+
+#ifdef WITH_BOOLECTOR
+#include "Boolector/Boolector.h"
+#endif
+
+#ifdef WITH_AIG
+#include "AIG/AigSolver.h"
+#endif
 
 
 void Solver::runSMTSolver() {
-    SMT::Solver::Result::Satisfiable;
-    SMTSolver smtSolver = STP;
-    SMT::Solver *solver;
-    SMT::SatCore *satCore;
-    if (smtSolver = SMTLIB) {
-        SMT::SMTLIB::Common *common = new SMT::SMTLIB::Common(*ostream2());
-        solver = new SMT::SMTLIB(common);
-    } else if (smtSolver = STP) {
-        solver = new SMT::STP(SMT::STP::MiniSat, false);
-        satCore = solver->getSatCore();
-        solver->disableSimplifications();
-        solver->outputCNF();
-        solver->useSimpleCNF();
-    } else if (smtSolver = Boolector) {
+    bool writesCnf = !m_cnfPrefix.empty() || !m_binaryCnfPath.empty();
+    if (writesCnf && (m_portfolio || !m_smtLib2Path.empty())) {
+        throw LLBMCException("CNF output needs the AIG backend, not the portfolio or SMT-LIB output!");
+    }
+    if (!m_cnfPrefix.empty() && !m_binaryCnfPath.empty()) {
+        throw LLBMCException("The CNF can only be written in one format!");
+    }
+    SMTSolver smtSolver = m_portfolio ? Portfolio : !m_smtLib2Path.empty() ? SMTLIB : writesCnf ? Aig : STP;
+    std::string description;
+    SMT::Solver::Result result;
+    // destroyed last, so the answer is printed before the losers are waited for
+    std::unique_ptr<SolverPortfolio> portfolio;
+
+    if (smtSolver == Portfolio) {
+        std::vector<SMTSolver> backends;
+        backends.push_back(STP);
+#ifdef WITH_BOOLECTOR
+        backends.push_back(Boolector);
+#ifdef PICOSAT
+        backends.push_back(BoolectorPicoSAT);
+#endif
+#ifdef BOOLECTOR_MINISAT
+        backends.push_back(BoolectorMiniSat);
+#endif
+#endif
+#ifdef WITH_AIG
+        backends.push_back(Aig);
+#endif
+        // the front-end runs once, the backends only lower its DAG
+        TermDagSolver *recorder = new TermDagSolver();
+        llbmc::SMTContext *context = new llbmc::SMTContext(recorder, 4);
+        SMTTranslator *translator = new SMTTranslator(*context);
+        assertConstraints(*translator, *recorder);
+        std::shared_ptr<const TermDag> dag = recorder->getDag();
+        delete translator;
+        delete context;
+        delete recorder;
+
+        portfolio.reset(new SolverPortfolio(backends));
+        result = portfolio->solve(dag);
+        description = "Portfolio, won by " + portfolio->getWinner();
+    } else {
+        SMT::Solver *solver = createSolver(smtSolver, m_smtLib2Path);
+        if (smtSolver == STP && m_stpCnfDump) {
+            // STP picks the file names itself (output_<n>.cnf in the working directory)
+            solver->outputCNF();
+            solver->useSimpleCNF();
+        }
+        CnfWriter *cnfWriter = NULL;
+        BinaryCnfWriter *binaryCnfWriter = NULL;
+#ifdef WITH_AIG
+        // before the first assertion, so the CNF gets every clause
+        if (!m_cnfPrefix.empty()) {
+            cnfWriter = new CnfWriter(m_cnfPrefix, m_cnfCompress);
+            static_cast<SMT::AigSolver *>(solver)->setClauseSink(cnfWriter);
+        } else if (!m_binaryCnfPath.empty()) {
+            binaryCnfWriter = new BinaryCnfWriter(m_binaryCnfPath);
+            static_cast<SMT::AigSolver *>(solver)->setClauseSink(binaryCnfWriter);
+        }
+#endif
+        llbmc::SMTContext *context = new llbmc::SMTContext(solver, 4);
+        SMTTranslator *translator = new SMTTranslator(*context);
+
+        assertConstraints(*translator, *solver);
+
+        QueryCache *cache = m_queryCachePath.empty() ? NULL : new QueryCache(m_queryCachePath);
+        QueryCache::Entry entry;
+        uint64_t queryHash = 0;
+        uint64_t queryCheck = 0;
+        if (cache != NULL && !cache->isOpen()) {
+            std::cerr << "Query cache " << m_queryCachePath << " cannot be used, solving without it\n";
+        }
+        // a cached answer would skip writing the SMT-LIB file
+        bool cacheable = cache != NULL && cache->isOpen() && smtSolver != SMTLIB
+                         && translator->getQueryHash(queryHash, queryCheck);
+
+        if (cacheable && cache->lookup(queryHash, queryCheck, entry)) {
+            description = solver->getDescription() + " (cached)";
+            result = entry.result;
+        } else {
+            solver->solve();
+            description = solver->getDescription();
+            result = solver->getResult();
 
+            if (cacheable) {
+                entry.result = result;
+                entry.hasModel = result == SMT::Solver::Satisfiable && readModel(smtSolver, *translator, *solver, entry.model);
+                cache->store(queryHash, queryCheck, entry);
+            }
+        }
+        delete cache;
+
+        // the solver gets no more clauses, its sink can go
+        if (cnfWriter != NULL) {
+            cnfWriter->close();
+            if (m_verbose) {
+                std::cerr << "CNF: " << cnfWriter->getVariableCount() << " variables, "
+                          << cnfWriter->getClauseCount() << " clauses in " << cnfWriter->getPath() << "\n";
+            }
+            delete cnfWriter;
+        }
+        if (binaryCnfWriter != NULL) {
+            binaryCnfWriter->close();
+            delete binaryCnfWriter;
+        }
+
+        if (entry.hasModel) {
+            printModel(*translator, entry.model);
+        }
+
+        if (m_verbose) {
+            std::cerr << "Translator cache:" << translator->getCacheHits() << " hits, "
+                      << translator->getCacheMisses() << " misses" << "\n";
+            translator->getSimplifier().printStatistics(std::cerr);
+        }
     }
 
+    printResult(description, result);
+    std::cout.flush();
+}
+
+void Solver::setPortfolio(bool portfolio) {
+    m_portfolio = portfolio;
+}
+
+void Solver::setVerbose(bool verbose) {
+    m_verbose = verbose;
+}
+
+void Solver::setQueryCache(const std::string &path) {
+    m_queryCachePath = path;
+}
+
+void Solver::setSmtLib2Output(const std::string &path) {
+    m_smtLib2Path = path;
+}
+
+void Solver::setStpCnfDump(bool dump) {
+    m_stpCnfDump = dump;
+}
+
+void Solver::setCnfOutput(const std::string &prefix, bool compress) {
+    m_cnfPrefix = prefix;
+    m_cnfCompress = compress;
+}
+
+void Solver::setBinaryCnfOutput(const std::string &path) {
+    m_binaryCnfPath = path;
+}
+
+void Solver::convertBinaryCnf(const std::string &path, const std::string &prefix, bool compress) {
+    BinaryCnf cnf(path);
+    CnfWriter writer(prefix, compress);
+    cnf.replay(writer);
+    writer.close();
+    std::cout << writer.getPath() << ": " << writer.getVariableCount() << " variables, "
+              << writer.getClauseCount() << " clauses\n";
+}
+
+bool Solver::readModel(SMTSolver smtSolver, SMTTranslator &translator, SMT::Solver &solver,
+                       std::vector<uint64_t> &model) {
+    const std::vector<SMTTranslator::Variable> &variables = translator.getVariables();
+    model.clear();
+    for (std::vector<SMTTranslator::Variable>::const_iterator it = variables.begin(); it != variables.end(); ++it) {
+        if (it->width > 64) {
+            return false;
+        }
+    }
+#ifdef WITH_BOOLECTOR
+    if (smtSolver == Boolector || smtSolver == BoolectorPicoSAT || smtSolver == BoolectorMiniSat) {
+        // every variable takes exactly one word of the buffer
+        std::vector<SMT::BVExp *> exps;
+        exps.reserve(variables.size());
+        for (std::vector<SMTTranslator::Variable>::const_iterator it = variables.begin(); it != variables.end(); ++it) {
+            exps.push_back(it->exp);
+        }
+        static_cast<SMT::Boolector &>(solver).getBitvectors(exps.data(), exps.size(), model);
+        return true;
+    }
+#endif
+    (void) smtSolver;
+    SMT::Model *smtModel = solver.getModel();
+    for (std::vector<SMTTranslator::Variable>::const_iterator it = variables.begin(); it != variables.end(); ++it) {
+        const Bitvector *value = smtModel->getBitvector(it->exp);
+        model.push_back(value != NULL && value->isValid() ? value->getUnsigned() : 0);
+        delete value;
+    }
+    return true;
+}
+
+void Solver::printModel(const SMTTranslator &translator, const std::vector<uint64_t> &model) {
+    const std::vector<SMTTranslator::Variable> &variables = translator.getVariables();
+    for (size_t i = 0; i < variables.size() && i < model.size(); ++i) {
+        std::cout << "Model:" << variables[i].name << " = " << model[i] << "\n";
+    }
+}
+
+void Solver::dumpFormula(const std::string &path) {
+    FormulaSink *sink = new FormulaSink(path);
+    llbmc::SMTContext *context = new llbmc::SMTContext(sink, 4);
+    SMTTranslator *translator = new SMTTranslator(*context);
+    assertConstraints(*translator, *sink);
+    sink->solve();
+    std::cout << "Wrote " << sink->getDag()->getAssertions().size() << " assertions to " << path << "\n";
+
+    delete translator;
+    delete context;
+    delete sink;
+}
+
+void Solver::replayFormula(const std::string &path, SMTSolver backend) {
+    FormulaFile file(path);
+    SMT::Solver *solver = createSolver(backend);
+    file.replay(*solver);
+    solver->solve();
+    printResult(solver->getDescription() + " (" + path + ")", solver->getResult());
+    delete solver;
+}
+
+void Solver::runSmtLib2(const std::string &path, SMTSolver backend) {
+    // destroyed in reverse order, also when the script is rejected
+    std::unique_ptr<SMT::Solver> solver(createSolver(backend));
+    if (solver->hasCapability(SMT::Solver::CapPushPop)) {
+        solver->enableIncrementalSolving();
+    }
+    std::unique_ptr<llbmc::SMTContext> context(new llbmc::SMTContext(solver.get(), 4));
+    std::unique_ptr<SMTTranslator> translator(new SMTTranslator(*context));
+
+    SmtLib2Parser parser(*translator, *solver);
+    parser.parseFile(path);
+    // one line per check-sat, like SMT-LIB solvers answer
+    const std::vector<SMT::Solver::Result> &results = parser.getResults();
+    for (std::vector<SMT::Solver::Result>::const_iterator it = results.begin(); it != results.end(); ++it) {
+        std::cout << getResultName(*it) << "\n";
+    }
+}
+
+void Solver::runDaemon(const std::string &socketPath, unsigned int poolSize) {
+    std::vector<SMTSolver> backends;
+    backends.push_back(STP);
+#ifdef WITH_BOOLECTOR
+    backends.push_back(Boolector);
+#ifdef PICOSAT
+    backends.push_back(BoolectorPicoSAT);
+#endif
+#ifdef BOOLECTOR_MINISAT
+    backends.push_back(BoolectorMiniSat);
+#endif
+#endif
+#ifdef WITH_AIG
+    backends.push_back(Aig);
+#endif
+    SolverPool pool(backends, poolSize);
+    BuiltinQueryFormat builtin;
+    BinaryQueryFormat binary;
+    SmtLib2QueryFormat smtLib2;
+
+    SolverDaemon daemon(socketPath, pool);
+    daemon.addFormat(&builtin);
+    daemon.addFormat(&binary);
+    daemon.addFormat(&smtLib2);
+    daemon.run();
+}
+
+void Solver::runBatch(const std::string &source, unsigned int workers, SMTSolver backend,
+                      const std::string &formatName) {
+    BuiltinQueryFormat builtin;
+    BinaryQueryFormat binary;
+    SmtLib2QueryFormat smtLib2;
+    QueryFormat *format;
+    if (formatName == "auto") {
+        // a line of a stream cannot hold a binary formula
+        format = source == "-" ? static_cast<QueryFormat *>(&smtLib2) : &binary;
+    } else if (formatName == builtin.getName()) {
+        format = &builtin;
+    } else if (formatName == binary.getName()) {
+        format = &binary;
+    } else if (formatName == smtLib2.getName()) {
+        format = &smtLib2;
+    } else {
+        throw LLBMCException("Unknown query format " + formatName);
+    }
+
+    BatchRunner runner(*format, backend, workers, std::cout);
+    if (formatName == "auto") {
+        runner.addFormat(".smt2", smtLib2);
+    }
+    if (source == "-") {
+        runner.runStream(std::cin);
+    } else {
+        runner.runDirectory(source);
+    }
+}
+
+void Solver::runBmc(unsigned int maxDepth) {
+#ifdef WITH_BOOLECTOR
+    SMT::Solver *solver = createSolver(Boolector);
+#else
+    SMT::Solver *solver = createSolver(STP);
+#endif
     llbmc::SMTContext *context = new llbmc::SMTContext(solver, 4);
     SMTTranslator *translator = new SMTTranslator(*context);
+    TransitionSystem system = TransitionSystem::transformerExample();
+
+    {
+        BmcEngine bmc(system, *translator, *solver);
+        BmcEngine::Result result = bmc.check(maxDepth);
+
+        std::cout << "Desc:" << "BMC with " << solver->getDescription() << "\n";
+        switch (result) {
+            case BmcEngine::Unsafe:
+                std::cout << "Result:" << "Unsafe at depth " << bmc.getDepth() << "\n";
+                break;
+            case BmcEngine::Safe:
+                std::cout << "Result:" << "Safe up to depth " << maxDepth << "\n";
+                break;
+            default:
+                std::cout << "Result:" << "Unknown at depth " << bmc.getDepth() << "\n";
+        }
+    }
+
+    delete translator;
+    delete context;
+    delete solver;
+}
+
+void Solver::runKInduction(unsigned int maxK) {
+#ifdef WITH_BOOLECTOR
+    SMTSolver backend = Boolector;
+#else
+    SMTSolver backend = STP;
+#endif
+    TransitionSystem system = TransitionSystem::transformerExample();
+    KInduction kInduction(system, backend);
+    KInduction::Result result = kInduction.prove(maxK);
+
+    std::cout << "Desc:" << "k-induction" << "\n";
+    switch (result) {
+        case KInduction::Unsafe:
+            std::cout << "Result:" << "Unsafe at depth " << kInduction.getK() << "\n";
+            break;
+        case KInduction::Safe:
+            std::cout << "Result:" << "Safe, " << kInduction.getK() << "-inductive" << "\n";
+            break;
+        default:
+            std::cout << "Result:" << "Unknown up to k = " << maxK << "\n";
+    }
+}
+
+void Solver::runPdr(unsigned int maxFrames) {
+#ifdef WITH_BOOLECTOR
+    SMTSolver backend = Boolector;
+#else
+    SMTSolver backend = STP;
+#endif
+    TransitionSystem system = TransitionSystem::transformerExample();
+    PdrEngine pdr(system, backend);
+    PdrEngine::Result result = pdr.prove(maxFrames);
+
+    std::cout << "Desc:" << "PDR" << "\n";
+    switch (result) {
+        case PdrEngine::Unsafe:
+            std::cout << "Result:" << "Unsafe" << "\n";
+            break;
+        case PdrEngine::Safe:
+            std::cout << "Result:" << "Safe, invariant F_" << pdr.getInvariantFrame() << "\n";
+            break;
+        default:
+            std::cout << "Result:" << "Unknown after " << maxFrames << " frames" << "\n";
+    }
+    pdr.printStatistics(std::cout);
+}
+
+SMT::Solver *Solver::createSolver(SMTSolver smtSolver, const std::string &smtLib2Path) {
+    static std::atomic<unsigned long> smtLib2Files(0);
+    SMT::Solver *solver = NULL;
+    switch (smtSolver) {
+        case SMTLIB:
+            if (smtLib2Path.empty()) {
+                std::ostringstream path;
+                path << "formula-" << getpid() << "-" << smtLib2Files++ << ".smt2";
+                solver = new SmtLib2Sink(path.str());
+            } else {
+                solver = new SmtLib2Sink(smtLib2Path);
+            }
+            break;
+        case STP: {
+            solver = new SMT::STP(SMT::STP::MiniSat, false);
+            solver->disableSimplifications();
+            break;
+        }
+#ifdef WITH_BOOLECTOR
+        case Boolector:
+            solver = new SMT::Boolector(SMT::Boolector::Lingeling);
+            break;
+        case BoolectorPicoSAT:
+            solver = new SMT::Boolector(SMT::Boolector::PicoSAT);
+            break;
+        case BoolectorMiniSat:
+            solver = new SMT::Boolector(SMT::Boolector::MiniSat);
+            break;
+#else
+        case Boolector:
+        case BoolectorPicoSAT:
+        case BoolectorMiniSat:
+            throw LLBMCException("No Boolector support!");
+#endif
+        case Aig:
+#ifdef WITH_AIG
+            solver = new SMT::AigSolver();
+            break;
+#else
+            throw LLBMCException("No MiniSat for the AIG solver!");
+#endif
+        default:
+            throw LLBMCException("Not a single SMT solver!");
+    }
+    return solver;
+}
 
+bool Solver::interruptSolver(SMTSolver smtSolver, SMT::Solver *solver) {
+    switch (smtSolver) {
+#ifdef WITH_BOOLECTOR
+        case Boolector:
+        case BoolectorPicoSAT:
+        case BoolectorMiniSat:
+            // createSolver builds the SMT::Boolector of Boolector/ for these
+            static_cast<SMT::Boolector *>(solver)->cancel();
+            return true;
+#endif
+#ifdef WITH_AIG
+        case Aig:
+            static_cast<SMT::AigSolver *>(solver)->cancel();
+            return true;
+#endif
+        default:
+            (void) solver;
+            return false;
+    }
+}
+
+void Solver::assertConstraints(SMTTranslator &translator, SMT::Solver &solver) {
     // assert Constraints einzeln s = 3, s'=4, s --> s'
-    SMT::BVExp *s = translator->createBV("s", 4);
-    SMT::BoolExp *sValue = translator->bvAssignValue(s, 3);
+    SMT::BVExp *s = translator.createBV("s", 4);
+    SMT::BoolExp *sValue = translator.bvAssignValue(s, 3);
 
 
-    SMT::BVExp *sDash = translator->createBV("sDash", 4);
-    SMT::BoolExp *sDashValue = translator->bvAssignValue(sDash, 4);
+    SMT::BVExp *sDash = translator.createBV("sDash", 4);
+    SMT::BoolExp *sDashValue = translator.bvAssignValue(sDash, 4);
 
 
-    SMT::BoolExp *imp = satCore->mk_implies(sValue, sDashValue);
-    solver->assertConstraint(imp);
-    //solver->assertConstraint(sValue);
-    //solver->assertConstraint(sDashValue);
+    SMT::BoolExp *imp = translator.boolImplies(sValue, sDashValue);
+    translator.assertConstraint(solver, imp);
+    //solver.assertConstraint(sValue);
+    //solver.assertConstraint(sDashValue);
 
 
-        SMT::BVExp *number = translator->createConst(4096, 9);
-        SMT::BVExp *x = translator->createBV("x", 9);
-        SMT::BoolExp *slt = translator->compareSlt(number, x);
-        solver->assertConstraint(slt);
+        SMT::BVExp *number = translator.createConst(4096, 9);
+        SMT::BVExp *x = translator.createBV("x", 9);
+        SMT::BoolExp *slt = translator.compareSlt(number, x);
+        translator.assertConstraint(solver, slt);
 /*
-        SMT::BoolExp *sValueNeg = translator->bvAssignValueNeg(s, 3);
+        SMT::BoolExp *sValueNeg = translator.bvAssignValueNeg(s, 3);
         SMT::BoolExp *notSValue = satCore->mk_not(sValue);
         SMT::BoolExp *orImp = satCore->mk_or(sValueNeg, sDashValue);
      */
@@ -54,14 +506,12 @@ void Solver::runSMTSolver() {
 
 
     //SMT::BoolExp *test = satCore->mk_implies(sValue,satCore->mk_not(sValue) );
-    //solver->assertConstraint(test);
-
-
-
-    solver->solve();
+    //solver.assertConstraint(test);
+}
 
-    std::cout << "Desc:" << solver->getDescription() << "\n";
-    switch (solver->getResult()) {
+void Solver::printResult(const std::string &description, SMT::Solver::Result result) {
+    std::cout << "Desc:" << description << "\n";
+    switch (result) {
         case SMT::Solver::Result::Satisfiable: {
             std::cout << "Result:" << "Satisfiable" << "\n";
             break;
@@ -81,9 +531,36 @@ void Solver::runSMTSolver() {
     }
 }
 
-llvm::raw_ostream *Solver::ostream2() {
-    llvm::StringRef sRefName("/home/marko/test");
-    std::error_code err_code;
-    llvm::raw_fd_ostream *raw = new llvm::raw_fd_ostream(sRefName, err_code, llvm::sys::fs::OpenFlags::F_Append);
-    return raw;
+bool Solver::parseSMTSolver(const std::string &name, SMTSolver &smtSolver) {
+    if (name == "stp") {
+        smtSolver = STP;
+    } else if (name == "smtlib") {
+        smtSolver = SMTLIB;
+    } else if (name == "boolector") {
+        smtSolver = Boolector;
+    } else if (name == "boolector-picosat") {
+        smtSolver = BoolectorPicoSAT;
+    } else if (name == "boolector-minisat") {
+        smtSolver = BoolectorMiniSat;
+    } else if (name == "aig") {
+        smtSolver = Aig;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *Solver::getResultName(SMT::Solver::Result result) {
+    switch (result) {
+        case SMT::Solver::Satisfiable:
+            return "sat";
+        case SMT::Solver::Unsatisfiable:
+            return "unsat";
+        case SMT::Solver::Unsupported:
+            return "unsupported";
+        case SMT::Solver::Timeout:
+            return "timeout";
+        default:
+            return "unknown";
+    }
 }
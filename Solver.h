@@ -14,6 +14,7 @@
 #include <llbmc/SMT/STP.h>
 #include <llvm/Support/FormattedStream.h>
 #include <llvm/Support/FileSystem.h>
+#include <vector>
 
 
 
@@ -23,13 +24,156 @@ public:
     {
         SMTLIB,
         STP,
-        Boolector
+        Boolector,
+        BoolectorPicoSAT,
+        BoolectorMiniSat,
+        Aig,
+        Portfolio
     };
 
     void runSMTSolver();
 
-    llvm::raw_ostream *ostream2();
+    /*
+     * Makes runSMTSolver race all available backends with SolverPortfolio
+     * instead of solving on STP alone.
+     */
+    void setPortfolio(bool portfolio);
 
+    /*
+     * Makes runSMTSolver print the translator and simplifier statistics to
+     * stderr. Off by default, stdout only carries the result.
+     */
+    void setVerbose(bool verbose);
+
+    /*
+     * Answers runSMTSolver from the query cache at path if the same query
+     * (up to variable names) was solved before, and stores new answers.
+     */
+    void setQueryCache(const std::string &path);
+
+    /*
+     * Makes runSMTSolver write the formula as SMT-LIB2 to path instead of
+     * solving it, see SmtLib2Writer.
+     */
+    void setSmtLib2Output(const std::string &path);
+
+    /*
+     * Lets STP dump its CNF into the working directory during runSMTSolver.
+     * Off by default, the dump takes about as long as solving; CnfWriter is
+     * the faster sink for the CNF we produce ourselves.
+     */
+    void setStpCnfDump(bool dump);
+
+    /*
+     * Makes runSMTSolver solve on the AIG backend and write the CNF it
+     * bit-blasts to <prefix>.cnf (gzip compressed if compress) with the
+     * variable map in <prefix>.map, see CnfWriter.
+     */
+    void setCnfOutput(const std::string &prefix, bool compress);
+
+    /*
+     * Like setCnfOutput, but writes the CNF to path as a BinaryCnf. Only one
+     * of the two outputs can be used at a time.
+     */
+    void setBinaryCnfOutput(const std::string &path);
+
+    /* Converts the BinaryCnf at path to <prefix>.cnf in DIMACS, see CnfWriter. */
+    void convertBinaryCnf(const std::string &path, const std::string &prefix, bool compress);
+
+    /*
+     * Writes the transformer constraints to path as a FormulaFile instead
+     * of solving them.
+     */
+    void dumpFormula(const std::string &path);
+
+    /* Solves the FormulaFile at path with the given backend. */
+    void replayFormula(const std::string &path, SMTSolver backend);
+
+    /*
+     * Runs the SMT-LIB2 script at path on the given backend and prints the
+     * result of every check-sat as a line with its getResultName, see
+     * SmtLib2Parser. Throws LLBMCException for rejected scripts.
+     */
+    void runSmtLib2(const std::string &path, SMTSolver backend);
+
+    /*
+     * Serves queries on the Unix socket at socketPath until a client asks
+     * for shutdown, see SolverDaemon.
+     */
+    void runDaemon(const std::string &socketPath, unsigned int poolSize);
+
+    /*
+     * Solves every file in the directory at source, or every line of stdin
+     * if source is "-", on workers threads with the given backend and prints
+     * one record per query as it completes, see BatchRunner. formatName is
+     * builtin, binary, smtlib2 or auto: files ending in .smt2 are SMT-LIB2
+     * scripts and all other files FormulaFiles, stream lines SMT-LIB2.
+     */
+    void runBatch(const std::string &source, unsigned int workers, SMTSolver backend,
+                  const std::string &formatName = "auto");
+
+    /*
+     * Unrolls TransitionSystem::transformerExample up to maxDepth steps on
+     * one incremental solver.
+     */
+    void runBmc(unsigned int maxDepth);
+
+    /*
+     * Proves TransitionSystem::transformerExample by k-induction, base and step case on two
+     * solver instances of the same backend.
+     */
+    void runKInduction(unsigned int maxK);
+
+    /* Proves TransitionSystem::transformerExample with PDR. */
+    void runPdr(unsigned int maxFrames);
+
+    /*
+     * Creates a fresh backend instance. Portfolio is not a backend. SMTLIB
+     * only writes the formula to smtLib2Path; without one every instance
+     * gets its own formula-<pid>-<n>.smt2 in the working directory, so
+     * parallel workers do not overwrite each other's files.
+     */
+    static SMT::Solver *createSolver(SMTSolver smtSolver, const std::string &smtLib2Path = std::string());
+
+    /*
+     * Asks a solver made by createSolver(smtSolver) to abort its running
+     * solve(); may be called from another thread. Returns false if the
+     * backend cannot be interrupted, its solve() then runs to the end.
+     */
+    static bool interruptSolver(SMTSolver smtSolver, SMT::Solver *solver);
+
+    /*
+     * Asserts the transformer constraints. Called once per backend, so it
+     * must only use the given translator and solver.
+     */
+    static void assertConstraints(SMTTranslator &translator, SMT::Solver &solver);
+
+    static void printResult(const std::string &description, SMT::Solver::Result result);
+
+    /*
+     * Backend by its command line name: stp, smtlib, boolector,
+     * boolector-picosat, boolector-minisat, aig. False for unknown names.
+     */
+    static bool parseSMTSolver(const std::string &name, SMTSolver &smtSolver);
+
+    /* sat, unsat, unknown, unsupported or timeout */
+    static const char *getResultName(SMT::Solver::Result result);
+
+    /* values of translator.getVariables(), false if one is wider than 64 bits; Boolector decodes them in bulk */
+    static bool readModel(SMTSolver smtSolver, SMTTranslator &translator, SMT::Solver &solver,
+                          std::vector<uint64_t> &model);
+
+    static void printModel(const SMTTranslator &translator, const std::vector<uint64_t> &model);
+
+private:
+    std::string m_queryCachePath;
+    std::string m_smtLib2Path;
+    bool m_stpCnfDump = false;
+    std::string m_cnfPrefix;
+    bool m_cnfCompress = false;
+    std::string m_binaryCnfPath;
+    bool m_portfolio = false;
+    bool m_verbose = false;
 };
 
 
@@ -0,0 +1,272 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "SolverDaemon.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <sstream>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+/* Buffered reads and writes on one client socket. */
+class SolverDaemon::Connection {
+public:
+    Connection(int fd) : m_fd(fd), m_begin(0), m_end(0) {}
+
+    /* false at the end of the stream */
+    bool readLine(std::string &line) {
+        line.clear();
+        for (;;) {
+            for (size_t i = m_begin; i < m_end; ++i) {
+                if (m_buffer[i] == '\n') {
+                    line.append(m_buffer + m_begin, i - m_begin);
+                    m_begin = i + 1;
+                    return true;
+                }
+            }
+            line.append(m_buffer + m_begin, m_end - m_begin);
+            if (!fill()) {
+                return false;
+            }
+        }
+    }
+
+    bool readExact(size_t size, std::string &data) {
+        data.clear();
+        data.reserve(size);
+        while (data.size() < size) {
+            if (m_begin == m_end && !fill()) {
+                return false;
+            }
+            size_t chunk = std::min(size - data.size(), m_end - m_begin);
+            data.append(m_buffer + m_begin, chunk);
+            m_begin += chunk;
+        }
+        return true;
+    }
+
+    bool write(const std::string &data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t res = send(m_fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+            if (res <= 0) {
+                return false;
+            }
+            written += static_cast<size_t>(res);
+        }
+        return true;
+    }
+
+private:
+    bool fill() {
+        m_begin = 0;
+        m_end = 0;
+        for (;;) {
+            ssize_t res = read(m_fd, m_buffer, sizeof(m_buffer));
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+            if (res <= 0) {
+                return false;
+            }
+            m_end = static_cast<size_t>(res);
+            return true;
+        }
+    }
+
+    int m_fd;
+    char m_buffer[65536];
+    size_t m_begin;
+    size_t m_end;
+};
+
+SolverDaemon::SolverDaemon(const std::string &socketPath, SolverPool &pool)
+        : m_socketPath(socketPath), m_pool(pool), m_listenFd(-1), m_stopping(false) {
+
+}
+
+SolverDaemon::~SolverDaemon() {
+    if (m_listenFd >= 0) {
+        close(m_listenFd);
+        unlink(m_socketPath.c_str());
+    }
+}
+
+void SolverDaemon::addFormat(QueryFormat *format) {
+    m_formats[format->getName()] = format;
+}
+
+void SolverDaemon::run() {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (m_socketPath.size() >= sizeof(address.sun_path)) {
+        throw LLBMCException("Socket path too long: " + m_socketPath);
+    }
+    strncpy(address.sun_path, m_socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    m_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listenFd < 0) {
+        throw LLBMCException("Cannot create socket!");
+    }
+    unlink(m_socketPath.c_str());
+    if (bind(m_listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0
+        || listen(m_listenFd, 64) != 0) {
+        throw LLBMCException("Cannot listen on " + m_socketPath);
+    }
+
+    for (;;) {
+        int fd = accept(m_listenFd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // stop() shut the listening socket down
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping) {
+            close(fd);
+            break;
+        }
+        reap();
+        m_connections.insert(fd);
+        m_threads.push_back(std::thread(&SolverDaemon::serve, this, fd));
+    }
+
+    // wake up connections waiting for their next request and wait for the rest
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        for (std::set<int>::iterator it = m_connections.begin(); it != m_connections.end(); ++it) {
+            shutdown(*it, SHUT_RD);
+        }
+    }
+    for (std::list<std::thread>::iterator it = m_threads.begin(); it != m_threads.end(); ++it) {
+        it->join();
+    }
+    m_threads.clear();
+    m_finished.clear();
+}
+
+void SolverDaemon::serve(int fd) {
+    Connection connection(fd);
+    std::string request;
+    while (connection.readLine(request)) {
+        if (request == "shutdown") {
+            connection.write("ok\n");
+            stop();
+            break;
+        }
+        std::string response;
+        bool inSync = answer(request, connection, response);
+        if (!connection.write(response) || !inSync) {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_connections.erase(fd);
+    close(fd);
+    m_finished.push_back(std::this_thread::get_id());
+}
+
+bool SolverDaemon::answer(const std::string &request, Connection &connection, std::string &response) {
+    std::istringstream header(request);
+    std::string formatName;
+    std::string backendName;
+    std::string sizeText;
+    if (!(header >> formatName >> backendName >> sizeText)) {
+        response = "error malformed request\n";
+        return false;
+    }
+
+    // istream would wrap "-1" to SIZE_MAX, only plain digits are a size
+    size_t size = 0;
+    for (std::string::const_iterator it = sizeText.begin(); it != sizeText.end(); ++it) {
+        if (*it < '0' || *it > '9' || size > (MaxPayloadSize - (*it - '0')) / 10) {
+            response = "error payload size " + sizeText + " not in 0.." + std::to_string(MaxPayloadSize) + "\n";
+            return false;
+        }
+        size = size * 10 + static_cast<size_t>(*it - '0');
+    }
+
+    std::string payload;
+    if (!connection.readExact(size, payload)) {
+        response = "error truncated payload\n";
+        return false;
+    }
+
+    std::map<std::string, QueryFormat *>::iterator format = m_formats.find(formatName);
+    if (format == m_formats.end()) {
+        response = "error unknown format " + formatName + "\n";
+        return true;
+    }
+    Solver::SMTSolver backend;
+    if (!Solver::parseSMTSolver(backendName, backend) || !m_pool.hasBackend(backend)) {
+        response = "error unknown backend " + backendName + "\n";
+        return true;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    SolverPool::Instance *instance = NULL;
+    std::ostringstream out;
+    try {
+        instance = m_pool.acquire(backend);
+        format->second->assertQuery(payload.data(), payload.size(), *instance->translator, *instance->solver);
+
+        std::chrono::steady_clock::time_point solveStart = std::chrono::steady_clock::now();
+        instance->solver->solve();
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        out << Solver::getResultName(instance->solver->getResult()) << " "
+            << std::chrono::duration_cast<std::chrono::microseconds>(end - solveStart).count() << " "
+            << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << "\n";
+    } catch (const LLBMCException &e) {
+        out.str("");
+        out << "error " << e.getMessage() << "\n";
+    } catch (const std::exception &e) {
+        // e.g. bad_alloc from a huge query, the daemon keeps serving
+        out.str("");
+        out << "error " << e.what() << "\n";
+    }
+    if (instance != NULL) {
+        m_pool.release(instance);
+    }
+    response = out.str();
+    return true;
+}
+
+void SolverDaemon::stop() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+    shutdown(m_listenFd, SHUT_RDWR);
+}
+
+void SolverDaemon::reap() {
+    for (std::vector<std::thread::id>::iterator id = m_finished.begin(); id != m_finished.end(); ++id) {
+        for (std::list<std::thread>::iterator it = m_threads.begin(); it != m_threads.end(); ++it) {
+            if (it->get_id() == *id) {
+                // the thread is past its last lock, join only waits for it to return
+                it->join();
+                m_threads.erase(it);
+                break;
+            }
+        }
+    }
+    m_finished.clear();
+}
@@ -0,0 +1,80 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_SOLVERDAEMON_H
+#define TRANSFORMERSOLVER_SOLVERDAEMON_H
+
+#include "QueryFormat.h"
+#include "SolverPool.h"
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/*
+ * Answers queries on a Unix domain socket with solvers from a SolverPool,
+ * so a query pays neither process startup nor solver construction. Every
+ * connection gets a thread and may send any number of requests:
+ *
+ *   <format> <backend> <payload size>\n<payload>
+ *
+ * is answered with
+ *
+ *   <result> <solve microseconds> <total microseconds>\n
+ *
+ * or "error <message>\n". Backends are named as in Solver::parseSMTSolver,
+ * results as in Solver::getResultName. The request "shutdown\n" stops the
+ * daemon. A malformed size, a payload over MaxPayloadSize or a truncated
+ * payload is answered with an error and closes the connection.
+ */
+class SolverDaemon {
+public:
+    static const size_t MaxPayloadSize = 256 * 1024 * 1024;
+
+    SolverDaemon(const std::string &socketPath, SolverPool &pool);
+
+    ~SolverDaemon();
+
+    /* the format is not owned and must outlive the daemon */
+    void addFormat(QueryFormat *format);
+
+    /* serves until a shutdown request, throws LLBMCException if the socket cannot be set up */
+    void run();
+
+private:
+    SolverDaemon(const SolverDaemon &);
+    SolverDaemon &operator=(const SolverDaemon &);
+
+    class Connection;
+
+    void serve(int fd);
+
+    /* false if the connection is out of sync and has to be closed after the response */
+    bool answer(const std::string &request, Connection &connection, std::string &response);
+
+    void stop();
+
+    /* joins the threads of closed connections, m_mutex must be held */
+    void reap();
+
+    std::string m_socketPath;
+    SolverPool &m_pool;
+    std::map<std::string, QueryFormat *> m_formats;
+
+    int m_listenFd;
+    std::mutex m_mutex;
+    bool m_stopping;
+    std::set<int> m_connections;
+    std::list<std::thread> m_threads;
+    /* threads whose connection is closed, joined by reap */
+    std::vector<std::thread::id> m_finished;
+};
+
+
+#endif //TRANSFORMERSOLVER_SOLVERDAEMON_H
@@ -0,0 +1,155 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "SolverPool.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <iostream>
+
+
+SolverPool::SolverPool(const std::vector<Solver::SMTSolver> &backends, unsigned int size)
+        : m_size(size), m_stopping(false) {
+    for (std::vector<Solver::SMTSolver>::const_iterator it = backends.begin(); it != backends.end(); ++it) {
+        std::vector<Instance *> idle;
+        try {
+            while (idle.size() < m_size) {
+                idle.push_back(create(*it));
+            }
+        } catch (const LLBMCException &e) {
+            // e.g. a SAT solver Boolector was built without, the other backends still serve
+            std::cerr << "Backend left out of the solver pool: " << e.getMessage() << "\n";
+            for (std::vector<Instance *>::iterator instance = idle.begin(); instance != idle.end(); ++instance) {
+                destroy(*instance);
+            }
+            continue;
+        }
+        m_idle[*it].swap(idle);
+    }
+    m_refill = std::thread(&SolverPool::refill, this);
+}
+
+SolverPool::~SolverPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeRefill.notify_all();
+    m_refill.join();
+
+    for (std::map<Solver::SMTSolver, std::vector<Instance *> >::iterator it = m_idle.begin(); it != m_idle.end(); ++it) {
+        for (std::vector<Instance *>::iterator instance = it->second.begin(); instance != it->second.end(); ++instance) {
+            destroy(*instance);
+        }
+    }
+}
+
+SolverPool::Instance *SolverPool::acquire(Solver::SMTSolver backend) {
+    Instance *instance = NULL;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<Solver::SMTSolver, std::vector<Instance *> >::iterator it = m_idle.find(backend);
+        if (it == m_idle.end()) {
+            throw LLBMCException("Backend not in the solver pool!");
+        }
+        if (!it->second.empty()) {
+            instance = it->second.back();
+            it->second.pop_back();
+        }
+    }
+    m_wakeRefill.notify_one();
+
+    if (instance == NULL) {
+        instance = create(backend);
+    }
+    if (instance->reusable) {
+        instance->solver->push();
+    }
+    return instance;
+}
+
+void SolverPool::release(Instance *instance) {
+    if (!reset(instance)) {
+        destroy(instance);
+        m_wakeRefill.notify_one();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<Instance *> &idle = m_idle[instance->backend];
+    if (idle.size() < m_size) {
+        idle.push_back(instance);
+    } else {
+        destroy(instance);
+    }
+}
+
+bool SolverPool::hasBackend(Solver::SMTSolver backend) const {
+    return m_idle.find(backend) != m_idle.end();
+}
+
+SolverPool::Instance *SolverPool::create(Solver::SMTSolver backend) {
+    Instance *instance = new Instance;
+    instance->backend = backend;
+    instance->solver = Solver::createSolver(backend);
+    instance->reusable = instance->solver->hasCapability(SMT::Solver::CapPushPop);
+    instance->queries = 0;
+    if (instance->reusable) {
+        instance->solver->enableIncrementalSolving();
+    }
+    instance->context = new llbmc::SMTContext(instance->solver, 4);
+    instance->translator = new SMTTranslator(*instance->context);
+    return instance;
+}
+
+void SolverPool::destroy(Instance *instance) {
+    delete instance->translator;
+    delete instance->context;
+    delete instance->solver;
+    delete instance;
+}
+
+bool SolverPool::reset(Instance *instance) {
+    if (!instance->reusable) {
+        return false;
+    }
+    instance->solver->pop();
+    instance->translator->clearAssertions();
+    return ++instance->queries < MaxQueries;
+}
+
+void SolverPool::refill() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        bool built = false;
+        for (std::map<Solver::SMTSolver, std::vector<Instance *> >::iterator it = m_idle.begin(); it != m_idle.end(); ++it) {
+            if (it->second.size() < m_size) {
+                Solver::SMTSolver backend = it->first;
+                // build outside of the lock, acquire() must not wait for it
+                lock.unlock();
+                Instance *instance = NULL;
+                try {
+                    instance = create(backend);
+                } catch (const LLBMCException &) {
+                    // acquire() builds its own instance then and reports the error
+                }
+                lock.lock();
+                if (instance == NULL) {
+                    break;
+                }
+                std::vector<Instance *> &idle = m_idle[backend];
+                if (idle.size() < m_size) {
+                    idle.push_back(instance);
+                } else {
+                    destroy(instance);
+                }
+                built = true;
+                break;
+            }
+        }
+        if (!built) {
+            m_wakeRefill.wait(lock);
+        }
+    }
+}
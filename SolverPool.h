@@ -0,0 +1,76 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_SOLVERPOOL_H
+#define TRANSFORMERSOLVER_SOLVERPOOL_H
+
+#include "Solver.h"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/*
+ * Pre-constructed solvers per backend, each with its SMTContext and
+ * SMTTranslator, so a query does not pay for building them. Backends with
+ * push/pop are reused: acquire() pushes a context and release() pops it
+ * again. All other instances are thrown away after one query and a
+ * background thread builds a replacement. The translator and its simplifier
+ * keep every term they have built, so reused instances are replaced as well
+ * once they have answered MaxQueries queries.
+ */
+class SolverPool {
+public:
+    struct Instance {
+        Solver::SMTSolver backend;
+        SMT::Solver *solver;
+        llbmc::SMTContext *context;
+        SMTTranslator *translator;
+        bool reusable;
+        unsigned int queries;
+    };
+
+    enum { MaxQueries = 64 };
+
+    /* keeps size warm instances of every backend, backends that cannot be built are left out */
+    SolverPool(const std::vector<Solver::SMTSolver> &backends, unsigned int size);
+
+    ~SolverPool();
+
+    /* takes a warm instance, or builds one if none is left */
+    Instance *acquire(Solver::SMTSolver backend);
+
+    /* hands an instance back after its query */
+    void release(Instance *instance);
+
+    bool hasBackend(Solver::SMTSolver backend) const;
+
+    /* a fresh instance outside of any pool, incremental if the backend has push/pop */
+    static Instance *create(Solver::SMTSolver backend);
+
+    static void destroy(Instance *instance);
+
+    /* pops a reusable instance after its query; false if it has to be destroyed instead */
+    static bool reset(Instance *instance);
+
+private:
+    SolverPool(const SolverPool &);
+    SolverPool &operator=(const SolverPool &);
+
+    void refill();
+
+    unsigned int m_size;
+    std::map<Solver::SMTSolver, std::vector<Instance *> > m_idle;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeRefill;
+    bool m_stopping;
+    std::thread m_refill;
+};
+
+
+#endif //TRANSFORMERSOLVER_SOLVERPOOL_H
@@ -0,0 +1,139 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "SolverPortfolio.h"
+#include "DagLowering.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+
+
+struct SolverPortfolio::Race {
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::atomic<bool> cancelled;
+    unsigned int pending;
+    SMT::Solver::Result result;
+    std::string winner;
+    // backends currently building or solving, guarded by mutex
+    std::map<SMT::Solver *, Solver::SMTSolver> running;
+
+    Race(unsigned int backends) : cancelled(false), pending(backends), result(SMT::Solver::Unknown) {}
+};
+
+SolverPortfolio::SolverPortfolio(const std::vector<Solver::SMTSolver> &backends) : m_backends(backends) {
+
+}
+
+SolverPortfolio::~SolverPortfolio() {
+    join();
+}
+
+SMT::Solver::Result SolverPortfolio::solve(ConstraintBuilder builder) {
+    return run(builder, std::shared_ptr<const TermDag>());
+}
+
+SMT::Solver::Result SolverPortfolio::solve(std::shared_ptr<const TermDag> dag) {
+    return run(ConstraintBuilder(), dag);
+}
+
+SMT::Solver::Result SolverPortfolio::run(ConstraintBuilder builder, std::shared_ptr<const TermDag> dag) {
+    join();
+    m_winner.clear();
+    if (m_backends.empty()) {
+        return SMT::Solver::Unknown;
+    }
+
+    std::shared_ptr<Race> race(new Race(static_cast<unsigned int>(m_backends.size())));
+    for (std::vector<Solver::SMTSolver>::const_iterator it = m_backends.begin(); it != m_backends.end(); ++it) {
+        m_threads.push_back(std::thread(&SolverPortfolio::runBackend, race, *it, builder, dag));
+    }
+
+    std::unique_lock<std::mutex> lock(race->mutex);
+    race->finished.wait(lock, [&race] { return race->cancelled || race->pending == 0; });
+    m_winner = race->winner;
+    return race->result;
+}
+
+void SolverPortfolio::join() {
+    // the losers were interrupted when the winner answered, only STP may still be busy
+    for (std::vector<std::thread>::iterator it = m_threads.begin(); it != m_threads.end(); ++it) {
+        it->join();
+    }
+    m_threads.clear();
+}
+
+const std::string &SolverPortfolio::getWinner() const {
+    return m_winner;
+}
+
+void SolverPortfolio::runBackend(std::shared_ptr<Race> race, Solver::SMTSolver backend, ConstraintBuilder builder,
+                                 std::shared_ptr<const TermDag> dag) {
+    SMT::Solver *solver = NULL;
+    llbmc::SMTContext *context = NULL;
+    SMTTranslator *translator = NULL;
+    DagLowering *lowering = NULL;
+    SMT::Solver::Result result = SMT::Solver::Unknown;
+    std::string description;
+
+    try {
+        solver = Solver::createSolver(backend);
+        description = solver->getDescription();
+        if (dag) {
+            lowering = new DagLowering(*dag, *solver);
+            lowering->assertAll();
+        } else {
+            context = new llbmc::SMTContext(solver, 4);
+            translator = new SMTTranslator(*context);
+            builder(*translator, *solver);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(race->mutex);
+            if (race->cancelled) {
+                Solver::interruptSolver(backend, solver);
+            }
+            race->running.insert(std::make_pair(solver, backend));
+        }
+
+        if (!race->cancelled) {
+            solver->solve();
+            result = solver->getResult();
+        }
+    } catch (const LLBMCException &) {
+        // a backend that cannot handle the query simply does not win
+        result = SMT::Solver::Unknown;
+    } catch (const std::exception &) {
+        // nor does one that fails otherwise, nothing may escape the thread
+        result = SMT::Solver::Unknown;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(race->mutex);
+        --race->pending;
+        race->running.erase(solver);
+        bool decided = result == SMT::Solver::Satisfiable || result == SMT::Solver::Unsatisfiable;
+        if (decided && !race->cancelled) {
+            race->result = result;
+            race->winner = description;
+            race->cancelled = true;
+            // stop the losers instead of letting them run to completion
+            for (std::map<SMT::Solver *, Solver::SMTSolver>::iterator it = race->running.begin(); it != race->running.end(); ++it) {
+                Solver::interruptSolver(it->second, it->first);
+            }
+        }
+    }
+    race->finished.notify_all();
+
+    delete lowering;
+    delete translator;
+    delete context;
+    delete solver;
+}
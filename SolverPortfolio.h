@@ -0,0 +1,73 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_SOLVERPORTFOLIO_H
+#define TRANSFORMERSOLVER_SOLVERPORTFOLIO_H
+
+#include "Solver.h"
+#include "TermDag.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/*
+ * Runs the same constraints on several backends at once, one thread per
+ * backend. Every thread owns its SMT::Solver, SMTContext and SMTTranslator,
+ * so nothing is shared between the backends. The first Satisfiable or
+ * Unsatisfiable answer wins. The threads outlive solve() and are joined
+ * by the destructor or the next solve().
+ */
+class SolverPortfolio {
+public:
+    typedef std::function<void(SMTTranslator &, SMT::Solver &)> ConstraintBuilder;
+
+    SolverPortfolio(const std::vector<Solver::SMTSolver> &backends);
+
+    /* waits for the losers of the last race, see solve() */
+    ~SolverPortfolio();
+
+    /*
+     * Blocks until one backend answers Satisfiable/Unsatisfiable or all of
+     * them gave up. Losing backends are cancelled: the ones still building
+     * constraints never call solve(), Boolector and AIG backends inside
+     * solve() are interrupted, the others (STP) run to completion in the
+     * background and their answer is dropped.
+     */
+    SMT::Solver::Result solve(ConstraintBuilder builder);
+
+    /*
+     * Same race on constraints that were built once into dag; every backend
+     * only lowers the assertions of the DAG with DagLowering instead of
+     * running the front-end again. The DAG is shared with the threads,
+     * losers may still be lowering it after solve() returned.
+     */
+    SMT::Solver::Result solve(std::shared_ptr<const TermDag> dag);
+
+    const std::string &getWinner() const;
+
+private:
+    struct Race;
+
+    SolverPortfolio(const SolverPortfolio &);
+    SolverPortfolio &operator=(const SolverPortfolio &);
+
+    void join();
+
+    SMT::Solver::Result run(ConstraintBuilder builder, std::shared_ptr<const TermDag> dag);
+
+    /* builds the constraints with builder, or lowers dag if it is set */
+    static void runBackend(std::shared_ptr<Race> race, Solver::SMTSolver backend, ConstraintBuilder builder,
+                           std::shared_ptr<const TermDag> dag);
+
+    std::vector<Solver::SMTSolver> m_backends;
+    std::string m_winner;
+    std::vector<std::thread> m_threads;
+};
+
+
+#endif //TRANSFORMERSOLVER_SOLVERPORTFOLIO_H
@@ -0,0 +1,602 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "TermDag.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+
+TermDag::TermDag() : m_unique(0, NodeHash{this}, NodeEqual{this}) {
+
+}
+
+size_t TermDag::size() const {
+    return m_nodes.size();
+}
+
+const TermDag::Node &TermDag::getNode(NodeId id) const {
+    return m_nodes[id];
+}
+
+TermDag::NodeId TermDag::getOperand(NodeId id, unsigned int i) const {
+    return m_operands[m_nodes[id].operands + i];
+}
+
+unsigned int TermDag::getIndexWidth(NodeId id) const {
+    return m_nodes[id].operands;
+}
+
+const std::string &TermDag::getName(NodeId id) const {
+    return m_names[m_nodes[id].aux];
+}
+
+const Bitvector &TermDag::getConstant(NodeId id) const {
+    return m_constants[m_nodes[id].aux];
+}
+
+TermDag::Sort TermDag::getSort(Op op) {
+    if (op < OpBitvector) {
+        return SortBool;
+    } else if (op < OpArray) {
+        return SortBitvector;
+    } else {
+        return SortArray;
+    }
+}
+
+TermDag::NodeId TermDag::toId(SMT::BoolExp *exp) {
+    return static_cast<NodeId>(reinterpret_cast<uintptr_t>(exp) - 1);
+}
+
+TermDag::NodeId TermDag::toId(SMT::BVExp *exp) {
+    return static_cast<NodeId>(reinterpret_cast<uintptr_t>(exp) - 1);
+}
+
+TermDag::NodeId TermDag::toId(SMT::AExp *exp) {
+    return static_cast<NodeId>(reinterpret_cast<uintptr_t>(exp) - 1);
+}
+
+SMT::BoolExp *TermDag::toBoolExp(NodeId id) {
+    return reinterpret_cast<SMT::BoolExp *>(static_cast<uintptr_t>(id) + 1);
+}
+
+SMT::BVExp *TermDag::toBVExp(NodeId id) {
+    return reinterpret_cast<SMT::BVExp *>(static_cast<uintptr_t>(id) + 1);
+}
+
+SMT::AExp *TermDag::toAExp(NodeId id) {
+    return reinterpret_cast<SMT::AExp *>(static_cast<uintptr_t>(id) + 1);
+}
+
+const std::vector<TermDag::NodeId> &TermDag::getAssertions() const {
+    return m_assertions;
+}
+
+void TermDag::addAssertion(NodeId id) {
+    m_assertions.push_back(id);
+}
+
+void TermDag::push() {
+    m_levels.push_back(m_assertions.size());
+}
+
+void TermDag::pop() {
+    if (m_levels.empty()) {
+        throw LLBMCException("pop() without push()");
+    }
+    m_assertions.resize(m_levels.back());
+    m_levels.pop_back();
+}
+
+// SatCore
+
+SMT::BoolExp *TermDag::mk_free(const std::string &name) {
+    return toBoolExp(makeLeaf(OpFree, 0, internName(name)));
+}
+
+SMT::BoolExp *TermDag::mk_true() {
+    return toBoolExp(makeLeaf(OpTrue, 0, 0));
+}
+
+SMT::BoolExp *TermDag::mk_false() {
+    return toBoolExp(makeLeaf(OpFalse, 0, 0));
+}
+
+SMT::BoolExp *TermDag::mk_not(SMT::BoolExp *exp) {
+    return toBoolExp(make(OpNot, 0, toId(exp)));
+}
+
+SMT::BoolExp *TermDag::mk_and(SMT::BoolExp *a, SMT::BoolExp *b) {
+    return makeConnective(OpAnd, a, b);
+}
+
+SMT::BoolExp *TermDag::mk_or(SMT::BoolExp *a, SMT::BoolExp *b) {
+    return makeConnective(OpOr, a, b);
+}
+
+SMT::BoolExp *TermDag::mk_xor(SMT::BoolExp *a, SMT::BoolExp *b) {
+    return makeConnective(OpXor, a, b);
+}
+
+SMT::BoolExp *TermDag::mk_implies(SMT::BoolExp *a, SMT::BoolExp *b) {
+    return makeConnective(OpImplies, a, b);
+}
+
+SMT::BoolExp *TermDag::mk_iff(SMT::BoolExp *a, SMT::BoolExp *b) {
+    return makeConnective(OpIff, a, b);
+}
+
+SMT::BoolExp *TermDag::mk_cond(SMT::BoolExp *cond, SMT::BoolExp *a, SMT::BoolExp *b) {
+    return toBoolExp(make(OpCond, 0, toId(cond), toId(a), toId(b)));
+}
+
+SMT::BoolExp *TermDag::copy(SMT::BoolExp *exp) {
+    return exp;
+}
+
+void TermDag::release(SMT::BoolExp *) {
+    // nodes live as long as the DAG
+}
+
+// TheoryOfBitvectors
+
+SMT::BVExp *TermDag::bitvector(unsigned int width, const std::string &name) {
+    return toBVExp(makeLeaf(OpBitvector, width, internName(name)));
+}
+
+SMT::BVExp *TermDag::copy(SMT::BVExp *exp) {
+    return exp;
+}
+
+SMT::BVExp *TermDag::bool2bv1(SMT::BoolExp *exp) {
+    return toBVExp(make(OpBool2BV1, 1, toId(exp)));
+}
+
+SMT::BoolExp *TermDag::bv12bool(SMT::BVExp *exp) {
+    return toBoolExp(make(OpBV12Bool, 0, toId(exp)));
+}
+
+SMT::BoolExp *TermDag::eq(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpEq, a, b);
+}
+
+SMT::BVExp *TermDag::concat(SMT::BVExp *a, SMT::BVExp *b) {
+    return toBVExp(make(OpConcat, width(a) + width(b), toId(a), toId(b)));
+}
+
+SMT::BVExp *TermDag::extract(unsigned int i, unsigned int j, SMT::BVExp *exp) {
+    NodeId operand = toId(exp);
+    return toBVExp(make(OpExtract, i - j + 1, j, &operand, 1));
+}
+
+SMT::BVExp *TermDag::bvnot(SMT::BVExp *exp) {
+    return toBVExp(make(OpBVNot, width(exp), toId(exp)));
+}
+
+SMT::BVExp *TermDag::bvneg(SMT::BVExp *exp) {
+    return toBVExp(make(OpBVNeg, width(exp), toId(exp)));
+}
+
+SMT::BVExp *TermDag::bvand(SMT::BVExp *a, SMT::BVExp *b) {
+    return makeWord(OpBVAnd, a, b);
+}
+
+SMT::BVExp *TermDag::bvor(SMT::BVExp *a, SMT::BVExp *b) {
+    return makeWord(OpBVOr, a, b);
+}
+
+SMT::BVExp *TermDag::bvadd(SMT::BVExp *a, SMT::BVExp *b) {
+    return makeWord(OpAdd, a, b);
+}
+
+SMT::BVExp *TermDag::bvmul(SMT::BVExp *a, SMT::BVExp *b) {
+    return makeWord(OpMul, a, b);
+}
+
+SMT::BVExp *TermDag::bvudiv(SMT::BVExp *a, SMT::BVExp *b) {
+    return makeWord(OpUdiv, a, b);
+}
+
+SMT::BVExp *TermDag::bvurem(SMT::BVExp *a, SMT::BVExp *b) {
+    return makeWord(OpUrem, a, b);
+}
+
+SMT::BVExp *TermDag::bvshl(SMT::BVExp *a, SMT::BVExp *b) {
+    return makeWord(OpShl, a, b);
+}
+
+SMT::BVExp *TermDag::bvlshr(SMT::BVExp *a, SMT::BVExp *b) {
+    return makeWord(OpLshr, a, b);
+}
+
+SMT::BoolExp *TermDag::bvult(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpUlt, a, b);
+}
+
+SMT::BVExp *TermDag::bv2bv(const Bitvector *bv) {
+    return toBVExp(makeLeaf(OpConst, bv->getWidth(), internConstant(*bv)));
+}
+
+SMT::BVExp *TermDag::bvzeros(unsigned int width) {
+    Bitvector zeros(0, width);
+    return bv2bv(&zeros);
+}
+
+SMT::BVExp *TermDag::bvones(unsigned int width) {
+    Bitvector ones(0, width);
+    for (unsigned int i = 0; i < width; ++i) {
+        ones.setBit(i, true);
+    }
+    return bv2bv(&ones);
+}
+
+SMT::BVExp *TermDag::uext(SMT::BVExp *exp, unsigned int newWidth) {
+    return toBVExp(make(OpUext, newWidth, toId(exp)));
+}
+
+SMT::BVExp *TermDag::sext(SMT::BVExp *exp, unsigned int newWidth) {
+    return toBVExp(make(OpSext, newWidth, toId(exp)));
+}
+
+SMT::BoolExp *TermDag::bvne(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpNe, a, b);
+}
+
+SMT::BVExp *TermDag::bvxor(SMT::BVExp *a, SMT::BVExp *b) {
+    return makeWord(OpBVXor, a, b);
+}
+
+SMT::BVExp *TermDag::bvimplies(SMT::BVExp *a, SMT::BVExp *b) {
+    return makeWord(OpBVImplies, a, b);
+}
+
+SMT::BVExp *TermDag::bvcond(SMT::BoolExp *cond, SMT::BVExp *a, SMT::BVExp *b) {
+    return toBVExp(make(OpBVCond, width(a), toId(cond), toId(a), toId(b)));
+}
+
+SMT::BVExp *TermDag::bvsub(SMT::BVExp *a, SMT::BVExp *b) {
+    return makeWord(OpSub, a, b);
+}
+
+SMT::BVExp *TermDag::bvsdiv(SMT::BVExp *a, SMT::BVExp *b) {
+    return makeWord(OpSdiv, a, b);
+}
+
+SMT::BVExp *TermDag::bvsrem(SMT::BVExp *a, SMT::BVExp *b) {
+    return makeWord(OpSrem, a, b);
+}
+
+SMT::BVExp *TermDag::bvashr(SMT::BVExp *a, SMT::BVExp *b) {
+    return makeWord(OpAshr, a, b);
+}
+
+SMT::BoolExp *TermDag::bvuaddo(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpUaddo, a, b);
+}
+
+SMT::BoolExp *TermDag::bvusubo(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpUsubo, a, b);
+}
+
+SMT::BoolExp *TermDag::bvumulo(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpUmulo, a, b);
+}
+
+SMT::BoolExp *TermDag::bvsaddo(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpSaddo, a, b);
+}
+
+SMT::BoolExp *TermDag::bvssubo(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpSsubo, a, b);
+}
+
+SMT::BoolExp *TermDag::bvsmulo(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpSmulo, a, b);
+}
+
+SMT::BoolExp *TermDag::bvsdivo(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpSdivo, a, b);
+}
+
+SMT::BoolExp *TermDag::bvule(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpUle, a, b);
+}
+
+SMT::BoolExp *TermDag::bvugt(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpUgt, a, b);
+}
+
+SMT::BoolExp *TermDag::bvuge(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpUge, a, b);
+}
+
+SMT::BoolExp *TermDag::bvslt(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpSlt, a, b);
+}
+
+SMT::BoolExp *TermDag::bvsle(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpSle, a, b);
+}
+
+SMT::BoolExp *TermDag::bvsgt(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpSgt, a, b);
+}
+
+SMT::BoolExp *TermDag::bvsge(SMT::BVExp *a, SMT::BVExp *b) {
+    return makePredicate(OpSge, a, b);
+}
+
+void TermDag::release(SMT::BVExp *) {
+    // nodes live as long as the DAG
+}
+
+unsigned int TermDag::width(SMT::BVExp *exp) {
+    return m_nodes[toId(exp)].width;
+}
+
+// BitvectorTheoryOfArrays
+
+SMT::AExp *TermDag::array(unsigned int indexWidth, unsigned int elementWidth, const std::string &name) {
+    Node node;
+    node.op = OpArray;
+    node.arity = 0;
+    node.width = elementWidth;
+    node.aux = internName(name);
+    node.operands = indexWidth;
+    return toAExp(intern(node, NULL));
+}
+
+SMT::AExp *TermDag::copy(SMT::AExp *exp) {
+    return exp;
+}
+
+SMT::BoolExp *TermDag::eq(SMT::AExp *a, SMT::AExp *b) {
+    return toBoolExp(make(OpArrayEq, 0, toId(a), toId(b)));
+}
+
+SMT::BVExp *TermDag::read(SMT::AExp *array, SMT::BVExp *index) {
+    return toBVExp(make(OpRead, m_nodes[toId(array)].width, toId(array), toId(index)));
+}
+
+SMT::AExp *TermDag::write(SMT::AExp *array, SMT::BVExp *index, SMT::BVExp *value) {
+    return toAExp(make(OpWrite, m_nodes[toId(array)].width, toId(array), toId(index), toId(value)));
+}
+
+SMT::AExp *TermDag::memcpy(SMT::AExp *dst, SMT::BVExp *dstIndex, SMT::AExp *src, SMT::BVExp *srcIndex,
+                           SMT::BVExp *size) {
+    NodeId operands[5] = {toId(dst), toId(dstIndex), toId(src), toId(srcIndex), toId(size)};
+    return toAExp(make(OpMemcpy, m_nodes[operands[0]].width, 0, operands, 5));
+}
+
+SMT::AExp *TermDag::memset(SMT::AExp *dst, SMT::BVExp *dstIndex, SMT::BVExp *value, SMT::BVExp *size) {
+    NodeId operands[4] = {toId(dst), toId(dstIndex), toId(value), toId(size)};
+    return toAExp(make(OpMemset, m_nodes[operands[0]].width, 0, operands, 4));
+}
+
+SMT::AExp *TermDag::array2exp(const BVArray *) {
+    throw LLBMCException("TermDag does not support constant arrays");
+}
+
+SMT::AExp *TermDag::acond(SMT::BoolExp *cond, SMT::AExp *a, SMT::AExp *b) {
+    return toAExp(make(OpArrayCond, m_nodes[toId(a)].width, toId(cond), toId(a), toId(b)));
+}
+
+void TermDag::release(SMT::AExp *) {
+    // nodes live as long as the DAG
+}
+
+// nodes
+
+TermDag::NodeId TermDag::intern(const Node &node, const NodeId *operands) {
+    // the candidate goes in at the end and is taken back out if it exists already
+    size_t operandCount = m_operands.size();
+    m_operands.insert(m_operands.end(), operands, operands + node.arity);
+    m_nodes.push_back(node);
+
+    NodeId id = static_cast<NodeId>(m_nodes.size() - 1);
+    std::pair<std::unordered_set<NodeId, NodeHash, NodeEqual>::iterator, bool> res = m_unique.insert(id);
+    if (!res.second) {
+        m_nodes.pop_back();
+        m_operands.resize(operandCount);
+        return *res.first;
+    }
+    if (id == UINT32_MAX - 1) {
+        throw LLBMCException("TermDag is full");
+    }
+    return id;
+}
+
+TermDag::NodeId TermDag::make(Op op, uint32_t width, uint32_t aux, const NodeId *operands, unsigned int arity) {
+    Node node;
+    node.op = op;
+    node.arity = static_cast<uint8_t>(arity);
+    node.width = width;
+    node.aux = aux;
+    node.operands = arity != 0 ? static_cast<uint32_t>(m_operands.size()) : 0;
+    return intern(node, operands);
+}
+
+TermDag::NodeId TermDag::makeLeaf(Op op, uint32_t width, uint32_t aux) {
+    return make(op, width, aux, static_cast<const NodeId *>(NULL), 0);
+}
+
+TermDag::NodeId TermDag::make(Op op, uint32_t width, NodeId a) {
+    return make(op, width, 0, &a, 1);
+}
+
+TermDag::NodeId TermDag::make(Op op, uint32_t width, NodeId a, NodeId b) {
+    NodeId operands[2] = {a, b};
+    return make(op, width, 0, operands, 2);
+}
+
+TermDag::NodeId TermDag::make(Op op, uint32_t width, NodeId a, NodeId b, NodeId c) {
+    NodeId operands[3] = {a, b, c};
+    return make(op, width, 0, operands, 3);
+}
+
+SMT::BVExp *TermDag::makeWord(Op op, SMT::BVExp *a, SMT::BVExp *b) {
+    return toBVExp(make(op, width(a), toId(a), toId(b)));
+}
+
+SMT::BoolExp *TermDag::makePredicate(Op op, SMT::BVExp *a, SMT::BVExp *b) {
+    return toBoolExp(make(op, 0, toId(a), toId(b)));
+}
+
+SMT::BoolExp *TermDag::makeConnective(Op op, SMT::BoolExp *a, SMT::BoolExp *b) {
+    return toBoolExp(make(op, 0, toId(a), toId(b)));
+}
+
+uint32_t TermDag::internName(const std::string &name) {
+    std::unordered_map<std::string, uint32_t>::iterator it = m_nameIds.find(name);
+    if (it != m_nameIds.end()) {
+        return it->second;
+    }
+    uint32_t index = static_cast<uint32_t>(m_names.size());
+    m_names.push_back(name);
+    m_nameIds.insert(std::make_pair(name, index));
+    return index;
+}
+
+uint32_t TermDag::internConstant(const Bitvector &value) {
+    unsigned int width = value.getWidth();
+    uint32_t index = static_cast<uint32_t>(m_constants.size());
+
+    if (width <= 64) {
+        uint64_t bits = value.getUnsigned();
+        if (width < 64) {
+            bits &= (static_cast<uint64_t>(1) << width) - 1;
+        }
+        std::pair<std::unordered_map<SmallKey, uint32_t, SmallKeyHash>::iterator, bool> res =
+                m_smallConstants.insert(std::make_pair(SmallKey(bits, width), index));
+        if (res.second) {
+            m_constants.push_back(Bitvector(bits, width));
+        }
+        return res.first->second;
+    }
+
+    std::string bits(width, '0');
+    for (unsigned int i = 0; i < width; ++i) {
+        if (value.getBit(i)) {
+            bits[width - i - 1] = '1';
+        }
+    }
+    std::pair<std::map<std::pair<unsigned int, std::string>, uint32_t>::iterator, bool> res =
+            m_wideConstants.insert(std::make_pair(std::make_pair(width, bits), index));
+    if (res.second) {
+        m_constants.push_back(value);
+    }
+    return res.first->second;
+}
+
+size_t TermDag::NodeHash::operator()(NodeId id) const {
+    const Node &node = dag->m_nodes[id];
+    size_t hash = node.op;
+    hash = hash * 31 + node.width;
+    hash = hash * 31 + node.aux;
+    if (node.arity == 0) {
+        hash = hash * 31 + node.operands;
+    }
+    for (unsigned int i = 0; i < node.arity; ++i) {
+        hash = hash * 31 + dag->m_operands[node.operands + i];
+    }
+    return hash;
+}
+
+bool TermDag::NodeEqual::operator()(NodeId a, NodeId b) const {
+    const Node &nodeA = dag->m_nodes[a];
+    const Node &nodeB = dag->m_nodes[b];
+    if (nodeA.op != nodeB.op || nodeA.arity != nodeB.arity || nodeA.width != nodeB.width || nodeA.aux != nodeB.aux) {
+        return false;
+    }
+    if (nodeA.arity == 0) {
+        return nodeA.operands == nodeB.operands;
+    }
+    for (unsigned int i = 0; i < nodeA.arity; ++i) {
+        if (dag->m_operands[nodeA.operands + i] != dag->m_operands[nodeB.operands + i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t TermDag::SmallKeyHash::operator()(const SmallKey &key) const {
+    return std::hash<uint64_t>()(key.first) * 31 + key.second;
+}
+
+
+TermDagSolver::TermDagSolver() : m_dag(new TermDag()), m_result(Unknown), m_description("term DAG") {
+
+}
+
+std::shared_ptr<TermDag> TermDagSolver::getDag() const {
+    return m_dag;
+}
+
+bool TermDagSolver::hasCapability(Capability cap) const {
+    switch (cap) {
+        case CapIncrementalSolving:
+        case CapPushPop:
+        case CapTheoryOfBitvectors:
+        case CapTheoryOfArrays:
+            return true;
+        default:
+            return false;
+    }
+}
+
+SMT::SatCore *TermDagSolver::getSatCore() {
+    return m_dag.get();
+}
+
+SMT::TheoryOfBitvectors *TermDagSolver::getTheoryOfBitvectors() {
+    return m_dag.get();
+}
+
+SMT::BitvectorTheoryOfArrays *TermDagSolver::getBitvectorTheoryOfArrays() {
+    return m_dag.get();
+}
+
+SMT::BitvectorTheoryOfUFs *TermDagSolver::getBitvectorTheoryOfUFs() {
+    return NULL;
+}
+
+bool TermDagSolver::hasModel() {
+    return false;
+}
+
+SMT::Model *TermDagSolver::getModel() {
+    return NULL;
+}
+
+void TermDagSolver::assertConstraint(SMT::BoolExp *exp) {
+    m_dag->addAssertion(TermDag::toId(exp));
+}
+
+void TermDagSolver::push() {
+    m_dag->push();
+}
+
+void TermDagSolver::pop() {
+    m_dag->pop();
+}
+
+void TermDagSolver::solve() {
+    m_result = Unsupported;
+}
+
+SMT::Solver::Result TermDagSolver::getResult() const {
+    return m_result;
+}
+
+const std::string &TermDagSolver::getDescription() const {
+    return m_description;
+}
+
+void TermDagSolver::enableIncrementalSolving() {
+    // assertions are only recorded
+}
+
+void TermDagSolver::setTimeout(int) {
+    // nothing to time out
+}
@@ -0,0 +1,433 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_TERMDAG_H
+#define TRANSFORMERSOLVER_TERMDAG_H
+
+#include <llbmc/SMT/SatCore.h>
+#include <llbmc/SMT/Solver.h>
+#include <llbmc/SMT/TheoryOfArrays.h>
+#include <llbmc/SMT/TheoryOfBitvectors.h>
+#include <llbmc/Util/Bitvector.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+
+/*
+ * Solver-independent term DAG. Nodes live in one flat array and are
+ * addressed by 32-bit ids; operands live in a second flat array. Every
+ * node is interned, so building the same term twice yields the same id,
+ * and operands always have smaller ids than the node using them: the
+ * node array is in topological order.
+ *
+ * The DAG implements the theories itself. Handles are the node id plus
+ * one cast to a pointer, copy() and release() do nothing because the DAG
+ * owns all nodes until it is destroyed. DagLowering replays it into any
+ * SMT::Solver, TermDagSolver lets SMTTranslator build into it.
+ */
+class TermDag : public SMT::SatCore, public SMT::TheoryOfBitvectors, public SMT::BitvectorTheoryOfArrays {
+public:
+    typedef uint32_t NodeId;
+
+    enum Op : uint8_t {
+        // Bool
+        OpTrue,
+        OpFalse,
+        OpFree,
+        OpNot,
+        OpAnd,
+        OpOr,
+        OpXor,
+        OpImplies,
+        OpIff,
+        OpCond,
+        OpBV12Bool,
+        OpEq,
+        OpNe,
+        OpUlt,
+        OpUle,
+        OpUgt,
+        OpUge,
+        OpSlt,
+        OpSle,
+        OpSgt,
+        OpSge,
+        OpUaddo,
+        OpUsubo,
+        OpUmulo,
+        OpSaddo,
+        OpSsubo,
+        OpSmulo,
+        OpSdivo,
+        OpArrayEq,
+        // bitvector
+        OpBitvector,
+        OpConst,
+        OpBool2BV1,
+        OpConcat,
+        OpExtract,
+        OpUext,
+        OpSext,
+        OpBVNot,
+        OpBVNeg,
+        OpBVAnd,
+        OpBVOr,
+        OpBVXor,
+        OpBVImplies,
+        OpBVCond,
+        OpAdd,
+        OpSub,
+        OpMul,
+        OpUdiv,
+        OpUrem,
+        OpSdiv,
+        OpSrem,
+        OpShl,
+        OpLshr,
+        OpAshr,
+        OpRead,
+        // array
+        OpArray,
+        OpWrite,
+        OpMemcpy,
+        OpMemset,
+        OpArrayCond,
+        OpCount
+    };
+
+    enum Sort {
+        SortBool,
+        SortBitvector,
+        SortArray
+    };
+
+    /* widest bitvector accepted from untrusted input, formula files and SMT-LIB2 scripts */
+    enum {
+        MaxWidth = 1 << 24
+    };
+
+    /*
+     * width is the bitvector width, the element width of arrays and 0 for
+     * Bool. aux is the name index of variables, the constant index of
+     * OpConst and the low bit of OpExtract. operands is the index of the
+     * first operand in the operand array; leaves have none, there it is 0
+     * except for OpArray, which keeps its index width in it.
+     */
+    struct Node {
+        Op op;
+        uint8_t arity;
+        uint32_t width;
+        uint32_t aux;
+        uint32_t operands;
+    };
+
+    TermDag();
+
+    size_t size() const;
+
+    const Node &getNode(NodeId id) const;
+
+    NodeId getOperand(NodeId id, unsigned int i) const;
+
+    /* index width of an OpArray node */
+    unsigned int getIndexWidth(NodeId id) const;
+
+    /* name of a variable node */
+    const std::string &getName(NodeId id) const;
+
+    /* value of an OpConst node */
+    const Bitvector &getConstant(NodeId id) const;
+
+    static Sort getSort(Op op);
+
+    static NodeId toId(SMT::BoolExp *exp);
+
+    static NodeId toId(SMT::BVExp *exp);
+
+    static NodeId toId(SMT::AExp *exp);
+
+    static SMT::BoolExp *toBoolExp(NodeId id);
+
+    static SMT::BVExp *toBVExp(NodeId id);
+
+    static SMT::AExp *toAExp(NodeId id);
+
+    /* asserted constraints of all open levels, in order */
+    const std::vector<NodeId> &getAssertions() const;
+
+    void addAssertion(NodeId id);
+
+    void push();
+
+    void pop();
+
+    // SatCore
+
+    SMT::BoolExp *mk_free(const std::string &name);
+
+    SMT::BoolExp *mk_true();
+
+    SMT::BoolExp *mk_false();
+
+    SMT::BoolExp *mk_not(SMT::BoolExp *exp);
+
+    SMT::BoolExp *mk_and(SMT::BoolExp *a, SMT::BoolExp *b);
+
+    SMT::BoolExp *mk_or(SMT::BoolExp *a, SMT::BoolExp *b);
+
+    SMT::BoolExp *mk_xor(SMT::BoolExp *a, SMT::BoolExp *b);
+
+    SMT::BoolExp *mk_implies(SMT::BoolExp *a, SMT::BoolExp *b);
+
+    SMT::BoolExp *mk_iff(SMT::BoolExp *a, SMT::BoolExp *b);
+
+    SMT::BoolExp *mk_cond(SMT::BoolExp *cond, SMT::BoolExp *a, SMT::BoolExp *b);
+
+    SMT::BoolExp *copy(SMT::BoolExp *exp);
+
+    void release(SMT::BoolExp *exp);
+
+    // TheoryOfBitvectors
+
+    SMT::BVExp *bitvector(unsigned int width, const std::string &name);
+
+    SMT::BVExp *copy(SMT::BVExp *exp);
+
+    SMT::BVExp *bool2bv1(SMT::BoolExp *exp);
+
+    SMT::BoolExp *bv12bool(SMT::BVExp *exp);
+
+    SMT::BoolExp *eq(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *concat(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *extract(unsigned int i, unsigned int j, SMT::BVExp *exp);
+
+    SMT::BVExp *bvnot(SMT::BVExp *exp);
+
+    SMT::BVExp *bvneg(SMT::BVExp *exp);
+
+    SMT::BVExp *bvand(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvor(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvadd(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvmul(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvudiv(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvurem(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvshl(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvlshr(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvult(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bv2bv(const Bitvector *bv);
+
+    SMT::BVExp *bvzeros(unsigned int width);
+
+    SMT::BVExp *bvones(unsigned int width);
+
+    SMT::BVExp *uext(SMT::BVExp *exp, unsigned int newWidth);
+
+    SMT::BVExp *sext(SMT::BVExp *exp, unsigned int newWidth);
+
+    SMT::BoolExp *bvne(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvxor(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvimplies(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvcond(SMT::BoolExp *cond, SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvsub(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvsdiv(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvsrem(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BVExp *bvashr(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvuaddo(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvusubo(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvumulo(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvsaddo(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvssubo(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvsmulo(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvsdivo(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvule(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvugt(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvuge(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvslt(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvsle(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvsgt(SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *bvsge(SMT::BVExp *a, SMT::BVExp *b);
+
+    void release(SMT::BVExp *exp);
+
+    unsigned int width(SMT::BVExp *exp);
+
+    // BitvectorTheoryOfArrays
+
+    SMT::AExp *array(unsigned int indexWidth, unsigned int elementWidth, const std::string &name);
+
+    SMT::AExp *copy(SMT::AExp *exp);
+
+    SMT::BoolExp *eq(SMT::AExp *a, SMT::AExp *b);
+
+    SMT::BVExp *read(SMT::AExp *array, SMT::BVExp *index);
+
+    SMT::AExp *write(SMT::AExp *array, SMT::BVExp *index, SMT::BVExp *value);
+
+    SMT::AExp *memcpy(SMT::AExp *dst, SMT::BVExp *dstIndex, SMT::AExp *src, SMT::BVExp *srcIndex, SMT::BVExp *size);
+
+    SMT::AExp *memset(SMT::AExp *dst, SMT::BVExp *dstIndex, SMT::BVExp *value, SMT::BVExp *size);
+
+    /* throws, the DAG cannot own a BVArray */
+    SMT::AExp *array2exp(const BVArray *array);
+
+    SMT::AExp *acond(SMT::BoolExp *cond, SMT::AExp *a, SMT::AExp *b);
+
+    void release(SMT::AExp *exp);
+
+private:
+    TermDag(const TermDag &);
+    TermDag &operator=(const TermDag &);
+
+    /* hashes and compares nodes by id, operands included */
+    struct NodeHash {
+        const TermDag *dag;
+        size_t operator()(NodeId id) const;
+    };
+
+    struct NodeEqual {
+        const TermDag *dag;
+        bool operator()(NodeId a, NodeId b) const;
+    };
+
+    typedef std::pair<uint64_t, unsigned int> SmallKey;
+
+    struct SmallKeyHash {
+        size_t operator()(const SmallKey &key) const;
+    };
+
+    /* the existing node if it is already there, a new one otherwise */
+    NodeId intern(const Node &node, const NodeId *operands);
+
+    NodeId make(Op op, uint32_t width, uint32_t aux, const NodeId *operands, unsigned int arity);
+
+    NodeId makeLeaf(Op op, uint32_t width, uint32_t aux);
+
+    NodeId make(Op op, uint32_t width, NodeId a);
+
+    NodeId make(Op op, uint32_t width, NodeId a, NodeId b);
+
+    NodeId make(Op op, uint32_t width, NodeId a, NodeId b, NodeId c);
+
+    /* a bitvector node as wide as its first operand */
+    SMT::BVExp *makeWord(Op op, SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *makePredicate(Op op, SMT::BVExp *a, SMT::BVExp *b);
+
+    SMT::BoolExp *makeConnective(Op op, SMT::BoolExp *a, SMT::BoolExp *b);
+
+    uint32_t internName(const std::string &name);
+
+    uint32_t internConstant(const Bitvector &value);
+
+    std::vector<Node> m_nodes;
+    std::vector<NodeId> m_operands;
+    std::unordered_set<NodeId, NodeHash, NodeEqual> m_unique;
+
+    std::vector<std::string> m_names;
+    std::unordered_map<std::string, uint32_t> m_nameIds;
+
+    std::vector<Bitvector> m_constants;
+    std::unordered_map<SmallKey, uint32_t, SmallKeyHash> m_smallConstants;
+    std::map<std::pair<unsigned int, std::string>, uint32_t> m_wideConstants;
+
+    std::vector<NodeId> m_assertions;
+    /* size of m_assertions at every open push() */
+    std::vector<size_t> m_levels;
+};
+
+
+/*
+ * An SMT::Solver that does not solve but records: its theories are those
+ * of a TermDag and assertions go into the DAG. SMTTranslator builds into
+ * it like into any backend, the DAG can then be lowered into as many
+ * real solvers as needed. The DAG is shared so that it can outlive this
+ * solver, e.g. in threads still lowering it.
+ */
+class TermDagSolver : public SMT::Solver {
+public:
+    TermDagSolver();
+
+    std::shared_ptr<TermDag> getDag() const;
+
+    bool hasCapability(Capability cap) const;
+
+    SMT::SatCore *getSatCore();
+
+    SMT::TheoryOfBitvectors *getTheoryOfBitvectors();
+
+    SMT::BitvectorTheoryOfArrays *getBitvectorTheoryOfArrays();
+
+    SMT::BitvectorTheoryOfUFs *getBitvectorTheoryOfUFs();
+
+    bool hasModel();
+
+    SMT::Model *getModel();
+
+    void assertConstraint(SMT::BoolExp *exp);
+
+    void push();
+
+    void pop();
+
+    /* Unsupported, lower the DAG into a real solver instead */
+    void solve();
+
+    Result getResult() const;
+
+    const std::string &getDescription() const;
+
+    void enableIncrementalSolving();
+
+    void setTimeout(int seconds);
+
+private:
+    TermDagSolver(const TermDagSolver &);
+    TermDagSolver &operator=(const TermDagSolver &);
+
+    std::shared_ptr<TermDag> m_dag;
+    Result m_result;
+    std::string m_description;
+};
+
+
+#endif //TRANSFORMERSOLVER_TERMDAG_H
@@ -0,0 +1,118 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "TransitionSystem.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <sstream>
+
+
+TransitionSystem::TransitionSystem() {
+
+}
+
+unsigned int TransitionSystem::addStateVar(const std::string &name, unsigned int width) {
+    StateVar var;
+    var.name = name;
+    var.width = width;
+    m_vars.push_back(var);
+    return static_cast<unsigned int>(m_vars.size() - 1);
+}
+
+void TransitionSystem::setInit(Predicate init) {
+    m_init = init;
+}
+
+void TransitionSystem::setTrans(Relation trans) {
+    m_trans = trans;
+}
+
+void TransitionSystem::setBad(Predicate bad) {
+    m_bad = bad;
+}
+
+const std::vector<TransitionSystem::StateVar> &TransitionSystem::getStateVars() const {
+    return m_vars;
+}
+
+TransitionSystem::State TransitionSystem::frame(SMTTranslator &translator, unsigned int k) const {
+    std::ostringstream tag;
+    tag << k;
+    return frame(translator, tag.str());
+}
+
+TransitionSystem::State TransitionSystem::frame(SMTTranslator &translator, const std::string &tag) const {
+    State state;
+    state.reserve(m_vars.size());
+    for (std::vector<StateVar>::const_iterator it = m_vars.begin(); it != m_vars.end(); ++it) {
+        state.push_back(translator.createBV(it->name + "@" + tag, static_cast<int>(it->width)));
+    }
+    return state;
+}
+
+void TransitionSystem::releaseFrame(SMT::Solver &solver, State &state) {
+    SMT::TheoryOfBitvectors *bvs = solver.getTheoryOfBitvectors();
+    for (State::iterator it = state.begin(); it != state.end(); ++it) {
+        bvs->release(*it);
+    }
+    state.clear();
+}
+
+SMT::BoolExp *TransitionSystem::init(SMTTranslator &translator, SMT::SatCore &sat, const State &state) const {
+    if (!m_init) {
+        throw LLBMCException("Transition system without init!");
+    }
+    return m_init(translator, sat, state);
+}
+
+SMT::BoolExp *TransitionSystem::trans(SMTTranslator &translator, SMT::SatCore &sat, const State &current,
+                                      const State &next) const {
+    if (!m_trans) {
+        throw LLBMCException("Transition system without transition relation!");
+    }
+    return m_trans(translator, sat, current, next);
+}
+
+SMT::BoolExp *TransitionSystem::bad(SMTTranslator &translator, SMT::SatCore &sat, const State &state) const {
+    if (!m_bad) {
+        throw LLBMCException("Transition system without bad states!");
+    }
+    return m_bad(translator, sat, state);
+}
+
+TransitionSystem TransitionSystem::transformerExample() {
+    TransitionSystem system;
+    system.addStateVar("s", 4);
+
+    system.setInit([](SMTTranslator &translator, SMT::SatCore &, const State &state) {
+        return translator.bvAssignValue(state[0], 3);
+    });
+
+    // (s = 3 --> s' = 4) and (s != 3 --> s' = s)
+    system.setTrans([](SMTTranslator &translator, SMT::SatCore &sat, const State &s, const State &sDash) {
+        SMT::BoolExp *sValue = translator.bvAssignValue(s[0], 3);
+        SMT::BoolExp *sDashValue = translator.bvAssignValue(sDash[0], 4);
+        SMT::BoolExp *step = sat.mk_implies(sValue, sDashValue);
+
+        SMT::BoolExp *sValueNeg = translator.bvAssignValueNeg(s[0], 3);
+        SMT::BoolExp *keep = translator.compareEq(sDash[0], s[0]);
+        SMT::BoolExp *stay = sat.mk_implies(sValueNeg, keep);
+
+        SMT::BoolExp *ret = sat.mk_and(step, stay);
+        sat.release(sValue);
+        sat.release(sDashValue);
+        sat.release(step);
+        sat.release(sValueNeg);
+        sat.release(keep);
+        sat.release(stay);
+        return ret;
+    });
+
+    system.setBad([](SMTTranslator &translator, SMT::SatCore &, const State &state) {
+        return translator.bvAssignValue(state[0], 5);
+    });
+
+    return system;
+}
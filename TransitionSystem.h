@@ -0,0 +1,80 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_TRANSITIONSYSTEM_H
+#define TRANSFORMERSOLVER_TRANSITIONSYSTEM_H
+
+#include "SMTTranslator.h"
+
+#include <llbmc/SMT/Solver.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+
+/*
+ * A transition system over bitvector state variables. Init, transition
+ * relation and bad states are given as builders that are called with the
+ * variables of the frames they talk about, e.g. trans(s, sDash) is
+ * instantiated as trans(s@0, s@1), trans(s@1, s@2), ... Frame variables are
+ * named "<name>@<k>" and created through the SMTTranslator, so asking for a
+ * frame twice yields the same expressions.
+ *
+ * Builders return a new reference, which the caller releases.
+ */
+class TransitionSystem {
+public:
+    typedef std::vector<SMT::BVExp *> State;
+    typedef std::function<SMT::BoolExp *(SMTTranslator &, SMT::SatCore &, const State &)> Predicate;
+    typedef std::function<SMT::BoolExp *(SMTTranslator &, SMT::SatCore &, const State &, const State &)> Relation;
+
+    struct StateVar {
+        std::string name;
+        unsigned int width;
+    };
+
+    TransitionSystem();
+
+    /* returns the index of the variable in a State */
+    unsigned int addStateVar(const std::string &name, unsigned int width);
+
+    void setInit(Predicate init);
+
+    void setTrans(Relation trans);
+
+    void setBad(Predicate bad);
+
+    const std::vector<StateVar> &getStateVars() const;
+
+    /* variables of frame k, the caller releases them with releaseFrame */
+    State frame(SMTTranslator &translator, unsigned int k) const;
+
+    /* variables named "<name>@<tag>", e.g. for frames not on the unrolled path */
+    State frame(SMTTranslator &translator, const std::string &tag) const;
+
+    static void releaseFrame(SMT::Solver &solver, State &state);
+
+    SMT::BoolExp *init(SMTTranslator &translator, SMT::SatCore &sat, const State &state) const;
+
+    SMT::BoolExp *trans(SMTTranslator &translator, SMT::SatCore &sat, const State &current, const State &next) const;
+
+    SMT::BoolExp *bad(SMTTranslator &translator, SMT::SatCore &sat, const State &state) const;
+
+    /*
+     * The transformer of Solver::assertConstraints as a system: s starts at
+     * 3, s = 3 steps to s' = 4, every other value is kept. Bad is s = 5,
+     * which is unreachable.
+     */
+    static TransitionSystem transformerExample();
+
+private:
+    std::vector<StateVar> m_vars;
+    Predicate m_init;
+    Relation m_trans;
+    Predicate m_bad;
+};
+
+
+#endif //TRANSFORMERSOLVER_TRANSITIONSYSTEM_H
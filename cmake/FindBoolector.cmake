@@ -0,0 +1,36 @@
+# Find Boolector
+#
+#  BOOLECTOR_FOUND       - True if Boolector was found
+#  BOOLECTOR_INCLUDE_DIR - Path to Boolector's include directory.
+#  BOOLECTOR_LIBRARY     - Path to Boolector's library.
+#  BOOLECTOR_PICOSAT_LIBRARY - Path to the PicoSAT library Boolector was built with, if any.
+#  BOOLECTOR_MINISAT_LIBRARY - Path to the MiniSat library Boolector was built with, if any.
+
+include(FindPackageHandleStandardArgs)
+
+if(BOOLECTOR_INCLUDE_DIR)
+
+  # Already found, don't search again
+  set(BOOLECTOR_FOUND TRUE)
+
+else (BOOLECTOR_INCLUDE_DIR)
+
+  find_path(BOOLECTOR_INCLUDE_DIR boolector/boolector.h DOC "Path to Boolector's include directory")
+
+  find_library(BOOLECTOR_LIBRARY NAMES boolector DOC "Path to Boolector's library")
+  find_library(BOOLECTOR_PICOSAT_LIBRARY NAMES picosat DOC "Path to the PicoSAT library of Boolector")
+  find_library(BOOLECTOR_MINISAT_LIBRARY NAMES minisat DOC "Path to the MiniSat library of Boolector")
+
+  FIND_PACKAGE_HANDLE_STANDARD_ARGS(BOOLECTOR DEFAULT_MSG
+    BOOLECTOR_LIBRARY
+    BOOLECTOR_INCLUDE_DIR
+  )
+
+  mark_as_advanced(
+    BOOLECTOR_LIBRARY
+    BOOLECTOR_INCLUDE_DIR
+    BOOLECTOR_PICOSAT_LIBRARY
+    BOOLECTOR_MINISAT_LIBRARY
+  )
+
+endif(BOOLECTOR_INCLUDE_DIR)
@@ -1,7 +1,11 @@
+#include <algorithm>
+#include <exception>
 #include <iostream>
 #include <sstream>
+#include <thread>
 
 #include <llbmc/Util/Bitvector.h>
+#include <llbmc/Util/LLBMCException.h>
 #include <llbmc/SMT/QF_ABV.h>
 #include <llbmc/SMT/Solver.h>
 #include <llbmc/SMT/STP.h>
@@ -27,11 +31,114 @@ llvm::raw_ostream &ostream();
  * First Step: SMT(F) QF_ABV
  * Second Step: SAT(F) with some SMT Solver
  */
-int main() {
+static int run(int argc, char **argv) {
+
+    if (argc > 2 && std::string(argv[1]) == "--bmc") {
+        Solver bmc;
+        bmc.runBmc(static_cast<unsigned int>(std::stoul(argv[2])));
+        return 0;
+    }
+
+    if (argc > 2 && std::string(argv[1]) == "--kind") {
+        Solver kInduction;
+        kInduction.runKInduction(static_cast<unsigned int>(std::stoul(argv[2])));
+        return 0;
+    }
+
+    if (argc > 2 && std::string(argv[1]) == "--pdr") {
+        Solver pdr;
+        pdr.runPdr(static_cast<unsigned int>(std::stoul(argv[2])));
+        return 0;
+    }
+
+    if (argc > 2 && std::string(argv[1]) == "--daemon") {
+        Solver daemon;
+        daemon.runDaemon(argv[2], argc > 3 ? static_cast<unsigned int>(std::stoul(argv[3])) : 2);
+        return 0;
+    }
+
+    if (argc > 2 && std::string(argv[1]) == "--batch") {
+        unsigned int workers = argc > 3 ? static_cast<unsigned int>(std::stoul(argv[3]))
+                                        : std::max(std::thread::hardware_concurrency(), 1u);
+        Solver::SMTSolver backend = Solver::STP;
+        if (argc > 4 && !Solver::parseSMTSolver(argv[4], backend)) {
+            std::cerr << "Unknown backend " << argv[4] << "\n";
+            return 1;
+        }
+        Solver batch;
+        batch.runBatch(argv[2], workers, backend, argc > 5 ? argv[5] : "auto");
+        return 0;
+    }
+
+    if (argc > 2 && std::string(argv[1]) == "--dump-formula") {
+        Solver dump;
+        dump.dumpFormula(argv[2]);
+        return 0;
+    }
+
+    if (argc > 2 && std::string(argv[1]) == "--replay") {
+        Solver::SMTSolver backend = Solver::STP;
+        if (argc > 3 && !Solver::parseSMTSolver(argv[3], backend)) {
+            std::cerr << "Unknown backend " << argv[3] << "\n";
+            return 1;
+        }
+        Solver replay;
+        replay.replayFormula(argv[2], backend);
+        return 0;
+    }
+
+    if (argc > 3 && std::string(argv[1]) == "--bcnf-to-dimacs") {
+        Solver convert;
+        convert.convertBinaryCnf(argv[2], argv[3], argc > 4 && std::string(argv[4]) == "--gz");
+        return 0;
+    }
+
+    if (argc > 2 && std::string(argv[1]) == "--smtlib-in") {
+        Solver::SMTSolver backend = Solver::STP;
+        if (argc > 3 && !Solver::parseSMTSolver(argv[3], backend)) {
+            std::cerr << "Unknown backend " << argv[3] << "\n";
+            return 1;
+        }
+        Solver script;
+        script.runSmtLib2(argv[2], backend);
+        return 0;
+    }
 
     Solver *s = new Solver();
+    for (int i = 1; i < argc; ++i) {
+        std::string option(argv[i]);
+        if (option == "--cache" && i + 1 < argc) {
+            s->setQueryCache(argv[++i]);
+        } else if (option == "--smtlib" && i + 1 < argc) {
+            s->setSmtLib2Output(argv[++i]);
+        } else if ((option == "--cnf" || option == "--cnf-gz") && i + 1 < argc) {
+            s->setCnfOutput(argv[++i], option == "--cnf-gz");
+        } else if (option == "--bcnf" && i + 1 < argc) {
+            s->setBinaryCnfOutput(argv[++i]);
+        } else if (option == "--stp-cnf") {
+            s->setStpCnfDump(true);
+        } else if (option == "--portfolio") {
+            s->setPortfolio(true);
+        } else if (option == "--verbose" || option == "-v") {
+            s->setVerbose(true);
+        } else {
+            std::cerr << "Unknown option " << option << "\n";
+            return 1;
+        }
+    }
     s->runSMTSolver();
 
     return 0;
 }
 
+int main(int argc, char **argv) {
+    try {
+        return run(argc, argv);
+    } catch (const LLBMCException &e) {
+        std::cerr << "Error: " << e.getMessage() << "\n";
+    } catch (const std::exception &e) {
+        // e.g. std::stoul on a malformed count
+        std::cerr << "Error: " << e.what() << "\n";
+    }
+    return 1;
+}
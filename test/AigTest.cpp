@@ -0,0 +1,448 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "AIG/Aig.h"
+#include "AIG/AigCnf.h"
+#include "AIG/Bitvectors.h"
+#include "ClauseSink.h"
+
+#include <llbmc/Util/Bitvector.h>
+#include <llbmc/Util/LLBMCException.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+namespace {
+    uint64_t mask(unsigned int width) {
+        return width >= 64 ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << width) - 1;
+    }
+
+    int64_t toSigned(uint64_t value, unsigned int width) {
+        if (width < 64 && ((value >> (width - 1)) & 1)) {
+            return static_cast<int64_t>(value | ~mask(width));
+        }
+        return static_cast<int64_t>(value);
+    }
+
+    bool fitsSigned(int64_t value, unsigned int width) {
+        return value >= -(static_cast<int64_t>(1) << (width - 1)) && value < (static_cast<int64_t>(1) << (width - 1));
+    }
+
+    /* SMT-LIB semantics of every operator on small operands, results masked to their width */
+    uint64_t refAdd(uint64_t a, uint64_t b, unsigned int w) { return (a + b) & mask(w); }
+    uint64_t refSub(uint64_t a, uint64_t b, unsigned int w) { return (a - b) & mask(w); }
+    uint64_t refMul(uint64_t a, uint64_t b, unsigned int w) { return (a * b) & mask(w); }
+    uint64_t refNeg(uint64_t a, uint64_t, unsigned int w) { return (0 - a) & mask(w); }
+    uint64_t refNot(uint64_t a, uint64_t, unsigned int w) { return ~a & mask(w); }
+    uint64_t refAnd(uint64_t a, uint64_t b, unsigned int) { return a & b; }
+    uint64_t refOr(uint64_t a, uint64_t b, unsigned int) { return a | b; }
+    uint64_t refXor(uint64_t a, uint64_t b, unsigned int) { return a ^ b; }
+    uint64_t refImplies(uint64_t a, uint64_t b, unsigned int w) { return (~a | b) & mask(w); }
+    uint64_t refUdiv(uint64_t a, uint64_t b, unsigned int w) { return b == 0 ? mask(w) : a / b; }
+    uint64_t refUrem(uint64_t a, uint64_t b, unsigned int) { return b == 0 ? a : a % b; }
+
+    uint64_t refSdiv(uint64_t a, uint64_t b, unsigned int w) {
+        bool negative1 = toSigned(a, w) < 0;
+        bool negative2 = toSigned(b, w) < 0;
+        uint64_t quotient = refUdiv(negative1 ? refNeg(a, 0, w) : a, negative2 ? refNeg(b, 0, w) : b, w);
+        return negative1 != negative2 ? refNeg(quotient, 0, w) : quotient;
+    }
+
+    uint64_t refSrem(uint64_t a, uint64_t b, unsigned int w) {
+        bool negative1 = toSigned(a, w) < 0;
+        bool negative2 = toSigned(b, w) < 0;
+        uint64_t remainder = refUrem(negative1 ? refNeg(a, 0, w) : a, negative2 ? refNeg(b, 0, w) : b, w);
+        return negative1 ? refNeg(remainder, 0, w) : remainder;
+    }
+
+    uint64_t refShl(uint64_t a, uint64_t b, unsigned int w) { return b >= w ? 0 : (a << b) & mask(w); }
+    uint64_t refLshr(uint64_t a, uint64_t b, unsigned int w) { return b >= w ? 0 : a >> b; }
+
+    uint64_t refAshr(uint64_t a, uint64_t b, unsigned int w) {
+        return static_cast<uint64_t>(toSigned(a, w) >> (b >= w ? w - 1 : b)) & mask(w);
+    }
+
+    uint64_t refEq(uint64_t a, uint64_t b, unsigned int) { return a == b; }
+    uint64_t refNe(uint64_t a, uint64_t b, unsigned int) { return a != b; }
+    uint64_t refUlt(uint64_t a, uint64_t b, unsigned int) { return a < b; }
+    uint64_t refUle(uint64_t a, uint64_t b, unsigned int) { return a <= b; }
+    uint64_t refUgt(uint64_t a, uint64_t b, unsigned int) { return a > b; }
+    uint64_t refUge(uint64_t a, uint64_t b, unsigned int) { return a >= b; }
+    uint64_t refSlt(uint64_t a, uint64_t b, unsigned int w) { return toSigned(a, w) < toSigned(b, w); }
+    uint64_t refSle(uint64_t a, uint64_t b, unsigned int w) { return toSigned(a, w) <= toSigned(b, w); }
+    uint64_t refSgt(uint64_t a, uint64_t b, unsigned int w) { return toSigned(a, w) > toSigned(b, w); }
+    uint64_t refSge(uint64_t a, uint64_t b, unsigned int w) { return toSigned(a, w) >= toSigned(b, w); }
+    uint64_t refUaddo(uint64_t a, uint64_t b, unsigned int w) { return a + b > mask(w); }
+    uint64_t refUsubo(uint64_t a, uint64_t b, unsigned int) { return a < b; }
+    uint64_t refUmulo(uint64_t a, uint64_t b, unsigned int w) { return a * b > mask(w); }
+
+    uint64_t refSaddo(uint64_t a, uint64_t b, unsigned int w) {
+        return !fitsSigned(toSigned(a, w) + toSigned(b, w), w);
+    }
+
+    uint64_t refSsubo(uint64_t a, uint64_t b, unsigned int w) {
+        return !fitsSigned(toSigned(a, w) - toSigned(b, w), w);
+    }
+
+    uint64_t refSmulo(uint64_t a, uint64_t b, unsigned int w) {
+        return !fitsSigned(toSigned(a, w) * toSigned(b, w), w);
+    }
+
+    uint64_t refSdivo(uint64_t a, uint64_t b, unsigned int w) {
+        return a == (static_cast<uint64_t>(1) << (w - 1)) && b == mask(w);
+    }
+
+    uint64_t refMin(uint64_t a, uint64_t b, unsigned int) { return a < b ? a : b; }
+    uint64_t refConcat(uint64_t a, uint64_t b, unsigned int w) { return a << w | b; }
+    uint64_t refExtract(uint64_t a, uint64_t, unsigned int w) { return (a >> 1) & mask(w - 1); }
+    uint64_t refUext(uint64_t a, uint64_t, unsigned int) { return a; }
+    uint64_t refSext(uint64_t a, uint64_t, unsigned int w) { return static_cast<uint64_t>(toSigned(a, w)) & mask(w + 3); }
+    uint64_t refConstant(uint64_t, uint64_t, unsigned int w) { return 0x5a5a & mask(w); }
+    uint64_t refZeros(uint64_t, uint64_t, unsigned int) { return 0; }
+    uint64_t refOnes(uint64_t, uint64_t, unsigned int w) { return mask(w); }
+
+    typedef uint64_t (*Reference)(uint64_t a, uint64_t b, unsigned int width);
+
+    /* one operator applied to the symbolic operands, with its reference */
+    struct Operator {
+        std::string name;
+        SMT::BVExp *result;
+        Reference reference;
+    };
+
+    typedef SMT::BVExp *(SMT::AigBitvectors::*Binary)(SMT::BVExp *, SMT::BVExp *);
+    typedef SMT::BoolExp *(SMT::AigBitvectors::*Predicate)(SMT::BVExp *, SMT::BVExp *);
+
+    /*
+     * Bit-blasts every operator over two symbolic operands a and b of one
+     * width. Predicates are wrapped into 1-bit words so that all results can
+     * be read back the same way.
+     */
+    class Circuit {
+    public:
+        Circuit(unsigned int width) : m_bvs(m_aig) {
+            m_a = m_bvs.bitvector(width, "a");
+            m_b = m_bvs.bitvector(width, "b");
+
+            add("bvadd", &SMT::AigBitvectors::bvadd, refAdd);
+            add("bvsub", &SMT::AigBitvectors::bvsub, refSub);
+            add("bvmul", &SMT::AigBitvectors::bvmul, refMul);
+            add("bvudiv", &SMT::AigBitvectors::bvudiv, refUdiv);
+            add("bvurem", &SMT::AigBitvectors::bvurem, refUrem);
+            add("bvsdiv", &SMT::AigBitvectors::bvsdiv, refSdiv);
+            add("bvsrem", &SMT::AigBitvectors::bvsrem, refSrem);
+            add("bvand", &SMT::AigBitvectors::bvand, refAnd);
+            add("bvor", &SMT::AigBitvectors::bvor, refOr);
+            add("bvxor", &SMT::AigBitvectors::bvxor, refXor);
+            add("bvimplies", &SMT::AigBitvectors::bvimplies, refImplies);
+            add("bvshl", &SMT::AigBitvectors::bvshl, refShl);
+            add("bvlshr", &SMT::AigBitvectors::bvlshr, refLshr);
+            add("bvashr", &SMT::AigBitvectors::bvashr, refAshr);
+
+            add("eq", &SMT::AigBitvectors::eq, refEq);
+            add("bvne", &SMT::AigBitvectors::bvne, refNe);
+            add("bvult", &SMT::AigBitvectors::bvult, refUlt);
+            add("bvule", &SMT::AigBitvectors::bvule, refUle);
+            add("bvugt", &SMT::AigBitvectors::bvugt, refUgt);
+            add("bvuge", &SMT::AigBitvectors::bvuge, refUge);
+            add("bvslt", &SMT::AigBitvectors::bvslt, refSlt);
+            add("bvsle", &SMT::AigBitvectors::bvsle, refSle);
+            add("bvsgt", &SMT::AigBitvectors::bvsgt, refSgt);
+            add("bvsge", &SMT::AigBitvectors::bvsge, refSge);
+            add("bvuaddo", &SMT::AigBitvectors::bvuaddo, refUaddo);
+            add("bvusubo", &SMT::AigBitvectors::bvusubo, refUsubo);
+            add("bvumulo", &SMT::AigBitvectors::bvumulo, refUmulo);
+            add("bvsaddo", &SMT::AigBitvectors::bvsaddo, refSaddo);
+            add("bvssubo", &SMT::AigBitvectors::bvssubo, refSsubo);
+            add("bvsmulo", &SMT::AigBitvectors::bvsmulo, refSmulo);
+            add("bvsdivo", &SMT::AigBitvectors::bvsdivo, refSdivo);
+
+            add("bvnot", m_bvs.bvnot(m_a), refNot);
+            add("bvneg", m_bvs.bvneg(m_a), refNeg);
+            add("concat", m_bvs.concat(m_a, m_b), refConcat);
+            if (width > 1) {
+                add("extract", m_bvs.extract(width - 1, 1, m_a), refExtract);
+            }
+            add("uext", m_bvs.uext(m_a, width + 3), refUext);
+            add("sext", m_bvs.sext(m_a, width + 3), refSext);
+            add("bvzeros", m_bvs.bvzeros(width), refZeros);
+            add("bvones", m_bvs.bvones(width), refOnes);
+
+            Bitvector constant(0x5a5a & mask(width), width);
+            add("bv2bv", m_bvs.bv2bv(&constant), refConstant);
+
+            SMT::BVExp *bit = m_bvs.bool2bv1(m_bvs.bvult(m_a, m_b));
+            add("bvcond", m_bvs.bvcond(m_bvs.bv12bool(bit), m_a, m_b), refMin);
+            m_bvs.release(bit);
+        }
+
+        ~Circuit() {
+            for (size_t i = 0; i < m_operators.size(); ++i) {
+                m_bvs.release(m_operators[i].result);
+            }
+            m_bvs.release(m_b);
+            m_bvs.release(m_a);
+        }
+
+        const SMT::Aig &getAig() const {
+            return m_aig;
+        }
+
+        const std::vector<Operator> &getOperators() const {
+            return m_operators;
+        }
+
+        /* bits of a word, least significant first */
+        static const std::vector<SMT::AigLit> &bits(SMT::BVExp *exp) {
+            return SMT::toAig(exp)->bits;
+        }
+
+    private:
+        Circuit(const Circuit &);
+        Circuit &operator=(const Circuit &);
+
+        void add(const std::string &name, Binary binary, Reference reference) {
+            add(name, (m_bvs.*binary)(m_a, m_b), reference);
+        }
+
+        void add(const std::string &name, Predicate predicate, Reference reference) {
+            add(name, m_bvs.bool2bv1((m_bvs.*predicate)(m_a, m_b)), reference);
+        }
+
+        void add(const std::string &name, SMT::BVExp *result, Reference reference) {
+            Operator op = {name, result, reference};
+            m_operators.push_back(op);
+        }
+
+        SMT::Aig m_aig;
+        SMT::AigBitvectors m_bvs;
+        SMT::BVExp *m_a;
+        SMT::BVExp *m_b;
+        std::vector<Operator> m_operators;
+    };
+
+    /* simulates the whole Aig for one assignment of the inputs a and b */
+    void simulate(const SMT::Aig &aig, uint64_t a, uint64_t b, std::vector<bool> &values) {
+        values.assign(aig.getNodeCount(), false);
+        for (uint32_t node = 1; node < aig.getNodeCount(); ++node) {
+            if (aig.isInput(node)) {
+                uint64_t word = aig.getInputName(node) == "a" ? a : b;
+                values[node] = ((word >> aig.getInputBit(node)) & 1) != 0;
+            } else {
+                SMT::AigLit c0 = aig.getChild0(node);
+                SMT::AigLit c1 = aig.getChild1(node);
+                values[node] = (values[SMT::aigNode(c0)] != SMT::aigIsNegated(c0)) &&
+                               (values[SMT::aigNode(c1)] != SMT::aigIsNegated(c1));
+            }
+        }
+    }
+
+    bool valueOf(const std::vector<bool> &values, SMT::AigLit lit) {
+        return values[SMT::aigNode(lit)] != SMT::aigIsNegated(lit);
+    }
+
+    uint64_t valueOf(const std::vector<bool> &values, const std::vector<SMT::AigLit> &bits) {
+        uint64_t result = 0;
+        for (size_t i = 0; i < bits.size(); ++i) {
+            result |= static_cast<uint64_t>(valueOf(values, bits[i])) << i;
+        }
+        return result;
+    }
+
+    /* counts and prints the first few mismatches of one check */
+    class Check {
+    public:
+        explicit Check(const std::string &name) : m_name(name), m_failures(0) {
+
+        }
+
+        void expect(bool ok, const std::string &what, unsigned int width, uint64_t a, uint64_t b, uint64_t got,
+                    uint64_t expected) {
+            if (ok) {
+                return;
+            }
+            if (m_failures < 5) {
+                std::cout << m_name << " " << what << " w=" << width << " a=" << a << " b=" << b << ": " << got
+                          << ", expected " << expected << "\n";
+            }
+            ++m_failures;
+        }
+
+        bool finish() {
+            std::cout << m_name << ": " << (m_failures == 0 ? "ok" : "FAILED") << "\n";
+            return m_failures == 0;
+        }
+
+    private:
+        std::string m_name;
+        unsigned int m_failures;
+    };
+
+    /* every bit-blasted operator against the reference for all operands up to maxWidth bits */
+    bool checkOperators(unsigned int maxWidth) {
+        Check check("AigBitvectors");
+        std::vector<bool> values;
+        for (unsigned int w = 1; w <= maxWidth; ++w) {
+            Circuit circuit(w);
+            const std::vector<Operator> &operators = circuit.getOperators();
+            for (uint64_t a = 0; a <= mask(w); ++a) {
+                for (uint64_t b = 0; b <= mask(w); ++b) {
+                    simulate(circuit.getAig(), a, b, values);
+                    for (size_t i = 0; i < operators.size(); ++i) {
+                        uint64_t got = valueOf(values, Circuit::bits(operators[i].result));
+                        uint64_t expected = operators[i].reference(a, b, w);
+                        check.expect(got == expected, operators[i].name, w, a, b, got, expected);
+                    }
+                }
+            }
+        }
+        return check.finish();
+    }
+
+    /* keeps the clauses and remembers which variables stand for inputs */
+    class ClauseRecorder : public ClauseSink {
+    public:
+        ClauseRecorder() : m_variables(0) {
+
+        }
+
+        int addVariable(const std::string &, unsigned int) {
+            m_inputs.resize(m_variables + 2, false);
+            m_inputs[m_variables + 1] = true;
+            return ++m_variables;
+        }
+
+        int addVariable() {
+            m_inputs.resize(m_variables + 2, false);
+            return ++m_variables;
+        }
+
+        void addClause(const int *literals, size_t size) {
+            m_clauses.push_back(std::vector<int>(literals, literals + size));
+        }
+
+        int getVariables() const {
+            return m_variables;
+        }
+
+        bool isInput(int variable) const {
+            return m_inputs[variable];
+        }
+
+        const std::vector<std::vector<int> > &getClauses() const {
+            return m_clauses;
+        }
+
+    private:
+        int m_variables;
+        std::vector<bool> m_inputs;
+        std::vector<std::vector<int> > m_clauses;
+    };
+
+    bool satisfies(const std::vector<int> &clause, const std::vector<bool> &assignment) {
+        for (size_t i = 0; i < clause.size(); ++i) {
+            int l = clause[i];
+            if (assignment[l < 0 ? -l : l] == (l > 0)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+     * Encodes every operator of the circuits up to maxWidth bits and checks
+     * the CNF for all operands: the simulated values of the encoded nodes
+     * have to satisfy every clause, the literals handed out by encode have
+     * to carry the value of their edge, and flipping any auxiliary variable
+     * alone has to falsify a clause, so that no auxiliary variable is left
+     * unconstrained.
+     */
+    bool checkCnf(unsigned int maxWidth) {
+        Check check("AigCnf");
+        std::vector<bool> values;
+        for (unsigned int w = 1; w <= maxWidth; ++w) {
+            Circuit circuit(w);
+            const SMT::Aig &aig = circuit.getAig();
+            const std::vector<Operator> &operators = circuit.getOperators();
+
+            ClauseRecorder recorder;
+            SMT::AigCnf cnf(aig, recorder);
+            std::vector<SMT::AigLit> lits;
+            std::vector<int> encoded;
+            for (size_t i = 0; i < operators.size(); ++i) {
+                const std::vector<SMT::AigLit> &bits = Circuit::bits(operators[i].result);
+                for (size_t j = 0; j < bits.size(); ++j) {
+                    lits.push_back(bits[j]);
+                    encoded.push_back(cnf.encode(bits[j]));
+                }
+            }
+
+            const std::vector<std::vector<int> > &clauses = recorder.getClauses();
+            std::vector<std::vector<size_t> > occurrences(recorder.getVariables() + 1);
+            for (size_t i = 0; i < clauses.size(); ++i) {
+                for (size_t j = 0; j < clauses[i].size(); ++j) {
+                    occurrences[clauses[i][j] < 0 ? -clauses[i][j] : clauses[i][j]].push_back(i);
+                }
+            }
+
+            std::vector<bool> assignment;
+            for (uint64_t a = 0; a <= mask(w); ++a) {
+                for (uint64_t b = 0; b <= mask(w); ++b) {
+                    simulate(aig, a, b, values);
+                    assignment.assign(recorder.getVariables() + 1, false);
+                    for (uint32_t node = 0; node < aig.getNodeCount(); ++node) {
+                        int v = cnf.getVariable(node);
+                        if (v != 0) {
+                            assignment[v] = values[node];
+                        }
+                    }
+
+                    for (size_t i = 0; i < lits.size(); ++i) {
+                        int l = encoded[i];
+                        bool got = assignment[l < 0 ? -l : l] == (l > 0);
+                        check.expect(got == valueOf(values, lits[i]), "encoded literal", w, a, b, got,
+                                     valueOf(values, lits[i]));
+                    }
+                    for (size_t i = 0; i < clauses.size(); ++i) {
+                        check.expect(satisfies(clauses[i], assignment), "clause falsified", w, a, b, i, 0);
+                    }
+                    for (int v = 1; v <= recorder.getVariables(); ++v) {
+                        if (recorder.isInput(v)) {
+                            continue;
+                        }
+                        assignment[v] = !assignment[v];
+                        bool determined = false;
+                        for (size_t i = 0; i < occurrences[v].size() && !determined; ++i) {
+                            determined = !satisfies(clauses[occurrences[v][i]], assignment);
+                        }
+                        assignment[v] = !assignment[v];
+                        check.expect(determined, "variable not determined", w, a, b, v, 0);
+                    }
+                }
+            }
+        }
+        return check.finish();
+    }
+}
+
+/*
+ * Checks the AIG bit-blaster exhaustively on small widths: every operator
+ * of SMT::AigBitvectors is simulated on the Aig against plain C++
+ * arithmetic, and the CNF SMT::AigCnf produces for them is checked against
+ * the simulation. No SAT solver is involved.
+ */
+int main() {
+    bool ok = true;
+    try {
+        ok = checkOperators(6) && ok;
+        ok = checkCnf(5) && ok;
+    } catch (const LLBMCException &e) {
+        std::cout << "LLBMCException: " << e.getMessage() << "\n";
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,215 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "Boolector/Boolector.h"
+
+#include <llbmc/SMT/TheoryOfArrays.h>
+#include <llbmc/SMT/TheoryOfBitvectors.h>
+#include <llbmc/Util/Bitvector.h>
+#include <llbmc/Util/LLBMCException.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+namespace {
+    /* (width + 63) / 64 words of pseudo-random bits, the unused top bits are zero */
+    std::vector<uint64_t> randomWords(unsigned int width) {
+        std::vector<uint64_t> words((width + 63) / 64);
+        for (size_t i = 0; i < words.size(); ++i) {
+            words[i] = static_cast<uint64_t>(rand()) << 40 ^ static_cast<uint64_t>(rand()) << 20 ^ rand();
+        }
+        if (width % 64 != 0) {
+            words.back() &= (static_cast<uint64_t>(1) << (width % 64)) - 1;
+        }
+        return words;
+    }
+
+    Bitvector toBitvector(const std::vector<uint64_t> &words, unsigned int width) {
+        Bitvector value(0, width);
+        for (unsigned int i = 0; i < width; ++i) {
+            value.setBit(i, (words[i / 64] >> (i % 64)) & 1);
+        }
+        return value;
+    }
+
+    class Check {
+    public:
+        explicit Check(const std::string &name) : m_name(name), m_failures(0) {
+
+        }
+
+        void expect(bool ok, const std::string &what, unsigned int width) {
+            if (ok) {
+                return;
+            }
+            if (m_failures < 5) {
+                std::cout << m_name << " w=" << width << ": " << what << "\n";
+            }
+            ++m_failures;
+        }
+
+        bool finish() {
+            std::cout << m_name << ": " << (m_failures == 0 ? "ok" : "FAILED") << "\n";
+            return m_failures == 0;
+        }
+
+    private:
+        std::string m_name;
+        unsigned int m_failures;
+    };
+
+    /*
+     * Fixes bitvectors of widths around the word and chunk boundaries of the
+     * decoder to random values, then reads the model back through
+     * getBitvectors and compares it with the values and with getBitvector.
+     */
+    bool checkBitvectors() {
+        static const unsigned int Widths[] = {1, 2, 7, 8, 9, 15, 16, 17, 31, 32, 33, 56, 57, 63, 64, 65, 71, 72,
+                                              120, 127, 128, 129, 200};
+        static const size_t Count = sizeof(Widths) / sizeof(Widths[0]);
+
+        SMT::Boolector solver(SMT::Boolector::Lingeling);
+        SMT::TheoryOfBitvectors &bvs = *solver.getTheoryOfBitvectors();
+        SMT::SatCore &sat = *solver.getSatCore();
+        Check check("getBitvectors");
+
+        std::vector<SMT::BVExp *> exps;
+        std::vector<std::vector<uint64_t> > expected;
+        for (size_t i = 0; i < Count; ++i) {
+            expected.push_back(randomWords(Widths[i]));
+            exps.push_back(bvs.bitvector(Widths[i], "v" + std::to_string(i)));
+            Bitvector value = toBitvector(expected.back(), Widths[i]);
+            SMT::BVExp *constant = bvs.bv2bv(&value);
+            SMT::BoolExp *equal = bvs.eq(exps.back(), constant);
+            solver.assertConstraint(equal);
+            sat.release(equal);
+            bvs.release(constant);
+        }
+        solver.solve();
+        check.expect(solver.getResult() == SMT::Solver::Satisfiable, "not satisfiable", 0);
+
+        /* values are appended behind what the buffer already holds */
+        std::vector<uint64_t> buffer(1, 0x5a5a5a5a5a5a5a5aULL);
+        solver.getBitvectors(exps.data(), exps.size(), buffer);
+        check.expect(buffer[0] == 0x5a5a5a5a5a5a5a5aULL, "buffer prefix overwritten", 0);
+
+        size_t offset = 1;
+        for (size_t i = 0; i < Count; ++i) {
+            unsigned int width = Widths[i];
+            for (size_t word = 0; word < expected[i].size(); ++word) {
+                check.expect(offset + word < buffer.size() && buffer[offset + word] == expected[i][word],
+                             "bulk value differs", width);
+            }
+
+            const Bitvector *single = solver.getBitvector(exps[i]);
+            for (unsigned int bit = 0; bit < width; ++bit) {
+                bool bulk = offset + bit / 64 < buffer.size() && ((buffer[offset + bit / 64] >> (bit % 64)) & 1);
+                check.expect(single != NULL && single->getBit(bit) == bulk, "getBitvector differs", width);
+            }
+            delete single;
+            offset += expected[i].size();
+        }
+        check.expect(offset == buffer.size(), "buffer size", 0);
+
+        for (size_t i = 0; i < Count; ++i) {
+            bvs.release(exps[i]);
+        }
+        return check.finish();
+    }
+
+    /*
+     * Fixes a few entries of arrays with narrow and wide elements and finds
+     * them among the entries getBVArrays decodes.
+     */
+    bool checkBVArrays() {
+        static const unsigned int IndexWidth = 8;
+        static const unsigned int ValueWidths[] = {1, 8, 64, 70};
+        static const size_t Count = sizeof(ValueWidths) / sizeof(ValueWidths[0]);
+        static const uint64_t Indices[] = {0, 3, 77, 255};
+        static const size_t Entries = sizeof(Indices) / sizeof(Indices[0]);
+
+        SMT::Boolector solver(SMT::Boolector::Lingeling);
+        SMT::TheoryOfBitvectors &bvs = *solver.getTheoryOfBitvectors();
+        SMT::BitvectorTheoryOfArrays &arrays = *solver.getBitvectorTheoryOfArrays();
+        SMT::SatCore &sat = *solver.getSatCore();
+        Check check("getBVArrays");
+
+        std::vector<SMT::AExp *> exps;
+        std::vector<std::vector<std::vector<uint64_t> > > expected(Count);
+        for (size_t i = 0; i < Count; ++i) {
+            exps.push_back(arrays.array(IndexWidth, ValueWidths[i], "a" + std::to_string(i)));
+            for (size_t j = 0; j < Entries; ++j) {
+                expected[i].push_back(randomWords(ValueWidths[i]));
+                Bitvector index(Indices[j], IndexWidth);
+                Bitvector value = toBitvector(expected[i][j], ValueWidths[i]);
+                SMT::BVExp *indexExp = bvs.bv2bv(&index);
+                SMT::BVExp *valueExp = bvs.bv2bv(&value);
+                SMT::BVExp *read = arrays.read(exps[i], indexExp);
+                SMT::BoolExp *equal = bvs.eq(read, valueExp);
+                solver.assertConstraint(equal);
+                sat.release(equal);
+                bvs.release(read);
+                bvs.release(valueExp);
+                bvs.release(indexExp);
+            }
+        }
+        solver.solve();
+        check.expect(solver.getResult() == SMT::Solver::Satisfiable, "not satisfiable", 0);
+
+        std::vector<uint64_t> buffer;
+        solver.getBVArrays(exps.data(), exps.size(), buffer);
+
+        size_t offset = 0;
+        for (size_t i = 0; i < Count && offset < buffer.size(); ++i) {
+            size_t valueWords = (ValueWidths[i] + 63) / 64;
+            uint64_t size = buffer[offset++];
+            std::vector<bool> found(Entries, false);
+            for (uint64_t entry = 0; entry < size && offset + 1 + valueWords <= buffer.size(); ++entry) {
+                uint64_t index = buffer[offset++];
+                for (size_t j = 0; j < Entries; ++j) {
+                    if (Indices[j] != index) {
+                        continue;
+                    }
+                    found[j] = true;
+                    for (size_t word = 0; word < valueWords; ++word) {
+                        check.expect(buffer[offset + word] == expected[i][j][word], "entry value differs",
+                                     ValueWidths[i]);
+                    }
+                }
+                offset += valueWords;
+            }
+            for (size_t j = 0; j < Entries; ++j) {
+                check.expect(found[j], "fixed entry missing", ValueWidths[i]);
+            }
+        }
+        check.expect(offset == buffer.size(), "buffer size", 0);
+
+        for (size_t i = 0; i < Count; ++i) {
+            arrays.release(exps[i]);
+        }
+        return check.finish();
+    }
+}
+
+/*
+ * Round-trips models through the bulk getters of SMT::Boolector: values
+ * fixed by the constraints have to come back from getBitvectors and
+ * getBVArrays, and agree with the single-value getBitvector.
+ */
+int main() {
+    srand(17);
+    bool ok = true;
+    try {
+        ok = checkBitvectors() && ok;
+        ok = checkBVArrays() && ok;
+    } catch (const LLBMCException &e) {
+        std::cout << "LLBMCException: " << e.getMessage() << "\n";
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
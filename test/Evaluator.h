@@ -0,0 +1,352 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#ifndef TRANSFORMERSOLVER_EVALUATOR_H
+#define TRANSFORMERSOLVER_EVALUATOR_H
+
+#include "QF_ABV.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+
+
+inline uint64_t mask(unsigned int width) {
+    return width >= 64 ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << width) - 1;
+}
+
+inline int64_t toSigned(uint64_t value, unsigned int width) {
+    if (width < 64 && ((value >> (width - 1)) & 1)) {
+        return static_cast<int64_t>(value | ~mask(width));
+    }
+    return static_cast<int64_t>(value);
+}
+
+/*
+ * A QF_ABV backend that evaluates instead of building formulas, every
+ * expression is a constant of at most 64 bits. Variables take the value
+ * assigned to their name, 0 if there is none. It counts references, so
+ * the checks also catch leaked and doubly released handles.
+ */
+class Evaluator : public SMT::QF_ABV {
+public:
+    Evaluator() : m_live(0), m_errors(0) {
+
+    }
+
+    ~Evaluator() {
+        clearDivisionCache();
+    }
+
+    SMT::BVExp *constant(uint64_t value, unsigned int width) {
+        return toBVExp(make(value, width));
+    }
+
+    uint64_t value(SMT::BVExp *exp) {
+        return node(exp)->value;
+    }
+
+    bool value(SMT::BoolExp *exp) {
+        return node(exp)->value != 0;
+    }
+
+    /* handles not released yet */
+    size_t getLive() const {
+        return m_live;
+    }
+
+    /* handles used or released after their last release */
+    size_t getErrors() const {
+        return m_errors;
+    }
+
+    /* drops the storage once every handle is released */
+    void collect() {
+        if (m_live == 0) {
+            m_nodes.clear();
+        }
+    }
+
+    /* value of the variables called name built from now on */
+    void assign(const std::string &name, uint64_t value) {
+        m_assignment[name] = value;
+    }
+
+    SMT::BoolExp *mk_free(const std::string &name) {
+        return toBoolExp(make(lookup(name), 1));
+    }
+
+    SMT::BoolExp *mk_true() {
+        return toBoolExp(make(1, 1));
+    }
+
+    SMT::BoolExp *mk_false() {
+        return toBoolExp(make(0, 1));
+    }
+
+    SMT::BoolExp *mk_not(SMT::BoolExp *exp) {
+        return boolean(!value(exp));
+    }
+
+    SMT::BoolExp *mk_and(SMT::BoolExp *exp1, SMT::BoolExp *exp2) {
+        return boolean(value(exp1) && value(exp2));
+    }
+
+    SMT::BoolExp *mk_or(SMT::BoolExp *exp1, SMT::BoolExp *exp2) {
+        return boolean(value(exp1) || value(exp2));
+    }
+
+    SMT::BoolExp *mk_xor(SMT::BoolExp *exp1, SMT::BoolExp *exp2) {
+        return boolean(value(exp1) != value(exp2));
+    }
+
+    SMT::BoolExp *mk_implies(SMT::BoolExp *exp1, SMT::BoolExp *exp2) {
+        return boolean(!value(exp1) || value(exp2));
+    }
+
+    SMT::BoolExp *mk_iff(SMT::BoolExp *exp1, SMT::BoolExp *exp2) {
+        return boolean(value(exp1) == value(exp2));
+    }
+
+    SMT::BoolExp *mk_cond(SMT::BoolExp *cond, SMT::BoolExp *exp1, SMT::BoolExp *exp2) {
+        return boolean(value(cond) ? value(exp1) : value(exp2));
+    }
+
+    SMT::BoolExp *copy(SMT::BoolExp *exp) {
+        retain(node(exp));
+        return exp;
+    }
+
+    void release(SMT::BoolExp *exp) {
+        drop(reinterpret_cast<Node *>(exp));
+    }
+
+    SMT::BVExp *bitvector(unsigned int width, const std::string &name) {
+        return constant(lookup(name), width);
+    }
+
+    SMT::BVExp *copy(SMT::BVExp *exp) {
+        retain(node(exp));
+        return exp;
+    }
+
+    SMT::BVExp *bool2bv1(SMT::BoolExp *exp) {
+        return constant(value(exp) ? 1 : 0, 1);
+    }
+
+    SMT::BoolExp *bv12bool(SMT::BVExp *exp) {
+        return boolean(value(exp) == 1);
+    }
+
+    SMT::BoolExp *eq(SMT::BVExp *exp1, SMT::BVExp *exp2) {
+        return boolean(value(exp1) == value(exp2));
+    }
+
+    SMT::BVExp *concat(SMT::BVExp *exp1, SMT::BVExp *exp2) {
+        unsigned int low = width(exp2);
+        return constant(value(exp1) << low | value(exp2), width(exp1) + low);
+    }
+
+    SMT::BVExp *extract(unsigned int i, unsigned int j, SMT::BVExp *exp) {
+        if (i < j || i >= width(exp)) {
+            throw LLBMCException("extract out of range");
+        }
+        return constant(value(exp) >> j, i - j + 1);
+    }
+
+    SMT::BVExp *bvnot(SMT::BVExp *exp) {
+        return constant(~value(exp), width(exp));
+    }
+
+    SMT::BVExp *bvneg(SMT::BVExp *exp) {
+        return constant(0 - value(exp), width(exp));
+    }
+
+    SMT::BVExp *bvand(SMT::BVExp *exp1, SMT::BVExp *exp2) {
+        return constant(value(exp1) & value(exp2), same(exp1, exp2));
+    }
+
+    SMT::BVExp *bvor(SMT::BVExp *exp1, SMT::BVExp *exp2) {
+        return constant(value(exp1) | value(exp2), same(exp1, exp2));
+    }
+
+    SMT::BVExp *bvadd(SMT::BVExp *exp1, SMT::BVExp *exp2) {
+        return constant(value(exp1) + value(exp2), same(exp1, exp2));
+    }
+
+    SMT::BVExp *bvmul(SMT::BVExp *exp1, SMT::BVExp *exp2) {
+        return constant(value(exp1) * value(exp2), same(exp1, exp2));
+    }
+
+    SMT::BVExp *bvudiv(SMT::BVExp *exp1, SMT::BVExp *exp2) {
+        unsigned int w = same(exp1, exp2);
+        return constant(value(exp2) == 0 ? mask(w) : value(exp1) / value(exp2), w);
+    }
+
+    SMT::BVExp *bvurem(SMT::BVExp *exp1, SMT::BVExp *exp2) {
+        unsigned int w = same(exp1, exp2);
+        return constant(value(exp2) == 0 ? value(exp1) : value(exp1) % value(exp2), w);
+    }
+
+    SMT::BVExp *bvshl(SMT::BVExp *exp1, SMT::BVExp *exp2) {
+        unsigned int w = same(exp1, exp2);
+        return constant(value(exp2) >= w ? 0 : value(exp1) << value(exp2), w);
+    }
+
+    SMT::BVExp *bvlshr(SMT::BVExp *exp1, SMT::BVExp *exp2) {
+        unsigned int w = same(exp1, exp2);
+        return constant(value(exp2) >= w ? 0 : value(exp1) >> value(exp2), w);
+    }
+
+    SMT::BoolExp *bvult(SMT::BVExp *exp1, SMT::BVExp *exp2) {
+        same(exp1, exp2);
+        return boolean(value(exp1) < value(exp2));
+    }
+
+    SMT::BVExp *bv2bv(const Bitvector *bv) {
+        return constant(bv->getUnsigned(), bv->getWidth());
+    }
+
+    SMT::BVExp *bvzeros(unsigned int width) {
+        return constant(0, width);
+    }
+
+    SMT::BVExp *bvones(unsigned int width) {
+        return constant(mask(width), width);
+    }
+
+    SMT::BVExp *bvcond(SMT::BoolExp *cond, SMT::BVExp *exp1, SMT::BVExp *exp2) {
+        unsigned int w = same(exp1, exp2);
+        return constant(value(cond) ? value(exp1) : value(exp2), w);
+    }
+
+    void release(SMT::BVExp *exp) {
+        drop(reinterpret_cast<Node *>(exp));
+    }
+
+    unsigned int width(SMT::BVExp *exp) {
+        return node(exp)->width;
+    }
+
+    SMT::AExp *array(unsigned int, unsigned int, const std::string &) {
+        throw LLBMCException("The evaluator has no arrays");
+    }
+
+    SMT::AExp *copy(SMT::AExp *) {
+        throw LLBMCException("The evaluator has no arrays");
+    }
+
+    SMT::BoolExp *eq(SMT::AExp *, SMT::AExp *) {
+        throw LLBMCException("The evaluator has no arrays");
+    }
+
+    SMT::BVExp *read(SMT::AExp *, SMT::BVExp *) {
+        throw LLBMCException("The evaluator has no arrays");
+    }
+
+    SMT::AExp *write(SMT::AExp *, SMT::BVExp *, SMT::BVExp *) {
+        throw LLBMCException("The evaluator has no arrays");
+    }
+
+    SMT::AExp *memcpy(SMT::AExp *, SMT::BVExp *, SMT::AExp *, SMT::BVExp *, SMT::BVExp *) {
+        throw LLBMCException("The evaluator has no arrays");
+    }
+
+    SMT::AExp *memset(SMT::AExp *, SMT::BVExp *, SMT::BVExp *, SMT::BVExp *) {
+        throw LLBMCException("The evaluator has no arrays");
+    }
+
+    SMT::AExp *array2exp(const BVArray *) {
+        throw LLBMCException("The evaluator has no arrays");
+    }
+
+    SMT::AExp *acond(SMT::BoolExp *, SMT::AExp *, SMT::AExp *) {
+        throw LLBMCException("The evaluator has no arrays");
+    }
+
+    void release(SMT::AExp *) {
+        throw LLBMCException("The evaluator has no arrays");
+    }
+
+private:
+    struct Node {
+        uint64_t value;
+        unsigned int width;
+        int references;
+    };
+
+    Node *make(uint64_t value, unsigned int width) {
+        if (width == 0 || width > 64) {
+            throw LLBMCException("The evaluator only handles 1 to 64 bits");
+        }
+        Node created = {value & mask(width), width, 1};
+        m_nodes.push_back(created);
+        ++m_live;
+        return &m_nodes.back();
+    }
+
+    SMT::BoolExp *boolean(bool value) {
+        return toBoolExp(make(value ? 1 : 0, 1));
+    }
+
+    Node *node(SMT::BVExp *exp) {
+        return checked(reinterpret_cast<Node *>(exp));
+    }
+
+    Node *node(SMT::BoolExp *exp) {
+        return checked(reinterpret_cast<Node *>(exp));
+    }
+
+    Node *checked(Node *n) {
+        if (n->references <= 0) {
+            ++m_errors;
+        }
+        return n;
+    }
+
+    void retain(Node *n) {
+        ++n->references;
+        ++m_live;
+    }
+
+    void drop(Node *n) {
+        if (n->references <= 0) {
+            ++m_errors;
+            return;
+        }
+        --n->references;
+        --m_live;
+    }
+
+    uint64_t lookup(const std::string &name) const {
+        std::map<std::string, uint64_t>::const_iterator it = m_assignment.find(name);
+        return it == m_assignment.end() ? 0 : it->second;
+    }
+
+    unsigned int same(SMT::BVExp *exp1, SMT::BVExp *exp2) {
+        if (width(exp1) != width(exp2)) {
+            throw LLBMCException("Operands of different width");
+        }
+        return width(exp1);
+    }
+
+    static SMT::BVExp *toBVExp(Node *n) {
+        return reinterpret_cast<SMT::BVExp *>(n);
+    }
+
+    static SMT::BoolExp *toBoolExp(Node *n) {
+        return reinterpret_cast<SMT::BoolExp *>(n);
+    }
+
+    std::deque<Node> m_nodes;
+    std::map<std::string, uint64_t> m_assignment;
+    size_t m_live;
+    size_t m_errors;
+};
+
+
+#endif //TRANSFORMERSOLVER_EVALUATOR_H
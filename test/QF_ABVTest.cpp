@@ -0,0 +1,242 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "Evaluator.h"
+#include "QF_ABV.h"
+
+#include <llbmc/Util/LLBMCException.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+
+namespace {
+    /* counts and prints the first few mismatches of one check */
+    class Check {
+    public:
+        explicit Check(const std::string &name) : m_name(name), m_failures(0) {
+
+        }
+
+        void expect(bool ok, unsigned int width, uint64_t a, uint64_t b, uint64_t got, uint64_t expected) {
+            if (ok) {
+                return;
+            }
+            if (m_failures < 5) {
+                std::cout << m_name << " w=" << width << " a=" << a << " b=" << b << ": " << got
+                          << ", expected " << expected << "\n";
+            }
+            ++m_failures;
+        }
+
+        /* prints the summary, true if there were no mismatches and no handle errors */
+        bool finish(const Evaluator &evaluator) {
+            if (evaluator.getLive() != 0 || evaluator.getErrors() != 0) {
+                std::cout << m_name << ": " << evaluator.getLive() << " handles leaked, "
+                          << evaluator.getErrors() << " misused\n";
+                ++m_failures;
+            }
+            std::cout << m_name << ": " << (m_failures == 0 ? "ok" : "FAILED") << "\n";
+            return m_failures == 0;
+        }
+
+    private:
+        std::string m_name;
+        unsigned int m_failures;
+    };
+
+    uint64_t referenceAshr(uint64_t a, uint64_t b, unsigned int width) {
+        int64_t value = toSigned(a, width);
+        return static_cast<uint64_t>(value >> (b >= width ? width - 1 : b)) & mask(width);
+    }
+
+    /* bvashr against the reference for all operands up to maxWidth bits */
+    bool checkAshr(SMT::QF_ABV::ShiftEncoding encoding, unsigned int maxWidth) {
+        Evaluator evaluator;
+        evaluator.setShiftEncoding(encoding);
+        Check check(encoding == SMT::QF_ABV::LinearShiftEncoding ? "bvashr linear" : "bvashr barrel");
+        for (unsigned int w = 1; w <= maxWidth; ++w) {
+            for (uint64_t a = 0; a <= mask(w); ++a) {
+                for (uint64_t b = 0; b <= mask(w); ++b) {
+                    SMT::BVExp *x = evaluator.constant(a, w);
+                    SMT::BVExp *y = evaluator.constant(b, w);
+                    SMT::BVExp *result = evaluator.bvashr(x, y);
+                    uint64_t expected = referenceAshr(a, b, w);
+                    check.expect(evaluator.value(result) == expected, w, a, b, evaluator.value(result), expected);
+                    evaluator.release(result);
+                    evaluator.release(y);
+                    evaluator.release(x);
+                    evaluator.collect();
+                }
+            }
+        }
+        return check.finish(evaluator);
+    }
+
+    /*
+     * bvsdiv and bvsrem against the reference for all operands up to maxWidth
+     * bits. The shared divider memo must stay bounded and release everything
+     * it holds on clearDivisionCache.
+     */
+    bool checkSignedDivision(unsigned int maxWidth) {
+        Evaluator evaluator;
+        Check check("bvsdiv/bvsrem");
+        for (unsigned int w = 1; w <= maxWidth; ++w) {
+            uint64_t m = mask(w);
+            for (uint64_t a = 0; a <= m; ++a) {
+                for (uint64_t b = 0; b <= m; ++b) {
+                    bool negative1 = toSigned(a, w) < 0;
+                    bool negative2 = toSigned(b, w) < 0;
+                    uint64_t norm1 = negative1 ? (0 - a) & m : a;
+                    uint64_t norm2 = negative2 ? (0 - b) & m : b;
+                    uint64_t udiv = norm2 == 0 ? m : norm1 / norm2;
+                    uint64_t urem = norm2 == 0 ? norm1 : norm1 % norm2;
+                    uint64_t quotient = negative1 != negative2 ? (0 - udiv) & m : udiv;
+                    uint64_t remainder = negative1 ? (0 - urem) & m : urem;
+
+                    SMT::BVExp *x = evaluator.constant(a, w);
+                    SMT::BVExp *y = evaluator.constant(b, w);
+                    SMT::BVExp *sdiv = evaluator.bvsdiv(x, y);
+                    SMT::BVExp *srem = evaluator.bvsrem(x, y);
+                    check.expect(evaluator.value(sdiv) == quotient, w, a, b, evaluator.value(sdiv), quotient);
+                    check.expect(evaluator.value(srem) == remainder, w, a, b, evaluator.value(srem), remainder);
+                    evaluator.release(srem);
+                    evaluator.release(sdiv);
+                    evaluator.release(y);
+                    evaluator.release(x);
+                }
+            }
+            /* 16 cached operand pairs of 9 handles each */
+            check.expect(evaluator.getLive() <= 16 * 9, w, 0, 0, evaluator.getLive(), 16 * 9);
+            evaluator.clearDivisionCache();
+            evaluator.collect();
+        }
+        return check.finish(evaluator);
+    }
+
+    typedef SMT::BoolExp *(SMT::QF_ABV::*Comparison)(SMT::BVExp *, SMT::BVExp *);
+
+    /* one comparison against the reference for all operands up to maxWidth bits */
+    bool checkComparison(const std::string &name, Comparison comparison, bool isSigned, int expectedSign,
+                         bool orEqual, unsigned int maxWidth) {
+        Evaluator evaluator;
+        Check check(name);
+        for (unsigned int w = 1; w <= maxWidth; ++w) {
+            for (uint64_t a = 0; a <= mask(w); ++a) {
+                for (uint64_t b = 0; b <= mask(w); ++b) {
+                    int order;
+                    if (isSigned) {
+                        order = toSigned(a, w) < toSigned(b, w) ? -1 : toSigned(a, w) > toSigned(b, w) ? 1 : 0;
+                    } else {
+                        order = a < b ? -1 : a > b ? 1 : 0;
+                    }
+                    bool expected = order == expectedSign || (orEqual && order == 0);
+                    SMT::BVExp *x = evaluator.constant(a, w);
+                    SMT::BVExp *y = evaluator.constant(b, w);
+                    SMT::BoolExp *result = (evaluator.*comparison)(x, y);
+                    check.expect(evaluator.value(result) == expected, w, a, b, evaluator.value(result), expected);
+                    evaluator.release(result);
+                    evaluator.release(y);
+                    evaluator.release(x);
+                    evaluator.collect();
+                }
+            }
+        }
+        return check.finish(evaluator);
+    }
+
+    bool checkComparisons(unsigned int maxWidth) {
+        bool ok = true;
+        ok = checkComparison("bvule", &SMT::QF_ABV::bvule, false, -1, true, maxWidth) && ok;
+        ok = checkComparison("bvugt", &SMT::QF_ABV::bvugt, false, 1, false, maxWidth) && ok;
+        ok = checkComparison("bvuge", &SMT::QF_ABV::bvuge, false, 1, true, maxWidth) && ok;
+        ok = checkComparison("bvslt", &SMT::QF_ABV::bvslt, true, -1, false, maxWidth) && ok;
+        ok = checkComparison("bvsle", &SMT::QF_ABV::bvsle, true, -1, true, maxWidth) && ok;
+        ok = checkComparison("bvsgt", &SMT::QF_ABV::bvsgt, true, 1, false, maxWidth) && ok;
+        ok = checkComparison("bvsge", &SMT::QF_ABV::bvsge, true, 1, true, maxWidth) && ok;
+        return ok;
+    }
+
+    /* the overflow predicates against exact arithmetic for all operands up to maxWidth bits */
+    bool checkOverflows(unsigned int maxWidth) {
+        static const char *const Names[] = {"bvuaddo", "bvusubo", "bvumulo", "bvsaddo", "bvssubo", "bvsmulo",
+                                            "bvsdivo"};
+        static const Comparison Predicates[] = {&SMT::QF_ABV::bvuaddo, &SMT::QF_ABV::bvusubo,
+                                                &SMT::QF_ABV::bvumulo, &SMT::QF_ABV::bvsaddo,
+                                                &SMT::QF_ABV::bvssubo, &SMT::QF_ABV::bvsmulo,
+                                                &SMT::QF_ABV::bvsdivo};
+        static const size_t Count = sizeof(Predicates) / sizeof(Predicates[0]);
+
+        bool ok = true;
+        for (size_t i = 0; i < Count; ++i) {
+            Evaluator evaluator;
+            Check check(Names[i]);
+            for (unsigned int w = 1; w <= maxWidth; ++w) {
+                int64_t min = -(static_cast<int64_t>(1) << (w - 1));
+                int64_t max = (static_cast<int64_t>(1) << (w - 1)) - 1;
+                for (uint64_t a = 0; a <= mask(w); ++a) {
+                    for (uint64_t b = 0; b <= mask(w); ++b) {
+                        int64_t signed1 = toSigned(a, w);
+                        int64_t signed2 = toSigned(b, w);
+                        int64_t exact[] = {0, 0, 0, signed1 + signed2, signed1 - signed2, signed1 * signed2, 0};
+                        bool expected;
+                        switch (i) {
+                            case 0:
+                                expected = a + b > mask(w);
+                                break;
+                            case 1:
+                                expected = a < b;
+                                break;
+                            case 2:
+                                expected = a * b > mask(w);
+                                break;
+                            case 6:
+                                expected = signed1 == min && signed2 == -1;
+                                break;
+                            default:
+                                expected = exact[i] < min || exact[i] > max;
+                                break;
+                        }
+                        SMT::BVExp *x = evaluator.constant(a, w);
+                        SMT::BVExp *y = evaluator.constant(b, w);
+                        SMT::BoolExp *result = (evaluator.*Predicates[i])(x, y);
+                        check.expect(evaluator.value(result) == expected, w, a, b, evaluator.value(result), expected);
+                        evaluator.release(result);
+                        evaluator.release(y);
+                        evaluator.release(x);
+                        evaluator.collect();
+                    }
+                }
+            }
+            ok = check.finish(evaluator) && ok;
+        }
+        return ok;
+    }
+}
+
+/*
+ * Checks the lowerings of the vendored SMT::QF_ABV exhaustively on small
+ * widths against plain C++ arithmetic. With --encoding-report it prints the
+ * gate counts of the comparison encodings instead.
+ */
+int main(int argc, char **argv) {
+    if (argc > 1 && std::string(argv[1]) == "--encoding-report") {
+        SMT::QF_ABV::reportComparisonEncodings(std::cout);
+        return 0;
+    }
+
+    bool ok = true;
+    try {
+        ok = checkComparisons(8) && ok;
+        ok = checkOverflows(7) && ok;
+        ok = checkSignedDivision(7) && ok;
+        ok = checkAshr(SMT::QF_ABV::LinearShiftEncoding, 9) && ok;
+        ok = checkAshr(SMT::QF_ABV::BarrelShiftEncoding, 9) && ok;
+    } catch (const LLBMCException &e) {
+        std::cout << "LLBMCException: " << e.getMessage() << "\n";
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
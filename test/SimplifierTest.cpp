@@ -0,0 +1,463 @@
+//
+// Created by marko on 17.10.26.
+//
+
+#include "Evaluator.h"
+#include "Simplifier.h"
+
+#include <llbmc/Util/Bitvector.h>
+#include <llbmc/Util/LLBMCException.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+
+namespace {
+    /* deterministic, so that the same seed builds the same term on both sides */
+    class Random {
+    public:
+        explicit Random(uint32_t seed) : m_state(seed * 2654435761u + 1) {
+
+        }
+
+        unsigned int next(unsigned int n) {
+            m_state = m_state * 1103515245u + 12345u;
+            return (m_state >> 16) % n;
+        }
+
+    private:
+        uint32_t m_state;
+    };
+
+    /*
+     * One way of building terms: the plain evaluator, or the simplifier in
+     * front of another evaluator. The variables are built once, so that
+     * terms using them twice share the handle, as they do in SMTTranslator.
+     */
+    class Side {
+    public:
+        Side(SMT::TheoryOfBitvectors &bvs, SMT::SatCore &sat, unsigned int width)
+                : m_bvs(bvs), m_sat(sat), m_width(width) {
+            m_x = bvs.bitvector(width, "x");
+            m_y = bvs.bitvector(width, "y");
+            m_z = bvs.bitvector(1, "z");
+            m_p = sat.mk_free("p");
+            m_q = sat.mk_free("q");
+        }
+
+        ~Side() {
+            m_sat.release(m_q);
+            m_sat.release(m_p);
+            m_bvs.release(m_z);
+            m_bvs.release(m_y);
+            m_bvs.release(m_x);
+        }
+
+        /* a random word of the given width, the full width or 1 */
+        SMT::BVExp *word(Random &random, unsigned int width, int depth) {
+            if (depth == 0 || random.next(5) == 0) {
+                return wordLeaf(random, width, depth);
+            }
+            unsigned int op = random.next(22);
+            if (op < 14) {
+                SMT::BVExp *a = word(random, width, depth - 1);
+                SMT::BVExp *b = related(random, a, width, depth - 1);
+                SMT::BVExp *result = binary(op, a, b);
+                m_bvs.release(b);
+                m_bvs.release(a);
+                return result;
+            }
+            SMT::BVExp *a = word(random, width, depth - 1);
+            SMT::BVExp *result;
+            switch (op) {
+                case 14:
+                    result = m_bvs.bvnot(a);
+                    break;
+                case 15:
+                    result = m_bvs.bvneg(a);
+                    break;
+                case 16: {
+                    SMT::BoolExp *cond = boolean(random, depth - 1);
+                    SMT::BVExp *b = related(random, a, width, depth - 1);
+                    result = m_bvs.bvcond(cond, a, b);
+                    m_bvs.release(b);
+                    m_sat.release(cond);
+                    break;
+                }
+                case 17:
+                    result = widened(m_bvs.uext(a, width + 1), width);
+                    break;
+                case 18:
+                    result = widened(m_bvs.sext(a, width + 1), width);
+                    break;
+                case 19:
+                    result = widened(m_bvs.uext(a, width + 2), width);
+                    break;
+                case 20:
+                    result = widened(m_bvs.sext(a, width + 2), width);
+                    break;
+                default: {
+                    SMT::BVExp *b = word(random, width, depth - 1);
+                    result = widened(m_bvs.concat(b, a), width);
+                    m_bvs.release(b);
+                    break;
+                }
+            }
+            m_bvs.release(a);
+            return result;
+        }
+
+        /* a random Boolean */
+        SMT::BoolExp *boolean(Random &random, int depth) {
+            if (depth == 0 || random.next(5) == 0) {
+                switch (random.next(4)) {
+                    case 0:
+                        return m_sat.copy(m_p);
+                    case 1:
+                        return m_sat.copy(m_q);
+                    case 2:
+                        return m_sat.mk_true();
+                    default:
+                        return m_sat.mk_false();
+                }
+            }
+            unsigned int op = random.next(28);
+            if (op < 18) {
+                unsigned int width = random.next(3) == 0 ? 1 : m_width;
+                SMT::BVExp *a = word(random, width, depth - 1);
+                SMT::BVExp *b = related(random, a, width, depth - 1);
+                SMT::BoolExp *result = predicate(op, a, b);
+                m_bvs.release(b);
+                m_bvs.release(a);
+                return result;
+            }
+            if (op == 18) {
+                SMT::BVExp *a = word(random, 1, depth - 1);
+                SMT::BoolExp *result = m_bvs.bv12bool(a);
+                m_bvs.release(a);
+                return result;
+            }
+            if (op == 19) {
+                return lifted(random, depth - 1);
+            }
+            SMT::BoolExp *a = boolean(random, depth - 1);
+            SMT::BoolExp *b;
+            switch (random.next(4)) {
+                case 0:
+                    b = m_sat.copy(a);
+                    break;
+                case 1:
+                    b = m_sat.mk_not(a);
+                    break;
+                default:
+                    b = boolean(random, depth - 1);
+                    break;
+            }
+            SMT::BoolExp *result;
+            switch (op) {
+                case 20:
+                    result = m_sat.mk_not(a);
+                    break;
+                case 21:
+                    result = m_sat.mk_and(a, b);
+                    break;
+                case 22:
+                    result = m_sat.mk_or(a, b);
+                    break;
+                case 23:
+                    result = m_sat.mk_xor(a, b);
+                    break;
+                case 24:
+                    result = m_sat.mk_implies(a, b);
+                    break;
+                case 25:
+                    result = m_sat.mk_iff(a, b);
+                    break;
+                default: {
+                    SMT::BoolExp *cond = boolean(random, depth - 1);
+                    result = op == 26 ? m_sat.mk_cond(cond, a, b) : m_sat.mk_cond(a, b, cond);
+                    m_sat.release(cond);
+                    break;
+                }
+            }
+            m_sat.release(b);
+            m_sat.release(a);
+            return result;
+        }
+
+    private:
+        Side(const Side &);
+        Side &operator=(const Side &);
+
+        /* one-bit leaves are mostly bool2bv1, so that bitwise operators on them can be lifted */
+        SMT::BVExp *wordLeaf(Random &random, unsigned int width, int depth) {
+            if (width == 1 && random.next(2) == 0) {
+                SMT::BoolExp *b = boolean(random, depth > 0 ? depth - 1 : 0);
+                SMT::BVExp *result = m_bvs.bool2bv1(b);
+                m_sat.release(b);
+                return result;
+            }
+            switch (random.next(7)) {
+                case 0:
+                    return m_bvs.copy(width == 1 ? m_z : m_x);
+                case 1:
+                    return m_bvs.copy(width == 1 ? m_z : m_y);
+                case 2:
+                    return m_bvs.bvzeros(width);
+                case 3:
+                    return m_bvs.bvones(width);
+                case 4: {
+                    Bitvector value(random.next(3) == 0 ? 1 : random.next(1u << width), width);
+                    return m_bvs.bv2bv(&value);
+                }
+                case 5: {
+                    unsigned int bit = random.next(m_width - width + 1);
+                    return m_bvs.extract(bit + width - 1, bit, m_x);
+                }
+                default:
+                    return m_bvs.copy(width == 1 ? m_z : m_x);
+            }
+        }
+
+        /* a bitwise operator on bool2bv1 results, read back with bv12bool */
+        SMT::BoolExp *lifted(Random &random, int depth) {
+            SMT::BoolExp *a = boolean(random, depth);
+            SMT::BoolExp *b = boolean(random, depth);
+            SMT::BVExp *wordA = m_bvs.bool2bv1(a);
+            SMT::BVExp *wordB = m_bvs.bool2bv1(b);
+            unsigned int op = random.next(5);
+            SMT::BVExp *word = op == 4 ? m_bvs.bvnot(wordA) : binary(op, wordA, wordB);
+            SMT::BoolExp *result = m_bvs.bv12bool(word);
+            m_bvs.release(word);
+            m_bvs.release(wordB);
+            m_bvs.release(wordA);
+            m_sat.release(b);
+            m_sat.release(a);
+            return result;
+        }
+
+        /* a itself, its complement or negation, a word built on a, or an unrelated word */
+        SMT::BVExp *related(Random &random, SMT::BVExp *a, unsigned int width, int depth) {
+            switch (random.next(6)) {
+                case 0:
+                    return m_bvs.copy(a);
+                case 1:
+                    return m_bvs.bvnot(a);
+                case 2:
+                    return m_bvs.bvneg(a);
+                case 3: {
+                    SMT::BVExp *b = word(random, width, depth);
+                    SMT::BVExp *result = binary(random.next(14), a, b);
+                    m_bvs.release(b);
+                    return result;
+                }
+                default:
+                    return word(random, width, depth);
+            }
+        }
+
+        SMT::BVExp *binary(unsigned int op, SMT::BVExp *a, SMT::BVExp *b) {
+            switch (op) {
+                case 0:
+                    return m_bvs.bvand(a, b);
+                case 1:
+                    return m_bvs.bvor(a, b);
+                case 2:
+                    return m_bvs.bvxor(a, b);
+                case 3:
+                    return m_bvs.bvimplies(a, b);
+                case 4:
+                    return m_bvs.bvadd(a, b);
+                case 5:
+                    return m_bvs.bvsub(a, b);
+                case 6:
+                    return m_bvs.bvmul(a, b);
+                case 7:
+                    return m_bvs.bvudiv(a, b);
+                case 8:
+                    return m_bvs.bvurem(a, b);
+                case 9:
+                    return m_bvs.bvsdiv(a, b);
+                case 10:
+                    return m_bvs.bvsrem(a, b);
+                case 11:
+                    return m_bvs.bvshl(a, b);
+                case 12:
+                    return m_bvs.bvlshr(a, b);
+                default:
+                    return m_bvs.bvashr(a, b);
+            }
+        }
+
+        SMT::BoolExp *predicate(unsigned int op, SMT::BVExp *a, SMT::BVExp *b) {
+            switch (op) {
+                case 0:
+                    return m_bvs.eq(a, b);
+                case 1:
+                    return m_bvs.bvne(a, b);
+                case 2:
+                    return m_bvs.bvult(a, b);
+                case 3:
+                    return m_bvs.bvule(a, b);
+                case 4:
+                    return m_bvs.bvugt(a, b);
+                case 5:
+                    return m_bvs.bvuge(a, b);
+                case 6:
+                    return m_bvs.bvslt(a, b);
+                case 7:
+                    return m_bvs.bvsle(a, b);
+                case 8:
+                    return m_bvs.bvsgt(a, b);
+                case 9:
+                    return m_bvs.bvsge(a, b);
+                case 10:
+                    return m_bvs.bvuaddo(a, b);
+                case 11:
+                    return m_bvs.bvusubo(a, b);
+                case 12:
+                    return m_bvs.bvumulo(a, b);
+                case 13:
+                    return m_bvs.bvsaddo(a, b);
+                case 14:
+                    return m_bvs.bvssubo(a, b);
+                case 15:
+                    return m_bvs.bvsmulo(a, b);
+                case 16:
+                    return m_bvs.bvsdivo(a, b);
+                default:
+                    return m_bvs.eq(a, b);
+            }
+        }
+
+        /* the low width bits of a wider word, which is released */
+        SMT::BVExp *widened(SMT::BVExp *wide, unsigned int width) {
+            SMT::BVExp *result = m_bvs.extract(width - 1, 0, wide);
+            m_bvs.release(wide);
+            return result;
+        }
+
+        SMT::TheoryOfBitvectors &m_bvs;
+        SMT::SatCore &m_sat;
+        unsigned int m_width;
+        SMT::BVExp *m_x;
+        SMT::BVExp *m_y;
+        SMT::BVExp *m_z;
+        SMT::BoolExp *m_p;
+        SMT::BoolExp *m_q;
+    };
+
+    /* counts and prints the first few mismatches of one check */
+    class Check {
+    public:
+        explicit Check(const std::string &name) : m_name(name), m_failures(0) {
+
+        }
+
+        void expect(bool ok, const std::string &what, unsigned int width, unsigned int seed, uint64_t assignment,
+                    uint64_t got, uint64_t expected) {
+            if (ok) {
+                return;
+            }
+            if (m_failures < 5) {
+                std::cout << m_name << " " << what << " w=" << width << " seed=" << seed << " assignment="
+                          << assignment << ": " << got << ", expected " << expected << "\n";
+            }
+            ++m_failures;
+        }
+
+        bool finish() {
+            std::cout << m_name << ": " << (m_failures == 0 ? "ok" : "FAILED") << "\n";
+            return m_failures == 0;
+        }
+
+    private:
+        std::string m_name;
+        unsigned int m_failures;
+    };
+
+    void assign(Evaluator &evaluator, uint64_t assignment, unsigned int width) {
+        evaluator.assign("x", assignment & mask(width));
+        evaluator.assign("y", (assignment >> width) & mask(width));
+        evaluator.assign("z", (assignment >> (2 * width)) & 1);
+        evaluator.assign("p", (assignment >> (2 * width + 1)) & 1);
+        evaluator.assign("q", (assignment >> (2 * width + 2)) & 1);
+    }
+
+    /*
+     * Builds random terms over x, y, z, p and q once on the plain evaluator
+     * and once through the Simplifier, for every assignment of the
+     * variables, and compares the values. The operands of a term are often
+     * related (equal, complemented, built on each other) and constant, so
+     * that the rules actually fire; every rule has to fire somewhere, and
+     * the Simplifier has to release every handle it held once destroyed.
+     */
+    bool checkSimplifier(unsigned int maxWidth, unsigned int terms, int depth) {
+        Check check("Simplifier");
+        unsigned long hits[Simplifier::RuleCount] = {};
+        for (unsigned int w = 1; w <= maxWidth; ++w) {
+            for (uint64_t assignment = 0; assignment < (static_cast<uint64_t>(1) << (2 * w + 3)); ++assignment) {
+                Evaluator plain;
+                Evaluator backend;
+                assign(plain, assignment, w);
+                assign(backend, assignment, w);
+                {
+                    Simplifier simplifier(backend, backend);
+                    Side unsimplified(plain, plain, w);
+                    Side simplified(simplifier, simplifier, w);
+                    for (unsigned int seed = 0; seed < terms; ++seed) {
+                        Random random1(seed);
+                        Random random2(seed);
+                        if (seed % 2 == 0) {
+                            unsigned int width = seed % 3 == 0 ? 1 : w;
+                            SMT::BVExp *expected = unsimplified.word(random1, width, depth);
+                            SMT::BVExp *got = simplified.word(random2, width, depth);
+                            check.expect(backend.width(got) == width && backend.value(got) == plain.value(expected),
+                                         "word", w, seed, assignment, backend.value(got), plain.value(expected));
+                            simplifier.release(got);
+                            plain.release(expected);
+                        } else {
+                            SMT::BoolExp *expected = unsimplified.boolean(random1, depth);
+                            SMT::BoolExp *got = simplified.boolean(random2, depth);
+                            check.expect(backend.value(got) == plain.value(expected), "boolean", w, seed, assignment,
+                                         backend.value(got), plain.value(expected));
+                            simplifier.release(got);
+                            plain.release(expected);
+                        }
+                    }
+                    for (int rule = 0; rule < Simplifier::RuleCount; ++rule) {
+                        hits[rule] += simplifier.getRuleHits(static_cast<Simplifier::Rule>(rule));
+                    }
+                }
+                plain.clearDivisionCache();
+                backend.clearDivisionCache();
+                check.expect(plain.getLive() == 0 && plain.getErrors() == 0, "plain handles", w, 0, assignment,
+                             plain.getLive(), plain.getErrors());
+                check.expect(backend.getLive() == 0 && backend.getErrors() == 0, "simplified handles", w, 0,
+                             assignment, backend.getLive(), backend.getErrors());
+            }
+        }
+        for (int rule = 0; rule < Simplifier::RuleCount; ++rule) {
+            check.expect(hits[rule] != 0, Simplifier::getRuleName(static_cast<Simplifier::Rule>(rule)), 0, 0, 0, 0,
+                         1);
+        }
+        return check.finish();
+    }
+}
+
+/*
+ * Checks that the rewriting of Simplifier is sound: terms built through it
+ * evaluate to the same values as the terms built without it, on the
+ * evaluator of the QF_ABV checks.
+ */
+int main() {
+    bool ok = true;
+    try {
+        ok = checkSimplifier(4, 400, 4) && ok;
+    } catch (const LLBMCException &e) {
+        std::cout << "LLBMCException: " << e.getMessage() << "\n";
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
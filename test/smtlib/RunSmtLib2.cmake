@@ -0,0 +1,27 @@
+# runs one script of the corpus through "TransformerSolver --smtlib-in" and compares
+# it with <name>.expected: either the lines the solver prints, one per check-sat, or
+# "error: <message>" for scripts that have to be rejected with that message
+get_filename_component(NAME ${SCRIPT} NAME_WE)
+get_filename_component(DIR ${SCRIPT} DIRECTORY)
+file(READ ${DIR}/${NAME}.expected EXPECTED)
+
+execute_process(COMMAND ${SOLVER} --smtlib-in ${SCRIPT} ${BACKEND}
+        OUTPUT_VARIABLE OUTPUT ERROR_VARIABLE ERROR RESULT_VARIABLE STATUS)
+
+if (EXPECTED MATCHES "^error: ")
+    string(REGEX REPLACE "^error: (.*)\n$" "\\1" MESSAGE "${EXPECTED}")
+    if (STATUS EQUAL 0)
+        message(FATAL_ERROR "${NAME}: accepted, expected the error \"${MESSAGE}\"\n${OUTPUT}")
+    endif ()
+    string(FIND "${ERROR}" "${MESSAGE}" FOUND)
+    if (FOUND EQUAL -1)
+        message(FATAL_ERROR "${NAME}: expected the error \"${MESSAGE}\", got\n${ERROR}")
+    endif ()
+else ()
+    if (NOT STATUS EQUAL 0)
+        message(FATAL_ERROR "${NAME}: exit status ${STATUS}\n${ERROR}")
+    endif ()
+    if (NOT OUTPUT STREQUAL EXPECTED)
+        message(FATAL_ERROR "${NAME}: expected\n${EXPECTED}got\n${OUTPUT}")
+    endif ()
+endif ()
@@ -0,0 +1,25 @@
+; = is chained, distinct is pairwise
+(set-logic QF_BV)
+(declare-const x (_ BitVec 2))
+(declare-const y (_ BitVec 2))
+(declare-const z (_ BitVec 2))
+(assert (= x y z))
+(assert (= z #b01))
+(check-sat)
+(push 1)
+(assert (distinct x z))
+(check-sat)
+(pop 1)
+(push 1)
+(assert (distinct x y #b10))
+(check-sat)
+(pop 1)
+(declare-const u (_ BitVec 2))
+(declare-const v (_ BitVec 2))
+(declare-const w (_ BitVec 2))
+(assert (distinct u v w #b00))
+(check-sat)
+(push 1)
+(assert (= u w))
+(check-sat)
+(pop 1)
@@ -0,0 +1,13 @@
+; (=> a b c) is (=> a (=> b c)), true whenever a is false
+(set-logic QF_BV)
+(declare-const a Bool)
+(declare-const b Bool)
+(declare-const c Bool)
+(assert (not a))
+(assert (not c))
+(assert (=> a b c))
+(check-sat)
+(push 1)
+(assert (not (=> a b c)))
+(check-sat)
+(pop 1)
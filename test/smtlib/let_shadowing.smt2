@@ -0,0 +1,15 @@
+; let binds in parallel and shadows outer names only inside its body
+(set-logic QF_BV)
+(declare-const x (_ BitVec 4))
+(declare-const y (_ BitVec 4))
+(assert (= x #x3))
+(assert (= y #x5))
+(assert (let ((x y) (y x)) (and (= x #x5) (= y #x3))))
+(assert (let ((x y)) (and (let ((x #x7)) (= x #x7)) (= x #x5))))
+(assert (= x #x3))
+(check-sat)
+(push 1)
+(assert (let ((x y)) (= x #x3)))
+(check-sat)
+(pop 1)
+(check-sat)
@@ -0,0 +1,3 @@
+(set-logic QF_BV)
+(declare-const x (_ BitVec 4))
+(assert (= x #b101))
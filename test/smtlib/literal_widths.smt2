@@ -0,0 +1,8 @@
+; decimal, hexadecimal and binary literals of the same value and width
+(set-logic QF_BV)
+(declare-const x (_ BitVec 4))
+(assert (= x (_ bv15 4) #xf #b1111))
+(assert (= ((_ zero_extend 4) x) (_ bv15 8) #x0f))
+(check-sat)
+(assert (= x (_ bv0 4)))
+(check-sat)
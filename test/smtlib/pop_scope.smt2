@@ -0,0 +1,7 @@
+; b is declared at the popped level
+(set-logic QF_BV)
+(declare-const a (_ BitVec 8))
+(push 1)
+(declare-const b (_ BitVec 8))
+(pop 1)
+(assert (= a b))
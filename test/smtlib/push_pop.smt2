@@ -0,0 +1,19 @@
+; assertions and declarations end with their level
+(set-logic QF_BV)
+(declare-const a (_ BitVec 8))
+(assert (bvult a #x10))
+(push 1)
+(assert (= a #x20))
+(check-sat)
+(pop 1)
+(check-sat)
+(push 2)
+(declare-const b (_ BitVec 8))
+(assert (= b a))
+(assert (bvugt b #x0f))
+(check-sat)
+(pop 2)
+(check-sat)
+(declare-const b (_ BitVec 8))
+(assert (= b #xff))
+(check-sat)
@@ -0,0 +1,10 @@
+; the level left open at the end is popped again
+(set-logic QF_BV)
+(declare-const a (_ BitVec 8))
+(push 1)
+(assert (= a #x01))
+(push 1)
+(assert (= a #x02))
+(check-sat)
+(pop 1)
+(check-sat)
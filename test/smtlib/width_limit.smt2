@@ -0,0 +1,2 @@
+(set-logic QF_BV)
+(declare-const x (_ BitVec 16777217))
@@ -0,0 +1,3 @@
+(set-logic QF_BV)
+(declare-const x (_ BitVec 8))
+(assert (= x (_ bv0 0)))